@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "qiniu/base/base64.h"
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char * argv[])
+{
+    static const char * knl_names[] = {"scalar", "sse4.1", "avx2"};
+    qn_size sizes[] = {48, 256, 4096, 1 << 20};
+    qn_size total = 64 << 20;
+    qn_size str_size;
+    char * bin;
+    char * str;
+    char * out;
+    char name[32];
+    double begin;
+    double elapsed;
+    int knl;
+    int rounds;
+    int i;
+    int j;
+
+    if (argc > 1 && atoi(argv[1]) > 0) total = (qn_size) atoi(argv[1]) << 20;
+
+    bin = malloc(sizes[3]);
+    str = malloc(sizes[3] / 3 * 4 + 4);
+    out = malloc(sizes[3] + 4);
+    if (!bin || !str || !out) return 1;
+
+    srand(1);
+    for (i = 0; i < sizes[3]; i += 1) bin[i] = (char) rand();
+
+    for (knl = QN_B64_KERNEL_SCALAR; knl <= QN_B64_KERNEL_AVX2; knl += 1) {
+        if (qn_b64_set_kernel(knl) != knl) {
+            printf("%s is not supported.\n", knl_names[knl]);
+            continue;
+        } // if
+
+        for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i += 1) {
+            rounds = total / sizes[i];
+
+            begin = bench_now();
+            for (j = 0; j < rounds; j += 1) str_size = qn_b64_encode_urlsafe(str, sizes[i] / 3 * 4 + 4, bin, sizes[i], QN_B64_APPEND_PADDING);
+            elapsed = bench_now() - begin;
+            sprintf(name, "encode %s %zu", knl_names[knl], sizes[i]);
+            printf("%-24s %8.3f ms %8.1f MB/s\n", name, elapsed * 1000, (double) total / (1 << 20) / elapsed);
+
+            begin = bench_now();
+            for (j = 0; j < rounds; j += 1) qn_b64_decode_urlsafe(out, sizes[3] + 4, str, str_size, 0);
+            elapsed = bench_now() - begin;
+            sprintf(name, "decode %s %zu", knl_names[knl], sizes[i]);
+            printf("%-24s %8.3f ms %8.1f MB/s\n", name, elapsed * 1000, (double) total / (1 << 20) / elapsed);
+
+            if (memcmp(out, bin, sizes[i]) != 0) {
+                printf("Decoded data mismatches.\n");
+                return 2;
+            } // if
+        } // for
+    } // for
+
+    free(bin);
+    free(str);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "qiniu/base/errors.h"
+#include "qiniu/os/file.h"
+#include "qiniu/etag.h"
+
+#define BENCH_BUF_SIZE (1 << 22)
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ---- Baseline: read the file into a buffer and hash the buffer.
+static qn_string bench_digest_by_reading(const char * restrict fname)
+{
+    qn_etag_context_ptr ctx;
+    qn_file_ptr fl;
+    qn_string digest = NULL;
+    ssize_t buf_size;
+    char * buf;
+
+    if (! (fl = qn_fl_open(fname, NULL))) return NULL;
+    if (! (ctx = qn_etag_ctx_create())) {
+        qn_fl_close(fl);
+        return NULL;
+    } // if
+
+    if ((buf = malloc(BENCH_BUF_SIZE))) {
+        while ((buf_size = qn_fl_read(fl, buf, BENCH_BUF_SIZE)) > 0) {
+            if (! qn_etag_ctx_update(ctx, buf, buf_size)) break;
+        } // while
+        if (buf_size == 0) digest = qn_etag_ctx_final(ctx);
+        free(buf);
+    } // if
+
+    qn_etag_ctx_destroy(ctx);
+    qn_fl_close(fl);
+    return digest;
+}
+
+int main(int argc, char * argv[])
+{
+    typedef qn_string (*bench_digest_fn)(const char * restrict fname);
+
+    static const struct {
+        const char * name;
+        bench_digest_fn digest;
+    } cases[] = {
+        {"read", &bench_digest_by_reading},
+        {"qn_etag_digest_file", &qn_etag_digest_file}
+    };
+
+    qn_fl_info_ptr fi;
+    qn_string digest;
+    double begin;
+    double best;
+    double elapsed;
+    double mb;
+    int rounds = 5;
+    int i;
+    int j;
+
+    if (argc < 2) {
+        printf("Usage: bench_etag <FILE> [ROUNDS]\n");
+        return 0;
+    } // if
+    if (argc > 2 && atoi(argv[2]) > 0) rounds = atoi(argv[2]);
+
+    if (! (fi = qn_fl_info_stat(argv[1]))) {
+        printf("Cannot stat the `%s` file due to application error `%s`.\n", argv[1], qn_err_get_message());
+        return 1;
+    } // if
+    mb = (double) qn_fl_info_fsize(fi) / (1 << 20);
+    qn_fl_info_destroy(fi);
+
+    // ---- Rounds run on a warm page cache, so the numbers reflect the cost of copying and hashing.
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i += 1) {
+        best = 0.0;
+        digest = NULL;
+        for (j = 0; j < rounds; j += 1) {
+            qn_str_destroy(digest);
+            begin = bench_now();
+            digest = cases[i].digest(argv[1]);
+            elapsed = bench_now() - begin;
+            if (! digest) {
+                printf("Cannot digest the `%s` file due to application error `%s`.\n", argv[1], qn_err_get_message());
+                return 2;
+            } // if
+            if (j == 0 || elapsed < best) best = elapsed;
+        } // for
+        printf("%-20s %s %8.3f ms %8.1f MB/s\n", cases[i].name, qn_str_cstr(digest), best * 1000, mb / best);
+        qn_str_destroy(digest);
+    } // for
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "qiniu/base/json.h"
+#include "qiniu/base/json_parser.h"
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench_report(const char * name, double elapsed, int rounds)
+{
+    printf("%-24s %8.3f ms %8.1f ns/op\n", name, elapsed * 1000, elapsed * 1e9 / rounds);
+}
+
+// -- Build, query and destroy an object of the size of a typical list item.
+static int bench_small_object(int rounds)
+{
+    qn_json_object_ptr obj;
+    qn_json_integer sum = 0;
+    double begin;
+    int i;
+
+    begin = bench_now();
+    for (i = 0; i < rounds; i += 1) {
+        if (! (obj = qn_json_create_object())) return 1;
+        qn_json_set_cstr(obj, "key", "path/to/a/file.txt");
+        qn_json_set_cstr(obj, "hash", "FqNfdcFsRPodJvbOnW3vYSfO5Ddg");
+        qn_json_set_integer(obj, "fsize", i);
+        qn_json_set_integer(obj, "putTime", 14500000000000000LL);
+        qn_json_set_cstr(obj, "mimeType", "text/plain");
+        qn_json_set_integer(obj, "type", 0);
+        sum += qn_json_get_integer(obj, "fsize", 0) + qn_json_get_integer(obj, "type", 0);
+        qn_json_destroy_object(obj);
+    } // for
+    bench_report("small object", bench_now() - begin, rounds);
+    return (sum == (qn_json_integer) rounds * (rounds - 1) / 2) ? 0 : 2;
+}
+
+// -- Push, pick and shift elements of a short array.
+static int bench_small_array(int rounds)
+{
+    qn_json_array_ptr arr;
+    qn_json_integer sum = 0;
+    double begin;
+    int i;
+    int j;
+
+    begin = bench_now();
+    for (i = 0; i < rounds; i += 1) {
+        if (! (arr = qn_json_create_array())) return 1;
+        for (j = 0; j < 8; j += 1) qn_json_push_integer(arr, j);
+        for (j = 0; j < qn_json_size_array(arr); j += 1) sum += qn_json_pick_integer(arr, j, 0);
+        qn_json_shift(arr);
+        qn_json_destroy_array(arr);
+    } // for
+    bench_report("small array", bench_now() - begin, rounds);
+    return (sum == (qn_json_integer) rounds * 28) ? 0 : 2;
+}
+
+// -- Parse a page of a list result.
+static int bench_parse_list(int rounds)
+{
+    char * buf;
+    qn_size buf_size = 0;
+    qn_size size;
+    qn_json_object_ptr obj;
+    qn_json_parser_ptr prs;
+    double begin;
+    int i;
+
+    if (! (buf = malloc(256 * 1000 + 64))) return 1;
+    buf_size += sprintf(buf + buf_size, "{\"marker\":\"eyJjIjowLCJrIjoiYSJ9\",\"items\":[");
+    for (i = 0; i < 1000; i += 1) {
+        buf_size += sprintf(buf + buf_size, "%s{\"key\":\"path/to/file-%d.txt\",\"hash\":\"FqNfdcFsRPodJvbOnW3vYSfO5Ddg\",\"fsize\":%d,\"putTime\":14500000000000000,\"mimeType\":\"text/plain\",\"type\":0}", (i > 0) ? "," : "", i, i);
+    } // for
+    buf_size += sprintf(buf + buf_size, "]}");
+
+    if (! (prs = qn_json_prs_create())) return 1;
+
+    begin = bench_now();
+    for (i = 0; i < rounds; i += 1) {
+        obj = NULL;
+        size = buf_size;
+        if (! qn_json_prs_parse_object(prs, buf, &size, &obj)) return 2;
+        qn_json_destroy_object(obj);
+    } // for
+    bench_report("parse list of 1000", bench_now() - begin, rounds);
+
+    qn_json_prs_destroy(prs);
+    free(buf);
+    return 0;
+}
+
+int main(int argc, char * argv[])
+{
+    int rounds = 1000000;
+    int ret;
+
+    if (argc > 1 && atoi(argv[1]) > 0) rounds = atoi(argv[1]);
+
+    if ((ret = bench_small_object(rounds)) != 0) return ret;
+    if ((ret = bench_small_array(rounds)) != 0) return ret;
+    return bench_parse_list(rounds / 10000 + 1);
+}
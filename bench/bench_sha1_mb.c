@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <openssl/sha.h>
+
+#include "qiniu/base/sha1_mb.h"
+
+#define BENCH_BLK_SIZE (1 << 22)
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned char expected[QN_SHA1_MB_MAX_LANES][SHA_DIGEST_LENGTH];
+    unsigned char digests[QN_SHA1_MB_MAX_LANES][QN_SHA1_MB_DIGEST_SIZE];
+    char * bufs[QN_SHA1_MB_MAX_LANES];
+    double begin;
+    double elapsed;
+    double mb;
+    int lane_cnt = qn_sha1_mb_lane_count();
+    int rounds = 5;
+    int i;
+    int j;
+
+    if (argc > 1 && atoi(argv[1]) > 0) rounds = atoi(argv[1]);
+
+    printf("multi-buffer lanes: %d\n", lane_cnt);
+    if (lane_cnt == 0) return 0;
+
+    srand(1);
+    for (i = 0; i < lane_cnt; i += 1) {
+        if (! (bufs[i] = malloc(BENCH_BLK_SIZE))) return 1;
+        for (j = 0; j < BENCH_BLK_SIZE; j += 1) bufs[i][j] = (char) rand();
+    } // for
+    mb = (double) lane_cnt * rounds * BENCH_BLK_SIZE / (1 << 20);
+
+    // ---- OpenSSL hashes one block after another.
+    begin = bench_now();
+    for (j = 0; j < rounds; j += 1) {
+        for (i = 0; i < lane_cnt; i += 1) SHA1((const unsigned char *) bufs[i], BENCH_BLK_SIZE, expected[i]);
+    } // for
+    elapsed = bench_now() - begin;
+    printf("%-20s %8.3f ms %8.1f MB/s\n", "openssl", elapsed * 1000, mb / elapsed);
+
+    begin = bench_now();
+    for (j = 0; j < rounds; j += 1) qn_sha1_mb_digest((const char * const *) bufs, BENCH_BLK_SIZE, lane_cnt, digests);
+    elapsed = bench_now() - begin;
+    printf("%-20s %8.3f ms %8.1f MB/s\n", "qn_sha1_mb_digest", elapsed * 1000, mb / elapsed);
+
+    for (i = 0; i < lane_cnt; i += 1) {
+        if (memcmp(expected[i], digests[i], SHA_DIGEST_LENGTH) != 0) {
+            printf("Digest of lane %d mismatches.\n", i);
+            return 2;
+        } // if
+        free(bufs[i]);
+    } // for
+    return 0;
+}
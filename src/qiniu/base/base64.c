@@ -1,8 +1,14 @@
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "qiniu/base/base64.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define QN_B64_SIMD_SUPPORT 1
+#include <immintrin.h>
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -107,17 +113,11 @@ static inline void qn_b64_decode_2_chars(char c1, char c2, char * dst)
     dst[0] = ((qn_b64_calc_ord(c1) & 0x3F) << 2) | ((qn_b64_calc_ord(c2) & 0x30) >> 4);
 }
 
-static qn_size qn_b64_decode(char * restrict decoded_bin, qn_size decoded_cap, const char * str, qn_size str_size, qn_uint32 opts)
+// -- Decode the chars which precede the padding ones.
+static qn_size qn_b64_decode(char * restrict decoded_bin, const char * str, qn_size rem)
 {
     qn_size i = 0;
     qn_size m = 0;
-    qn_size rem = str_size;
-
-    if (str[rem] == QN_B64_PADDING_CHAR) {
-        if (str[--rem] == QN_B64_PADDING_CHAR) {
-            rem -= 1;
-        } // if
-    } // if
 
     while (rem >= 4) {
         qn_b64_decode_4_chars(str[i], str[i+1], str[i+2], str[i+3], &decoded_bin[m]);
@@ -141,6 +141,195 @@ static qn_size qn_b64_decode(char * restrict decoded_bin, qn_size decoded_cap, c
     return m;
 }
 
+// ---- SIMD kernels ----
+
+// The kernels handle whole groups only, and return the size of input they consumed. The scalar code above
+// handles the rest, including padding chars. The decoding kernels give up on a vector holding any char out of
+// the alphabet and leave it to the scalar code, so the results match the scalar ones for any input.
+
+#if defined(QN_B64_SIMD_SUPPORT)
+
+#define QN_B64_SSE41 __attribute__((target("sse4.1")))
+#define QN_B64_AVX2 __attribute__((target("avx2")))
+
+// -- Spread 12 bytes into 16 bytes, one 6-bit index per byte.
+static QN_B64_SSE41 inline __m128i qn_b64_split_sse41(__m128i in)
+{
+    __m128i t0;
+    __m128i t1;
+
+    in = _mm_shuffle_epi8(in, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+    t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t0, t1);
+}
+
+// -- Map 6-bit indices to chars by adding the offset of the range each index falls in.
+static QN_B64_SSE41 inline __m128i qn_b64_translate_sse41(__m128i idx)
+{
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '-' - 62, '_' - 63, 'A', 0, 0);
+    __m128i rng = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+
+    rng = _mm_or_si128(rng, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), idx), _mm_set1_epi8(13)));
+    return _mm_add_epi8(idx, _mm_shuffle_epi8(offsets, rng));
+}
+
+static QN_B64_SSE41 qn_size qn_b64_encode_urlsafe_sse41(char * restrict encoded_str, const char * restrict bin, qn_size bin_size)
+{
+    qn_size i = 0;
+    qn_size m = 0;
+
+    // -- Each round loads 16 bytes but consumes 12 only.
+    while (i + 16 <= bin_size) {
+        __m128i in = _mm_loadu_si128((const __m128i *)(bin + i));
+        _mm_storeu_si128((__m128i *)(encoded_str + m), qn_b64_translate_sse41(qn_b64_split_sse41(in)));
+        i += 12;
+        m += 16;
+    } // while
+    return i;
+}
+
+// -- Map chars of both the URL-safe and the standard alphabets to 6-bit values, and set bits in the mask for
+//    the valid ones.
+static QN_B64_SSE41 inline __m128i qn_b64_lookup_sse41(__m128i c, int * restrict valid)
+{
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('Z' + 1)));
+    __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('z' + 1)));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+    __m128i v62 = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('-')), _mm_cmpeq_epi8(c, _mm_set1_epi8('+')));
+    __m128i v63 = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('_')), _mm_cmpeq_epi8(c, _mm_set1_epi8('/')));
+    __m128i val;
+
+    *valid = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(_mm_or_si128(digit, v62), v63)));
+
+    val = _mm_and_si128(upper, _mm_sub_epi8(c, _mm_set1_epi8('A')));
+    val = _mm_or_si128(val, _mm_and_si128(lower, _mm_sub_epi8(c, _mm_set1_epi8('a' - 26))));
+    val = _mm_or_si128(val, _mm_and_si128(digit, _mm_add_epi8(c, _mm_set1_epi8(52 - '0'))));
+    val = _mm_or_si128(val, _mm_and_si128(v62, _mm_set1_epi8(62)));
+    return _mm_or_si128(val, _mm_and_si128(v63, _mm_set1_epi8(63)));
+}
+
+// -- Pack 16 6-bit values into 12 bytes at the low end.
+static QN_B64_SSE41 inline __m128i qn_b64_pack_sse41(__m128i val)
+{
+    val = _mm_maddubs_epi16(val, _mm_set1_epi32(0x01400140));
+    val = _mm_madd_epi16(val, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(val, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+static QN_B64_SSE41 qn_size qn_b64_decode_urlsafe_sse41(char * restrict decoded_bin, const char * restrict str, qn_size str_size)
+{
+    qn_size i = 0;
+    qn_size m = 0;
+    int valid;
+    __m128i out;
+    qn_uint32 tail;
+
+    while (i + 16 <= str_size) {
+        out = qn_b64_lookup_sse41(_mm_loadu_si128((const __m128i *)(str + i)), &valid);
+        if (valid != 0xFFFF) break;
+
+        // -- Store 12 bytes only, so as not to write beyond the end of the buffer.
+        out = qn_b64_pack_sse41(out);
+        _mm_storel_epi64((__m128i *)(decoded_bin + m), out);
+        tail = _mm_extract_epi32(out, 2);
+        memcpy(decoded_bin + m + 8, &tail, sizeof(tail));
+        i += 16;
+        m += 12;
+    } // while
+    return i;
+}
+
+static QN_B64_AVX2 qn_size qn_b64_encode_urlsafe_avx2(char * restrict encoded_str, const char * restrict bin, qn_size bin_size)
+{
+    const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '-' - 62, '_' - 63, 'A', 0, 0, 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '-' - 62, '_' - 63, 'A', 0, 0);
+    const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    qn_size i = 0;
+    qn_size m = 0;
+    __m256i in;
+    __m256i idx;
+    __m256i rng;
+
+    // -- Each round loads 12 bytes into each 128-bit lane, and reads 4 bytes more than it consumes.
+    while (i + 28 <= bin_size) {
+        in = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(bin + i))), _mm_loadu_si128((const __m128i *)(bin + i + 12)), 1);
+        in = _mm256_shuffle_epi8(in, spread);
+        idx = _mm256_or_si256(
+            _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040)),
+            _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010))
+        );
+
+        rng = _mm256_subs_epu8(idx, _mm256_set1_epi8(51));
+        rng = _mm256_or_si256(rng, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), idx), _mm256_set1_epi8(13)));
+        _mm256_storeu_si256((__m256i *)(encoded_str + m), _mm256_add_epi8(idx, _mm256_shuffle_epi8(offsets, rng)));
+        i += 24;
+        m += 32;
+    } // while
+    return i;
+}
+
+static QN_B64_AVX2 qn_size qn_b64_decode_urlsafe_avx2(char * restrict decoded_bin, const char * restrict str, qn_size str_size)
+{
+    qn_size i = 0;
+    qn_size m = 0;
+    __m256i c;
+    __m256i upper;
+    __m256i lower;
+    __m256i digit;
+    __m256i v62;
+    __m256i v63;
+    __m256i val;
+
+    while (i + 32 <= str_size) {
+        c = _mm256_loadu_si256((const __m256i *)(str + i));
+        upper = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), c));
+        lower = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), c));
+        digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+        v62 = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('-')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('+')));
+        v63 = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('_')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('/')));
+        if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(_mm256_or_si256(digit, v62), v63))) != -1) break;
+
+        val = _mm256_and_si256(upper, _mm256_sub_epi8(c, _mm256_set1_epi8('A')));
+        val = _mm256_or_si256(val, _mm256_and_si256(lower, _mm256_sub_epi8(c, _mm256_set1_epi8('a' - 26))));
+        val = _mm256_or_si256(val, _mm256_and_si256(digit, _mm256_add_epi8(c, _mm256_set1_epi8(52 - '0'))));
+        val = _mm256_or_si256(val, _mm256_and_si256(v62, _mm256_set1_epi8(62)));
+        val = _mm256_or_si256(val, _mm256_and_si256(v63, _mm256_set1_epi8(63)));
+
+        // -- Pack 12 bytes in each lane, then move them together and store 24 bytes only.
+        val = _mm256_maddubs_epi16(val, _mm256_set1_epi32(0x01400140));
+        val = _mm256_madd_epi16(val, _mm256_set1_epi32(0x00011000));
+        val = _mm256_shuffle_epi8(val, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        val = _mm256_permutevar8x32_epi32(val, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm_storeu_si128((__m128i *)(decoded_bin + m), _mm256_castsi256_si128(val));
+        _mm_storel_epi64((__m128i *)(decoded_bin + m + 16), _mm256_extracti128_si256(val, 1));
+        i += 32;
+        m += 24;
+    } // while
+    return i;
+}
+
+#endif
+
+static int qn_b64_kernel_in_use = -1;
+
+QN_SDK qn_b64_kernel qn_b64_get_kernel(void)
+{
+    if (qn_b64_kernel_in_use < 0) qn_b64_set_kernel(QN_B64_KERNEL_AVX2);
+    return qn_b64_kernel_in_use;
+}
+
+QN_SDK qn_b64_kernel qn_b64_set_kernel(qn_b64_kernel knl)
+{
+#if defined(QN_B64_SIMD_SUPPORT)
+    if (knl >= QN_B64_KERNEL_AVX2 && ! __builtin_cpu_supports("avx2")) knl = QN_B64_KERNEL_SSE41;
+    if (knl >= QN_B64_KERNEL_SSE41 && ! __builtin_cpu_supports("sse4.1")) knl = QN_B64_KERNEL_SCALAR;
+#else
+    knl = QN_B64_KERNEL_SCALAR;
+#endif
+    qn_b64_kernel_in_use = knl;
+    return knl;
+}
+
 static char qn_b64_urlsafe_map[] = {"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"};
 
 QN_SDK qn_size qn_b64_encode_urlsafe(char * restrict encoded_str, qn_size encoded_cap, const char * restrict bin, qn_size bin_size, qn_uint32 opts)
@@ -153,6 +342,18 @@ QN_SDK qn_size qn_b64_encode_urlsafe(char * restrict encoded_str, qn_size encode
     }
 
     assert(encoding_size <= encoded_cap);
+
+#if defined(QN_B64_SIMD_SUPPORT)
+    {
+        qn_b64_kernel knl = qn_b64_get_kernel();
+        qn_size done = 0;
+
+        if (knl >= QN_B64_KERNEL_AVX2) done = qn_b64_encode_urlsafe_avx2(encoded_str, bin, bin_size);
+        if (knl >= QN_B64_KERNEL_SSE41) done += qn_b64_encode_urlsafe_sse41(encoded_str + done / 3 * 4, bin + done, bin_size - done);
+        if (done > 0) return done / 3 * 4 + qn_b64_encode(encoded_str + done / 3 * 4, encoded_cap - done / 3 * 4, bin + done, bin_size - done, opts, qn_b64_urlsafe_map);
+    }
+#endif
+
     return qn_b64_encode(encoded_str, encoded_cap, bin, bin_size, opts, qn_b64_urlsafe_map);
 }
 
@@ -165,7 +366,25 @@ QN_SDK qn_size qn_b64_decode_urlsafe(char * restrict decoded_bin, qn_size decode
     }
 
     assert(decoding_size <= decoded_cap);
-    return qn_b64_decode(decoded_bin, decoded_cap, str, str_size, opts);
+
+    // -- Skip up to two padding chars.
+    if (str_size > 0 && str[str_size - 1] == QN_B64_PADDING_CHAR) {
+        str_size -= 1;
+        if (str_size > 0 && str[str_size - 1] == QN_B64_PADDING_CHAR) str_size -= 1;
+    } // if
+
+#if defined(QN_B64_SIMD_SUPPORT)
+    {
+        qn_b64_kernel knl = qn_b64_get_kernel();
+        qn_size done = 0;
+
+        if (knl >= QN_B64_KERNEL_AVX2) done = qn_b64_decode_urlsafe_avx2(decoded_bin, str, str_size);
+        if (knl >= QN_B64_KERNEL_SSE41) done += qn_b64_decode_urlsafe_sse41(decoded_bin + done / 4 * 3, str + done, str_size - done);
+        if (done > 0) return done / 4 * 3 + qn_b64_decode(decoded_bin + done / 4 * 3, str + done, str_size - done);
+    }
+#endif
+
+    return qn_b64_decode(decoded_bin, str, str_size);
 }
 
 #ifdef __cplusplus
@@ -13,6 +13,19 @@ enum {
     QN_B64_APPEND_PADDING = 0x1
 };
 
+// -- Kernels to encode and decode, from the plainest to the fastest. The fastest one which the CPU supports is
+//    chosen at the first call. Setting a kernel the CPU lacks falls back to a plainer one, and the kernel in
+//    use is returned.
+typedef enum _QN_B64_KERNEL
+{
+    QN_B64_KERNEL_SCALAR = 0,
+    QN_B64_KERNEL_SSE41 = 1,
+    QN_B64_KERNEL_AVX2 = 2
+} qn_b64_kernel;
+
+QN_SDK extern qn_b64_kernel qn_b64_get_kernel(void);
+QN_SDK extern qn_b64_kernel qn_b64_set_kernel(qn_b64_kernel knl);
+
 QN_SDK extern qn_size qn_b64_encode_urlsafe(char * restrict encoded_str, qn_size encoded_cap, const char * restrict bin, qn_size bin_size, qn_uint32 opts);
 QN_SDK extern qn_size qn_b64_decode_urlsafe(char * restrict decoded_bin, qn_size decoded_cap, const char * restrict str, qn_size str_size, qn_uint32 opts);
 
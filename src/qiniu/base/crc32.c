@@ -0,0 +1,73 @@
+#include <pthread.h>
+
+#include "qiniu/base/crc32.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// -- Slicing-by-8: table[k][b] is the CRC of byte b followed by k zero bytes, so eight bytes are folded in
+//    with eight independent lookups instead of a chain of eight dependent ones.
+static qn_uint32 qn_crc32_table[8][256];
+static pthread_once_t qn_crc32_table_once = PTHREAD_ONCE_INIT;
+
+static void qn_crc32_compile_table(void)
+{
+    qn_uint32 crc;
+    int b;
+    int k;
+
+    for (b = 0; b < 256; b += 1) {
+        crc = b;
+        for (k = 0; k < 8; k += 1) crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+        qn_crc32_table[0][b] = crc;
+    } // for
+    for (b = 0; b < 256; b += 1) {
+        crc = qn_crc32_table[0][b];
+        for (k = 1; k < 8; k += 1) {
+            crc = (crc >> 8) ^ qn_crc32_table[0][crc & 0xFF];
+            qn_crc32_table[k][b] = crc;
+        } // for
+    } // for
+}
+
+/***************************************************************************//**
+* @ingroup CRC32
+*
+* Update a CRC-32 checksum with the given data.
+*
+* @param [in] crc The checksum of the preceding data, or 0 to start a new one.
+* @param [in] buf The pointer to the data.
+* @param [in] buf_size The size of the data.
+*
+* @retval ANY The checksum of all data passed so far.
+*******************************************************************************/
+QN_SDK qn_uint32 qn_crc32_update(qn_uint32 crc, const char * restrict buf, qn_size buf_size)
+{
+    const unsigned char * pos = (const unsigned char *) buf;
+    qn_uint32 lo;
+    qn_uint32 hi;
+
+    pthread_once(&qn_crc32_table_once, &qn_crc32_compile_table);
+
+    crc = ~crc;
+    for (; buf_size > 0 && ((qn_size) pos & 7) != 0; buf_size -= 1) {
+        crc = (crc >> 8) ^ qn_crc32_table[0][(crc ^ *pos++) & 0xFF];
+    } // for
+    for (; buf_size >= 8; buf_size -= 8, pos += 8) {
+        // -- Assemble the words byte by byte, so the result does not depend on the byte order of the CPU.
+        lo = crc ^ ((qn_uint32) pos[0] | ((qn_uint32) pos[1] << 8) | ((qn_uint32) pos[2] << 16) | ((qn_uint32) pos[3] << 24));
+        hi = (qn_uint32) pos[4] | ((qn_uint32) pos[5] << 8) | ((qn_uint32) pos[6] << 16) | ((qn_uint32) pos[7] << 24);
+        crc = qn_crc32_table[7][lo & 0xFF] ^ qn_crc32_table[6][(lo >> 8) & 0xFF] ^ qn_crc32_table[5][(lo >> 16) & 0xFF] ^ qn_crc32_table[4][lo >> 24]
+            ^ qn_crc32_table[3][hi & 0xFF] ^ qn_crc32_table[2][(hi >> 8) & 0xFF] ^ qn_crc32_table[1][(hi >> 16) & 0xFF] ^ qn_crc32_table[0][hi >> 24];
+    } // for
+    for (; buf_size > 0; buf_size -= 1) {
+        crc = (crc >> 8) ^ qn_crc32_table[0][(crc ^ *pos++) & 0xFF];
+    } // for
+    return ~crc;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,22 @@
+#ifndef __QN_CRC32_H__
+#define __QN_CRC32_H__ 1
+
+#include "qiniu/os/types.h"
+#include "qiniu/macros.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// ---- CRC-32 (abbreviation: crc32) ----
+
+// -- The IEEE 802.3 CRC-32, the same one as zlib's crc32() and the one returned by the upload APIs. Start
+//    with 0 and pass the previous result to go on with the next piece of data.
+QN_SDK extern qn_uint32 qn_crc32_update(qn_uint32 crc, const char * restrict buf, qn_size buf_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __QN_CRC32_H__
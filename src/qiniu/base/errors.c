@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 #include <curl/curl.h>
 #include <openssl/err.h>
 
@@ -28,6 +29,7 @@ static qn_err_message_map_st qn_err_message_maps[] = {
     {QN_ERR_OUT_OF_CAPACITY, "Out of capacity"},
     {QN_ERR_NO_SUCH_ENTRY, "No such entry to the specified key or name"},
     {QN_ERR_OUT_OF_RANGE, "Out of range"},
+    {QN_ERR_IN_PROGRESS, "Operation is in progress"},
 
     {QN_ERR_JSON_BAD_TEXT_INPUT, "Bad text input of a JSON string is read"},
     {QN_ERR_JSON_TOO_MANY_PARSING_LEVELS, "Parsing too many levels in a piece of JSON text"},
@@ -42,10 +44,15 @@ static qn_err_message_map_st qn_err_message_maps[] = {
     {QN_ERR_HTTP_ADDING_BUFFER_FIELD_FAILED, "Adding buffer field to HTTP form failed"},
     {QN_ERR_HTTP_MISMATCHING_FILE_SIZE, "Mismatching file size"},
 
+    {QN_ERR_COMM_DNS_FAILED, "Resolving host name failed"},
+    {QN_ERR_COMM_TRANSMISSION_FAILED, "Transmitting data failed"},
+
     {QN_ERR_FL_OPENING_FILE_FAILED, "Opening file failed"},
     {QN_ERR_FL_DUPLICATING_FILE_FAILED, "Duplicating file failed"},
     {QN_ERR_FL_READING_FILE_FAILED, "Reading file failed"},
     {QN_ERR_FL_SEEKING_FILE_FAILED, "Seeking file failed"},
+    {QN_ERR_FL_MAPPING_FILE_FAILED, "Mapping file failed"},
+    {QN_ERR_FL_WRITING_FILE_FAILED, "Writing file failed"},
     {QN_ERR_FL_INFO_STATING_FILE_INFO_FAILED, "Stating file infomation failed"},
 
     {QN_ERR_STOR_LACK_OF_AUTHORIZATION_INFORMATION, "Lack of auhorization information like token or put policy"},
@@ -59,6 +66,9 @@ static qn_err_message_map_st qn_err_message_maps[] = {
     {QN_ERR_STOR_LACK_OF_BLOCK_INFO, "Lack of block information"},
     {QN_ERR_STOR_LACK_OF_FILE_SIZE, "Lack of file size"},
     {QN_ERR_STOR_INVALID_UPLOAD_RESULT, "Invalid upload result"},
+    {QN_ERR_STOR_MISMATCHING_CRC32, "Mismatching CRC-32 of uploaded data"},
+    {QN_ERR_STOR_MISMATCHING_QETAG, "Mismatching QETAG of downloaded data"},
+    {QN_ERR_STOR_UNEXPECTED_DOWNLOAD_RANGE, "Unexpected range of downloaded data"},
 
     {QN_ERR_ETAG_INITIALIZING_CONTEXT_FAILED, "Failed in initializing a new qetag context"},
     {QN_ERR_ETAG_UPDATING_CONTEXT_FAILED, "Failed in updating the qetag context"},
@@ -71,7 +81,8 @@ static qn_err_message_map_st qn_err_message_maps[] = {
 
     {QN_ERR_3RDP_GLIBC_ERROR_OCCURRED, "glibc error occurred"},
     {QN_ERR_3RDP_CURL_EASY_ERROR_OCCURRED, "cURL easy error occurred"},
-    {QN_ERR_3RDP_OPENSSL_ERROR_OCCURRED, "OpenSSL error occurred"}
+    {QN_ERR_3RDP_OPENSSL_ERROR_OCCURRED, "OpenSSL error occurred"},
+    {QN_ERR_3RDP_CURL_MULTI_ERROR_OCCURRED, "cURL multi error occurred"}
 };
 
 typedef struct _QN_ERR_MESSAGE
@@ -82,7 +93,8 @@ typedef struct _QN_ERR_MESSAGE
     qn_uint32 lib_code;
 } qn_err_message_st;
 
-static qn_err_message_st qn_err_msg;
+// -- Each thread keeps its own error state, so that one thread's failure never changes the result checked by another one.
+static QN_THREAD_LOCAL qn_err_message_st qn_err_msg = {__FILE__, __LINE__, QN_ERR_SUCCEED, 0};
 
 static int qn_err_compare(const void * restrict key, const void * restrict item)
 {
@@ -99,19 +111,26 @@ QN_SDK ssize_t qn_err_format_message(char * buf, size_t buf_size)
 {
     ssize_t ret;
     ssize_t ret2 = 0;
-    char * short_file = posix_strstr(qn_err_msg.file, "src/qiniu/") + 4;
+    char lib_msg[256];
+    const char * short_file = posix_strstr(qn_err_msg.file, "src/qiniu/");
+
+    short_file = (short_file) ? short_file + 4 : qn_err_msg.file;
 
     ret = qn_cs_snprintf(buf, buf_size, "%s:%d %s", short_file, qn_err_msg.line, qn_err_get_message());
     if (0 < ret) {
         switch (qn_err_msg.code) {
             case QN_ERR_3RDP_GLIBC_ERROR_OCCURRED:
-                ret2 = qn_cs_snprintf(buf + ret, buf_size - ret, "(%lu:%s)", qn_err_msg.lib_code, strerror(qn_err_msg.lib_code));
+                ret2 = qn_cs_snprintf(buf + ret, buf_size - ret, "(%lu:%s)", qn_err_msg.lib_code, strerror_r(qn_err_msg.lib_code, lib_msg, sizeof(lib_msg)));
                 break;
             case QN_ERR_3RDP_CURL_EASY_ERROR_OCCURRED:
                 ret2 = qn_cs_snprintf(buf + ret, buf_size - ret, "(%lu:%s)", qn_err_msg.lib_code, curl_easy_strerror(qn_err_msg.lib_code));
                 break;
             case QN_ERR_3RDP_OPENSSL_ERROR_OCCURRED:
-                ret2 = qn_cs_snprintf(buf + ret, buf_size - ret, "(%lu:%s)", qn_err_msg.lib_code, ERR_error_string(qn_err_msg.lib_code, NULL));
+                ERR_error_string_n(qn_err_msg.lib_code, lib_msg, sizeof(lib_msg));
+                ret2 = qn_cs_snprintf(buf + ret, buf_size - ret, "(%lu:%s)", qn_err_msg.lib_code, lib_msg);
+                break;
+            case QN_ERR_3RDP_CURL_MULTI_ERROR_OCCURRED:
+                ret2 = qn_cs_snprintf(buf + ret, buf_size - ret, "(%lu:%s)", qn_err_msg.lib_code, curl_multi_strerror(qn_err_msg.lib_code));
                 break;
             default:
                 break;
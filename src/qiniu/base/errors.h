@@ -22,6 +22,7 @@ typedef enum _QN_ERR_CODE
     QN_ERR_OUT_OF_CAPACITY = 1008,
     QN_ERR_NO_SUCH_ENTRY = 1009,
     QN_ERR_OUT_OF_RANGE = 1010,
+    QN_ERR_IN_PROGRESS = 1011,
 
     QN_ERR_JSON_BAD_TEXT_INPUT  = 2001,
     QN_ERR_JSON_TOO_MANY_PARSING_LEVELS = 2002,
@@ -43,6 +44,8 @@ typedef enum _QN_ERR_CODE
     QN_ERR_FL_DUPLICATING_FILE_FAILED = 11002,
     QN_ERR_FL_READING_FILE_FAILED = 11003,
     QN_ERR_FL_SEEKING_FILE_FAILED = 11004,
+    QN_ERR_FL_MAPPING_FILE_FAILED = 11005,
+    QN_ERR_FL_WRITING_FILE_FAILED = 11006,
     QN_ERR_FL_INFO_STATING_FILE_INFO_FAILED = 11101,
 
     QN_ERR_STOR_LACK_OF_AUTHORIZATION_INFORMATION = 21001,
@@ -56,6 +59,9 @@ typedef enum _QN_ERR_CODE
     QN_ERR_STOR_LACK_OF_BLOCK_INFO = 21009,
     QN_ERR_STOR_LACK_OF_FILE_SIZE = 21010,
     QN_ERR_STOR_INVALID_UPLOAD_RESULT = 21011,
+    QN_ERR_STOR_MISMATCHING_CRC32 = 21012,
+    QN_ERR_STOR_MISMATCHING_QETAG = 21013,
+    QN_ERR_STOR_UNEXPECTED_DOWNLOAD_RANGE = 21014,
 
     QN_ERR_ETAG_INITIALIZING_CONTEXT_FAILED = 22001,
     QN_ERR_ETAG_UPDATING_CONTEXT_FAILED = 22002,
@@ -69,11 +75,14 @@ typedef enum _QN_ERR_CODE
     QN_ERR_3RDP_GLIBC_ERROR_OCCURRED = 101001,
     QN_ERR_3RDP_CURL_EASY_ERROR_OCCURRED = 101002,
     QN_ERR_3RDP_OPENSSL_ERROR_OCCURRED = 101003,
+    QN_ERR_3RDP_CURL_MULTI_ERROR_OCCURRED = 101004,
 } qn_err_code_em;
 
 QN_SDK extern ssize_t qn_err_format_message(char * buf, size_t buf_size);
 QN_SDK extern const char * qn_err_get_message(void);
 
+// -- Error states are kept per thread. Work done on behalf of another thread fails in the helper's state, so the
+//    helper passes the code got by qn_err_get_code() over, and the other thread sets it again by qn_err_set_code().
 QN_SDK extern void qn_err_set_code(qn_err_code_em cd, qn_uint32 lib_cd, const char * restrict file, int line);
 QN_SDK extern qn_err_code_em qn_err_get_code(void);
 
@@ -90,6 +99,7 @@ QN_SDK extern qn_err_code_em qn_err_get_code(void);
 #define qn_err_set_out_of_capacity() qn_err_set_code(QN_ERR_OUT_OF_CAPACITY, 0, __FILE__, __LINE__)
 #define qn_err_set_no_such_entry() qn_err_set_code(QN_ERR_NO_SUCH_ENTRY, 0, __FILE__, __LINE__)
 #define qn_err_set_out_of_range() qn_err_set_code(QN_ERR_OUT_OF_RANGE, 0, __FILE__, __LINE__)
+#define qn_err_set_in_progress() qn_err_set_code(QN_ERR_IN_PROGRESS, 0, __FILE__, __LINE__)
 
 #define qn_err_json_set_bad_text_input() qn_err_set_code(QN_ERR_JSON_BAD_TEXT_INPUT, 0, __FILE__, __LINE__)
 #define qn_err_json_set_too_many_parsing_levels() qn_err_set_code(QN_ERR_JSON_TOO_MANY_PARSING_LEVELS, 0, __FILE__, __LINE__)
@@ -111,6 +121,8 @@ QN_SDK extern qn_err_code_em qn_err_get_code(void);
 #define qn_err_fl_set_duplicating_file_failed() qn_err_set_code(QN_ERR_FL_DUPLICATING_FILE_FAILED, 0, __FILE__, __LINE__)
 #define qn_err_fl_set_reading_file_failed() qn_err_set_code(QN_ERR_FL_READING_FILE_FAILED, 0, __FILE__, __LINE__)
 #define qn_err_fl_set_seeking_file_failed() qn_err_set_code(QN_ERR_FL_SEEKING_FILE_FAILED, 0, __FILE__, __LINE__)
+#define qn_err_fl_set_mapping_file_failed() qn_err_set_code(QN_ERR_FL_MAPPING_FILE_FAILED, 0, __FILE__, __LINE__)
+#define qn_err_fl_set_writing_file_failed() qn_err_set_code(QN_ERR_FL_WRITING_FILE_FAILED, 0, __FILE__, __LINE__)
 
 #define qn_err_fl_info_set_stating_file_info_failed() qn_err_set_code(QN_ERR_FL_INFO_STATING_FILE_INFO_FAILED, 0, __FILE__, __LINE__)
 
@@ -125,6 +137,9 @@ QN_SDK extern qn_err_code_em qn_err_get_code(void);
 #define qn_err_stor_set_lack_of_file_size() qn_err_set_code(QN_ERR_STOR_LACK_OF_FILE_SIZE, 0, __FILE__, __LINE__)
 #define qn_err_stor_set_lack_of_block_info() qn_err_set_code(QN_ERR_STOR_LACK_OF_BLOCK_INFO, 0, __FILE__, __LINE__)
 #define qn_err_stor_set_invalid_upload_result() qn_err_set_code(QN_ERR_STOR_INVALID_UPLOAD_RESULT, 0, __FILE__, __LINE__)
+#define qn_err_stor_set_mismatching_crc32() qn_err_set_code(QN_ERR_STOR_MISMATCHING_CRC32, 0, __FILE__, __LINE__)
+#define qn_err_stor_set_mismatching_qetag() qn_err_set_code(QN_ERR_STOR_MISMATCHING_QETAG, 0, __FILE__, __LINE__)
+#define qn_err_stor_set_unexpected_download_range() qn_err_set_code(QN_ERR_STOR_UNEXPECTED_DOWNLOAD_RANGE, 0, __FILE__, __LINE__)
 
 #define qn_err_etag_set_initializing_context_failed() qn_err_set_code(QN_ERR_ETAG_INITIALIZING_CONTEXT_FAILED, 0, __FILE__, __LINE__)
 #define qn_err_etag_set_updating_context_failed() qn_err_set_code(QN_ERR_ETAG_UPDATING_CONTEXT_FAILED, 0, __FILE__, __LINE__)
@@ -138,6 +153,7 @@ QN_SDK extern qn_err_code_em qn_err_get_code(void);
 #define qn_err_3rdp_set_glibc_error_occurred(lib_cd) qn_err_set_code(QN_ERR_3RDP_GLIBC_ERROR_OCCURRED, lib_cd, __FILE__, __LINE__)
 #define qn_err_3rdp_set_curl_easy_error_occurred(lib_cd) qn_err_set_code(QN_ERR_3RDP_CURL_EASY_ERROR_OCCURRED, lib_cd, __FILE__, __LINE__)
 #define qn_err_3rdp_set_openssl_error_occurred(lib_cd) qn_err_set_code(QN_ERR_3RDP_OPENSSL_ERROR_OCCURRED, lib_cd, __FILE__, __LINE__)
+#define qn_err_3rdp_set_curl_multi_error_occurred(lib_cd) qn_err_set_code(QN_ERR_3RDP_CURL_MULTI_ERROR_OCCURRED, lib_cd, __FILE__, __LINE__)
 
 // ----
 
@@ -196,6 +212,11 @@ static inline qn_bool qn_err_is_out_of_range(void)
     return qn_err_get_code() == QN_ERR_OUT_OF_RANGE;
 }
 
+static inline qn_bool qn_err_is_in_progress(void)
+{
+    return qn_err_get_code() == QN_ERR_IN_PROGRESS;
+}
+
 static inline qn_bool qn_err_json_is_bad_text_input(void)
 {
     return qn_err_get_code() == QN_ERR_JSON_BAD_TEXT_INPUT;
@@ -272,6 +293,16 @@ static inline qn_bool qn_err_fl_is_seeking_file_failed(void)
     return qn_err_get_code() == QN_ERR_FL_SEEKING_FILE_FAILED;
 }
 
+static inline qn_bool qn_err_fl_is_mapping_file_failed(void)
+{
+    return qn_err_get_code() == QN_ERR_FL_MAPPING_FILE_FAILED;
+}
+
+static inline qn_bool qn_err_fl_is_writing_file_failed(void)
+{
+    return qn_err_get_code() == QN_ERR_FL_WRITING_FILE_FAILED;
+}
+
 static inline qn_bool qn_err_fl_info_is_stating_file_info_failed(void)
 {
     return qn_err_get_code() == QN_ERR_FL_INFO_STATING_FILE_INFO_FAILED;
@@ -332,6 +363,21 @@ static inline qn_bool qn_err_stor_is_invalid_upload_result(void)
     return qn_err_get_code() == QN_ERR_STOR_INVALID_UPLOAD_RESULT;
 }
 
+static inline qn_bool qn_err_stor_is_mismatching_crc32(void)
+{
+    return qn_err_get_code() == QN_ERR_STOR_MISMATCHING_CRC32;
+}
+
+static inline qn_bool qn_err_stor_is_mismatching_qetag(void)
+{
+    return qn_err_get_code() == QN_ERR_STOR_MISMATCHING_QETAG;
+}
+
+static inline qn_bool qn_err_stor_is_unexpected_download_range(void)
+{
+    return qn_err_get_code() == QN_ERR_STOR_UNEXPECTED_DOWNLOAD_RANGE;
+}
+
 static inline qn_bool qn_err_etag_is_initializing_context_failed(void)
 {
     return qn_err_get_code() == QN_ERR_ETAG_INITIALIZING_CONTEXT_FAILED;
@@ -1,5 +1,7 @@
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 
 #include "qiniu/base/io.h"
 #include "qiniu/base/errors.h"
@@ -131,6 +133,423 @@ QN_SDK qn_io_reader_itf qn_io_srdr_to_io_reader(qn_io_section_reader_ptr restric
     return &srdr->rdr_vtbl;
 }
 
+// ---- Prefetcher ----
+
+typedef struct _QN_IO_PREFETCHER
+{
+    void * data;
+    qn_io_pf_next_callback_fn next_cb;
+    qn_io_pf_fill_callback_fn fill_cb;
+    qn_io_pf_commit_callback_fn commit_cb;
+
+    unsigned int filling:1;     // The helper thread is doing a piece without the lock.
+    unsigned int stopping:1;
+
+    qn_bool threaded;
+    pthread_t tid;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} qn_io_prefetcher_st;
+
+static void * qn_io_pf_routine(void * arg)
+{
+    qn_io_prefetcher_ptr pf = (qn_io_prefetcher_ptr) arg;
+
+    pthread_mutex_lock(&pf->lock);
+    while (1) {
+        while (! pf->stopping && ! pf->next_cb(pf->data)) pthread_cond_wait(&pf->cond, &pf->lock);
+        if (pf->stopping) break;
+
+        pf->filling = 1;
+        pthread_mutex_unlock(&pf->lock);
+
+        pf->fill_cb(pf->data);
+
+        pthread_mutex_lock(&pf->lock);
+        pf->commit_cb(pf->data);
+        pf->filling = 0;
+        pthread_cond_broadcast(&pf->cond);
+    } // while
+    pthread_mutex_unlock(&pf->lock);
+    return NULL;
+}
+
+QN_SDK qn_io_prefetcher_ptr qn_io_pf_create(void * restrict data, qn_io_pf_next_callback_fn next_cb, qn_io_pf_fill_callback_fn fill_cb, qn_io_pf_commit_callback_fn commit_cb, qn_bool threaded)
+{
+    qn_io_prefetcher_ptr new_pf;
+
+    assert(next_cb);
+    assert(fill_cb);
+    assert(commit_cb);
+
+    new_pf = calloc(1, sizeof(qn_io_prefetcher_st));
+    if (! new_pf) {
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+
+    new_pf->data = data;
+    new_pf->next_cb = next_cb;
+    new_pf->fill_cb = fill_cb;
+    new_pf->commit_cb = commit_cb;
+    if (! threaded) return new_pf;
+
+    if (pthread_mutex_init(&new_pf->lock, NULL) != 0) return new_pf;
+    if (pthread_cond_init(&new_pf->cond, NULL) != 0) {
+        pthread_mutex_destroy(&new_pf->lock);
+        return new_pf;
+    } // if
+    // -- Leave the pieces to the consumer if the helper thread cannot be created.
+    new_pf->threaded = (pthread_create(&new_pf->tid, NULL, &qn_io_pf_routine, new_pf) == 0);
+    if (! new_pf->threaded) {
+        pthread_cond_destroy(&new_pf->cond);
+        pthread_mutex_destroy(&new_pf->lock);
+    } // if
+    return new_pf;
+}
+
+QN_SDK void qn_io_pf_destroy(qn_io_prefetcher_ptr restrict pf)
+{
+    if (pf) {
+        if (pf->threaded) {
+            pthread_mutex_lock(&pf->lock);
+            pf->stopping = 1;
+            pthread_cond_broadcast(&pf->cond);
+            pthread_mutex_unlock(&pf->lock);
+
+            pthread_join(pf->tid, NULL);
+            pthread_cond_destroy(&pf->cond);
+            pthread_mutex_destroy(&pf->lock);
+        } // if
+        free(pf);
+    } // if
+}
+
+QN_SDK void qn_io_pf_lock(qn_io_prefetcher_ptr restrict pf)
+{
+    if (pf->threaded) pthread_mutex_lock(&pf->lock);
+}
+
+QN_SDK void qn_io_pf_unlock(qn_io_prefetcher_ptr restrict pf)
+{
+    if (pf->threaded) pthread_mutex_unlock(&pf->lock);
+}
+
+QN_SDK void qn_io_pf_notify(qn_io_prefetcher_ptr restrict pf)
+{
+    if (pf->threaded) pthread_cond_broadcast(&pf->cond);
+}
+
+QN_SDK void qn_io_pf_wait(qn_io_prefetcher_ptr restrict pf)
+{
+    if (pf->threaded) {
+        pthread_cond_wait(&pf->cond, &pf->lock);
+        return;
+    } // if
+    if (pf->next_cb(pf->data)) {
+        pf->fill_cb(pf->data);
+        pf->commit_cb(pf->data);
+    } // if
+}
+
+QN_SDK void qn_io_pf_settle(qn_io_prefetcher_ptr restrict pf)
+{
+    if (pf->threaded) {
+        while (pf->filling) pthread_cond_wait(&pf->cond, &pf->lock);
+    } // if
+}
+
+// ---- Read-ahead reader ----
+
+typedef struct _QN_IO_RARDR_BUFFER
+{
+    char * data;
+    size_t size;
+    size_t pos;
+} qn_io_rardr_buffer_st, *qn_io_rardr_buffer_ptr;
+
+typedef struct _QN_IO_READ_AHEAD_READER
+{
+    qn_io_reader_ptr rdr_vtbl;
+    qn_io_reader_itf src_rdr;
+
+    char * mem;
+    size_t buf_size;
+    int depth;
+    qn_io_rardr_buffer_st bufs[QN_IO_RARDR_MAX_DEPTH];
+    int head;                   // The buffer being consumed.
+    int cnt;                    // The number of filled buffers.
+
+    unsigned int paused:1;      // The consumer is repositioning the source, so do not read it.
+    unsigned int eof:1;         // No more data will be read from the source, because of the end or an error.
+    unsigned int failed:1;
+    qn_err_code_em err_code;
+
+    qn_io_rardr_buffer_ptr fill_buf;
+    ssize_t fill_ret;
+    qn_err_code_em fill_err_code;
+
+    qn_io_prefetcher_ptr pf;
+} qn_io_read_ahead_reader_st;
+
+static inline qn_io_read_ahead_reader_ptr qn_io_rardr_from_io_reader(qn_io_reader_itf restrict itf)
+{
+    return (qn_io_read_ahead_reader_ptr)( ( (char *) itf ) - (char *)( &((qn_io_read_ahead_reader_ptr)0)->rdr_vtbl ) );
+}
+
+static qn_bool qn_io_rardr_next_cfn(void * restrict data)
+{
+    qn_io_read_ahead_reader_ptr rardr = (qn_io_read_ahead_reader_ptr) data;
+
+    if (rardr->paused || ! rardr->src_rdr || rardr->eof || rardr->cnt == rardr->depth) return qn_false;
+
+    // -- The consumer only touches filled buffers before this one, so it is safe to fill it without the lock.
+    rardr->fill_buf = &rardr->bufs[(rardr->head + rardr->cnt) % rardr->depth];
+    return qn_true;
+}
+
+static void qn_io_rardr_fill_cfn(void * restrict data)
+{
+    qn_io_read_ahead_reader_ptr rardr = (qn_io_read_ahead_reader_ptr) data;
+    qn_io_rardr_buffer_ptr buf = rardr->fill_buf;
+    ssize_t ret = 0;
+
+    // ---- Fill the whole buffer, so the consumer gets large pieces even if the source returns small ones.
+    buf->size = 0;
+    buf->pos = 0;
+    while (buf->size < rardr->buf_size) {
+        ret = qn_io_rdr_read(rardr->src_rdr, buf->data + buf->size, rardr->buf_size - buf->size);
+        if (ret <= 0) break;
+        buf->size += ret;
+    } // while
+
+    rardr->fill_ret = ret;
+    if (ret < 0) rardr->fill_err_code = qn_err_get_code();
+}
+
+static void qn_io_rardr_commit_cfn(void * restrict data)
+{
+    qn_io_read_ahead_reader_ptr rardr = (qn_io_read_ahead_reader_ptr) data;
+
+    if (rardr->fill_ret < 0) {
+        rardr->failed = 1;
+        rardr->err_code = rardr->fill_err_code;
+    } // if
+    if (rardr->fill_ret <= 0) rardr->eof = 1;
+    if (rardr->fill_buf->size > 0) rardr->cnt += 1;
+}
+
+// -- Called with the lock held. Return the buffer holding the next data, or NULL at the end or on errors.
+static qn_io_rardr_buffer_ptr qn_io_rardr_wait(qn_io_read_ahead_reader_ptr restrict rardr)
+{
+    while (rardr->cnt == 0 && ! rardr->eof && rardr->src_rdr) qn_io_pf_wait(rardr->pf);
+    return (rardr->cnt > 0) ? &rardr->bufs[rardr->head] : NULL;
+}
+
+static void qn_io_rardr_release(qn_io_read_ahead_reader_ptr restrict rardr)
+{
+    rardr->head = (rardr->head + 1) % rardr->depth;
+    rardr->cnt -= 1;
+    qn_io_pf_notify(rardr->pf);
+}
+
+// -- Called with the lock held. Stop the helper thread from touching the source.
+static void qn_io_rardr_pause(qn_io_read_ahead_reader_ptr restrict rardr)
+{
+    rardr->paused = 1;
+    qn_io_pf_settle(rardr->pf);
+}
+
+static void qn_io_rardr_drop(qn_io_read_ahead_reader_ptr restrict rardr)
+{
+    rardr->head = 0;
+    rardr->cnt = 0;
+    rardr->eof = 0;
+    rardr->failed = 0;
+}
+
+static void qn_io_rardr_resume(qn_io_read_ahead_reader_ptr restrict rardr)
+{
+    rardr->paused = 0;
+    qn_io_pf_notify(rardr->pf);
+}
+
+static ssize_t qn_io_rardr_read(qn_io_read_ahead_reader_ptr restrict rardr, char * restrict buf, size_t buf_size, qn_bool consume)
+{
+    qn_io_rardr_buffer_ptr head;
+    size_t copy_size;
+
+    qn_io_pf_lock(rardr->pf);
+    if (! (head = qn_io_rardr_wait(rardr))) {
+        if (rardr->failed) {
+            qn_err_set_code(rardr->err_code, 0, __FILE__, __LINE__);
+            qn_io_pf_unlock(rardr->pf);
+            return QN_IO_RDR_READING_FAILED;
+        } // if
+        qn_io_pf_unlock(rardr->pf);
+        return QN_IO_RDR_EOF;
+    } // if
+    qn_io_pf_unlock(rardr->pf);
+
+    // ---- Filled buffers are left alone by the helper thread, so copy without the lock.
+    copy_size = head->size - head->pos;
+    if (buf_size < copy_size) copy_size = buf_size;
+    memcpy(buf, head->data + head->pos, copy_size);
+    if (! consume) return copy_size;
+
+    qn_io_pf_lock(rardr->pf);
+    head->pos += copy_size;
+    if (head->pos == head->size) qn_io_rardr_release(rardr);
+    qn_io_pf_unlock(rardr->pf);
+    return copy_size;
+}
+
+static void qn_io_rardr_close_vfn(qn_io_reader_itf restrict itf)
+{
+    qn_io_rardr_destroy(qn_io_rardr_from_io_reader(itf));
+}
+
+static ssize_t qn_io_rardr_peek_vfn(qn_io_reader_itf restrict itf, char * restrict buf, size_t buf_size)
+{
+    return qn_io_rardr_read(qn_io_rardr_from_io_reader(itf), buf, buf_size, qn_false);
+}
+
+static ssize_t qn_io_rardr_read_vfn(qn_io_reader_itf restrict itf, char * restrict buf, size_t buf_size)
+{
+    return qn_io_rardr_read(qn_io_rardr_from_io_reader(itf), buf, buf_size, qn_true);
+}
+
+static qn_bool qn_io_rardr_seek_vfn(qn_io_reader_itf restrict itf, qn_foffset offset)
+{
+    qn_bool ret;
+    qn_io_read_ahead_reader_ptr rardr = qn_io_rardr_from_io_reader(itf);
+
+    qn_io_pf_lock(rardr->pf);
+    qn_io_rardr_pause(rardr);
+    qn_io_rardr_drop(rardr);
+    ret = qn_io_rdr_seek(rardr->src_rdr, offset);
+    qn_io_rardr_resume(rardr);
+    qn_io_pf_unlock(rardr->pf);
+    return ret;
+}
+
+static qn_bool qn_io_rardr_advance_vfn(qn_io_reader_itf restrict itf, qn_foffset delta)
+{
+    qn_bool ret = qn_true;
+    qn_io_rardr_buffer_ptr head;
+    qn_io_read_ahead_reader_ptr rardr = qn_io_rardr_from_io_reader(itf);
+
+    qn_io_pf_lock(rardr->pf);
+    qn_io_rardr_pause(rardr);
+
+    // ---- Skip buffered data first, and move the source only for the rest.
+    while (delta > 0 && rardr->cnt > 0) {
+        head = &rardr->bufs[rardr->head];
+        if (delta < head->size - head->pos) {
+            head->pos += delta;
+            delta = 0;
+            break;
+        } // if
+        delta -= head->size - head->pos;
+        qn_io_rardr_release(rardr);
+    } // while
+
+    if (delta > 0) {
+        qn_io_rardr_drop(rardr);
+        ret = qn_io_rdr_advance(rardr->src_rdr, delta);
+    } // if
+
+    qn_io_rardr_resume(rardr);
+    qn_io_pf_unlock(rardr->pf);
+    return ret;
+}
+
+static qn_string qn_io_rardr_name_vfn(qn_io_reader_itf restrict itf)
+{
+    return qn_io_rdr_name(qn_io_rardr_from_io_reader(itf)->src_rdr);
+}
+
+static qn_fsize qn_io_rardr_size_vfn(qn_io_reader_itf restrict itf)
+{
+    return qn_io_rdr_size(qn_io_rardr_from_io_reader(itf)->src_rdr);
+}
+
+static qn_io_reader_st qn_io_rardr_vtable = {
+    &qn_io_rardr_close_vfn,
+    &qn_io_rardr_peek_vfn,
+    &qn_io_rardr_read_vfn,
+    &qn_io_rardr_seek_vfn,
+    &qn_io_rardr_advance_vfn,
+    NULL, // DUPLICATE
+    NULL, // SECTION
+    &qn_io_rardr_name_vfn,
+    &qn_io_rardr_size_vfn
+};
+
+QN_SDK qn_io_read_ahead_reader_ptr qn_io_rardr_create(qn_io_reader_itf restrict src_rdr, size_t buf_size, int depth)
+{
+    qn_io_read_ahead_reader_ptr new_rardr;
+    int i;
+
+    if (buf_size == 0) buf_size = QN_IO_RARDR_DEFAULT_BUF_SIZE;
+    if (depth <= 0) depth = QN_IO_RARDR_DEFAULT_DEPTH;
+    if (depth > QN_IO_RARDR_MAX_DEPTH) depth = QN_IO_RARDR_MAX_DEPTH;
+
+    new_rardr = calloc(1, sizeof(qn_io_read_ahead_reader_st));
+    if (! new_rardr) {
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+
+    new_rardr->mem = malloc(buf_size * depth);
+    if (! new_rardr->mem) {
+        free(new_rardr);
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+
+    for (i = 0; i < depth; i += 1) new_rardr->bufs[i].data = new_rardr->mem + buf_size * i;
+    new_rardr->buf_size = buf_size;
+    new_rardr->depth = depth;
+    new_rardr->src_rdr = src_rdr;
+    new_rardr->rdr_vtbl = &qn_io_rardr_vtable;
+
+    new_rardr->pf = qn_io_pf_create(new_rardr, &qn_io_rardr_next_cfn, &qn_io_rardr_fill_cfn, &qn_io_rardr_commit_cfn, qn_true);
+    if (! new_rardr->pf) {
+        free(new_rardr->mem);
+        free(new_rardr);
+        return NULL;
+    } // if
+    return new_rardr;
+}
+
+QN_SDK void qn_io_rardr_destroy(qn_io_read_ahead_reader_ptr restrict rardr)
+{
+    if (rardr) {
+        qn_io_pf_destroy(rardr->pf);
+        free(rardr->mem);
+        free(rardr);
+    } // if
+}
+
+QN_SDK void qn_io_rardr_reset(qn_io_read_ahead_reader_ptr restrict rardr, qn_io_reader_itf restrict src_rdr)
+{
+    assert(rardr);
+
+    qn_io_pf_lock(rardr->pf);
+    qn_io_rardr_pause(rardr);
+    qn_io_rardr_drop(rardr);
+    rardr->src_rdr = src_rdr;
+    qn_io_rardr_resume(rardr);
+    qn_io_pf_unlock(rardr->pf);
+}
+
+QN_SDK qn_io_reader_itf qn_io_rardr_to_io_reader(qn_io_read_ahead_reader_ptr restrict rardr)
+{
+    assert(rardr);
+    return &rardr->rdr_vtbl;
+}
+
 #ifdef __cplusplus
 }
 #endif
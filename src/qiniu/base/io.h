@@ -105,6 +105,54 @@ QN_SDK extern void qn_io_srdr_destroy(qn_io_section_reader_ptr restrict srdr);
 QN_SDK extern void qn_io_srdr_reset(qn_io_section_reader_ptr restrict srdr, qn_io_reader_itf restrict src_rdr, size_t section_size);
 QN_SDK extern qn_io_reader_itf qn_io_srdr_to_io_reader(qn_io_section_reader_ptr restrict srdr);
 
+// ---- Prefetcher (abbreviation: pf) ----
+
+// -- A helper thread does pieces of work for a consumer ahead of time. The callbacks get the `data` given on creation.
+//    `next_cb` is called with the lock held to stage the next piece, and returns false if there is none yet.
+//    `fill_cb` does the staged piece without the lock, and `commit_cb` publishes its result with the lock held.
+//    If no thread can be created, or none is wanted, the consumer does the pieces itself in qn_io_pf_wait().
+
+typedef qn_bool (*qn_io_pf_next_callback_fn)(void * restrict data);
+typedef void (*qn_io_pf_fill_callback_fn)(void * restrict data);
+typedef void (*qn_io_pf_commit_callback_fn)(void * restrict data);
+
+struct _QN_IO_PREFETCHER;
+typedef struct _QN_IO_PREFETCHER * qn_io_prefetcher_ptr;
+
+QN_SDK extern qn_io_prefetcher_ptr qn_io_pf_create(void * restrict data, qn_io_pf_next_callback_fn next_cb, qn_io_pf_fill_callback_fn fill_cb, qn_io_pf_commit_callback_fn commit_cb, qn_bool threaded);
+QN_SDK extern void qn_io_pf_destroy(qn_io_prefetcher_ptr restrict pf);
+
+QN_SDK extern void qn_io_pf_lock(qn_io_prefetcher_ptr restrict pf);
+QN_SDK extern void qn_io_pf_unlock(qn_io_prefetcher_ptr restrict pf);
+
+// -- Called with the lock held. Wake the helper thread up after changing what `next_cb` looks at.
+QN_SDK extern void qn_io_pf_notify(qn_io_prefetcher_ptr restrict pf);
+
+// -- Called with the lock held. Wait for a piece to be committed, or do the next one in the calling thread.
+QN_SDK extern void qn_io_pf_wait(qn_io_prefetcher_ptr restrict pf);
+
+// -- Called with the lock held. Wait until no piece is being done, so the state `fill_cb` uses may be changed.
+QN_SDK extern void qn_io_pf_settle(qn_io_prefetcher_ptr restrict pf);
+
+// ---- Read-ahead reader (abbreviation: rardr) ----
+
+// -- A prefetcher keeps up to `depth` buffers filled from the source reader, so the consumer finds data in memory
+//    instead of waiting for the disk. The source must not be used by others until it is detached by
+//    qn_io_rardr_reset() or qn_io_rardr_destroy().
+
+#define QN_IO_RARDR_DEFAULT_BUF_SIZE (1024 * 1024)
+#define QN_IO_RARDR_DEFAULT_DEPTH 2
+#define QN_IO_RARDR_MAX_DEPTH 4
+
+struct _QN_IO_READ_AHEAD_READER;
+typedef struct _QN_IO_READ_AHEAD_READER * qn_io_read_ahead_reader_ptr;
+
+QN_SDK extern qn_io_read_ahead_reader_ptr qn_io_rardr_create(qn_io_reader_itf restrict src_rdr, size_t buf_size, int depth);
+QN_SDK extern void qn_io_rardr_destroy(qn_io_read_ahead_reader_ptr restrict rardr);
+
+QN_SDK extern void qn_io_rardr_reset(qn_io_read_ahead_reader_ptr restrict rardr, qn_io_reader_itf restrict src_rdr);
+QN_SDK extern qn_io_reader_itf qn_io_rardr_to_io_reader(qn_io_read_ahead_reader_ptr restrict rardr);
+
 // ----
 
 struct _QN_IO_WRITER;
@@ -23,14 +23,174 @@ extern "C"
 #endif
 
 typedef qn_uint32 qn_json_hash;
-typedef unsigned short int qn_json_pos;
+typedef qn_uint32 qn_json_pos;
 
-static inline void qn_json_destroy_element(qn_json_class cls, qn_json_variant_ptr restrict elem)
+// -- Positions are exposed as `int` by the public API, so the capacity of a container stops doubling at this limit.
+#define QN_JSON_MAX_CAPACITY ((qn_json_pos) 1 << 30)
+
+// ---- Inplementation of arena of JSON ----
+
+// -- An arena allocates memory for a whole tree of objects and arrays from a few large chunks, and frees them
+//    all at once when the root owning the arena is destroyed. Blocks in an arena are never freed one by one,
+//    except that the last allocated block can be grown in place.
+#define QN_JSON_ARENA_ALIGNMENT 16
+#define QN_JSON_ARENA_MIN_CHUNK_SIZE (4 * 1024)
+#define QN_JSON_ARENA_MAX_CHUNK_SIZE (1024 * 1024)
+
+#define QN_JSON_ARENA_ALIGN(size, align) (((size) + (align) - 1) & ~((qn_size)(align) - 1))
+
+typedef struct _QN_JSON_ARENA_CHUNK
+{
+    struct _QN_JSON_ARENA_CHUNK * next;
+    char * pos;
+    char * end;
+} qn_json_arena_chunk, *qn_json_arena_chunk_ptr;
+
+typedef struct _QN_JSON_ARENA
+{
+    qn_json_arena_chunk_ptr head;
+    void * owner;
+    char * last;
+    qn_size chunk_size;
+    qn_bool foreign;
+} qn_json_arena, *qn_json_arena_ptr;
+
+#define QN_JSON_ARENA_CHUNK_HEADER_SIZE QN_JSON_ARENA_ALIGN(sizeof(qn_json_arena_chunk), QN_JSON_ARENA_ALIGNMENT)
+
+static qn_json_arena_chunk_ptr qn_json_arena_add_chunk(qn_json_arena_ptr restrict arena, qn_size size)
+{
+    qn_json_arena_chunk_ptr new_chunk;
+    qn_size chunk_size = arena->chunk_size;
+    qn_bool huge = (size + QN_JSON_ARENA_ALIGNMENT > chunk_size - QN_JSON_ARENA_CHUNK_HEADER_SIZE);
+
+    // -- A huge block takes a dedicated chunk.
+    if (huge) chunk_size = QN_JSON_ARENA_CHUNK_HEADER_SIZE + size + QN_JSON_ARENA_ALIGNMENT;
+
+    new_chunk = malloc(chunk_size);
+    if (!new_chunk) return NULL;
+
+    new_chunk->pos = (char *) new_chunk + QN_JSON_ARENA_CHUNK_HEADER_SIZE;
+    new_chunk->end = (char *) new_chunk + chunk_size;
+
+    if (huge) {
+        // -- Keep allocating small blocks from the current chunk.
+        new_chunk->next = arena->head->next;
+        arena->head->next = new_chunk;
+    } else {
+        new_chunk->next = arena->head;
+        arena->head = new_chunk;
+        if (arena->chunk_size < QN_JSON_ARENA_MAX_CHUNK_SIZE) arena->chunk_size *= 2;
+    } // if
+    return new_chunk;
+}
+
+static void * qn_json_arena_allocate(qn_json_arena_ptr restrict arena, qn_size size, qn_size align)
+{
+    qn_json_arena_chunk_ptr chunk = arena->head;
+    char * blk = (char *) QN_JSON_ARENA_ALIGN((qn_size) chunk->pos, align);
+
+    if (blk > chunk->end || (qn_size)(chunk->end - blk) < size) {
+        if (! (chunk = qn_json_arena_add_chunk(arena, size))) return NULL;
+        blk = (char *) QN_JSON_ARENA_ALIGN((qn_size) chunk->pos, align);
+    } // if
+
+    chunk->pos = blk + size;
+    arena->last = blk;
+    return blk;
+}
+
+static qn_bool qn_json_arena_extend(qn_json_arena_ptr restrict arena, void * restrict blk, qn_size old_size, qn_size new_size)
+{
+    qn_json_arena_chunk_ptr chunk = arena->head;
+
+    // -- Only the last block allocated from the current chunk can be extended.
+    if (blk != arena->last || chunk->pos != (char *) blk + old_size || (qn_size)(chunk->end - (char *) blk) < new_size) return qn_false;
+    chunk->pos = (char *) blk + new_size;
+    return qn_true;
+}
+
+static qn_json_arena_ptr qn_json_arena_create(void)
+{
+    qn_json_arena_chunk_ptr chunk;
+    qn_json_arena_ptr new_arena;
+
+    chunk = malloc(QN_JSON_ARENA_MIN_CHUNK_SIZE);
+    if (!chunk) {
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+
+    // -- The arena itself lives in its first chunk.
+    new_arena = (qn_json_arena_ptr) ((char *) chunk + QN_JSON_ARENA_CHUNK_HEADER_SIZE);
+    memset(new_arena, 0, sizeof(qn_json_arena));
+
+    chunk->next = NULL;
+    chunk->pos = (char *) new_arena + QN_JSON_ARENA_ALIGN(sizeof(qn_json_arena), QN_JSON_ARENA_ALIGNMENT);
+    chunk->end = (char *) chunk + QN_JSON_ARENA_MIN_CHUNK_SIZE;
+
+    new_arena->head = chunk;
+    new_arena->chunk_size = QN_JSON_ARENA_MIN_CHUNK_SIZE * 2;
+    return new_arena;
+}
+
+static void qn_json_arena_destroy(qn_json_arena_ptr restrict arena)
+{
+    qn_json_arena_chunk_ptr chunk = arena->head;
+    qn_json_arena_chunk_ptr next;
+
+    // -- The arena itself lives in its first chunk, so do not touch it after freeing begins.
+    while (chunk) {
+        next = chunk->next;
+        free(chunk);
+        chunk = next;
+    } // while
+}
+
+// ---- Allocation helpers which use the arena if any, or the heap otherwise ----
+
+static void * qn_json_allocate(qn_json_arena_ptr restrict arena, qn_size size)
+{
+    void * blk = (arena) ? qn_json_arena_allocate(arena, size, QN_JSON_ARENA_ALIGNMENT) : malloc(size);
+    if (!blk) {
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+    memset(blk, 0, size);
+    return blk;
+}
+
+static inline void qn_json_deallocate(qn_json_arena_ptr restrict arena, void * restrict blk)
+{
+    if (!arena) free(blk);
+}
+
+static qn_string qn_json_clone_text(qn_json_arena_ptr restrict arena, const char * restrict txt, qn_size txt_size)
+{
+    qn_string new_str;
+
+    if (!arena) return qn_cs_clone(txt, txt_size);
+
+    new_str = qn_json_arena_allocate(arena, txt_size + 1, 1);
+    if (!new_str) {
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+    memcpy(new_str, txt, txt_size);
+    new_str[txt_size] = '\0';
+    return new_str;
+}
+
+static inline void qn_json_destroy_text(qn_json_arena_ptr restrict arena, qn_string restrict str)
+{
+    if (!arena) qn_str_destroy(str);
+}
+
+static inline void qn_json_destroy_element(qn_json_arena_ptr restrict arena, qn_json_class cls, qn_json_variant_ptr restrict elem)
 {
     switch (cls) {
         case QN_JSON_OBJECT: qn_json_destroy_object(elem->object); break;
         case QN_JSON_ARRAY: qn_json_destroy_array(elem->array); break;
-        case QN_JSON_STRING: qn_str_destroy(elem->string); break;
+        case QN_JSON_STRING: qn_json_destroy_text(arena, elem->string); break;
         default: break;
     } // switch
 }
@@ -40,29 +200,39 @@ static inline void qn_json_destroy_element(qn_json_class cls, qn_json_variant_pt
 typedef struct _QN_JSON_OBJ_ITEM
 {
     qn_string key;
+    qn_json_hash hash;
     qn_json_class class;
     qn_json_variant elem;
 } qn_json_obj_item;
 
+// -- Items are stored in the order of insertion, and sorted by keys only before iterating.
+//    Objects with more items than the threshold are indexed by a hash table, using open addressing and
+//    linear probing. Each slot of the table holds the position of an item plus one, or zero if empty.
+#define QN_JSON_OBJ_INDEX_THRESHOLD 8
+
 typedef struct _QN_JSON_OBJECT
 {
+    qn_json_arena_ptr arena;
     qn_json_obj_item * itm;
+    qn_json_pos * idx;
+    qn_uint32 idx_cap;
     qn_json_pos cnt;
     qn_json_pos cap;
+    qn_bool sorted;
 
     qn_json_obj_item init_itm[2];
 } qn_json_object;
 
-// static qn_json_hash qn_json_obj_calculate_hash(const char * restrict cstr)
-// {
-//     qn_json_hash hash = 5381;
-//     int c;
-// 
-//     while ((c = *cstr++) != '\0') {
-//         hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
-//     } // while
-//     return hash;
-// }
+static qn_json_hash qn_json_obj_calculate_hash(const char * restrict cstr)
+{
+    qn_json_hash hash = 5381;
+    int c;
+
+    while ((c = *cstr++) != '\0') {
+        hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
+    } // while
+    return hash;
+}
 
 /***************************************************************************//**
 * @ingroup JSON-Object
@@ -77,6 +247,18 @@ QN_SDK qn_json_object_ptr qn_json_immutable_empty_object(void)
     return &obj;
 }
 
+static qn_json_object_ptr qn_json_obj_create(qn_json_arena_ptr restrict arena)
+{
+    qn_json_object_ptr new_obj = qn_json_allocate(arena, sizeof(qn_json_object));
+    if (!new_obj) return NULL;
+
+    new_obj->arena = arena;
+    new_obj->itm = &new_obj->init_itm[0];
+    new_obj->cap = sizeof(new_obj->init_itm) / sizeof(new_obj->init_itm[0]);
+    new_obj->sorted = qn_true;
+    return new_obj;
+}
+
 /***************************************************************************//**
 * @ingroup JSON-Object
 *
@@ -87,14 +269,31 @@ QN_SDK qn_json_object_ptr qn_json_immutable_empty_object(void)
 *******************************************************************************/
 QN_SDK qn_json_object_ptr qn_json_create_object(void)
 {
-    qn_json_object_ptr new_obj = calloc(1, sizeof(qn_json_object));
-    if (!new_obj) {
-        qn_err_set_out_of_memory();
+    return qn_json_obj_create(NULL);
+}
+
+/***************************************************************************//**
+* @ingroup JSON-Object
+*
+* Allocate and construct a new JSON object which owns a memory arena. All
+* objects, arrays, keys and strings created in or set into the new object,
+* directly or indirectly, are allocated from the arena, and freed at once when
+* the new object is destroyed.
+*
+* @retval non-NULL A pointer to the new JSON object.
+* @retval NULL Failed in creation and an error code is set.
+*******************************************************************************/
+QN_SDK qn_json_object_ptr qn_json_create_object_in_arena(void)
+{
+    qn_json_object_ptr new_obj;
+    qn_json_arena_ptr arena = qn_json_arena_create();
+    if (!arena) return NULL;
+
+    if (! (new_obj = qn_json_obj_create(arena))) {
+        qn_json_arena_destroy(arena);
         return NULL;
     } // if
-
-    new_obj->itm = &new_obj->init_itm[0];
-    new_obj->cap = sizeof(new_obj->init_itm) / sizeof(new_obj->init_itm[0]);
+    arena->owner = new_obj;
     return new_obj;
 }
 
@@ -108,52 +307,171 @@ QN_SDK qn_json_object_ptr qn_json_create_object(void)
 *******************************************************************************/
 QN_SDK void qn_json_destroy_object(qn_json_object_ptr restrict obj)
 {
+    qn_json_arena_ptr arena = obj->arena;
     qn_json_pos i;
 
-    for (i = 0; i < obj->cnt; i += 1) {
-        qn_json_destroy_element(obj->itm[i].class, &obj->itm[i].elem);
-        qn_str_destroy(obj->itm[i].key);
-    } // for
+    // -- Elements in an arena need not to be destroyed one by one, unless some foreign objects or arrays
+    //    have been set into the tree.
+    if (!arena || arena->foreign) {
+        for (i = 0; i < obj->cnt; i += 1) {
+            qn_json_destroy_element(arena, obj->itm[i].class, &obj->itm[i].elem);
+            qn_json_destroy_text(arena, obj->itm[i].key);
+        } // for
+    } // if
+    if (arena) {
+        if (arena->owner == obj) qn_json_arena_destroy(arena);
+        return;
+    } // if
+
     if (obj->itm != &obj->init_itm[0]) {
         free(obj->itm);
     } // if
+    free(obj->idx);
     free(obj);
 }
 
-static qn_json_pos qn_json_obj_bsearch(qn_json_obj_item * restrict itm, qn_json_pos cnt, const char * restrict key, int * restrict existence)
+static qn_json_pos qn_json_obj_find(qn_json_object_ptr restrict obj, const char * restrict key, qn_json_hash hash)
 {
-    qn_json_pos begin = 0;
-    qn_json_pos end = cnt;
-    qn_json_pos mid = 0;
-    while (begin < end) {
-        mid = begin + ((end - begin) / 2);
-        if (strcmp(itm[mid].key, key) < 0) {
-            begin = mid + 1;
-        } else {
-            end = mid;
+    qn_uint32 mask;
+    qn_uint32 i;
+    qn_json_pos pos;
+
+    if (obj->idx) {
+        mask = obj->idx_cap - 1;
+        for (i = hash & mask; obj->idx[i] != 0; i = (i + 1) & mask) {
+            pos = obj->idx[i] - 1;
+            if (obj->itm[pos].hash == hash && strcmp(obj->itm[pos].key, key) == 0) return pos;
+        } // for
+        return obj->cnt;
+    } // if
+
+    for (pos = 0; pos < obj->cnt; pos += 1) {
+        if (obj->itm[pos].hash == hash && strcmp(obj->itm[pos].key, key) == 0) return pos;
+    } // for
+    return obj->cnt;
+}
+
+static void qn_json_obj_index_insert(qn_json_object_ptr restrict obj, qn_json_pos pos)
+{
+    qn_uint32 mask = obj->idx_cap - 1;
+    qn_uint32 i;
+
+    for (i = obj->itm[pos].hash & mask; obj->idx[i] != 0; i = (i + 1) & mask) {
+        // Find an empty slot.
+    } // for
+    obj->idx[i] = pos + 1;
+}
+
+static qn_uint32 qn_json_obj_index_locate(qn_json_object_ptr restrict obj, qn_json_pos pos)
+{
+    qn_uint32 mask = obj->idx_cap - 1;
+    qn_uint32 i;
+
+    for (i = obj->itm[pos].hash & mask; obj->idx[i] != pos + 1; i = (i + 1) & mask) {
+        // Find the slot of the item.
+    } // for
+    return i;
+}
+
+static void qn_json_obj_index_remove(qn_json_object_ptr restrict obj, qn_json_pos pos)
+{
+    qn_uint32 mask = obj->idx_cap - 1;
+    qn_uint32 hole = qn_json_obj_index_locate(obj, pos);
+    qn_uint32 home;
+    qn_uint32 i;
+
+    // ---- Shift following slots of the same cluster backward, unless they are already at their home slots,
+    //      so that no tombstone is needed.
+    for (i = (hole + 1) & mask; obj->idx[i] != 0; i = (i + 1) & mask) {
+        home = obj->itm[obj->idx[i] - 1].hash & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            obj->idx[hole] = obj->idx[i];
+            hole = i;
         } // if
-    } // while
-    // -- Finally, the `begin` variable points to the first key that is equal to or larger than the given key,
-    //    as an insert point.
-    *existence = (begin < cnt) ? strcmp(itm[begin].key, key) : 1;
-    return begin;
+    } // for
+    obj->idx[hole] = 0;
+}
+
+static qn_bool qn_json_obj_rebuild_index(qn_json_object_ptr restrict obj)
+{
+    qn_uint32 new_cap;
+    qn_json_pos * new_idx;
+    qn_json_pos pos;
+
+    if (obj->cap < QN_JSON_OBJ_INDEX_THRESHOLD) return qn_true;
+
+    // -- Keep the load factor no more than 0.5.
+    for (new_cap = QN_JSON_OBJ_INDEX_THRESHOLD * 2; new_cap < (qn_uint32) obj->cap * 2; new_cap *= 2) {
+    } // for
+
+    if (new_cap != obj->idx_cap) {
+        new_idx = qn_json_allocate(obj->arena, sizeof(qn_json_pos) * new_cap);
+        if (!new_idx) return qn_false;
+        qn_json_deallocate(obj->arena, obj->idx);
+        obj->idx = new_idx;
+        obj->idx_cap = new_cap;
+    } else {
+        memset(obj->idx, 0, sizeof(qn_json_pos) * obj->idx_cap);
+    } // if
+
+    for (pos = 0; pos < obj->cnt; pos += 1) qn_json_obj_index_insert(obj, pos);
+    return qn_true;
+}
+
+static void qn_json_obj_remove_item(qn_json_object_ptr restrict obj, qn_json_pos pos)
+{
+    qn_json_pos last = obj->cnt - 1;
+
+    // ---- Fill the hole with the last item, instead of moving all following items.
+    if (obj->idx) qn_json_obj_index_remove(obj, pos);
+    if (pos < last) {
+        if (obj->idx) obj->idx[qn_json_obj_index_locate(obj, last)] = pos + 1;
+        obj->itm[pos] = obj->itm[last];
+        obj->sorted = qn_false;
+    } // if
+    obj->cnt -= 1;
+}
+
+static int qn_json_obj_compare_items(const void * restrict lhs, const void * restrict rhs)
+{
+    return strcmp(((const qn_json_obj_item *) lhs)->key, ((const qn_json_obj_item *) rhs)->key);
+}
+
+static void qn_json_obj_sort(qn_json_object_ptr restrict obj)
+{
+    if (obj->sorted || obj->cnt < 2) return;
+
+    qsort(obj->itm, obj->cnt, sizeof(qn_json_obj_item), &qn_json_obj_compare_items);
+    obj->sorted = qn_true;
+
+    // -- The table has enough capacity already, so rebuilding it never fails.
+    if (obj->idx) qn_json_obj_rebuild_index(obj);
 }
 
 static qn_bool qn_json_obj_augment(qn_json_object_ptr restrict obj)
 {
     qn_json_pos new_cap = obj->cap * 2;
-    qn_json_obj_item * new_itm = calloc(1, sizeof(qn_json_obj_item) * new_cap);
-    if (!new_itm) {
-        qn_err_set_out_of_memory();
+    qn_json_obj_item * new_itm;
+
+    if (obj->cap >= QN_JSON_MAX_CAPACITY) {
+        qn_err_set_overflow_upper_bound();
         return qn_false;
     } // if
 
+    if (obj->arena && obj->itm != &obj->init_itm[0] && qn_json_arena_extend(obj->arena, obj->itm, sizeof(qn_json_obj_item) * obj->cap, sizeof(qn_json_obj_item) * new_cap)) {
+        obj->cap = new_cap;
+        return qn_json_obj_rebuild_index(obj);
+    } // if
+
+    new_itm = qn_json_allocate(obj->arena, sizeof(qn_json_obj_item) * new_cap);
+    if (!new_itm) return qn_false;
+
     memcpy(new_itm, obj->itm, sizeof(qn_json_obj_item) * obj->cnt);
-    if (obj->itm != &obj->init_itm[0]) free(obj->itm);
+    if (obj->itm != &obj->init_itm[0]) qn_json_deallocate(obj->arena, obj->itm);
 
     obj->itm = new_itm;
     obj->cap = new_cap;
-    return qn_true;
+    return qn_json_obj_rebuild_index(obj);
 }
 
 // ---- Inplementation of array of JSON ----
@@ -166,6 +484,7 @@ typedef struct _QN_JSON_ARR_ITEM
 
 typedef struct _QN_JSON_ARRAY
 {
+    qn_json_arena_ptr arena;
     qn_json_arr_item * itm;
     qn_json_pos begin;
     qn_json_pos end;
@@ -188,6 +507,17 @@ QN_SDK qn_json_array_ptr qn_json_immutable_empty_array(void)
     return &arr;
 }
 
+static qn_json_array_ptr qn_json_arr_create(qn_json_arena_ptr restrict arena)
+{
+    qn_json_array_ptr new_arr = qn_json_allocate(arena, sizeof(qn_json_array));
+    if (!new_arr) return NULL;
+
+    new_arr->arena = arena;
+    new_arr->itm = &new_arr->init_itm[0];
+    new_arr->cap = sizeof(new_arr->init_itm) / sizeof(new_arr->init_itm[0]);
+    return new_arr;
+}
+
 /***************************************************************************//**
 * @ingroup JSON-Array
 *
@@ -198,14 +528,31 @@ QN_SDK qn_json_array_ptr qn_json_immutable_empty_array(void)
 *******************************************************************************/
 QN_SDK qn_json_array_ptr qn_json_create_array(void)
 {
-    qn_json_array_ptr new_arr = calloc(1, sizeof(qn_json_array));
-    if (!new_arr) {
-        qn_err_set_out_of_memory();
+    return qn_json_arr_create(NULL);
+}
+
+/***************************************************************************//**
+* @ingroup JSON-Array
+*
+* Allocate and construct a new JSON array which owns a memory arena. All
+* objects, arrays and strings created in or set into the new array, directly
+* or indirectly, are allocated from the arena, and freed at once when the new
+* array is destroyed.
+*
+* @retval non-NULL A pointer to the new JSON array.
+* @retval NULL Failed in creation and an error code is set.
+*******************************************************************************/
+QN_SDK qn_json_array_ptr qn_json_create_array_in_arena(void)
+{
+    qn_json_array_ptr new_arr;
+    qn_json_arena_ptr arena = qn_json_arena_create();
+    if (!arena) return NULL;
+
+    if (! (new_arr = qn_json_arr_create(arena))) {
+        qn_json_arena_destroy(arena);
         return NULL;
     } // if
-
-    new_arr->itm = &new_arr->init_itm[0];
-    new_arr->cap = sizeof(new_arr->init_itm) / sizeof(new_arr->init_itm[0]);
+    arena->owner = new_arr;
     return new_arr;
 }
 
@@ -219,11 +566,19 @@ QN_SDK qn_json_array_ptr qn_json_create_array(void)
 *******************************************************************************/
 QN_SDK void qn_json_destroy_array(qn_json_array_ptr restrict arr)
 {
+    qn_json_arena_ptr arena = arr->arena;
     qn_json_pos i;
 
-    for (i = arr->begin; i < arr->end; i += 1) {
-        qn_json_destroy_element(arr->itm[i].class, &arr->itm[i].elem);
-    } // for
+    if (!arena || arena->foreign) {
+        for (i = arr->begin; i < arr->end; i += 1) {
+            qn_json_destroy_element(arena, arr->itm[i].class, &arr->itm[i].elem);
+        } // for
+    } // if
+    if (arena) {
+        if (arena->owner == arr) qn_json_arena_destroy(arena);
+        return;
+    } // if
+
     if (arr->itm != &arr->init_itm[0]) free(arr->itm);
     free(arr);
 }
@@ -237,12 +592,21 @@ enum
 static qn_bool qn_json_arr_augment(qn_json_array_ptr restrict arr, int direct)
 {
     qn_json_pos new_cap = arr->cap * 2;
-    qn_json_arr_item * new_itm = calloc(1, sizeof(qn_json_arr_item) * new_cap);
-    if (!new_itm) {
-        qn_err_set_out_of_memory();
+    qn_json_arr_item * new_itm;
+
+    if (arr->cap >= QN_JSON_MAX_CAPACITY) {
+        qn_err_set_overflow_upper_bound();
         return qn_false;
     } // if
 
+    if (direct == QN_JSON_ARR_PUSHING && arr->arena && arr->itm != &arr->init_itm[0] && qn_json_arena_extend(arr->arena, arr->itm, sizeof(qn_json_arr_item) * arr->cap, sizeof(qn_json_arr_item) * new_cap)) {
+        arr->cap = new_cap;
+        return qn_true;
+    } // if
+
+    new_itm = qn_json_allocate(arr->arena, sizeof(qn_json_arr_item) * new_cap);
+    if (!new_itm) return qn_false;
+
     if (direct == QN_JSON_ARR_PUSHING) {
         memcpy(new_itm + arr->begin, arr->itm + arr->begin, sizeof(qn_json_arr_item) * arr->cnt);
     } else {
@@ -250,7 +614,7 @@ static qn_bool qn_json_arr_augment(qn_json_array_ptr restrict arr, int direct)
         arr->begin += arr->cap;
         arr->end += arr->cap;
     } // if
-    if (arr->itm != &arr->init_itm[0]) free(arr->itm);
+    if (arr->itm != &arr->init_itm[0]) qn_json_deallocate(arr->arena, arr->itm);
 
     arr->itm = new_itm;
     arr->cap = new_cap;
@@ -264,6 +628,37 @@ static inline qn_json_pos qn_json_arr_find(qn_json_array_ptr restrict arr, int n
 
 // ---- Inplementation of JSON ----
 
+static qn_bool qn_json_obj_set(qn_json_object_ptr restrict obj, const char * restrict key, qn_json_class cls, qn_json_variant new_elem);
+static qn_bool qn_json_arr_push(qn_json_array_ptr restrict arr, qn_json_class cls, qn_json_variant new_elem);
+static qn_bool qn_json_arr_unshift(qn_json_array_ptr restrict arr, qn_json_class cls, qn_json_variant new_elem);
+static qn_bool qn_json_arr_replace(qn_json_array_ptr restrict arr, int n, qn_json_class cls, qn_json_variant new_elem);
+
+// -- Prepare an element given by the caller to be put into a container in the arena. The string is copied into
+//    the arena, and the original one must be destroyed after the element is put in successfully.
+static qn_bool qn_json_prepare_element(qn_json_arena_ptr restrict arena, qn_json_class cls, qn_json_variant_ptr restrict elem, qn_string * restrict orig_str)
+{
+    *orig_str = NULL;
+    if (!arena) return qn_true;
+
+    switch (cls) {
+        case QN_JSON_STRING:
+            *orig_str = elem->string;
+            return (elem->string = qn_json_clone_text(arena, *orig_str, qn_str_size(*orig_str))) != NULL;
+
+        case QN_JSON_OBJECT:
+            if (elem->object->arena != arena) arena->foreign = qn_true;
+            break;
+
+        case QN_JSON_ARRAY:
+            if (elem->array->arena != arena) arena->foreign = qn_true;
+            break;
+
+        default:
+            break;
+    } // switch
+    return qn_true;
+}
+
 /***************************************************************************//**
 * @ingroup JSON-Object
 *
@@ -277,8 +672,8 @@ static inline qn_json_pos qn_json_arr_find(qn_json_array_ptr restrict arr, int n
 QN_SDK qn_json_object_ptr qn_json_create_and_set_object(qn_json_object_ptr restrict obj, const char * restrict key)
 {
     qn_json_variant new_elem;
-    new_elem.object = qn_json_create_object();
-    if (new_elem.object && ! qn_json_set_variant(obj, key, QN_JSON_OBJECT, new_elem)) {
+    new_elem.object = qn_json_obj_create(obj->arena);
+    if (new_elem.object && ! qn_json_obj_set(obj, key, QN_JSON_OBJECT, new_elem)) {
         qn_json_destroy_object(new_elem.object);
         return NULL;
     } // if
@@ -298,8 +693,8 @@ QN_SDK qn_json_object_ptr qn_json_create_and_set_object(qn_json_object_ptr restr
 QN_SDK qn_json_array_ptr qn_json_create_and_set_array(qn_json_object_ptr restrict obj, const char * restrict key)
 {
     qn_json_variant new_elem;
-    new_elem.array = qn_json_create_array();
-    if (new_elem.array && ! qn_json_set_variant(obj, key, QN_JSON_ARRAY, new_elem)) {
+    new_elem.array = qn_json_arr_create(obj->arena);
+    if (new_elem.array && ! qn_json_obj_set(obj, key, QN_JSON_ARRAY, new_elem)) {
         qn_json_destroy_array(new_elem.array);
         return NULL;
     } // if
@@ -318,8 +713,8 @@ QN_SDK qn_json_array_ptr qn_json_create_and_set_array(qn_json_object_ptr restric
 QN_SDK qn_json_object_ptr qn_json_create_and_push_object(qn_json_array_ptr restrict arr)
 {
     qn_json_variant new_elem;
-    new_elem.object = qn_json_create_object();
-    if (new_elem.object && ! qn_json_push_variant(arr, QN_JSON_OBJECT, new_elem)) {
+    new_elem.object = qn_json_obj_create(arr->arena);
+    if (new_elem.object && ! qn_json_arr_push(arr, QN_JSON_OBJECT, new_elem)) {
         qn_json_destroy_object(new_elem.object);
         return NULL;
     } // if
@@ -338,8 +733,8 @@ QN_SDK qn_json_object_ptr qn_json_create_and_push_object(qn_json_array_ptr restr
 QN_SDK qn_json_array_ptr qn_json_create_and_push_array(qn_json_array_ptr restrict arr)
 {
     qn_json_variant new_elem;
-    new_elem.array = qn_json_create_array();
-    if (new_elem.array && ! qn_json_push_variant(arr, QN_JSON_ARRAY, new_elem)) {
+    new_elem.array = qn_json_arr_create(arr->arena);
+    if (new_elem.array && ! qn_json_arr_push(arr, QN_JSON_ARRAY, new_elem)) {
         qn_json_destroy_array(new_elem.array);
         return NULL;
     } // if
@@ -358,8 +753,8 @@ QN_SDK qn_json_array_ptr qn_json_create_and_push_array(qn_json_array_ptr restric
 QN_SDK qn_json_object_ptr qn_json_create_and_unshift_object(qn_json_array_ptr restrict arr)
 {
     qn_json_variant new_elem;
-    new_elem.object = qn_json_create_object();
-    if (new_elem.object && ! qn_json_unshift_variant(arr, QN_JSON_OBJECT, new_elem)) {
+    new_elem.object = qn_json_obj_create(arr->arena);
+    if (new_elem.object && ! qn_json_arr_unshift(arr, QN_JSON_OBJECT, new_elem)) {
         qn_json_destroy_object(new_elem.object);
         return NULL;
     } // if
@@ -378,8 +773,8 @@ QN_SDK qn_json_object_ptr qn_json_create_and_unshift_object(qn_json_array_ptr re
 QN_SDK qn_json_array_ptr qn_json_create_and_unshift_array(qn_json_array_ptr restrict arr)
 {
     qn_json_variant new_elem;
-    new_elem.array = qn_json_create_array();
-    if (new_elem.array && ! qn_json_unshift_variant(arr, QN_JSON_ARRAY, new_elem)) {
+    new_elem.array = qn_json_arr_create(arr->arena);
+    if (new_elem.array && ! qn_json_arr_unshift(arr, QN_JSON_ARRAY, new_elem)) {
         qn_json_destroy_array(new_elem.array);
         return NULL;
     } // if
@@ -414,11 +809,10 @@ QN_SDK int qn_json_size_array(qn_json_array_ptr restrict arr)
 
 QN_SDK qn_json_variant_ptr qn_json_get_variant(qn_json_object_ptr restrict obj, const char * restrict key, qn_json_class cls)
 {
-    int existence;
     qn_json_pos pos;
     if (obj->cnt == 0) return NULL;
-    pos = qn_json_obj_bsearch(obj->itm, obj->cnt, key, &existence);
-    return (existence != 0 || obj->itm[pos].class != cls) ? NULL : &obj->itm[pos].elem;
+    pos = qn_json_obj_find(obj, key, qn_json_obj_calculate_hash(key));
+    return (pos == obj->cnt || obj->itm[pos].class != cls) ? NULL : &obj->itm[pos].elem;
 }
 
 QN_SDK qn_json_variant_ptr qn_json_pick_variant(qn_json_array_ptr restrict arr, int n, qn_json_class cls)
@@ -429,11 +823,11 @@ QN_SDK qn_json_variant_ptr qn_json_pick_variant(qn_json_array_ptr restrict arr,
     return (pos == arr->cnt || arr->itm[pos].class != cls) ? NULL : &arr->itm[pos].elem;
 }
 
-QN_SDK qn_bool qn_json_set_variant(qn_json_object_ptr restrict obj, const char * restrict key, qn_json_class cls, qn_json_variant new_elem)
+static qn_bool qn_json_obj_set(qn_json_object_ptr restrict obj, const char * restrict key, qn_json_class cls, qn_json_variant new_elem)
 {
     qn_json_pos pos;
+    qn_json_hash hash;
     qn_string new_key;
-    int existence;
 
     assert(obj);
     assert(key);
@@ -443,25 +837,63 @@ QN_SDK qn_bool qn_json_set_variant(qn_json_object_ptr restrict obj, const char *
         return qn_false;
     } // if
 
-    pos = qn_json_obj_bsearch(obj->itm, obj->cnt, key, &existence);
-    if (existence == 0) {
+    hash = qn_json_obj_calculate_hash(key);
+    pos = qn_json_obj_find(obj, key, hash);
+    if (pos < obj->cnt) {
         // There is an element according to the given key.
-        qn_json_destroy_element(obj->itm[pos].class, &obj->itm[pos].elem);
+        qn_json_destroy_element(obj->arena, obj->itm[pos].class, &obj->itm[pos].elem);
         obj->itm[pos].class = cls;
         obj->itm[pos].elem = new_elem;
         return qn_true;
     } // if
 
     if ((obj->cap - obj->cnt) <= 0 && !qn_json_obj_augment(obj)) return qn_false;
-    if (!(new_key = qn_cs_duplicate(key))) return qn_false;
+    if (!(new_key = qn_json_clone_text(obj->arena, key, strlen(key)))) return qn_false;
 
-    if (pos < obj->cnt) memmove(&obj->itm[pos+1], &obj->itm[pos], sizeof(qn_json_obj_item) * (obj->cnt - pos));
+    // -- Keys are usually set in order, so the object stays sorted in most cases.
+    if (obj->sorted && pos > 0 && strcmp(obj->itm[pos - 1].key, new_key) > 0) obj->sorted = qn_false;
 
     obj->itm[pos].class = cls;
     obj->itm[pos].key = new_key;
+    obj->itm[pos].hash = hash;
     obj->itm[pos].elem = new_elem;
 
     obj->cnt += 1;
+    if (obj->idx) qn_json_obj_index_insert(obj, pos);
+    return qn_true;
+}
+
+QN_SDK qn_bool qn_json_set_variant(qn_json_object_ptr restrict obj, const char * restrict key, qn_json_class cls, qn_json_variant new_elem)
+{
+    qn_string orig_str;
+
+    if (!qn_json_prepare_element(obj->arena, cls, &new_elem, &orig_str)) return qn_false;
+    if (!qn_json_obj_set(obj, key, cls, new_elem)) return qn_false;
+    if (orig_str) qn_str_destroy(orig_str);
+    return qn_true;
+}
+
+/***************************************************************************//**
+* @ingroup JSON-Object
+*
+* Create a new string from the given text and then set it as an element into
+* the target object.
+*
+* @param [in] obj The non-NULL pointer to the target object.
+* @param [in] key The key of the new string.
+* @param [in] val The text of the new string.
+* @param [in] size The size of the text.
+* @retval qn_true Succeeded in creation and setting.
+* @retval qn_false Failed in creation or setting, and an error code is set.
+*******************************************************************************/
+QN_SDK qn_bool qn_json_set_text(qn_json_object_ptr restrict obj, const char * restrict key, const char * restrict val, qn_size size)
+{
+    qn_json_variant new_elem;
+    if (! (new_elem.string = qn_json_clone_text(obj->arena, val, size))) return qn_false;
+    if (! qn_json_obj_set(obj, key, QN_JSON_STRING, new_elem)) {
+        qn_json_destroy_text(obj->arena, new_elem.string);
+        return qn_false;
+    } // if
     return qn_true;
 }
 
@@ -477,26 +909,23 @@ QN_SDK qn_bool qn_json_set_variant(qn_json_object_ptr restrict obj, const char *
 QN_SDK void qn_json_unset(qn_json_object_ptr restrict obj, const char * restrict key)
 {
     qn_json_pos pos;
-    int existence;
 
     if (obj->cnt == 0) return;
 
-    pos = qn_json_obj_bsearch(obj->itm, obj->cnt, key, &existence);
-    if (existence != 0) return; // There is no element corresponds to the key.
+    pos = qn_json_obj_find(obj, key, qn_json_obj_calculate_hash(key));
+    if (pos == obj->cnt) return; // There is no element corresponds to the key.
 
-    qn_json_destroy_element(obj->itm[pos].class, &obj->itm[pos].elem);
-    qn_str_destroy(obj->itm[pos].key);
-    if (pos < obj->cnt - 1) memmove(&obj->itm[pos], &obj->itm[pos+1], sizeof(qn_json_obj_item) * (obj->cnt - pos - 1));
-    obj->cnt -= 1;
+    qn_json_destroy_element(obj->arena, obj->itm[pos].class, &obj->itm[pos].elem);
+    qn_json_destroy_text(obj->arena, obj->itm[pos].key);
+    qn_json_obj_remove_item(obj, pos);
 }
 
 QN_SDK qn_bool qn_json_rename(qn_json_object_ptr restrict obj, const char * restrict old_key, const char * new_key)
 {
     qn_json_pos old_pos;
     qn_json_pos new_pos;
-    qn_json_obj_item tmp_item;
+    qn_json_hash new_hash;
     qn_string new_key_str;
-    int existence;
 
     if (obj->cnt == 0) {
         qn_err_set_no_such_entry();
@@ -505,56 +934,46 @@ QN_SDK qn_bool qn_json_rename(qn_json_object_ptr restrict obj, const char * rest
 
     if (strcmp(old_key, new_key) == 0) return qn_true; // The old key is exactly the same to the new key.
 
-    old_pos = qn_json_obj_bsearch(obj->itm, obj->cnt, old_key, &existence);
-    if (existence != 0) {
+    old_pos = qn_json_obj_find(obj, old_key, qn_json_obj_calculate_hash(old_key));
+    if (old_pos == obj->cnt) {
         // ---- There is no element corresponds to the old key.
         qn_err_set_no_such_entry();
         return qn_false;
     } // if
 
-    new_pos = qn_json_obj_bsearch(obj->itm, obj->cnt, new_key, &existence);
-    if (existence == 0) {
+    new_hash = qn_json_obj_calculate_hash(new_key);
+    new_pos = qn_json_obj_find(obj, new_key, new_hash);
+    if (new_pos < obj->cnt) {
         // ---- There is an element corresponds to the new key.
         // -- Destroy the element to be replaced.
-        qn_json_destroy_element(obj->itm[new_pos].class, &obj->itm[new_pos].elem);
+        qn_json_destroy_element(obj->arena, obj->itm[new_pos].class, &obj->itm[new_pos].elem);
 
         // -- Replace the element.
         obj->itm[new_pos].class = obj->itm[old_pos].class;
         obj->itm[new_pos].elem = obj->itm[old_pos].elem;
 
         // -- Destroy the old key.
-        qn_str_destroy(obj->itm[old_pos].key);
-
-        if (old_pos < obj->cnt - 1) memmove(&obj->itm[old_pos], &obj->itm[old_pos+1], sizeof(qn_json_obj_item) * (obj->cnt - old_pos - 1));
-        obj->cnt -= 1;
-
+        qn_json_destroy_text(obj->arena, obj->itm[old_pos].key);
+        qn_json_obj_remove_item(obj, old_pos);
         return qn_true;
     } // if
 
     // ---- There is no element corresponds to the new key.
     // -- Replace the old key.
-    new_key_str = qn_cs_duplicate(new_key);
+    new_key_str = qn_json_clone_text(obj->arena, new_key, strlen(new_key));
     if (!new_key_str) return qn_false;
 
-    qn_str_destroy(obj->itm[old_pos].key);
+    if (obj->idx) qn_json_obj_index_remove(obj, old_pos);
+    qn_json_destroy_text(obj->arena, obj->itm[old_pos].key);
     obj->itm[old_pos].key = new_key_str;
+    obj->itm[old_pos].hash = new_hash;
+    if (obj->idx) qn_json_obj_index_insert(obj, old_pos);
 
-    if (old_pos == new_pos) return qn_true; // -- The two keys reside in the same position.
-
-    tmp_item = obj->itm[old_pos];
-    if (old_pos < new_pos) {
-        // -- The old key resides in a position before the new key.
-        new_pos -= 1;
-        if (old_pos < new_pos) memmove(&obj->itm[old_pos], &obj->itm[old_pos+1], sizeof(qn_json_obj_item) * (new_pos - old_pos));
-    } else {
-        // -- The old key resides in a position after the new key.
-        memmove(&obj->itm[new_pos+1], &obj->itm[new_pos], sizeof(qn_json_obj_item) * (old_pos - new_pos));
-    } // if
-    obj->itm[new_pos] = tmp_item;
+    obj->sorted = qn_false;
     return qn_true;
 }
 
-QN_SDK qn_bool qn_json_push_variant(qn_json_array_ptr restrict arr, qn_json_class cls, qn_json_variant new_elem)
+static qn_bool qn_json_arr_push(qn_json_array_ptr restrict arr, qn_json_class cls, qn_json_variant new_elem)
 {
     assert(arr);
 
@@ -572,6 +991,38 @@ QN_SDK qn_bool qn_json_push_variant(qn_json_array_ptr restrict arr, qn_json_clas
     return qn_true;
 }
 
+QN_SDK qn_bool qn_json_push_variant(qn_json_array_ptr restrict arr, qn_json_class cls, qn_json_variant new_elem)
+{
+    qn_string orig_str;
+
+    if (!qn_json_prepare_element(arr->arena, cls, &new_elem, &orig_str)) return qn_false;
+    if (!qn_json_arr_push(arr, cls, new_elem)) return qn_false;
+    if (orig_str) qn_str_destroy(orig_str);
+    return qn_true;
+}
+
+/***************************************************************************//**
+* @ingroup JSON-Array
+*
+* Create a new string from the given text and then push it as an element into the target array.
+*
+* @param [in] arr The non-NULL pointer to the target array.
+* @param [in] val The text of the new string.
+* @param [in] size The size of the text.
+* @retval qn_true Succeeded in creation and pushing.
+* @retval qn_false Failed in creation or pushing, and an error code is set.
+*******************************************************************************/
+QN_SDK qn_bool qn_json_push_text(qn_json_array_ptr restrict arr, const char * restrict val, qn_size size)
+{
+    qn_json_variant new_elem;
+    if (! (new_elem.string = qn_json_clone_text(arr->arena, val, size))) return qn_false;
+    if (! qn_json_arr_push(arr, QN_JSON_STRING, new_elem)) {
+        qn_json_destroy_text(arr->arena, new_elem.string);
+        return qn_false;
+    } // if
+    return qn_true;
+}
+
 /***************************************************************************//**
 * @ingroup JSON-Array
 *
@@ -584,12 +1035,12 @@ QN_SDK void qn_json_pop(qn_json_array_ptr restrict arr)
 {
     if (arr->cnt > 0) {
         arr->end -= 1;
-        qn_json_destroy_element(arr->itm[arr->end].class, &arr->itm[arr->end].elem);
+        qn_json_destroy_element(arr->arena, arr->itm[arr->end].class, &arr->itm[arr->end].elem);
         arr->cnt -= 1;
     } // if
 }
 
-QN_SDK qn_bool qn_json_unshift_variant(qn_json_array_ptr restrict arr, qn_json_class cls, qn_json_variant new_elem)
+static qn_bool qn_json_arr_unshift(qn_json_array_ptr restrict arr, qn_json_class cls, qn_json_variant new_elem)
 {
     assert(arr);
 
@@ -607,6 +1058,38 @@ QN_SDK qn_bool qn_json_unshift_variant(qn_json_array_ptr restrict arr, qn_json_c
     return qn_true;
 }
 
+QN_SDK qn_bool qn_json_unshift_variant(qn_json_array_ptr restrict arr, qn_json_class cls, qn_json_variant new_elem)
+{
+    qn_string orig_str;
+
+    if (!qn_json_prepare_element(arr->arena, cls, &new_elem, &orig_str)) return qn_false;
+    if (!qn_json_arr_unshift(arr, cls, new_elem)) return qn_false;
+    if (orig_str) qn_str_destroy(orig_str);
+    return qn_true;
+}
+
+/***************************************************************************//**
+* @ingroup JSON-Array
+*
+* Create a new string from the given text and then unshift it as an element into the target array.
+*
+* @param [in] arr The non-NULL pointer to the target array.
+* @param [in] val The text of the new string.
+* @param [in] size The size of the text.
+* @retval qn_true Succeeded in creation and unshifting.
+* @retval qn_false Failed in creation or unshifting, and an error code is set.
+*******************************************************************************/
+QN_SDK qn_bool qn_json_unshift_text(qn_json_array_ptr restrict arr, const char * restrict val, qn_size size)
+{
+    qn_json_variant new_elem;
+    if (! (new_elem.string = qn_json_clone_text(arr->arena, val, size))) return qn_false;
+    if (! qn_json_arr_unshift(arr, QN_JSON_STRING, new_elem)) {
+        qn_json_destroy_text(arr->arena, new_elem.string);
+        return qn_false;
+    } // if
+    return qn_true;
+}
+
 /***************************************************************************//**
 * @ingroup JSON-Array
 *
@@ -618,13 +1101,13 @@ QN_SDK qn_bool qn_json_unshift_variant(qn_json_array_ptr restrict arr, qn_json_c
 QN_SDK void qn_json_shift(qn_json_array_ptr restrict arr)
 {
     if (arr->cnt > 0) {
-        qn_json_destroy_element(arr->itm[arr->begin].class, &arr->itm[arr->begin].elem);
+        qn_json_destroy_element(arr->arena, arr->itm[arr->begin].class, &arr->itm[arr->begin].elem);
         arr->begin += 1;
         arr->cnt -= 1;
     } // if
 }
 
-QN_SDK qn_bool qn_json_replace_variant(qn_json_array_ptr restrict arr, int n, qn_json_class cls, qn_json_variant new_elem)
+static qn_bool qn_json_arr_replace(qn_json_array_ptr restrict arr, int n, qn_json_class cls, qn_json_variant new_elem)
 {
     assert(arr);
     assert(0 <= n);
@@ -639,12 +1122,45 @@ QN_SDK qn_bool qn_json_replace_variant(qn_json_array_ptr restrict arr, int n, qn
         return qn_false;
     } // if
 
-    qn_json_destroy_element(arr->itm[arr->begin + n].class, &arr->itm[arr->begin + n].elem);
+    qn_json_destroy_element(arr->arena, arr->itm[arr->begin + n].class, &arr->itm[arr->begin + n].elem);
     arr->itm[arr->begin + n].elem = new_elem;
     arr->itm[arr->begin + n].class = cls;
     return qn_true;
 }
 
+QN_SDK qn_bool qn_json_replace_variant(qn_json_array_ptr restrict arr, int n, qn_json_class cls, qn_json_variant new_elem)
+{
+    qn_string orig_str;
+
+    if (!qn_json_prepare_element(arr->arena, cls, &new_elem, &orig_str)) return qn_false;
+    if (!qn_json_arr_replace(arr, n, cls, new_elem)) return qn_false;
+    if (orig_str) qn_str_destroy(orig_str);
+    return qn_true;
+}
+
+/***************************************************************************//**
+* @ingroup JSON-Array
+*
+* Create a new string from the given text and then replace the n-th element of the target array with it.
+*
+* @param [in] arr The non-NULL pointer to the target array.
+* @param [in] n The index of the element to replace.
+* @param [in] val The text of the new string.
+* @param [in] size The size of the text.
+* @retval qn_true Succeeded in creation and replacing.
+* @retval qn_false Failed in creation or replacing, and an error code is set.
+*******************************************************************************/
+QN_SDK qn_bool qn_json_replace_text(qn_json_array_ptr restrict arr, int n, const char * restrict val, qn_size size)
+{
+    qn_json_variant new_elem;
+    if (! (new_elem.string = qn_json_clone_text(arr->arena, val, size))) return qn_false;
+    if (! qn_json_arr_replace(arr, n, QN_JSON_STRING, new_elem)) {
+        qn_json_destroy_text(arr->arena, new_elem.string);
+        return qn_false;
+    } // if
+    return qn_true;
+}
+
 // ---- Inplementation of iterator of JSON ----
 
 typedef struct _QN_JSON_ITR_LEVEL
@@ -798,6 +1314,9 @@ QN_SDK qn_bool qn_json_itr_push_object(qn_json_iterator_ptr restrict itr, qn_jso
 {
     if ((itr->cnt + 1) > itr->cap && !qn_json_itr_augment_levels(itr)) return qn_false;
 
+    // -- Iterate pairs in the order of keys.
+    qn_json_obj_sort(obj);
+
     itr->lvl[itr->cnt].class = QN_JSON_OBJECT;
     itr->lvl[itr->cnt].parent.object = obj;
     itr->cnt += 1;
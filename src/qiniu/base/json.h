@@ -31,7 +31,7 @@ extern "C"
 *
 * The **qn_json_object_ptr** type represents a JSON object. Use this type to
 * collect a set of pairs of key and value. The maximum quantity of pairs is
-* 65535.
+* 2^30.
 *******************************************************************************/
 
 struct _QN_JSON_OBJECT;
@@ -41,7 +41,7 @@ typedef struct _QN_JSON_OBJECT * qn_json_object_ptr;
 * @defgroup JSON-Array Implementation of JSON Array
 *
 * The **qn_json_array_ptr** type represents a JSON array. Use this type to
-* collect a list of values. The maximum quantity of values is 65535.
+* collect a list of values. The maximum quantity of values is 2^30.
 * This type can be used as a **bidirectional queue**.
 *******************************************************************************/
 
@@ -85,6 +85,7 @@ typedef union _QN_JSON_VARIANT
 
 QN_SDK extern qn_json_object_ptr qn_json_immutable_empty_object(void);
 QN_SDK extern qn_json_object_ptr qn_json_create_object(void);
+QN_SDK extern qn_json_object_ptr qn_json_create_object_in_arena(void);
 QN_SDK extern qn_json_object_ptr qn_json_create_and_set_object(qn_json_object_ptr restrict obj, const char * restrict key);
 QN_SDK extern qn_json_array_ptr qn_json_create_and_set_array(qn_json_object_ptr restrict obj, const char * restrict key);
 QN_SDK extern void qn_json_destroy_object(qn_json_object_ptr restrict obj);
@@ -160,37 +161,16 @@ static inline qn_bool qn_json_set_array(qn_json_object_ptr restrict obj, const c
     return qn_json_set_variant(obj, key, QN_JSON_ARRAY, new_elem);
 }
 
+QN_SDK extern qn_bool qn_json_set_text(qn_json_object_ptr restrict obj, const char * restrict key, const char * restrict val, qn_size size);
+
 static inline qn_bool qn_json_set_string(qn_json_object_ptr restrict obj, const char * restrict key, qn_string restrict val)
 {
-    qn_json_variant new_elem;
-    if (! (new_elem.string = qn_str_duplicate(val))) return qn_false;
-    if (! qn_json_set_variant(obj, key, QN_JSON_STRING, new_elem)) {
-        qn_str_destroy(new_elem.string);
-        return qn_false;
-    } // if
-    return qn_true;
+    return qn_json_set_text(obj, key, val, qn_str_size(val));
 }
 
 static inline qn_bool qn_json_set_cstr(qn_json_object_ptr restrict obj, const char * restrict key, const char * restrict val)
 {
-    qn_json_variant new_elem;
-    if (! (new_elem.string = qn_cs_duplicate(val))) return qn_false;
-    if (! qn_json_set_variant(obj, key, QN_JSON_STRING, new_elem)) {
-        qn_str_destroy(new_elem.string);
-        return qn_false;
-    } // if
-    return qn_true;
-}
-
-static inline qn_bool qn_json_set_text(qn_json_object_ptr restrict obj, const char * restrict key, const char * restrict val, qn_size size)
-{
-    qn_json_variant new_elem;
-    if (! (new_elem.string = qn_cs_clone(val, size))) return qn_false;
-    if (! qn_json_set_variant(obj, key, QN_JSON_STRING, new_elem)) {
-        qn_str_destroy(new_elem.string);
-        return qn_false;
-    } // if
-    return qn_true;
+    return qn_json_set_text(obj, key, val, strlen(val));
 }
 
 static inline qn_bool qn_json_set_integer(qn_json_object_ptr restrict obj, const char * restrict key, qn_json_integer val)
@@ -231,6 +211,7 @@ QN_SDK extern qn_bool qn_json_rename(qn_json_object_ptr restrict obj, const char
 
 QN_SDK extern qn_json_array_ptr qn_json_immutable_empty_array(void);
 QN_SDK extern qn_json_array_ptr qn_json_create_array(void);
+QN_SDK extern qn_json_array_ptr qn_json_create_array_in_arena(void);
 
 QN_SDK extern qn_json_object_ptr qn_json_create_and_push_object(qn_json_array_ptr restrict arr);
 QN_SDK extern qn_json_array_ptr qn_json_create_and_push_array(qn_json_array_ptr restrict arr);
@@ -308,37 +289,16 @@ static inline qn_bool qn_json_push_array(qn_json_array_ptr restrict arr, qn_json
     return qn_json_push_variant(arr, QN_JSON_ARRAY, new_elem);
 }
 
+QN_SDK extern qn_bool qn_json_push_text(qn_json_array_ptr restrict arr, const char * restrict val, qn_size size);
+
 static inline qn_bool qn_json_push_string(qn_json_array_ptr restrict arr, qn_string restrict val)
 {
-    qn_json_variant new_elem;
-    if (! (new_elem.string = qn_str_duplicate(val))) return qn_false;
-    if (! qn_json_push_variant(arr, QN_JSON_STRING, new_elem)) {
-        qn_str_destroy(new_elem.string);
-        return qn_false;
-    } // if
-    return qn_true;
+    return qn_json_push_text(arr, val, qn_str_size(val));
 }
 
 static inline qn_bool qn_json_push_cstr(qn_json_array_ptr restrict arr, const char * restrict val)
 {
-    qn_json_variant new_elem;
-    if (! (new_elem.string = qn_cs_duplicate(val))) return qn_false;
-    if (! qn_json_push_variant(arr, QN_JSON_STRING, new_elem)) {
-        qn_str_destroy(new_elem.string);
-        return qn_false;
-    } // if
-    return qn_true;
-}
-
-static inline qn_bool qn_json_push_text(qn_json_array_ptr restrict arr, const char * restrict val, qn_size size)
-{
-    qn_json_variant new_elem;
-    if (! (new_elem.string = qn_cs_clone(val, size))) return qn_false;
-    if (! qn_json_push_variant(arr, QN_JSON_STRING, new_elem)) {
-        qn_str_destroy(new_elem.string);
-        return qn_false;
-    } // if
-    return qn_true;
+    return qn_json_push_text(arr, val, strlen(val));
 }
 
 static inline qn_bool qn_json_push_integer(qn_json_array_ptr restrict arr, qn_json_integer val)
@@ -391,37 +351,16 @@ static inline qn_bool qn_json_unshift_array(qn_json_array_ptr restrict arr, qn_j
     return qn_json_unshift_variant(arr, QN_JSON_ARRAY, new_elem);
 }
 
+QN_SDK extern qn_bool qn_json_unshift_text(qn_json_array_ptr restrict arr, const char * restrict val, qn_size size);
+
 static inline qn_bool qn_json_unshift_string(qn_json_array_ptr restrict arr, qn_string restrict val)
 {
-    qn_json_variant new_elem;
-    if (! (new_elem.string = qn_str_duplicate(val))) return qn_false;
-    if (! qn_json_unshift_variant(arr, QN_JSON_STRING, new_elem)) {
-        qn_str_destroy(new_elem.string);
-        return qn_false;
-    } // if
-    return qn_true;
+    return qn_json_unshift_text(arr, val, qn_str_size(val));
 }
 
 static inline qn_bool qn_json_unshift_cstr(qn_json_array_ptr restrict arr, const char * restrict val)
 {
-    qn_json_variant new_elem;
-    if (! (new_elem.string = qn_cs_duplicate(val))) return qn_false;
-    if (! qn_json_unshift_variant(arr, QN_JSON_STRING, new_elem)) {
-        qn_str_destroy(new_elem.string);
-        return qn_false;
-    } // if
-    return qn_true;
-}
-
-static inline qn_bool qn_json_unshift_text(qn_json_array_ptr restrict arr, const char * restrict val, qn_size size)
-{
-    qn_json_variant new_elem;
-    if (! (new_elem.string = qn_cs_clone(val, size))) return qn_false;
-    if (! qn_json_unshift_variant(arr, QN_JSON_STRING, new_elem)) {
-        qn_str_destroy(new_elem.string);
-        return qn_false;
-    } // if
-    return qn_true;
+    return qn_json_unshift_text(arr, val, strlen(val));
 }
 
 static inline qn_bool qn_json_unshift_integer(qn_json_array_ptr restrict arr, qn_json_integer val)
@@ -474,37 +413,16 @@ static inline qn_bool qn_json_replace_array(qn_json_array_ptr restrict arr, int
     return qn_json_replace_variant(arr, n, QN_JSON_ARRAY, new_elem);
 }
 
+QN_SDK extern qn_bool qn_json_replace_text(qn_json_array_ptr restrict arr, int n, const char * restrict val, qn_size size);
+
 static inline qn_bool qn_json_replace_string(qn_json_array_ptr restrict arr, int n, qn_string restrict val)
 {
-    qn_json_variant new_elem;
-    if (! (new_elem.string = qn_str_duplicate(val))) return qn_false;
-    if (! qn_json_replace_variant(arr, n, QN_JSON_STRING, new_elem)) {
-        qn_str_destroy(new_elem.string);
-        return qn_false;
-    } // if
-    return qn_true;
+    return qn_json_replace_text(arr, n, val, qn_str_size(val));
 }
 
 static inline qn_bool qn_json_replace_cstr(qn_json_array_ptr restrict arr, int n, const char * restrict val)
 {
-    qn_json_variant new_elem;
-    if (! (new_elem.string = qn_cs_duplicate(val))) return qn_false;
-    if (! qn_json_replace_variant(arr, n, QN_JSON_STRING, new_elem)) {
-        qn_str_destroy(new_elem.string);
-        return qn_false;
-    } // if
-    return qn_true;
-}
-
-static inline qn_bool qn_json_replace_text(qn_json_array_ptr restrict arr, int n, const char * restrict val, qn_size size)
-{
-    qn_json_variant new_elem;
-    if (! (new_elem.string = qn_cs_clone(val, size))) return qn_false;
-    if (! qn_json_replace_variant(arr, n, QN_JSON_STRING, new_elem)) {
-        qn_str_destroy(new_elem.string);
-        return qn_false;
-    } // if
-    return qn_true;
+    return qn_json_replace_text(arr, n, val, strlen(val));
 }
 
 static inline qn_bool qn_json_replace_integer(qn_json_array_ptr restrict arr, int n, qn_json_integer val)
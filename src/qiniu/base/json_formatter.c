@@ -33,6 +33,7 @@ typedef struct _QN_JSON_FORMATTER {
 
     qn_string string;
     qn_size string_pos;
+    qn_size string_size;
     qn_json_class class;
     qn_json_variant val;
 
@@ -109,12 +110,16 @@ static qn_bool qn_json_fmt_format_string(qn_json_formatter_ptr fmt)
 
     qn_size free_size;
     qn_size pos = fmt->string_pos;
-    qn_size end = qn_str_size(fmt->string);
+    qn_size end;
     const char * str = qn_str_cstr(fmt->string);
     int chars = 0;
     int ret = 0;
     qn_uint32 wch = 0;
 
+    // -- A long string may be formatted into several buffers, so measure it only when starting.
+    if (pos == 0) fmt->string_size = qn_str_size(fmt->string);
+    end = fmt->string_size;
+
     if (pos == 0 && !qn_json_fmt_putc(fmt, '"')) goto FORMATTING_STRING_FAILED;
 
     while (pos < end) {
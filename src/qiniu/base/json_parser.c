@@ -6,9 +6,11 @@
 #include <limits.h>
 #include <errno.h>
 #include <assert.h>
+#include <time.h>
 
 #include "qiniu/base/errors.h"
 #include "qiniu/base/json_parser.h"
+#include "qiniu/base/metrics.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -543,6 +545,15 @@ typedef struct _QN_JSON_PARSER
 {
     qn_json_scanner s;
     qn_json_variant elem;
+    qn_bool own_root;
+    qn_bool use_arena;
+
+    void * evt_data;
+    qn_json_prs_event_cfn evt_cfn;
+
+    // -- Only the key of the level on the top of the stack is pending, so one buffer is enough for all levels.
+    char * key;
+    qn_size key_cap;
 
     int cnt;
     int cap;
@@ -565,21 +576,23 @@ QN_SDK qn_json_parser_ptr qn_json_prs_create(void)
 
 static void qn_json_prs_reset(qn_json_parser_ptr restrict prs)
 {
-    while (prs->cnt > 0) {
-        prs->cnt -= 1;
-        if (prs->lvl[prs->cnt].class == QN_JSON_OBJECT) {
-            qn_json_destroy_object(prs->lvl[prs->cnt].elem.object);
-            qn_str_destroy(prs->lvl[prs->cnt].key);
-        } else {
-            qn_json_destroy_array(prs->lvl[prs->cnt].elem.array);
-        } // if
-    } // while
+    // -- All elements on the stack are held by the root, so none of them should be destroyed here.
+    prs->cnt = 0;
 }
 
 QN_SDK void qn_json_prs_destroy(qn_json_parser_ptr restrict prs)
 {
     if (prs) {
+        if (prs->cnt > 0 && prs->own_root) {
+            // -- Destroy the unfinished root created by the parser itself.
+            if (prs->lvl[0].class == QN_JSON_OBJECT) {
+                qn_json_destroy_object(prs->lvl[0].elem.object);
+            } else {
+                qn_json_destroy_array(prs->lvl[0].elem.array);
+            } // if
+        } // if
         qn_json_prs_reset(prs);
+        free(prs->key);
         if (prs->lvl != &prs->init_lvl[0]) {
             free(prs->lvl);
         } // if
@@ -614,6 +627,28 @@ static qn_bool qn_json_prs_push(qn_json_parser_ptr prs, qn_json_class cls, qn_js
     return qn_true;
 }
 
+static qn_string qn_json_prs_hold_key(qn_json_parser_ptr prs, const char * txt, qn_size txt_size)
+{
+    qn_size new_cap;
+    char * new_key;
+
+    if (prs->key_cap < txt_size + 1) {
+        for (new_cap = (prs->key_cap > 0) ? prs->key_cap : 64; new_cap < txt_size + 1; new_cap *= 2) {
+        } // for
+        new_key = realloc(prs->key, new_cap);
+        if (!new_key) {
+            qn_err_set_out_of_memory();
+            return NULL;
+        } // if
+        prs->key = new_key;
+        prs->key_cap = new_cap;
+    } // if
+
+    memcpy(prs->key, txt, txt_size);
+    prs->key[txt_size] = '\0';
+    return prs->key;
+}
+
 static inline void qn_json_prs_pop(qn_json_parser_ptr prs)
 {
     if (prs->cnt > 0) prs->cnt -= 1;
@@ -631,125 +666,83 @@ static inline qn_bool qn_json_prs_is_empty(qn_json_parser_ptr prs)
 
 static qn_bool qn_json_prs_put_in(qn_json_parser_ptr prs, qn_json_token tkn, char * txt, qn_size txt_size, qn_json_prs_level_ptr lvl)
 {
-    qn_integer integer = 0L;
-    qn_number number = 0.0L;
+    qn_json_class cls;
     qn_json_variant new_elem;
-    qn_json_object_ptr new_obj = NULL;
-    qn_json_array_ptr new_arr = NULL;
     char * end_txt = NULL;
 
     switch (tkn) {
         case QN_JSON_TKN_OPEN_BRACE:
-            if (prs->cnt + 1 > qn_json_prs_max_levels) {
-                qn_err_json_set_too_many_parsing_levels();
-                return qn_false;
-            } // if
-            if (lvl->class == QN_JSON_OBJECT) {
-                if (! (new_obj = qn_json_create_and_set_object(lvl->elem.object, lvl->key))) return qn_false;
-                new_elem.object = new_obj;
-                if (!qn_json_prs_push(prs, QN_JSON_OBJECT, new_elem, QN_JSON_PARSING_KEY)) return qn_false;
-                qn_str_destroy(lvl->key);
-                lvl->key = NULL;
-            } else {
-                if (! (new_obj = qn_json_create_and_push_object(lvl->elem.array)) ) return qn_false;
-                new_elem.object = new_obj;
-                if (!qn_json_prs_push(prs, QN_JSON_OBJECT, new_elem, QN_JSON_PARSING_KEY)) return qn_false;
-            }
-            return qn_true;
-
         case QN_JSON_TKN_OPEN_BRACKET:
             if (prs->cnt + 1 > qn_json_prs_max_levels) {
                 qn_err_json_set_too_many_parsing_levels();
                 return qn_false;
             } // if
-            if (lvl->class == QN_JSON_OBJECT) {
-                if (! (new_arr = qn_json_create_and_set_array(lvl->elem.object, lvl->key))) return qn_false;
-                new_elem.array = new_arr;
-                if (!qn_json_prs_push(prs, QN_JSON_ARRAY, new_elem, QN_JSON_PARSING_VALUE)) return qn_false;
-                qn_str_destroy(lvl->key);
-                lvl->key = NULL;
+
+            cls = (tkn == QN_JSON_TKN_OPEN_BRACE) ? QN_JSON_OBJECT : QN_JSON_ARRAY;
+            if (prs->evt_cfn) {
+                new_elem.object = NULL;
+                if (!(*prs->evt_cfn)(prs->evt_data, (cls == QN_JSON_OBJECT) ? QN_JSON_PRS_OPEN_OBJECT : QN_JSON_PRS_OPEN_ARRAY, lvl->key, cls, NULL)) return qn_false;
+            } else if (cls == QN_JSON_OBJECT) {
+                new_elem.object = (lvl->class == QN_JSON_OBJECT) ? qn_json_create_and_set_object(lvl->elem.object, lvl->key) : qn_json_create_and_push_object(lvl->elem.array);
+                if (!new_elem.object) return qn_false;
             } else {
-                if (! (new_arr = qn_json_create_and_push_array(lvl->elem.array)) ) return qn_false;
-                new_elem.array = new_arr;
-                if (!qn_json_prs_push(prs, QN_JSON_ARRAY, new_elem, QN_JSON_PARSING_VALUE)) return qn_false;
-            }
-            return qn_true;
+                new_elem.array = (lvl->class == QN_JSON_OBJECT) ? qn_json_create_and_set_array(lvl->elem.object, lvl->key) : qn_json_create_and_push_array(lvl->elem.array);
+                if (!new_elem.array) return qn_false;
+            } // if
+
+            // -- The level may be moved by pushing, so do not touch it afterwards.
+            lvl->key = NULL;
+            return qn_json_prs_push(prs, cls, new_elem, (cls == QN_JSON_OBJECT) ? QN_JSON_PARSING_KEY : QN_JSON_PARSING_VALUE);
 
         case QN_JSON_TKN_STRING:
-            if (lvl->class == QN_JSON_OBJECT) {
-                if (!qn_json_set_text(lvl->elem.object, lvl->key, txt, txt_size)) return qn_false;
-                qn_str_destroy(lvl->key);
-                lvl->key = NULL;
-                return qn_true;
-            }
-            return qn_json_push_text(lvl->elem.array, txt, txt_size);
+            cls = QN_JSON_STRING;
+            new_elem.string = txt;
+            break;
 
         case QN_JSON_TKN_INTEGER:
-            integer = strtoll(txt, &end_txt, 10);
+            cls = QN_JSON_INTEGER;
+            new_elem.integer = strtoll(txt, &end_txt, 10);
             if (end_txt == txt) {
                 qn_err_json_set_bad_text_input();
                 return qn_false;
             } // if
-            if ((integer == LLONG_MAX || integer == LLONG_MIN) && errno == ERANGE) {
+            if ((new_elem.integer == LLONG_MAX || new_elem.integer == LLONG_MIN) && errno == ERANGE) {
                 qn_err_set_overflow_upper_bound();
                 return qn_false;
             } // if
-            if (lvl->class == QN_JSON_OBJECT) {
-                if (!qn_json_set_integer(lvl->elem.object, lvl->key, integer)) return qn_false;
-                qn_str_destroy(lvl->key);
-                lvl->key = NULL;
-                return qn_true;
-            }
-            return qn_json_push_integer(lvl->elem.array, integer);
+            break;
 
         case QN_JSON_TKN_NUMBER:
-            number = strtold(txt, &end_txt);
+            cls = QN_JSON_NUMBER;
+            new_elem.number = strtold(txt, &end_txt);
             if (end_txt == txt) {
                 qn_err_json_set_bad_text_input();
                 return qn_false;
             } // if
-            if (number >= HUGE_VALL && number <= HUGE_VALL && errno == ERANGE) {
+            if (new_elem.number >= HUGE_VALL && new_elem.number <= HUGE_VALL && errno == ERANGE) {
                 qn_err_set_overflow_upper_bound();
                 return qn_false;
             } // if
-            if (number >= 0.0L && number <= 0.0L && errno == ERANGE) {
+            if (new_elem.number >= 0.0L && new_elem.number <= 0.0L && errno == ERANGE) {
                 qn_err_set_overflow_lower_bound();
                 return qn_false;
             } // if
-            if (lvl->class == QN_JSON_OBJECT) {
-                if (!qn_json_set_number(lvl->elem.object, lvl->key, number)) return qn_false;
-                qn_str_destroy(lvl->key);
-                lvl->key = NULL;
-                return qn_true;
-            }
-            return qn_json_push_number(lvl->elem.array, number);
+            break;
 
         case QN_JSON_TKN_TRUE:
-            if (lvl->class == QN_JSON_OBJECT) {
-                if (!qn_json_set_boolean(lvl->elem.object, lvl->key, qn_true)) return qn_false;
-                qn_str_destroy(lvl->key);
-                lvl->key = NULL;
-                return qn_true;
-            }
-            return qn_json_push_boolean(lvl->elem.array, qn_true);
+            cls = QN_JSON_BOOLEAN;
+            new_elem.boolean = qn_true;
+            break;
 
         case QN_JSON_TKN_FALSE:
-            if (lvl->class == QN_JSON_OBJECT) {
-                if (!qn_json_set_boolean(lvl->elem.object, lvl->key, qn_false)) return qn_false;
-                qn_str_destroy(lvl->key);
-                lvl->key = NULL;
-                return qn_true;
-            }
-            return qn_json_push_boolean(lvl->elem.array, qn_false);
+            cls = QN_JSON_BOOLEAN;
+            new_elem.boolean = qn_false;
+            break;
 
         case QN_JSON_TKN_NULL:
-            if (lvl->class == QN_JSON_OBJECT) {
-                if (!qn_json_set_null(lvl->elem.object, lvl->key)) return qn_false;
-                qn_str_destroy(lvl->key);
-                lvl->key = NULL;
-                return qn_true;
-            }
-            return qn_json_push_boolean(lvl->elem.array, qn_false);
+            cls = QN_JSON_NULL;
+            new_elem.integer = 0;
+            break;
 
         case QN_JSON_TKNERR_NEED_MORE_TEXT:
             qn_err_json_set_need_more_text_input();
@@ -759,6 +752,23 @@ static qn_bool qn_json_prs_put_in(qn_json_parser_ptr prs, qn_json_token tkn, cha
             qn_err_json_set_bad_text_input();
             return qn_false;
     } // switch
+
+    if (prs->evt_cfn) {
+        if (!(*prs->evt_cfn)(prs->evt_data, QN_JSON_PRS_SCALAR, lvl->key, cls, &new_elem)) return qn_false;
+    } else if (lvl->class == QN_JSON_OBJECT) {
+        if (cls == QN_JSON_STRING) {
+            if (!qn_json_set_text(lvl->elem.object, lvl->key, txt, txt_size)) return qn_false;
+        } else {
+            if (!qn_json_set_variant(lvl->elem.object, lvl->key, cls, new_elem)) return qn_false;
+        } // if
+    } else {
+        if (cls == QN_JSON_STRING) {
+            if (!qn_json_push_text(lvl->elem.array, txt, txt_size)) return qn_false;
+        } else {
+            if (!qn_json_push_variant(lvl->elem.array, cls, new_elem)) return qn_false;
+        } // if
+    } // if
+    lvl->key = NULL;
     return qn_true;
 }
 
@@ -788,7 +798,7 @@ PARSING_NEXT_ELEMENT_IN_THE_OBJECT:
                 return QN_JSON_PARSING_ERROR;
             } // if
 
-            lvl->key = qn_cs_clone(txt, txt_size);
+            if (! (lvl->key = qn_json_prs_hold_key(prs, txt, txt_size))) return QN_JSON_PARSING_ERROR;
             lvl->sts = QN_JSON_PARSING_COLON;
 
         case QN_JSON_PARSING_COLON:
@@ -808,15 +818,21 @@ PARSING_NEXT_ELEMENT_IN_THE_OBJECT:
         case QN_JSON_PARSING_VALUE:
             tkn = qn_json_scan(&prs->s, &txt, &txt_size);
 
+            if (tkn == QN_JSON_TKN_OPEN_BRACE || tkn == QN_JSON_TKN_OPEN_BRACKET) {
+                // The level may be moved by pushing the new element, so update its status first.
+                lvl->sts = QN_JSON_PARSING_COMMA;
+                if (!qn_json_prs_put_in(prs, tkn, txt, txt_size, lvl)) return QN_JSON_PARSING_ERROR;
+
+                // Go to parse the new element on the top of the stack.
+                return QN_JSON_PARSING_CHILD;
+            } // if
+
             // Put the parsed element into the container.
             ret = qn_json_prs_put_in(prs, tkn, txt, txt_size, lvl);
             if (!ret) return QN_JSON_PARSING_ERROR;
 
             lvl->sts = QN_JSON_PARSING_COMMA;
 
-            // Go to parse the new element on the top of the stack.
-            if (tkn == QN_JSON_TKN_OPEN_BRACE || tkn == QN_JSON_TKN_OPEN_BRACKET) return QN_JSON_PARSING_CHILD;
-
         case QN_JSON_PARSING_COMMA:
             tkn = qn_json_scan(&prs->s, &txt, &txt_size);
 
@@ -862,6 +878,15 @@ PARSING_NEXT_ELEMENT_IN_THE_ARRAY:
                 return QN_JSON_PARSING_OK;
             } // if
 
+            if (tkn == QN_JSON_TKN_OPEN_BRACE || tkn == QN_JSON_TKN_OPEN_BRACKET) {
+                // The level may be moved by pushing the new element, so update its status first.
+                lvl->sts = QN_JSON_PARSING_COMMA;
+                if (!qn_json_prs_put_in(prs, tkn, txt, txt_size, lvl)) return QN_JSON_PARSING_ERROR;
+
+                // Go to parse the new element on the top of the stack.
+                return QN_JSON_PARSING_CHILD;
+            } // if
+
             // Put the parsed element into the container.
             if (!qn_json_prs_put_in(prs, tkn, txt, txt_size, lvl)) {
                 return QN_JSON_PARSING_ERROR;
@@ -869,11 +894,6 @@ PARSING_NEXT_ELEMENT_IN_THE_ARRAY:
 
             lvl->sts = QN_JSON_PARSING_COMMA;
 
-            // Go to parse the new element on the top of the stack.
-            if (tkn == QN_JSON_TKN_OPEN_BRACE || tkn == QN_JSON_TKN_OPEN_BRACKET) {
-                return QN_JSON_PARSING_CHILD;
-            } // if
-
         case QN_JSON_PARSING_COMMA:
             tkn = qn_json_scan(&prs->s, &txt, &txt_size);
             if (tkn == QN_JSON_TKN_CLOSE_BRACKET) {
@@ -925,18 +945,39 @@ static qn_bool qn_json_prs_parse(qn_json_parser_ptr prs)
             return qn_false;
         } // if
 
+        if (prs->evt_cfn) {
+            if (!(*prs->evt_cfn)(prs->evt_data, (lvl->class == QN_JSON_OBJECT) ? QN_JSON_PRS_CLOSE_OBJECT : QN_JSON_PRS_CLOSE_ARRAY, NULL, lvl->class, NULL)) return qn_false;
+        } // if
+
         // Pop the parsed element out of the stack.
         qn_json_prs_pop(prs);
     } while (!qn_json_prs_is_empty(prs));
     return qn_true;
 }
 
+static qn_bool qn_json_prs_parse_measured(qn_json_parser_ptr prs)
+{
+    struct timespec begin;
+    struct timespec end;
+    qn_bool ret;
+
+    if (! qn_mtr_is_enabled()) return qn_json_prs_parse(prs);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    ret = qn_json_prs_parse(prs);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    qn_mtr_record_parsing((end.tv_sec - begin.tv_sec) * 1000000000ULL + end.tv_nsec - begin.tv_nsec, prs->s.buf_pos);
+    return ret;
+}
+
 QN_SDK qn_bool qn_json_prs_parse_object(qn_json_parser_ptr restrict prs, const char * restrict buf, qn_size * restrict buf_size, qn_json_object_ptr * restrict root)
 {
     qn_json_token tkn = QN_JSON_TKNERR_NEED_MORE_TEXT;
     char * txt = NULL;
     qn_size txt_size;
 
+    prs->evt_cfn = NULL;
     prs->s.buf = buf;
     prs->s.buf_size = *buf_size;
     prs->s.buf_pos = 0;
@@ -946,9 +987,10 @@ QN_SDK qn_bool qn_json_prs_parse_object(qn_json_parser_ptr restrict prs, const c
         if (tkn == QN_JSON_TKN_OPEN_BRACE) {
             if (*root) {
                 prs->elem.object = *root;
-            } else if (! (prs->elem.object = qn_json_create_object()) ) {
+            } else if (! (prs->elem.object = (prs->use_arena) ? qn_json_create_object_in_arena() : qn_json_create_object()) ) {
                 return qn_false;
             } // if
+            prs->own_root = (*root == NULL);
             if (!qn_json_prs_push(prs, QN_JSON_OBJECT, prs->elem, QN_JSON_PARSING_KEY)) {
                 if (!*root) qn_json_destroy_object(prs->elem.object);
                 return qn_false;
@@ -960,7 +1002,7 @@ QN_SDK qn_bool qn_json_prs_parse_object(qn_json_parser_ptr restrict prs, const c
         } // if
     } // if
 
-    if (!qn_json_prs_parse(prs)) {
+    if (!qn_json_prs_parse_measured(prs)) {
         if (!qn_err_json_is_need_more_text_input()) {
             qn_json_prs_reset(prs);
             if (!*root) qn_json_destroy_object(prs->elem.object);
@@ -978,6 +1020,7 @@ QN_SDK qn_bool qn_json_prs_parse_array(qn_json_parser_ptr restrict prs, const ch
     char * txt = NULL;
     qn_size txt_size;
 
+    prs->evt_cfn = NULL;
     prs->s.buf = buf;
     prs->s.buf_size = *buf_size;
     prs->s.buf_pos = 0;
@@ -987,9 +1030,10 @@ QN_SDK qn_bool qn_json_prs_parse_array(qn_json_parser_ptr restrict prs, const ch
         if (tkn == QN_JSON_TKN_OPEN_BRACKET) {
             if (*root) {
                 prs->elem.array = *root;
-            } else if (! (prs->elem.array = qn_json_create_array()) ) {
+            } else if (! (prs->elem.array = (prs->use_arena) ? qn_json_create_array_in_arena() : qn_json_create_array()) ) {
                 return qn_false;
             } // if
+            prs->own_root = (*root == NULL);
             if (!qn_json_prs_push(prs, QN_JSON_ARRAY, prs->elem, QN_JSON_PARSING_VALUE)) {
                 if (!*root) qn_json_destroy_array(prs->elem.array);
                 return qn_false;
@@ -1001,7 +1045,7 @@ QN_SDK qn_bool qn_json_prs_parse_array(qn_json_parser_ptr restrict prs, const ch
         } // if
     } // if
 
-    if (!qn_json_prs_parse(prs)) {
+    if (!qn_json_prs_parse_measured(prs)) {
         if (!qn_err_json_is_need_more_text_input()) {
             qn_json_prs_reset(prs);
             if (!*root) qn_json_destroy_array(prs->elem.array);
@@ -1013,6 +1057,48 @@ QN_SDK qn_bool qn_json_prs_parse_array(qn_json_parser_ptr restrict prs, const ch
     return qn_true;
 }
 
+QN_SDK qn_bool qn_json_prs_parse_events(qn_json_parser_ptr restrict prs, const char * restrict buf, qn_size * restrict buf_size, void * restrict evt_data, qn_json_prs_event_cfn evt_cfn)
+{
+    qn_json_token tkn = QN_JSON_TKNERR_NEED_MORE_TEXT;
+    char * txt = NULL;
+    qn_size txt_size;
+    qn_json_variant elem;
+
+    prs->evt_data = evt_data;
+    prs->evt_cfn = evt_cfn;
+    prs->s.buf = buf;
+    prs->s.buf_size = *buf_size;
+    prs->s.buf_pos = 0;
+
+    if (qn_json_prs_is_empty(prs)) {
+        tkn = qn_json_scan(&prs->s, &txt, &txt_size);
+        elem.object = NULL;
+        prs->own_root = qn_false;
+        if (tkn == QN_JSON_TKN_OPEN_BRACE) {
+            if (!(*evt_cfn)(evt_data, QN_JSON_PRS_OPEN_OBJECT, NULL, QN_JSON_OBJECT, NULL)) return qn_false;
+            if (!qn_json_prs_push(prs, QN_JSON_OBJECT, elem, QN_JSON_PARSING_KEY)) return qn_false;
+        } else if (tkn == QN_JSON_TKN_OPEN_BRACKET) {
+            if (!(*evt_cfn)(evt_data, QN_JSON_PRS_OPEN_ARRAY, NULL, QN_JSON_ARRAY, NULL)) return qn_false;
+            if (!qn_json_prs_push(prs, QN_JSON_ARRAY, elem, QN_JSON_PARSING_VALUE)) return qn_false;
+        } else if (tkn == QN_JSON_TKNERR_NEED_MORE_TEXT) {
+            // Only spaces have been input.
+            qn_err_json_set_need_more_text_input();
+            return qn_false;
+        } else {
+            // Not a valid piece of JSON text.
+            qn_err_json_set_bad_text_input();
+            return qn_false;
+        } // if
+    } // if
+
+    if (!qn_json_prs_parse_measured(prs)) {
+        if (!qn_err_json_is_need_more_text_input()) qn_json_prs_reset(prs);
+        return qn_false;
+    } // if
+    *buf_size = prs->s.buf_pos;
+    return qn_true;
+}
+
 int qn_json_prs_get_max_levels(void)
 {
     return qn_json_prs_max_levels;
@@ -1042,6 +1128,13 @@ QN_SDK qn_json_array_ptr qn_json_array_from_string(const char * restrict buf, qn
     return arr;
 }
 
+// -- Make the parser allocate roots it creates, and all elements in them, from memory arenas. Such a tree is freed
+//    at once when its root is destroyed. It takes effect on the next root created by the parser.
+QN_SDK void qn_json_prs_use_arena(qn_json_parser_ptr restrict prs, qn_bool use)
+{
+    prs->use_arena = use;
+}
+
 QN_SDK void qn_json_prs_set_max_levels(int count)
 {
     if (4 <= qn_json_prs_max_levels && qn_json_prs_max_levels < 64) {
@@ -16,9 +16,32 @@ typedef struct _QN_JSON_PARSER * qn_json_parser_ptr;
 
 QN_SDK extern qn_json_parser_ptr qn_json_prs_create(void);
 QN_SDK extern void qn_json_prs_destroy(qn_json_parser_ptr restrict prs);
+QN_SDK extern void qn_json_prs_use_arena(qn_json_parser_ptr restrict prs, qn_bool use);
 QN_SDK extern qn_bool qn_json_prs_parse_object(qn_json_parser_ptr restrict prs, const char * restrict buf, qn_size * restrict buf_size, qn_json_object_ptr * restrict root);
 QN_SDK extern qn_bool qn_json_prs_parse_array(qn_json_parser_ptr restrict prs, const char * restrict buf, qn_size * restrict buf_size, qn_json_array_ptr * restrict root);
 
+// ---- Event-driven parsing ----
+//
+// Instead of building a tree, report each element to the callback as soon as it is parsed. The key is NULL for
+// the root and elements of arrays. A scalar string is passed in `val->string`, and both the key and the string
+// are valid only during the call. Return qn_false from the callback to abort the parsing, after setting an
+// error code. Like the other parsing functions, feed the text chunk by chunk until no more text is needed.
+
+typedef enum _QN_JSON_PRS_EVENT
+{
+    QN_JSON_PRS_OPEN_OBJECT = 1,
+    QN_JSON_PRS_CLOSE_OBJECT = 2,
+    QN_JSON_PRS_OPEN_ARRAY = 3,
+    QN_JSON_PRS_CLOSE_ARRAY = 4,
+    QN_JSON_PRS_SCALAR = 5
+} qn_json_prs_event;
+
+typedef qn_bool (*qn_json_prs_event_cfn)(void * restrict evt_data, qn_json_prs_event evt, const char * restrict key, qn_json_class cls, qn_json_variant_ptr restrict val);
+
+QN_SDK extern qn_bool qn_json_prs_parse_events(qn_json_parser_ptr restrict prs, const char * restrict buf, qn_size * restrict buf_size, void * restrict evt_data, qn_json_prs_event_cfn evt_cfn);
+
+// ----
+
 QN_SDK extern qn_json_object_ptr qn_json_object_from_string(const char * restrict buf, qn_size buf_size);
 QN_SDK extern qn_json_array_ptr qn_json_array_from_string(const char * restrict buf, qn_size buf_size);
 
@@ -0,0 +1,442 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "qiniu/base/json_formatter.h"
+#include "qiniu/base/metrics.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// ---- Histograms ----
+
+// -- Log-linear buckets like HDR histograms: values below 16 have their own buckets, and each power of 2
+//    above is split into 16 sub-buckets, so a recorded value is off by at most 1/16 (6.25%). Values not
+//    less than 2^36 fall into the last bucket.
+#define QN_MTR_HIST_SUB_BITS 4
+#define QN_MTR_HIST_SUB_COUNT (1 << QN_MTR_HIST_SUB_BITS)
+#define QN_MTR_HIST_BUCKET_COUNT (QN_MTR_HIST_SUB_COUNT * 33)
+
+#define QN_MTR_ERROR_SLOT_COUNT 64
+
+typedef struct _QN_MTR_HISTOGRAM
+{
+    qn_uint64 count;
+    qn_uint64 sum;
+    qn_uint64 max;
+    qn_uint64 buckets[QN_MTR_HIST_BUCKET_COUNT];
+} qn_mtr_histogram;
+
+typedef struct _QN_MTR_API_STATS
+{
+    qn_uint64 requests;
+    qn_uint64 failures;
+    qn_uint64 retries;
+    qn_uint64 bytes_sent;
+    qn_uint64 bytes_received;
+    qn_mtr_histogram latency;
+} qn_mtr_api_stats;
+
+typedef struct _QN_MTR_ERROR_SLOT
+{
+    qn_err_code_em code;
+    qn_uint64 count;
+} qn_mtr_error_slot;
+
+typedef struct _QN_MTR_SHARD
+{
+    struct _QN_MTR_SHARD * next;
+    int in_use;
+
+    qn_mtr_api_stats apis[QN_MTR_API_COUNT];
+    qn_mtr_error_slot errors[QN_MTR_ERROR_SLOT_COUNT];
+    qn_uint64 other_errors;
+
+    qn_uint64 parsing_bytes;
+    qn_mtr_histogram parsing;
+} qn_mtr_shard;
+
+static const char * qn_mtr_api_names[QN_MTR_API_COUNT] = {
+    "stat",
+    "copy",
+    "move",
+    "delete",
+    "chgm",
+    "batch",
+    "list",
+    "fetch",
+    "prefetch",
+    "mkblk",
+    "bput",
+    "mkfile",
+    "upload",
+    "download"
+};
+
+static int qn_mtr_enabled = 0;
+static qn_mtr_shard * qn_mtr_shards = NULL;
+static QN_THREAD_LOCAL qn_mtr_shard * qn_mtr_local = NULL;
+static pthread_key_t qn_mtr_key;
+static pthread_once_t qn_mtr_key_once = PTHREAD_ONCE_INIT;
+
+// -- Only the owner thread writes to a shard, so a plain read followed by an atomic store is enough to keep
+//    snapshots from reading torn values.
+static inline void qn_mtr_add(qn_uint64 * restrict val, qn_uint64 delta)
+{
+    __atomic_store_n(val, *val + delta, __ATOMIC_RELAXED);
+}
+
+static inline qn_uint64 qn_mtr_load(const qn_uint64 * restrict val)
+{
+    return __atomic_load_n(val, __ATOMIC_RELAXED);
+}
+
+static inline int qn_mtr_hist_index(qn_uint64 val)
+{
+    int exp;
+    int idx;
+
+    if (val < QN_MTR_HIST_SUB_COUNT) return (int) val;
+
+    exp = 63 - __builtin_clzll(val);
+    idx = (exp - QN_MTR_HIST_SUB_BITS + 1) * QN_MTR_HIST_SUB_COUNT + (int)((val >> (exp - QN_MTR_HIST_SUB_BITS)) & (QN_MTR_HIST_SUB_COUNT - 1));
+    return (idx < QN_MTR_HIST_BUCKET_COUNT) ? idx : QN_MTR_HIST_BUCKET_COUNT - 1;
+}
+
+static inline qn_uint64 qn_mtr_hist_upper_bound(int idx)
+{
+    int grp = idx / QN_MTR_HIST_SUB_COUNT;
+    qn_uint64 sub = idx % QN_MTR_HIST_SUB_COUNT;
+
+    if (grp == 0) return sub;
+    return ((QN_MTR_HIST_SUB_COUNT + sub + 1) << (grp - 1)) - 1;
+}
+
+static void qn_mtr_hist_record(qn_mtr_histogram * restrict hist, qn_uint64 val)
+{
+    qn_mtr_add(&hist->buckets[qn_mtr_hist_index(val)], 1);
+    qn_mtr_add(&hist->count, 1);
+    qn_mtr_add(&hist->sum, val);
+    if (val > hist->max) __atomic_store_n(&hist->max, val, __ATOMIC_RELAXED);
+}
+
+static void qn_mtr_hist_merge(qn_mtr_histogram * restrict dst, const qn_mtr_histogram * restrict src)
+{
+    qn_uint64 max = qn_mtr_load(&src->max);
+    int i;
+
+    for (i = 0; i < QN_MTR_HIST_BUCKET_COUNT; i += 1) dst->buckets[i] += qn_mtr_load(&src->buckets[i]);
+    dst->count += qn_mtr_load(&src->count);
+    dst->sum += qn_mtr_load(&src->sum);
+    if (max > dst->max) dst->max = max;
+}
+
+static qn_uint64 qn_mtr_hist_percentile(const qn_mtr_histogram * restrict hist, qn_uint64 total, double pct)
+{
+    qn_uint64 rank = (qn_uint64)(total * pct / 100.0 + 0.5);
+    qn_uint64 seen = 0;
+    qn_uint64 val;
+    int i;
+
+    if (rank == 0) rank = 1;
+    for (i = 0; i < QN_MTR_HIST_BUCKET_COUNT; i += 1) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            val = qn_mtr_hist_upper_bound(i);
+            return (val < hist->max) ? val : hist->max;
+        } // if
+    } // for
+    return hist->max;
+}
+
+static qn_bool qn_mtr_hist_export(qn_json_object_ptr restrict obj, const char * restrict key, const qn_mtr_histogram * restrict hist)
+{
+    qn_json_object_ptr hist_obj = qn_json_create_and_set_object(obj, key);
+    qn_uint64 total = 0;
+    int i;
+
+    if (! hist_obj) return qn_false;
+
+    // -- Buckets are summed up again because counts may be recorded during merging.
+    for (i = 0; i < QN_MTR_HIST_BUCKET_COUNT; i += 1) total += hist->buckets[i];
+
+    if (! qn_json_set_integer(hist_obj, "count", total)) return qn_false;
+    if (! qn_json_set_integer(hist_obj, "sum", hist->sum)) return qn_false;
+    if (! qn_json_set_integer(hist_obj, "max", hist->max)) return qn_false;
+    if (total == 0) return qn_true;
+
+    if (! qn_json_set_integer(hist_obj, "p50", qn_mtr_hist_percentile(hist, total, 50.0))) return qn_false;
+    if (! qn_json_set_integer(hist_obj, "p90", qn_mtr_hist_percentile(hist, total, 90.0))) return qn_false;
+    if (! qn_json_set_integer(hist_obj, "p99", qn_mtr_hist_percentile(hist, total, 99.0))) return qn_false;
+    return qn_json_set_integer(hist_obj, "p999", qn_mtr_hist_percentile(hist, total, 99.9));
+}
+
+// ---- Shards ----
+
+static void qn_mtr_release_shard(void * shard)
+{
+    // -- Keep the counts of the exited thread and let a new thread take the shard over.
+    __atomic_store_n(&((qn_mtr_shard *) shard)->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void qn_mtr_create_key(void)
+{
+    pthread_key_create(&qn_mtr_key, &qn_mtr_release_shard);
+}
+
+static qn_mtr_shard * qn_mtr_acquire_shard(void)
+{
+    qn_mtr_shard * shard;
+    int unused;
+
+    if (qn_mtr_local) return qn_mtr_local;
+
+    pthread_once(&qn_mtr_key_once, &qn_mtr_create_key);
+
+    for (shard = __atomic_load_n(&qn_mtr_shards, __ATOMIC_ACQUIRE); shard; shard = shard->next) {
+        unused = 0;
+        if (__atomic_compare_exchange_n(&shard->in_use, &unused, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) break;
+    } // for
+
+    if (! shard) {
+        // -- Shards are never freed, so the list can be pushed and walked without locks.
+        if (! (shard = calloc(1, sizeof(qn_mtr_shard)))) return NULL;
+        shard->in_use = 1;
+        shard->next = __atomic_load_n(&qn_mtr_shards, __ATOMIC_RELAXED);
+        while (! __atomic_compare_exchange_n(&qn_mtr_shards, &shard->next, shard, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            // -- The head is reloaded into shard->next.
+        } // while
+    } // if
+
+    pthread_setspecific(qn_mtr_key, shard);
+    qn_mtr_local = shard;
+    return shard;
+}
+
+// ---- Recording ----
+
+QN_SDK void qn_mtr_enable(void)
+{
+    __atomic_store_n(&qn_mtr_enabled, 1, __ATOMIC_RELAXED);
+}
+
+QN_SDK void qn_mtr_disable(void)
+{
+    __atomic_store_n(&qn_mtr_enabled, 0, __ATOMIC_RELAXED);
+}
+
+QN_SDK qn_bool qn_mtr_is_enabled(void)
+{
+    return __atomic_load_n(&qn_mtr_enabled, __ATOMIC_RELAXED) != 0;
+}
+
+QN_SDK void qn_mtr_record_request(qn_mtr_api_em api, qn_bool ok, qn_uint64 latency_us, qn_uint64 bytes_sent, qn_uint64 bytes_received)
+{
+    qn_mtr_shard * shard;
+    qn_mtr_api_stats * stats;
+
+    if (! qn_mtr_is_enabled() || api < 0 || api >= QN_MTR_API_COUNT) return;
+    if (! (shard = qn_mtr_acquire_shard())) return;
+
+    stats = &shard->apis[api];
+    qn_mtr_add(&stats->requests, 1);
+    if (! ok) qn_mtr_add(&stats->failures, 1);
+    qn_mtr_add(&stats->bytes_sent, bytes_sent);
+    qn_mtr_add(&stats->bytes_received, bytes_received);
+    qn_mtr_hist_record(&stats->latency, latency_us);
+}
+
+QN_SDK void qn_mtr_record_retry(qn_mtr_api_em api)
+{
+    qn_mtr_shard * shard;
+
+    if (! qn_mtr_is_enabled() || api < 0 || api >= QN_MTR_API_COUNT) return;
+    if (! (shard = qn_mtr_acquire_shard())) return;
+
+    qn_mtr_add(&shard->apis[api].retries, 1);
+}
+
+QN_SDK void qn_mtr_record_error(qn_err_code_em cd)
+{
+    qn_mtr_shard * shard;
+    qn_mtr_error_slot * slot;
+    int i;
+
+    if (! qn_mtr_is_enabled() || cd == QN_ERR_SUCCEED) return;
+    if (! (shard = qn_mtr_acquire_shard())) return;
+
+    for (i = 0; i < QN_MTR_ERROR_SLOT_COUNT; i += 1) {
+        slot = &shard->errors[(cd + i) % QN_MTR_ERROR_SLOT_COUNT];
+        if (slot->code == cd) {
+            qn_mtr_add(&slot->count, 1);
+            return;
+        } // if
+        if (slot->code == QN_ERR_SUCCEED) {
+            // -- Publish the count before the code, so a snapshot never sees a code without its count.
+            __atomic_store_n(&slot->count, 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&slot->code, cd, __ATOMIC_RELEASE);
+            return;
+        } // if
+    } // for
+    qn_mtr_add(&shard->other_errors, 1);
+}
+
+QN_SDK void qn_mtr_record_parsing(qn_uint64 elapsed_ns, qn_size bytes)
+{
+    qn_mtr_shard * shard;
+
+    if (! qn_mtr_is_enabled()) return;
+    if (! (shard = qn_mtr_acquire_shard())) return;
+
+    qn_mtr_add(&shard->parsing_bytes, bytes);
+    qn_mtr_hist_record(&shard->parsing, elapsed_ns);
+}
+
+// ---- Snapshot ----
+
+static qn_bool qn_mtr_export_errors(qn_json_object_ptr restrict root)
+{
+    qn_json_object_ptr err_obj = qn_json_create_and_set_object(root, "errors");
+    qn_mtr_shard * shard;
+    qn_err_code_em cd;
+    qn_uint64 other = 0;
+    char key[16];
+    int i;
+
+    if (! err_obj) return qn_false;
+
+    for (shard = __atomic_load_n(&qn_mtr_shards, __ATOMIC_ACQUIRE); shard; shard = shard->next) {
+        for (i = 0; i < QN_MTR_ERROR_SLOT_COUNT; i += 1) {
+            cd = __atomic_load_n(&shard->errors[i].code, __ATOMIC_ACQUIRE);
+            if (cd == QN_ERR_SUCCEED) continue;
+
+            qn_cs_snprintf(key, sizeof(key), "%d", cd);
+            if (! qn_json_set_integer(err_obj, key, qn_json_get_integer(err_obj, key, 0) + qn_mtr_load(&shard->errors[i].count))) return qn_false;
+        } // for
+        other += qn_mtr_load(&shard->other_errors);
+    } // for
+
+    if (other > 0 && ! qn_json_set_integer(err_obj, "other", other)) return qn_false;
+    return qn_true;
+}
+
+/***************************************************************************//**
+* @ingroup Metrics
+*
+* Merge metrics recorded by all threads into a JSON object.
+*
+* @retval non-NULL The pointer to the snapshot object, which the caller MUST
+*                  destroy with qn_json_destroy_object().
+* @retval NULL An application error occurs in making the snapshot.
+*
+* @remark The snapshot object contains following fields:
+*
+*         ```
+*             {
+*                 "apis": {
+*                     "<API name>": {
+*                         "requests": <Count of requests done>,
+*                         "failures": <Count of requests failed>,
+*                         "retries": <Count of requests retried>,
+*                         "bytes-sent": <Bytes sent including headers>,
+*                         "bytes-received": <Bytes received including headers>,
+*                         "latency-us": {<Histogram>}
+*                     },
+*                     ...
+*                 },
+*                 "errors": {
+*                     "<Error code>": <Count of the error>,
+*                     ...
+*                 },
+*                 "json-parsing": {
+*                     "bytes": <Bytes parsed>,
+*                     "elapsed-ns": {<Histogram>}
+*                 }
+*             }
+*         ```
+*
+*         Each histogram holds `count`, `sum` and `max` fields, and `p50`,
+*         `p90`, `p99` and `p999` fields if it is not empty. Percentiles are
+*         accurate to 1/16 of the value.
+*
+*         Counts only grow, so take differences between snapshots to get rates.
+*         APIs never called are omitted.
+*******************************************************************************/
+QN_SDK qn_json_object_ptr qn_mtr_snapshot(void)
+{
+    qn_json_object_ptr root = NULL;
+    qn_json_object_ptr apis = NULL;
+    qn_json_object_ptr api_obj = NULL;
+    qn_json_object_ptr parsing = NULL;
+    qn_mtr_api_stats * stats = NULL;
+    qn_mtr_shard * shard;
+    qn_uint64 parsing_bytes = 0;
+    int api;
+
+    if (! (stats = calloc(1, sizeof(qn_mtr_api_stats)))) {
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+
+    if (! (root = qn_json_create_object())) goto QN_MTR_SNAPSHOT_ERROR_HANDLING;
+    if (! (apis = qn_json_create_and_set_object(root, "apis"))) goto QN_MTR_SNAPSHOT_ERROR_HANDLING;
+
+    for (api = 0; api < QN_MTR_API_COUNT; api += 1) {
+        memset(stats, 0, sizeof(qn_mtr_api_stats));
+        for (shard = __atomic_load_n(&qn_mtr_shards, __ATOMIC_ACQUIRE); shard; shard = shard->next) {
+            stats->requests += qn_mtr_load(&shard->apis[api].requests);
+            stats->failures += qn_mtr_load(&shard->apis[api].failures);
+            stats->retries += qn_mtr_load(&shard->apis[api].retries);
+            stats->bytes_sent += qn_mtr_load(&shard->apis[api].bytes_sent);
+            stats->bytes_received += qn_mtr_load(&shard->apis[api].bytes_received);
+            qn_mtr_hist_merge(&stats->latency, &shard->apis[api].latency);
+        } // for
+        if (stats->requests == 0 && stats->retries == 0) continue;
+
+        if (! (api_obj = qn_json_create_and_set_object(apis, qn_mtr_api_names[api]))) goto QN_MTR_SNAPSHOT_ERROR_HANDLING;
+        if (! qn_json_set_integer(api_obj, "requests", stats->requests)) goto QN_MTR_SNAPSHOT_ERROR_HANDLING;
+        if (! qn_json_set_integer(api_obj, "failures", stats->failures)) goto QN_MTR_SNAPSHOT_ERROR_HANDLING;
+        if (! qn_json_set_integer(api_obj, "retries", stats->retries)) goto QN_MTR_SNAPSHOT_ERROR_HANDLING;
+        if (! qn_json_set_integer(api_obj, "bytes-sent", stats->bytes_sent)) goto QN_MTR_SNAPSHOT_ERROR_HANDLING;
+        if (! qn_json_set_integer(api_obj, "bytes-received", stats->bytes_received)) goto QN_MTR_SNAPSHOT_ERROR_HANDLING;
+        if (! qn_mtr_hist_export(api_obj, "latency-us", &stats->latency)) goto QN_MTR_SNAPSHOT_ERROR_HANDLING;
+    } // for
+
+    if (! qn_mtr_export_errors(root)) goto QN_MTR_SNAPSHOT_ERROR_HANDLING;
+
+    // -- Reuse the histogram of the stats for merging the parsing one.
+    memset(&stats->latency, 0, sizeof(qn_mtr_histogram));
+    for (shard = __atomic_load_n(&qn_mtr_shards, __ATOMIC_ACQUIRE); shard; shard = shard->next) {
+        parsing_bytes += qn_mtr_load(&shard->parsing_bytes);
+        qn_mtr_hist_merge(&stats->latency, &shard->parsing);
+    } // for
+
+    if (! (parsing = qn_json_create_and_set_object(root, "json-parsing"))) goto QN_MTR_SNAPSHOT_ERROR_HANDLING;
+    if (! qn_json_set_integer(parsing, "bytes", parsing_bytes)) goto QN_MTR_SNAPSHOT_ERROR_HANDLING;
+    if (! qn_mtr_hist_export(parsing, "elapsed-ns", &stats->latency)) goto QN_MTR_SNAPSHOT_ERROR_HANDLING;
+
+    free(stats);
+    return root;
+
+QN_MTR_SNAPSHOT_ERROR_HANDLING:
+    if (root) qn_json_destroy_object(root);
+    free(stats);
+    return NULL;
+}
+
+QN_SDK qn_string qn_mtr_snapshot_to_string(void)
+{
+    qn_json_object_ptr root = qn_mtr_snapshot();
+    qn_string str = NULL;
+
+    if (! root) return NULL;
+    str = qn_json_object_to_string(root);
+    qn_json_destroy_object(root);
+    return str;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,60 @@
+#ifndef __QN_METRICS_H__
+#define __QN_METRICS_H__ 1
+
+#include "qiniu/os/types.h"
+#include "qiniu/base/string.h"
+#include "qiniu/base/errors.h"
+#include "qiniu/base/json.h"
+#include "qiniu/macros.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// ---- Metrics (abbreviation: mtr) ----
+
+// -- Each thread records into its own shard without locks or atomic read-modify-write operations. A
+//    snapshot merges all shards, so it is cheap to record and relatively expensive to take a snapshot.
+//    Recording is disabled by default.
+
+typedef enum _QN_MTR_API
+{
+    QN_MTR_API_STAT = 0,
+    QN_MTR_API_COPY,
+    QN_MTR_API_MOVE,
+    QN_MTR_API_DELETE,
+    QN_MTR_API_CHGM,
+    QN_MTR_API_BATCH,
+    QN_MTR_API_LIST,
+    QN_MTR_API_FETCH,
+    QN_MTR_API_PREFETCH,
+    QN_MTR_API_MKBLK,
+    QN_MTR_API_BPUT,
+    QN_MTR_API_MKFILE,
+    QN_MTR_API_UPLOAD,
+    QN_MTR_API_DOWNLOAD,
+    QN_MTR_API_COUNT
+} qn_mtr_api_em;
+
+QN_SDK extern void qn_mtr_enable(void);
+QN_SDK extern void qn_mtr_disable(void);
+QN_SDK extern qn_bool qn_mtr_is_enabled(void);
+
+// ----
+
+QN_SDK extern void qn_mtr_record_request(qn_mtr_api_em api, qn_bool ok, qn_uint64 latency_us, qn_uint64 bytes_sent, qn_uint64 bytes_received);
+QN_SDK extern void qn_mtr_record_retry(qn_mtr_api_em api);
+QN_SDK extern void qn_mtr_record_error(qn_err_code_em cd);
+QN_SDK extern void qn_mtr_record_parsing(qn_uint64 elapsed_ns, qn_size bytes);
+
+// ----
+
+QN_SDK extern qn_json_object_ptr qn_mtr_snapshot(void);
+QN_SDK extern qn_string qn_mtr_snapshot_to_string(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __QN_METRICS_H__
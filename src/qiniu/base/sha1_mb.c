@@ -0,0 +1,212 @@
+#include <string.h>
+#include <assert.h>
+
+#include "qiniu/base/sha1_mb.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define QN_SHA1_MB_AVX2_SUPPORT 1
+#include <immintrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// ---- Definition of multi-buffer SHA-1 ----
+
+// The kernel computes SHA-1 digests of up to 8 buffers of the same size at once, one buffer per 32-bit lane
+// of AVX2 registers. It pays off since QETAG hashes lots of independent blocks of the same size.
+
+#if defined(QN_SHA1_MB_AVX2_SUPPORT)
+
+#define QN_SHA1_MB_AVX2 __attribute__((target("avx2")))
+
+#define QN_SHA1_MB_ROTL(x, n) _mm256_or_si256(_mm256_slli_epi32((x), (n)), _mm256_srli_epi32((x), 32 - (n)))
+
+#define QN_SHA1_MB_F0(b, c, d) _mm256_xor_si256((d), _mm256_and_si256((b), _mm256_xor_si256((c), (d))))
+#define QN_SHA1_MB_F1(b, c, d) _mm256_xor_si256(_mm256_xor_si256((b), (c)), (d))
+#define QN_SHA1_MB_F2(b, c, d) _mm256_or_si256(_mm256_and_si256((b), (c)), _mm256_and_si256((d), _mm256_or_si256((b), (c))))
+
+#define QN_SHA1_MB_ROUND(a, b, c, d, e, f, k, w) \
+    do { \
+        (e) = _mm256_add_epi32((e), _mm256_add_epi32(_mm256_add_epi32(QN_SHA1_MB_ROTL((a), 5), f((b), (c), (d))), _mm256_add_epi32((k), (w)))); \
+        (b) = QN_SHA1_MB_ROTL((b), 30); \
+    } while (0)
+
+#define QN_SHA1_MB_SCHEDULE(i) \
+    (w[(i) & 15] = QN_SHA1_MB_ROTL(_mm256_xor_si256(_mm256_xor_si256(w[((i) - 3) & 15], w[((i) - 8) & 15]), _mm256_xor_si256(w[((i) - 14) & 15], w[(i) & 15])), 1))
+
+#define QN_SHA1_MB_STEP(i, a, b, c, d, e, f, k) \
+    QN_SHA1_MB_ROUND(a, b, c, d, e, f, k, ((i) < 16) ? w[(i) & 15] : QN_SHA1_MB_SCHEDULE(i))
+
+#define QN_SHA1_MB_5_STEPS(i, f, k) \
+    do { \
+        QN_SHA1_MB_STEP((i) + 0, a, b, c, d, e, f, k); \
+        QN_SHA1_MB_STEP((i) + 1, e, a, b, c, d, f, k); \
+        QN_SHA1_MB_STEP((i) + 2, d, e, a, b, c, f, k); \
+        QN_SHA1_MB_STEP((i) + 3, c, d, e, a, b, f, k); \
+        QN_SHA1_MB_STEP((i) + 4, b, c, d, e, a, f, k); \
+    } while (0)
+
+static QN_SHA1_MB_AVX2 inline void qn_sha1_mb_load_8_words(__m256i * restrict w, const unsigned char * const * restrict ptrs, qn_size offset)
+{
+    const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    __m256i r0, r1, r2, r3, r4, r5, r6, r7;
+    __m256i t0, t1, t2, t3, t4, t5, t6, t7;
+
+    // ---- Load 8 words of each lane as a row, and transpose the 8x8 matrix to get one word of all lanes per register.
+    r0 = _mm256_loadu_si256((const __m256i *)(ptrs[0] + offset));
+    r1 = _mm256_loadu_si256((const __m256i *)(ptrs[1] + offset));
+    r2 = _mm256_loadu_si256((const __m256i *)(ptrs[2] + offset));
+    r3 = _mm256_loadu_si256((const __m256i *)(ptrs[3] + offset));
+    r4 = _mm256_loadu_si256((const __m256i *)(ptrs[4] + offset));
+    r5 = _mm256_loadu_si256((const __m256i *)(ptrs[5] + offset));
+    r6 = _mm256_loadu_si256((const __m256i *)(ptrs[6] + offset));
+    r7 = _mm256_loadu_si256((const __m256i *)(ptrs[7] + offset));
+
+    t0 = _mm256_unpacklo_epi32(r0, r1);
+    t1 = _mm256_unpackhi_epi32(r0, r1);
+    t2 = _mm256_unpacklo_epi32(r2, r3);
+    t3 = _mm256_unpackhi_epi32(r2, r3);
+    t4 = _mm256_unpacklo_epi32(r4, r5);
+    t5 = _mm256_unpackhi_epi32(r4, r5);
+    t6 = _mm256_unpacklo_epi32(r6, r7);
+    t7 = _mm256_unpackhi_epi32(r6, r7);
+
+    r0 = _mm256_unpacklo_epi64(t0, t2);
+    r1 = _mm256_unpackhi_epi64(t0, t2);
+    r2 = _mm256_unpacklo_epi64(t1, t3);
+    r3 = _mm256_unpackhi_epi64(t1, t3);
+    r4 = _mm256_unpacklo_epi64(t4, t6);
+    r5 = _mm256_unpackhi_epi64(t4, t6);
+    r6 = _mm256_unpacklo_epi64(t5, t7);
+    r7 = _mm256_unpackhi_epi64(t5, t7);
+
+    w[0] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r0, r4, 0x20), bswap);
+    w[1] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r1, r5, 0x20), bswap);
+    w[2] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r2, r6, 0x20), bswap);
+    w[3] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r3, r7, 0x20), bswap);
+    w[4] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r0, r4, 0x31), bswap);
+    w[5] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r1, r5, 0x31), bswap);
+    w[6] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r2, r6, 0x31), bswap);
+    w[7] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r3, r7, 0x31), bswap);
+}
+
+static QN_SHA1_MB_AVX2 void qn_sha1_mb_compress_avx2(__m256i * restrict state, const unsigned char * const * restrict ptrs, qn_size blk_cnt)
+{
+    const __m256i k0 = _mm256_set1_epi32(0x5A827999);
+    const __m256i k1 = _mm256_set1_epi32(0x6ED9EBA1);
+    const __m256i k2 = _mm256_set1_epi32(0x8F1BBCDC);
+    const __m256i k3 = _mm256_set1_epi32(0xCA62C1D6);
+    __m256i w[16];
+    __m256i a, b, c, d, e;
+    qn_size offset;
+
+    for (offset = 0; offset < blk_cnt * 64; offset += 64) {
+        qn_sha1_mb_load_8_words(&w[0], ptrs, offset);
+        qn_sha1_mb_load_8_words(&w[8], ptrs, offset + 32);
+
+        a = state[0];
+        b = state[1];
+        c = state[2];
+        d = state[3];
+        e = state[4];
+
+        // ---- Unroll all rounds and rotate variables by arguments instead of moving data, five rounds a group.
+        QN_SHA1_MB_5_STEPS(0, QN_SHA1_MB_F0, k0);
+        QN_SHA1_MB_5_STEPS(5, QN_SHA1_MB_F0, k0);
+        QN_SHA1_MB_5_STEPS(10, QN_SHA1_MB_F0, k0);
+        QN_SHA1_MB_5_STEPS(15, QN_SHA1_MB_F0, k0);
+        QN_SHA1_MB_5_STEPS(20, QN_SHA1_MB_F1, k1);
+        QN_SHA1_MB_5_STEPS(25, QN_SHA1_MB_F1, k1);
+        QN_SHA1_MB_5_STEPS(30, QN_SHA1_MB_F1, k1);
+        QN_SHA1_MB_5_STEPS(35, QN_SHA1_MB_F1, k1);
+        QN_SHA1_MB_5_STEPS(40, QN_SHA1_MB_F2, k2);
+        QN_SHA1_MB_5_STEPS(45, QN_SHA1_MB_F2, k2);
+        QN_SHA1_MB_5_STEPS(50, QN_SHA1_MB_F2, k2);
+        QN_SHA1_MB_5_STEPS(55, QN_SHA1_MB_F2, k2);
+        QN_SHA1_MB_5_STEPS(60, QN_SHA1_MB_F1, k3);
+        QN_SHA1_MB_5_STEPS(65, QN_SHA1_MB_F1, k3);
+        QN_SHA1_MB_5_STEPS(70, QN_SHA1_MB_F1, k3);
+        QN_SHA1_MB_5_STEPS(75, QN_SHA1_MB_F1, k3);
+
+        state[0] = _mm256_add_epi32(state[0], a);
+        state[1] = _mm256_add_epi32(state[1], b);
+        state[2] = _mm256_add_epi32(state[2], c);
+        state[3] = _mm256_add_epi32(state[3], d);
+        state[4] = _mm256_add_epi32(state[4], e);
+    } // for
+}
+
+static QN_SHA1_MB_AVX2 void qn_sha1_mb_digest_avx2(const char * const * restrict bufs, qn_size buf_size, int buf_cnt, unsigned char (* restrict digests)[QN_SHA1_MB_DIGEST_SIZE])
+{
+    unsigned char tails[QN_SHA1_MB_MAX_LANES][128];
+    const unsigned char * ptrs[QN_SHA1_MB_MAX_LANES];
+    qn_uint32 words[QN_SHA1_MB_MAX_LANES];
+    __m256i state[5];
+    qn_size blk_cnt = buf_size / 64;
+    qn_size rem_size = buf_size % 64;
+    qn_size tail_size = (rem_size < 56) ? 64 : 128;
+    unsigned long long bits = (unsigned long long) buf_size * 8;
+    int i;
+    int j;
+
+    // -- Idle lanes repeat the first buffer, and their results are dropped.
+    for (i = 0; i < QN_SHA1_MB_MAX_LANES; i += 1) ptrs[i] = (const unsigned char *) bufs[(i < buf_cnt) ? i : 0];
+
+    state[0] = _mm256_set1_epi32(0x67452301);
+    state[1] = _mm256_set1_epi32(0xEFCDAB89);
+    state[2] = _mm256_set1_epi32(0x98BADCFE);
+    state[3] = _mm256_set1_epi32(0x10325476);
+    state[4] = _mm256_set1_epi32(0xC3D2E1F0);
+
+    qn_sha1_mb_compress_avx2(state, ptrs, blk_cnt);
+
+    // ---- All buffers are of the same size, so they share the same padding.
+    for (i = 0; i < QN_SHA1_MB_MAX_LANES; i += 1) {
+        memset(tails[i], 0, tail_size);
+        memcpy(tails[i], ptrs[i] + blk_cnt * 64, rem_size);
+        tails[i][rem_size] = 0x80;
+        for (j = 0; j < 8; j += 1) tails[i][tail_size - 1 - j] = (unsigned char)(bits >> (j * 8));
+        ptrs[i] = tails[i];
+    } // for
+    qn_sha1_mb_compress_avx2(state, ptrs, tail_size / 64);
+
+    for (j = 0; j < 5; j += 1) {
+        _mm256_storeu_si256((__m256i *) words, state[j]);
+        for (i = 0; i < buf_cnt; i += 1) {
+            digests[i][j * 4 + 0] = (unsigned char)(words[i] >> 24);
+            digests[i][j * 4 + 1] = (unsigned char)(words[i] >> 16);
+            digests[i][j * 4 + 2] = (unsigned char)(words[i] >> 8);
+            digests[i][j * 4 + 3] = (unsigned char)(words[i]);
+        } // for
+    } // for
+}
+
+#endif
+
+QN_SDK int qn_sha1_mb_lane_count(void)
+{
+#if defined(QN_SHA1_MB_AVX2_SUPPORT)
+    static int lane_cnt = -1;
+
+    if (lane_cnt < 0) lane_cnt = (__builtin_cpu_supports("avx2")) ? QN_SHA1_MB_MAX_LANES : 0;
+    return lane_cnt;
+#else
+    return 0;
+#endif
+}
+
+QN_SDK void qn_sha1_mb_digest(const char * const * restrict bufs, qn_size buf_size, int buf_cnt, unsigned char (* restrict digests)[QN_SHA1_MB_DIGEST_SIZE])
+{
+    assert(0 < buf_cnt && buf_cnt <= qn_sha1_mb_lane_count());
+
+#if defined(QN_SHA1_MB_AVX2_SUPPORT)
+    qn_sha1_mb_digest_avx2(bufs, buf_size, buf_cnt, digests);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
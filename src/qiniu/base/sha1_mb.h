@@ -0,0 +1,27 @@
+#ifndef __QN_SHA1_MB_H__
+#define __QN_SHA1_MB_H__ 1
+
+#include "qiniu/os/types.h"
+#include "qiniu/macros.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// ---- Declaration of multi-buffer SHA-1 (abbreviation: sha1_mb) ----
+
+enum
+{
+    QN_SHA1_MB_DIGEST_SIZE = 20,
+    QN_SHA1_MB_MAX_LANES = 8
+};
+
+QN_SDK extern int qn_sha1_mb_lane_count(void);
+QN_SDK extern void qn_sha1_mb_digest(const char * const * restrict bufs, qn_size buf_size, int buf_cnt, unsigned char (* restrict digests)[QN_SHA1_MB_DIGEST_SIZE]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __QN_SHA1_MB_H__
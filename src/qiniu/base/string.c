@@ -10,6 +10,11 @@
 #include "qiniu/base/base64.h"
 #include "qiniu/base/errors.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define QN_STR_SIMD_SUPPORT 1
+#include <immintrin.h>
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -349,7 +354,7 @@ QN_SDK qn_ssize qn_cs_percent_encode_in_buffer_with_checker(char * restrict buf,
     int m = 0;
     int ret = 0;
 
-    if (! need_to_encode) need_to_encode = &qn_cs_percent_encode_check;
+    if (! need_to_encode || need_to_encode == &qn_cs_percent_encode_check) return qn_cs_percent_encode_in_buffer_with_table(buf, buf_size, bin, bin_size, NULL);
 
     if (!buf || buf_size <= 0) {
         for (i = 0; i < bin_size; i += 1) {
@@ -417,6 +422,154 @@ QN_SDK qn_string qn_cs_percent_encode_with_checker(const char * restrict bin, qn
     return new_str;
 }
 
+// -- The class table of qn_cs_percent_encode_check(), which keeps unreserved chars of RFC 3986 as they are.
+static const qn_cs_percent_encode_table qn_cs_percent_encode_default_table = {{
+    0x57, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x0F, 0xAF, 0xAF, 0xAB, 0x2B, 0x8F,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+}};
+
+static inline qn_bool qn_cs_percent_encode_table_check(const qn_cs_percent_encode_table * restrict tbl, unsigned char c)
+{
+    return (tbl->rows[((c & 0x80) >> 3) | (c & 0x0F)] >> ((c >> 4) & 0x07)) & 0x1;
+}
+
+QN_SDK void qn_cs_percent_encode_compile_table(qn_cs_percent_encode_table * restrict tbl, qn_cs_percent_encode_check_fn need_to_encode)
+{
+    int c;
+
+    if (! need_to_encode) need_to_encode = &qn_cs_percent_encode_check;
+
+    memset(tbl->rows, 0, sizeof(tbl->rows));
+    for (c = 0; c < 256; c += 1) {
+        // -- Pass chars as the other encoding functions do, which are signed on most platforms.
+        if (need_to_encode((char) c)) tbl->rows[((c & 0x80) >> 3) | (c & 0x0F)] |= 1 << ((c >> 4) & 0x07);
+    } // for
+}
+
+#if defined(QN_STR_SIMD_SUPPORT)
+
+#define QN_STR_SSE41 __attribute__((target("sse4.1")))
+
+// -- Check 16 chars at a time by looking up the row of the low nibble, and testing the bit of the high nibble.
+static QN_STR_SSE41 qn_size qn_cs_percent_encode_scan_sse41(const qn_cs_percent_encode_table * restrict tbl, const char * restrict bin, qn_size bin_size)
+{
+    const __m128i lo_rows = _mm_loadu_si128((const __m128i *) tbl->rows);
+    const __m128i hi_rows = _mm_loadu_si128((const __m128i *) (tbl->rows + 16));
+    const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i c;
+    __m128i lo;
+    __m128i row;
+    __m128i hits;
+    int mask;
+    qn_size i = 0;
+
+    while (i + 16 <= bin_size) {
+        c = _mm_loadu_si128((const __m128i *) (bin + i));
+        lo = _mm_and_si128(c, nibble);
+        row = _mm_blendv_epi8(_mm_shuffle_epi8(lo_rows, lo), _mm_shuffle_epi8(hi_rows, lo), c);
+        hits = _mm_and_si128(row, _mm_shuffle_epi8(bits, _mm_and_si128(_mm_srli_epi16(c, 4), nibble)));
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(hits, _mm_setzero_si128())) ^ 0xFFFF;
+        if (mask) return i + __builtin_ctz(mask);
+        i += 16;
+    } // while
+    return i;
+}
+
+#endif
+
+// -- Return the size of the leading run of chars which need no encoding.
+static inline qn_size qn_cs_percent_encode_scan(const qn_cs_percent_encode_table * restrict tbl, const char * restrict bin, qn_size bin_size)
+{
+    qn_size i = 0;
+
+#if defined(QN_STR_SIMD_SUPPORT)
+    static int has_sse41 = -1;
+
+    if (has_sse41 < 0) has_sse41 = __builtin_cpu_supports("sse4.1");
+    if (has_sse41) i = qn_cs_percent_encode_scan_sse41(tbl, bin, bin_size);
+#endif
+
+    while (i < bin_size && ! qn_cs_percent_encode_table_check(tbl, bin[i])) i += 1;
+    return i;
+}
+
+QN_SDK qn_ssize qn_cs_percent_encode_in_buffer_with_table(char * restrict buf, qn_size buf_size, const char * restrict bin, qn_size bin_size, const qn_cs_percent_encode_table * restrict tbl)
+{
+    qn_size i = 0;
+    qn_size m = 0;
+    qn_size run;
+    qn_bool measure = (!buf || buf_size <= 0);
+
+    if (! tbl) tbl = &qn_cs_percent_encode_default_table;
+
+    if (!measure && buf_size < bin_size) {
+        qn_err_set_out_of_buffer();
+        return -1;
+    } // if
+
+    while (i < bin_size) {
+        // -- Copy a run of chars which need no encoding at once.
+        run = qn_cs_percent_encode_scan(tbl, bin + i, bin_size - i);
+        if (run > 0) {
+            if (!measure) {
+                if (m + run > buf_size) {
+                    qn_err_set_out_of_buffer();
+                    return -1;
+                } // if
+                memcpy(buf + m, bin + i, run);
+            } // if
+            i += run;
+            m += run;
+            if (i == bin_size) break;
+        } // if
+
+        // -- Keep chars which have been encoded already.
+        if (bin[i] == '%' && (i + 2 < bin_size) && isxdigit((unsigned char) bin[i+1]) && isxdigit((unsigned char) bin[i+2])) {
+            if (!measure) {
+                if (m + 1 > buf_size) {
+                    qn_err_set_out_of_buffer();
+                    return -1;
+                } // if
+                buf[m] = bin[i];
+            } // if
+            i += 1;
+            m += 1;
+            continue;
+        } // if
+
+        if (!measure) {
+            if (m + 3 > buf_size) {
+                qn_err_set_out_of_buffer();
+                return -1;
+            } // if
+            buf[m] = '%';
+            buf[m+1] = qn_str_hex_map[(bin[i] >> 4) & 0xF];
+            buf[m+2] = qn_str_hex_map[bin[i] & 0xF];
+        } // if
+        i += 1;
+        m += 3;
+    } // while
+    return m;
+}
+
+QN_SDK qn_string qn_cs_percent_encode_with_table(const char * restrict bin, qn_size bin_size, const qn_cs_percent_encode_table * restrict tbl)
+{
+    qn_string new_str = NULL;
+    qn_ssize buf_size = qn_cs_percent_encode_in_buffer_with_table(NULL, 0, bin, bin_size, tbl);
+
+    if (buf_size == bin_size) return qn_cs_clone(bin, bin_size);
+
+    new_str = malloc(buf_size + 1);
+    if (!new_str) {
+        qn_err_set_out_of_memory();
+        return NULL;
+    }
+    qn_cs_percent_encode_in_buffer_with_table(new_str, buf_size, bin, bin_size, tbl);
+    new_str[buf_size] = '\0';
+    return new_str;
+}
+
 // ---- Declaration of C String ----
 
 const qn_string qn_str_empty_string = "";
@@ -427,6 +580,7 @@ QN_SDK qn_string qn_str_join_list(const char * restrict deli, const qn_string *
     char * pos = NULL;
     qn_size final_size = 0;
     qn_size deli_size = 0L;
+    qn_size str_size = 0;
     int i = 0;
 
     if (n == 1) return qn_str_duplicate(ss[0]);
@@ -444,13 +598,15 @@ QN_SDK qn_string qn_str_join_list(const char * restrict deli, const qn_string *
         return NULL;
     }
 
-    memcpy(pos, qn_str_cstr(ss[0]), qn_str_size(ss[0]));
-    pos += qn_str_size(ss[0]);
+    str_size = qn_str_size(ss[0]);
+    memcpy(pos, qn_str_cstr(ss[0]), str_size);
+    pos += str_size;
     for (i = 1; i < n; i += 1) {
         memcpy(pos, deli, deli_size);
         pos += deli_size;
-        memcpy(pos, qn_str_cstr(ss[i]), qn_str_size(ss[i]));
-        pos += qn_str_size(ss[i]);
+        str_size = qn_str_size(ss[i]);
+        memcpy(pos, qn_str_cstr(ss[i]), str_size);
+        pos += str_size;
     } // for
 
     new_str[final_size] = '\0';
@@ -464,13 +620,18 @@ QN_SDK qn_string qn_str_join_va(const char * restrict deli, const qn_string rest
     qn_string str = NULL;
     qn_size final_size = 0;
     qn_size deli_size = strlen(deli);
+    qn_size s1_size;
+    qn_size s2_size;
+    qn_size str_size;
     int n = 0;
     char * pos = NULL;
 
     if (!s1) return NULL;
     if (!s2) return qn_str_duplicate(s1);
 
-    final_size = qn_str_size(s1) + deli_size + qn_str_size(s2);
+    s1_size = qn_str_size(s1);
+    s2_size = qn_str_size(s2);
+    final_size = s1_size + deli_size + s2_size;
 
     va_copy(cp, ap);
     while ((str = va_arg(cp, qn_string))) {
@@ -485,20 +646,21 @@ QN_SDK qn_string qn_str_join_va(const char * restrict deli, const qn_string rest
         return NULL;
     } // if
 
-    memcpy(pos, qn_str_cstr(s1), qn_str_size(s1));
-    pos += qn_str_size(s1);
+    memcpy(pos, qn_str_cstr(s1), s1_size);
+    pos += s1_size;
     memcpy(pos, deli, deli_size);
     pos += deli_size;
-    memcpy(pos, qn_str_cstr(s2), qn_str_size(s2));
-    pos += qn_str_size(s2);
+    memcpy(pos, qn_str_cstr(s2), s2_size);
+    pos += s2_size;
 
     if (n > 0) {
         va_copy(cp, ap);
         while ((str = va_arg(cp, qn_string))) {
             memcpy(pos, deli, deli_size);
             pos += deli_size;
-            memcpy(pos, qn_str_cstr(str), qn_str_size(str));
-            pos += qn_str_size(str);
+            str_size = qn_str_size(str);
+            memcpy(pos, qn_str_cstr(str), str_size);
+            pos += str_size;
         } // while
         va_end(cp);
     } // if
@@ -507,6 +669,132 @@ QN_SDK qn_string qn_str_join_va(const char * restrict deli, const qn_string rest
     return new_str; 
 }
 
+// ---- Definition of String Builder ----
+
+#define QN_STR_BLD_DEFAULT_CAPACITY 256
+
+typedef struct _QN_STRING_BUILDER
+{
+    char * buf;
+    qn_size size;
+    qn_size cap; // Excluding the space for the NUL char.
+} qn_str_builder_st;
+
+QN_SDK qn_str_builder_ptr qn_str_bld_create(qn_size cap)
+{
+    qn_str_builder_ptr new_bld = calloc(1, sizeof(qn_str_builder_st));
+    if (!new_bld) {
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+
+    new_bld->cap = (cap > 0) ? cap : QN_STR_BLD_DEFAULT_CAPACITY;
+    new_bld->buf = malloc(new_bld->cap + 1);
+    if (!new_bld->buf) {
+        free(new_bld);
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+
+    new_bld->buf[0] = '\0';
+    return new_bld;
+}
+
+QN_SDK void qn_str_bld_destroy(qn_str_builder_ptr restrict bld)
+{
+    if (bld) {
+        free(bld->buf);
+        free(bld);
+    } // if
+}
+
+QN_SDK void qn_str_bld_reset(qn_str_builder_ptr restrict bld)
+{
+    bld->size = 0;
+    bld->buf[0] = '\0';
+}
+
+QN_SDK const char * qn_str_bld_cstr(const qn_str_builder_ptr restrict bld)
+{
+    return bld->buf;
+}
+
+QN_SDK qn_size qn_str_bld_size(const qn_str_builder_ptr restrict bld)
+{
+    return bld->size;
+}
+
+static qn_bool qn_str_bld_reserve(qn_str_builder_ptr restrict bld, qn_size more)
+{
+    char * new_buf;
+    qn_size new_cap = bld->cap;
+
+    if (bld->size + more <= bld->cap) return qn_true;
+
+    while (new_cap < bld->size + more) new_cap *= 2;
+
+    new_buf = realloc(bld->buf, new_cap + 1);
+    if (!new_buf) {
+        qn_err_set_out_of_memory();
+        return qn_false;
+    } // if
+
+    bld->buf = new_buf;
+    bld->cap = new_cap;
+    return qn_true;
+}
+
+QN_SDK qn_bool qn_str_bld_append_raw(qn_str_builder_ptr restrict bld, const char * restrict s, qn_size s_size)
+{
+    if (!qn_str_bld_reserve(bld, s_size)) return qn_false;
+
+    memcpy(bld->buf + bld->size, s, s_size);
+    bld->size += s_size;
+    bld->buf[bld->size] = '\0';
+    return qn_true;
+}
+
+QN_SDK qn_bool qn_str_bld_append_base64_urlsafe(qn_str_builder_ptr restrict bld, const char * restrict bin, qn_size bin_size)
+{
+    qn_size encoding_size = qn_b64_encode_urlsafe(NULL, 0, bin, bin_size, QN_B64_APPEND_PADDING);
+
+    if (!qn_str_bld_reserve(bld, encoding_size)) return qn_false;
+
+    bld->size += qn_b64_encode_urlsafe(bld->buf + bld->size, encoding_size, bin, bin_size, QN_B64_APPEND_PADDING);
+    bld->buf[bld->size] = '\0';
+    return qn_true;
+}
+
+QN_SDK qn_bool qn_str_bld_append_percent_encoded(qn_str_builder_ptr restrict bld, const char * restrict bin, qn_size bin_size, const qn_cs_percent_encode_table * restrict tbl)
+{
+    qn_ssize encoded_size;
+
+    // -- Reserve for the worst case that every char is encoded, so the text is scanned only once.
+    if (!qn_str_bld_reserve(bld, bin_size * 3)) return qn_false;
+
+    encoded_size = qn_cs_percent_encode_in_buffer_with_table(bld->buf + bld->size, bld->cap - bld->size, bin, bin_size, tbl);
+    if (encoded_size < 0) return qn_false;
+
+    bld->size += encoded_size;
+    bld->buf[bld->size] = '\0';
+    return qn_true;
+}
+
+QN_SDK qn_bool qn_str_bld_append_integer(qn_str_builder_ptr restrict bld, long long val)
+{
+    char buf[24];
+    char * pos = buf + sizeof(buf);
+    unsigned long long uval = (val < 0) ? -(unsigned long long) val : (unsigned long long) val;
+
+    do {
+        *--pos = '0' + (uval % 10);
+        uval /= 10;
+    } while (uval > 0);
+    if (val < 0) *--pos = '-';
+
+    return qn_str_bld_append_raw(bld, pos, buf + sizeof(buf) - pos);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -85,8 +85,20 @@ QN_SDK extern qn_bool qn_cs_percent_encode_check(int c);
 QN_SDK extern qn_ssize qn_cs_percent_encode_in_buffer_with_checker(char * restrict buf, qn_size buf_size, const char * restrict bin, qn_size bin_size, qn_cs_percent_encode_check_fn need_to_encode);
 QN_SDK extern qn_string qn_cs_percent_encode_with_checker(const char * restrict bin, qn_size bin_size, qn_cs_percent_encode_check_fn need_to_encode);
 
-#define qn_cs_percent_encode_in_buffer(buf, buf_size, bin, bin_size) qn_cs_percent_encode_in_buffer_with_checker(buf, buf_size, bin, bin_size, NULL)
-#define qn_cs_percent_encode(bin, bin_size) qn_cs_percent_encode_with_checker(bin, bin_size, NULL)
+// -- A class table holds one bit per byte value, set if the byte needs encoding. Compile a custom checker into a
+//    table once and encode with the table, which scans runs of chars to keep many at a time. Pass NULL to use
+//    the table of qn_cs_percent_encode_check().
+typedef struct _QN_CS_PERCENT_ENCODE_TABLE
+{
+    unsigned char rows[32]; // Indexed by the top bit and the low nibble, one bit per value of the other 3 bits.
+} qn_cs_percent_encode_table;
+
+QN_SDK extern void qn_cs_percent_encode_compile_table(qn_cs_percent_encode_table * restrict tbl, qn_cs_percent_encode_check_fn need_to_encode);
+QN_SDK extern qn_ssize qn_cs_percent_encode_in_buffer_with_table(char * restrict buf, qn_size buf_size, const char * restrict bin, qn_size bin_size, const qn_cs_percent_encode_table * restrict tbl);
+QN_SDK extern qn_string qn_cs_percent_encode_with_table(const char * restrict bin, qn_size bin_size, const qn_cs_percent_encode_table * restrict tbl);
+
+#define qn_cs_percent_encode_in_buffer(buf, buf_size, bin, bin_size) qn_cs_percent_encode_in_buffer_with_table(buf, buf_size, bin, bin_size, NULL)
+#define qn_cs_percent_encode(bin, bin_size) qn_cs_percent_encode_with_table(bin, bin_size, NULL)
 
 // ---- Declaration of String ----
 
@@ -193,6 +205,31 @@ static inline qn_string qn_str_concat_3(const qn_string restrict s1, const qn_st
     return qn_str_join("", s1, s2, s3, NULL);
 }
 
+// ---- Declaration of String Builder ----
+//
+// A builder owns a growable buffer which always holds a NUL-terminated string. Reset it instead of destroying
+// it between uses, then the buffer is reused and no allocation happens once it grows large enough.
+
+struct _QN_STRING_BUILDER;
+typedef struct _QN_STRING_BUILDER * qn_str_builder_ptr;
+
+QN_SDK extern qn_str_builder_ptr qn_str_bld_create(qn_size cap);
+QN_SDK extern void qn_str_bld_destroy(qn_str_builder_ptr restrict bld);
+QN_SDK extern void qn_str_bld_reset(qn_str_builder_ptr restrict bld);
+
+QN_SDK extern const char * qn_str_bld_cstr(const qn_str_builder_ptr restrict bld);
+QN_SDK extern qn_size qn_str_bld_size(const qn_str_builder_ptr restrict bld);
+
+QN_SDK extern qn_bool qn_str_bld_append_raw(qn_str_builder_ptr restrict bld, const char * restrict s, qn_size s_size);
+QN_SDK extern qn_bool qn_str_bld_append_base64_urlsafe(qn_str_builder_ptr restrict bld, const char * restrict bin, qn_size bin_size);
+QN_SDK extern qn_bool qn_str_bld_append_percent_encoded(qn_str_builder_ptr restrict bld, const char * restrict bin, qn_size bin_size, const qn_cs_percent_encode_table * restrict tbl);
+QN_SDK extern qn_bool qn_str_bld_append_integer(qn_str_builder_ptr restrict bld, long long val);
+
+static inline qn_bool qn_str_bld_append_cstr(qn_str_builder_ptr restrict bld, const char * restrict s)
+{
+    return qn_str_bld_append_raw(bld, s, posix_strlen(s));
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,3 +1,4 @@
+#include <pthread.h>
 #include <openssl/md5.h>
 #include <openssl/err.h>
 #include "qiniu/cdn.h"
@@ -22,6 +23,14 @@ static qn_bool qn_cdn_percent_encode_check(int c)
     return qn_cs_percent_encode_check(c);
 }
 
+static qn_cs_percent_encode_table qn_cdn_percent_encode_table;
+static pthread_once_t qn_cdn_percent_encode_table_once = PTHREAD_ONCE_INIT;
+
+static void qn_cdn_compile_percent_encode_table(void)
+{
+    qn_cs_percent_encode_compile_table(&qn_cdn_percent_encode_table, &qn_cdn_percent_encode_check);
+}
+
 QN_SDK qn_string qn_cdn_make_dnurl_with_deadline(const char * restrict key, const char * restrict url, qn_uint32 deadline)
 {
     // ---- This function is based on the algorithm described on https://support.qiniu.com/question/195128 .
@@ -75,12 +84,13 @@ QN_SDK qn_string qn_cdn_make_dnurl_with_deadline(const char * restrict key, cons
         base_url_size = path - url;
 
         path_size = query - path;
-        encoded_path_size = qn_cs_percent_encode_in_buffer_with_checker(NULL, -1, path, path_size, &qn_cdn_percent_encode_check);
+        pthread_once(&qn_cdn_percent_encode_table_once, &qn_cdn_compile_percent_encode_table);
+        encoded_path_size = qn_cs_percent_encode_in_buffer_with_table(NULL, -1, path, path_size, &qn_cdn_percent_encode_table);
         if (encoded_path_size > path_size) {
             encoded_path = malloc(encoded_path_size + 1);
             if (! encoded_path) return NULL;
 
-            qn_cs_percent_encode_in_buffer_with_checker(encoded_path, encoded_path_size, path, path_size, &qn_cdn_percent_encode_check);
+            qn_cs_percent_encode_in_buffer_with_table(encoded_path, encoded_path_size, path, path_size, &qn_cdn_percent_encode_table);
             encoded_path[encoded_path_size] = '\0';
 
             sign_str = qn_cs_concat(key, encoded_path, encoded_unix_epoch, NULL);
@@ -17,6 +17,7 @@ typedef int qn_etbl_pos;
 typedef struct _QN_ETABLE
 {
     qn_string deli;
+    qn_size deli_size;
     qn_string * entries;
     qn_etbl_pos cnt;
     qn_etbl_pos cap;
@@ -36,6 +37,7 @@ QN_SDK qn_etable_ptr qn_etbl_create(const char * restrict deli)
         qn_err_set_out_of_memory();
         return NULL;
     } // if
+    new_etbl->deli_size = qn_str_size(new_etbl->deli);
 
     new_etbl->cnt = 0;
     new_etbl->cap = 4;
@@ -128,14 +130,14 @@ QN_SDK const char * qn_etbl_get_value(qn_etable_ptr restrict etbl, const char *
 {
     int ord;
     qn_etbl_pos pos = qn_etbl_bsearch(etbl, key, strlen(key), &ord);
-    return (pos == etbl->cnt) ? NULL : (strstr(etbl->entries[pos], etbl->deli) + qn_str_size(etbl->deli));
+    return (pos == etbl->cnt) ? NULL : (strstr(etbl->entries[pos], etbl->deli) + etbl->deli_size);
 }
 
 QN_SDK void qn_etbl_get_pair_raw(qn_etable_ptr restrict etbl, const qn_string ent, const char ** restrict key, qn_size * restrict key_size, const char ** restrict val, qn_size * restrict val_size)
 {
     *key = ent;
     *key_size = strstr(ent, etbl->deli) - ent;
-    *val = *key + *key_size + qn_str_size(etbl->deli);
+    *val = *key + *key_size + etbl->deli_size;
     *val_size = (ent + qn_str_size(ent)) - *val;
 }
 
@@ -147,7 +149,7 @@ static qn_bool qn_etbl_set_entry(qn_etable_ptr restrict etbl, const char * restr
 
     if (etbl->cnt == etbl->cap && !qn_etbl_augment(etbl)) return qn_false;
 
-    new_entry = qn_cs_concat_raw(key, key_size, etbl->deli, posix_strlen(etbl->deli), val, val_size, NULL);
+    new_entry = qn_cs_concat_raw(key, key_size, etbl->deli, etbl->deli_size, val, val_size, NULL);
     if (!new_entry) {
         qn_err_set_out_of_memory();
         return qn_false;
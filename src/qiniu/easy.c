@@ -44,6 +44,13 @@ typedef struct _QN_EASY_PUT_EXTRA
         qn_fsize fsize;             // The size of the local file provided by the caller.
         qn_io_reader_itf rdr;       // A customized data reader provided by the caller.
 
+        qn_size ra_buf_size;        // The size of each buffer read ahead from the local file, 0 means the default.
+        int ra_depth;               // The number of buffers read ahead for each reader of the local file. Reading ahead
+                                    // is off by default, and only a positive number enables it.
+
+        qn_uint32 ru_opts;          // Options of resumable uploads, such as QN_STOR_RU_ADAPT_CHUNK_SIZE. None is set
+                                    // by default.
+
         qn_string resumable_info;
         qn_ud_variable_ptr ud_vars; // User-Defined Variables.
 
@@ -136,6 +143,17 @@ QN_SDK void qn_easy_pe_set_min_resumable_fsize(qn_easy_put_extra_ptr restrict pe
     pe->put_ctrl.min_resumable_fsize = fsize;
 }
 
+QN_SDK void qn_easy_pe_set_read_ahead(qn_easy_put_extra_ptr restrict pe, qn_size buf_size, int depth)
+{
+    pe->put_ctrl.ra_buf_size = buf_size;
+    pe->put_ctrl.ra_depth = depth;
+}
+
+QN_SDK void qn_easy_pe_set_resumable_options(qn_easy_put_extra_ptr restrict pe, qn_uint32 opts)
+{
+    pe->put_ctrl.ru_opts = opts;
+}
+
 QN_SDK void qn_easy_pe_set_local_crc32(qn_easy_put_extra_ptr restrict pe, qn_uint32 crc32)
 {
     pe->put_ctrl.fcrc32 = crc32;
@@ -185,6 +203,7 @@ typedef struct _QN_EASY
     qn_json_parser_ptr json_prs;
     qn_rgn_service_ptr rgn_svc;
     qn_rgn_table_ptr rgn_tbl;
+    qn_http_connection_pool_ptr pool;
 } qn_easy_st;
 
 QN_SDK qn_easy_ptr qn_easy_create(void)
@@ -214,6 +233,13 @@ QN_SDK void qn_easy_destroy(qn_easy_ptr restrict easy)
     } // if
 }
 
+QN_SDK void qn_easy_set_pool(qn_easy_ptr restrict easy, qn_http_connection_pool_ptr restrict pool)
+{
+    easy->pool = pool;
+    qn_stor_set_pool(easy->stor, pool);
+    if (easy->rgn_svc) qn_rgn_svc_set_pool(easy->rgn_svc, pool);
+}
+
 #define QN_EASY_MB_UNIT (1 << 20)
 
 static void qn_easy_init_put_extra(qn_easy_put_extra_ptr ext, qn_easy_put_extra_ptr real_ext)
@@ -229,6 +255,21 @@ static void qn_easy_init_put_extra(qn_easy_put_extra_ptr ext, qn_easy_put_extra_
     if (real_ext->temp.qetag) qn_etag_ctx_init(real_ext->temp.qetag);
 }
 
+static qn_file_ptr qn_easy_open_put_file(const char * restrict fname, qn_easy_put_extra_ptr real_ext)
+{
+    qn_fl_open_extra fl_ext;
+
+    memset(&fl_ext, 0, sizeof(fl_ext));
+    if (real_ext->put_ctrl.ra_depth > 0) {
+        // -- Read the following chunks while the current one is being sent. It falls back to plain reads if io_uring
+        //    is not available.
+        fl_ext.flags = QN_FL_OPEN_READ_AHEAD;
+        fl_ext.ra_buf_size = real_ext->put_ctrl.ra_buf_size;
+        fl_ext.ra_depth = real_ext->put_ctrl.ra_depth;
+    } // if
+    return qn_fl_open(fname, &fl_ext);
+}
+
 static qn_io_reader_itf qn_easy_create_put_reader(const char * restrict fname, qn_easy_put_extra_ptr real_ext)
 {
     qn_file_ptr fl = NULL;
@@ -239,7 +280,7 @@ static qn_io_reader_itf qn_easy_create_put_reader(const char * restrict fname, q
     if (real_ext->put_ctrl.rdr) {
         io_rdr = real_ext->put_ctrl.rdr;
     } else {
-        fl = qn_fl_open(fname, NULL);
+        fl = qn_easy_open_put_file(fname, real_ext);
         if (! fl) return NULL;
 
         real_ext->put_ctrl.fsize = qn_fl_fsize(fl);
@@ -281,6 +322,9 @@ static qn_json_object_ptr qn_easy_put_file_in_one_piece(qn_easy_ptr restrict eas
     if (io_rdr) {
         ret = qn_stor_up_api_upload(easy->stor, uptoken, io_rdr, upe);
     } else {
+        // -- The file is mapped and checksummed in place, instead of going through the filters of the reader.
+        qn_stor_upe_set_crc32_checking(upe, ext->put_ctrl.check_crc32);
+        if (ext->put_ctrl.check_qetag) qn_stor_upe_set_qetag_context(upe, ext->temp.qetag);
         ret = qn_stor_up_api_upload_file(easy->stor, uptoken, fname, upe);
     } // if
     qn_stor_upe_destroy(upe);
@@ -292,12 +336,14 @@ static qn_json_object_ptr qn_easy_put_huge(qn_easy_ptr restrict easy, const char
     int start_idx = 0;
     qn_string resumable_info = NULL;
     qn_stor_upload_extra_ptr upe = NULL;
-    qn_json_object_ptr put_ret;
+    qn_json_object_ptr put_ret = NULL;
     qn_stor_resumable_upload_ptr ru;
 
-    if (ext) {
-        if (! (upe = qn_stor_upe_create())) return NULL;
+    if (! (upe = qn_stor_upe_create())) return NULL;
 
+    if (ext) {
+        // -- Adapted chunk sizes are kept on the connection of the easy object, so later uploads start from them.
+        qn_stor_upe_set_resumable_options(upe, ext->put_ctrl.ru_opts);
         qn_stor_upe_set_final_key(upe, ext->attr.final_key);
         qn_stor_upe_set_mime_type(upe, ext->attr.mime_type);
         qn_stor_upe_set_user_defined_variables(upe, ext->put_ctrl.ud_vars);
@@ -364,6 +410,7 @@ static qn_rgn_host_ptr qn_easy_select_putting_region_host(qn_easy_ptr restrict e
     if (! easy->rgn_svc) {
         easy->rgn_svc = qn_rgn_svc_create();
         if (! easy->rgn_svc) return NULL;
+        qn_rgn_svc_set_pool(easy->rgn_svc, easy->pool);
     } // if
 
     if (! easy->rgn_tbl) {
@@ -457,10 +504,11 @@ QN_SDK qn_json_object_ptr qn_easy_put_file(qn_easy_ptr restrict easy, const char
 {
     int i;
     qn_string tmp_str;
-    qn_io_reader_itf io_rdr;
+    qn_io_reader_itf io_rdr = NULL;
     qn_json_object_ptr put_ret;
     qn_easy_put_extra_st real_ext;
     qn_rgn_host_ptr rgn_host;
+    qn_fl_info_ptr fi;
     qn_json_object_ptr pp = NULL;
 
     qn_easy_init_put_extra(ext, &real_ext);
@@ -486,10 +534,23 @@ QN_SDK qn_json_object_ptr qn_easy_put_file(qn_easy_ptr restrict easy, const char
         } // if
     } // if
 
-    io_rdr = qn_easy_create_put_reader(fname, &real_ext);
-    if (! io_rdr) {
-        qn_json_destroy_object(pp);
-        return NULL;
+    if (! real_ext.put_ctrl.rdr) {
+        // -- Stat the size first, since small files are mapped and uploaded in one piece without any reader.
+        fi = qn_fl_info_stat(fname);
+        if (! fi) {
+            qn_json_destroy_object(pp);
+            return NULL;
+        } // if
+        real_ext.put_ctrl.fsize = qn_fl_info_fsize(fi);
+        qn_fl_info_destroy(fi);
+    } // if
+
+    if (real_ext.put_ctrl.rdr || real_ext.put_ctrl.fsize > real_ext.put_ctrl.min_resumable_fsize) {
+        io_rdr = qn_easy_create_put_reader(fname, &real_ext);
+        if (! io_rdr) {
+            qn_json_destroy_object(pp);
+            return NULL;
+        } // if
     } // if
 
     if (real_ext.put_ctrl.rgn_entry) {
@@ -510,7 +571,7 @@ QN_SDK qn_json_object_ptr qn_easy_put_file(qn_easy_ptr restrict easy, const char
         } // for
     } // if
 
-    qn_io_rdr_close(io_rdr);
+    if (io_rdr) qn_io_rdr_close(io_rdr);
     qn_json_destroy_object(pp);
 
     if (put_ret && (qn_json_get_integer(put_ret, "fn-code", 0) == 200)) {
@@ -549,7 +610,7 @@ QN_SDK qn_json_object_ptr qn_easy_put_huge_file(qn_easy_ptr restrict easy, const
         } // if
     } // if
 
-    fl = qn_fl_open(fname, NULL);
+    fl = qn_easy_open_put_file(fname, &real_ext);
     if (! fl) {
         qn_json_destroy_object(pp);
         return NULL;
@@ -600,15 +661,31 @@ QN_SDK void qn_easy_le_set_limit(qn_easy_list_extra_ptr restrict le, unsigned in
 
 // ----
 
+typedef struct _QN_EASY_LIST_ITERATOR
+{
+    void * itr_data;
+    qn_easy_le_itr_callback_fn itr_cb;
+    unsigned int cnt;
+    qn_bool stopped;
+} qn_easy_list_iterator;
+
+static qn_bool qn_easy_list_item_cfn(void * restrict itm_data, qn_json_object_ptr restrict item)
+{
+    qn_easy_list_iterator * itr = (qn_easy_list_iterator *) itm_data;
+
+    itr->cnt += 1;
+    if (itr->stopped) return qn_false;
+    if (! itr->itr_cb(itr->itr_data, item)) itr->stopped = qn_true;
+    return ! itr->stopped;
+}
+
 QN_SDK qn_json_object_ptr qn_easy_list(qn_easy_ptr restrict easy, const qn_mac_ptr restrict mac, const char * restrict bucket, void * restrict itr_data, qn_easy_le_itr_callback_fn itr_cb, qn_easy_list_extra_ptr restrict ext)
 {
     qn_string marker = NULL;
     qn_json_object_ptr list_ret;
-    qn_json_object_ptr item;
-    qn_json_array_ptr items;
     qn_stor_list_extra_ptr lse;
     qn_easy_list_extra_st real_ext;
-    int i;
+    qn_easy_list_iterator itr;
 
     assert(easy);
     assert(bucket);
@@ -628,9 +705,16 @@ QN_SDK qn_json_object_ptr qn_easy_list(qn_easy_ptr restrict easy, const qn_mac_p
     if (real_ext.prefix) qn_stor_lse_set_prefix(lse, real_ext.prefix, real_ext.delimiter);
     if (real_ext.limit) qn_stor_lse_set_limit(lse, real_ext.limit);
 
+    // ---- Hand out items as soon as they are parsed, rather than after the whole page is received.
+    itr.itr_data = itr_data;
+    itr.itr_cb = itr_cb;
+    itr.stopped = qn_false;
+    qn_stor_lse_set_item_callback(lse, &itr, &qn_easy_list_item_cfn);
+
     do {
         if (marker) qn_stor_lse_set_marker(lse, qn_str_cstr(marker));
 
+        itr.cnt = 0;
         list_ret = qn_stor_ls_api_list(easy->stor, mac, bucket, lse);
         qn_str_destroy(marker);
         if (! list_ret) {
@@ -642,20 +726,11 @@ QN_SDK qn_json_object_ptr qn_easy_list(qn_easy_ptr restrict easy, const qn_mac_p
             return list_ret;
         } // if
 
-        items = qn_json_get_array(list_ret, "items", NULL);
-        if (! items) {
+        if (itr.stopped) {
             qn_stor_lse_destroy(lse);
-            return list_ret;
+            return NULL;
         } // if
 
-        for (i = 0; i < qn_json_size_array(items); i += 1) {
-            item = qn_json_pick_object(items, i, NULL);
-            if (! itr_cb(itr_data, item)) {
-                qn_stor_lse_destroy(lse);
-                return NULL;
-            } // if
-        } // for
-
         if (qn_json_get_string(list_ret, "marker", NULL)) {
             marker = qn_cs_duplicate(qn_json_get_string(list_ret, "marker", NULL));
             if (! marker) {
@@ -666,8 +741,9 @@ QN_SDK qn_json_object_ptr qn_easy_list(qn_easy_ptr restrict easy, const qn_mac_p
         } else {
             marker = NULL;
         } // if
-    } while (qn_json_size_array(items) == real_ext.limit && marker);
+    } while (itr.cnt == real_ext.limit && marker);
 
+    qn_stor_lse_destroy(lse);
     return list_ret;
 }
 
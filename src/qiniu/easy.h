@@ -19,6 +19,8 @@ typedef struct _QN_EASY * qn_easy_ptr;
 QN_SDK extern qn_easy_ptr qn_easy_create(void);
 QN_SDK extern void qn_easy_destroy(qn_easy_ptr restrict easy);
 
+QN_SDK extern void qn_easy_set_pool(qn_easy_ptr restrict easy, qn_http_connection_pool_ptr restrict pool);
+
 // ----
 
 QN_SDK extern qn_json_object_ptr qn_easy_fi_stat(const char * restrict fname);
@@ -53,6 +55,12 @@ QN_SDK extern void qn_easy_pe_set_abort_variable(qn_easy_put_extra_ptr restrict
 
 QN_SDK extern void qn_easy_pe_set_min_resumable_fsize(qn_easy_put_extra_ptr restrict pe, qn_size fsize);
 
+// -- Read the local file ahead with `depth` buffers of `buf_size` bytes each. It is off unless `depth` is positive.
+QN_SDK extern void qn_easy_pe_set_read_ahead(qn_easy_put_extra_ptr restrict pe, qn_size buf_size, int depth);
+
+// -- Options of resumable uploads, such as QN_STOR_RU_PIPELINE_CHUNKS and QN_STOR_RU_ADAPT_CHUNK_SIZE.
+QN_SDK extern void qn_easy_pe_set_resumable_options(qn_easy_put_extra_ptr restrict pe, qn_uint32 opts);
+
 QN_SDK extern void qn_easy_pe_set_local_crc32(qn_easy_put_extra_ptr restrict pe, qn_uint32 crc32);
 QN_SDK extern void qn_easy_pe_set_source_reader(qn_easy_put_extra_ptr restrict pe, qn_io_reader_itf restrict rdr, qn_fsize fsize);
 
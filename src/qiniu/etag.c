@@ -1,6 +1,10 @@
+#include <assert.h>
+#include <pthread.h>
 #include <openssl/sha.h>
 
 #include "qiniu/base/errors.h"
+#include "qiniu/base/sha1_mb.h"
+#include "qiniu/os/file.h"
 #include "qiniu/etag.h"
 
 #ifdef __cplusplus
@@ -14,8 +18,11 @@ typedef unsigned int qn_etag_alloc;
 typedef unsigned short int qn_etag_pos;
 
 #define QN_ETAG_BLK_MAX_SIZE (1 << 22)
+#define QN_ETAG_MAP_MAX_SIZE (QN_ETAG_BLK_MAX_SIZE * 16)
 
-#if (!defined(QN_ETAG_BLK_MAX_COUNT) || QN_ETAG_BLK_MAX_COUNT < 2)
+#if !defined(QN_ETAG_BLK_MAX_COUNT)
+#define QN_ETAG_BLK_MAX_COUNT 16
+#elif (QN_ETAG_BLK_MAX_COUNT < 2)
 #undef QN_ETAG_BLK_MAX_COUNT
 #define QN_ETAG_BLK_MAX_COUNT 2
 #endif
@@ -30,6 +37,8 @@ typedef unsigned short int qn_etag_pos;
 typedef struct _QN_ETAG_BLOCK
 {
     SHA_CTX sha1_ctx; 
+    qn_bool digested;
+    unsigned char digest[SHA_DIGEST_LENGTH];
 } qn_etag_block;
 
 QN_SDK qn_bool qn_etag_blk_update(qn_etag_block_ptr restrict blk, char * restrict buf, int buf_size)
@@ -57,6 +66,7 @@ typedef struct _QN_ETAG_CONTEXT
 
     qn_etag_block_ptr blk;
     int blk_cap;
+    int mb_lane_cnt;
 
     qn_etag_alloc allocs[QN_ETAG_ALLOCATION_MAX_COUNT];
     qn_etag_block blks[QN_ETAG_BLK_MAX_COUNT];
@@ -75,6 +85,7 @@ QN_SDK qn_etag_context_ptr qn_etag_ctx_create(void)
         free(new_ctx);
         return NULL;
     } // if
+    qn_etag_ctx_set_backend(new_ctx, QN_ETAG_BACKEND_AUTO);
     return new_ctx;
 }
 
@@ -85,14 +96,42 @@ QN_SDK void qn_etag_ctx_destroy(qn_etag_context_ptr restrict ctx)
     } // if
 }
 
+// Choose the SHA-1 implementation for hashing whole blocks. The multi-buffer backend hashes several blocks
+// at once on SIMD lanes, and is used by default if the CPU supports it.
+QN_SDK qn_bool qn_etag_ctx_set_backend(qn_etag_context_ptr restrict ctx, qn_etag_backend_em backend)
+{
+    switch (backend) {
+        case QN_ETAG_BACKEND_AUTO:
+            ctx->mb_lane_cnt = qn_sha1_mb_lane_count();
+            break;
+
+        case QN_ETAG_BACKEND_OPENSSL:
+            ctx->mb_lane_cnt = 0;
+            break;
+
+        case QN_ETAG_BACKEND_MULTI_BUFFER:
+            if (qn_sha1_mb_lane_count() == 0) {
+                qn_err_set_invalid_argument();
+                return qn_false;
+            } // if
+            ctx->mb_lane_cnt = qn_sha1_mb_lane_count();
+            break;
+
+        default:
+            qn_err_set_invalid_argument();
+            return qn_false;
+    } // switch
+    return qn_true;
+}
+
 static qn_bool qn_etag_ctx_merge_blocks(qn_etag_context_ptr ctx)
 {
     unsigned char digest[SHA_DIGEST_LENGTH];
-    qn_etag_pos i = ctx->begin / QN_ETAG_BLK_MAX_COUNT;
 
-    qn_etag_alloc b = 0x1L << (ctx->begin % QN_ETAG_BLK_MAX_COUNT);
-    while (ctx->unused < QN_ETAG_BLK_MAX_COUNT && ctx->allocs[i] & b) {
-        if (SHA1_Final(digest, &ctx->blks[ctx->begin].sha1_ctx) == 0) {
+    while (ctx->unused < QN_ETAG_BLK_MAX_COUNT && QN_ETAG_ALLOC_IS_SET(ctx->allocs, ctx->begin)) {
+        if (ctx->blks[ctx->begin].digested) {
+            memcpy(digest, ctx->blks[ctx->begin].digest, sizeof(digest));
+        } else if (SHA1_Final(digest, &ctx->blks[ctx->begin].sha1_ctx) == 0) {
             qn_err_etag_set_making_digest_failed();
             return qn_false;
         } // if
@@ -101,14 +140,7 @@ static qn_bool qn_etag_ctx_merge_blocks(qn_etag_context_ptr ctx)
             return qn_false;
         } // if
 
-        ctx->allocs[i] &= ~b; // reset
-        if (b == 0) {
-            b = 0x1L;
-            i += 1;
-            if (i == QN_ETAG_ALLOCATION_MAX_COUNT) i = 0;
-        } else {
-            b <<= 1;
-        } // if
+        QN_ETAG_ALLOC_RESET(ctx->allocs, ctx->begin);
         if (++ctx->begin == QN_ETAG_BLK_MAX_COUNT) ctx->begin = 0;
         ctx->unused += 1;
     } // while
@@ -125,6 +157,7 @@ QN_SDK qn_bool qn_etag_ctx_init(qn_etag_context_ptr restrict ctx)
         qn_err_etag_set_initializing_context_failed();
         return qn_false;
     } // if
+    ctx->blks[0].digested = qn_false;
     ctx->unused = QN_ETAG_BLK_MAX_COUNT;
     ctx->begin = 0;
     ctx->end = 0;
@@ -134,6 +167,34 @@ QN_SDK qn_bool qn_etag_ctx_init(qn_etag_context_ptr restrict ctx)
     return qn_true;
 }
 
+static int qn_etag_ctx_update_blocks(qn_etag_context_ptr restrict ctx, const char * restrict buf, int buf_size)
+{
+    unsigned char digests[QN_SHA1_MB_MAX_LANES][QN_SHA1_MB_DIGEST_SIZE];
+    const char * bufs[QN_SHA1_MB_MAX_LANES] = {NULL};
+    qn_etag_block_ptr blks[QN_SHA1_MB_MAX_LANES];
+    int blk_cap;
+    int blk_cnt = buf_size / QN_ETAG_BLK_MAX_SIZE;
+    int i;
+
+    if (blk_cnt > ctx->mb_lane_cnt) blk_cnt = ctx->mb_lane_cnt;
+    if (blk_cnt > ctx->unused) blk_cnt = ctx->unused;
+
+    // ---- Hash whole blocks at once, and commit their digests in order.
+    for (i = 0; i < blk_cnt; i += 1) {
+        if (!qn_etag_ctx_allocate_block(ctx, &blks[i], &blk_cap)) return -1;
+        bufs[i] = buf + i * QN_ETAG_BLK_MAX_SIZE;
+    } // for
+
+    qn_sha1_mb_digest(bufs, QN_ETAG_BLK_MAX_SIZE, blk_cnt, digests);
+
+    for (i = 0; i < blk_cnt; i += 1) {
+        memcpy(blks[i]->digest, digests[i], SHA_DIGEST_LENGTH);
+        blks[i]->digested = qn_true;
+        if (!qn_etag_ctx_commit_block(ctx, blks[i])) return -1;
+    } // for
+    return blk_cnt * QN_ETAG_BLK_MAX_SIZE;
+}
+
 QN_SDK qn_bool qn_etag_ctx_update(qn_etag_context_ptr restrict ctx, char * restrict buf, int buf_size)
 {
     int update_size;
@@ -141,6 +202,14 @@ QN_SDK qn_bool qn_etag_ctx_update(qn_etag_context_ptr restrict ctx, char * restr
     char * pos = buf;
 
     while (rem_size > 0) {
+        if (!ctx->blk && rem_size >= QN_ETAG_BLK_MAX_SIZE * 2 && ctx->mb_lane_cnt > 1 && ctx->unused > 1) {
+            update_size = qn_etag_ctx_update_blocks(ctx, pos, rem_size);
+            if (update_size < 0) return qn_false;
+            rem_size -= update_size;
+            pos += update_size;
+            continue;
+        } // if
+
         if (!ctx->blk) {
             qn_etag_ctx_allocate_block(ctx, &ctx->blk, &ctx->blk_cap);
         } // if
@@ -198,6 +267,7 @@ QN_SDK qn_bool qn_etag_ctx_allocate_block(qn_etag_context_ptr restrict ctx, qn_e
         qn_err_etag_set_initializing_block_failed();
         return qn_false;
     } // if
+    ctx->blks[ctx->end].digested = qn_false;
     
     *blk = &ctx->blks[ctx->end];
     QN_ETAG_ALLOC_RESET(ctx->allocs, ctx->end);
@@ -224,9 +294,269 @@ QN_SDK qn_bool qn_etag_ctx_commit_block(qn_etag_context_ptr restrict ctx, qn_eta
     return qn_etag_ctx_merge_blocks(ctx);
 }
 
+// ---- Definition of concurrent QETAG calculator
+
+typedef struct _QN_ETAG_JOB
+{
+    qn_etag_block_ptr blk;
+    char * buf;
+    int buf_size;
+} qn_etag_job;
+
+typedef struct _QN_ETAG_WORKER_POOL
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    qn_etag_context_ptr ctx;
+
+    int job_cnt;
+    int job_head;
+    int free_cnt;
+    int stopped;
+    int failed;
+    qn_err_code_em err_code; // The error of the first failed worker.
+
+    qn_etag_job * jobs;
+    char ** free_bufs;
+} qn_etag_worker_pool;
+
+static void * qn_etag_wkr_routine(void * data)
+{
+    qn_etag_worker_pool * pool = (qn_etag_worker_pool *) data;
+    qn_etag_job job;
+    qn_bool ret;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (pool->job_cnt == 0 && ! pool->stopped) pthread_cond_wait(&pool->cond, &pool->lock);
+        if (pool->job_cnt == 0) break;
+
+        job = pool->jobs[pool->job_head];
+        if (++pool->job_head == QN_ETAG_BLK_MAX_COUNT) pool->job_head = 0;
+        pool->job_cnt -= 1;
+        pthread_mutex_unlock(&pool->lock);
+
+        // ---- Hash blocks out of the lock, and merge digests in order under the lock.
+        ret = qn_etag_blk_update(job.blk, job.buf, job.buf_size);
+
+        pthread_mutex_lock(&pool->lock);
+        if (! ret || ! qn_etag_ctx_commit_block(pool->ctx, job.blk)) {
+            if (! pool->failed) pool->err_code = qn_err_get_code();
+            pool->failed = 1;
+        } // if
+        pool->free_bufs[pool->free_cnt++] = job.buf;
+        pthread_cond_broadcast(&pool->cond);
+    } // while
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static ssize_t qn_etag_read_block(qn_io_reader_itf restrict rdr, char * restrict buf, int buf_size)
+{
+    ssize_t ret;
+    int total = 0;
+
+    while (total < buf_size) {
+        ret = qn_io_rdr_read(rdr, buf + total, buf_size - total);
+        if (ret < 0) return ret;
+        if (ret == 0) break;
+        total += ret;
+    } // while
+    return total;
+}
+
+// Read data from the reader until EOF, and hash blocks on a pool of worker threads.
+// Workers commit blocks to the context as they are done, and the context merges digests in order.
+// The last block, if not full, stays in the context as the current block, so the context can be
+// updated or finalized as usual.
+QN_SDK qn_bool qn_etag_ctx_update_concurrently(qn_etag_context_ptr restrict ctx, qn_io_reader_itf restrict rdr, int wkr_cnt)
+{
+    qn_etag_worker_pool pool;
+    qn_etag_block_ptr blk;
+    pthread_t * tids = NULL;
+    char * buf = NULL;
+    char * rem_buf = NULL;
+    ssize_t buf_size;
+    int blk_cap;
+    int started = 0;
+    int buf_cnt;
+    int i;
+    qn_bool ret = qn_false;
+
+    assert(ctx);
+    assert(rdr);
+
+    if (wkr_cnt < 1) wkr_cnt = 1;
+    if (wkr_cnt > QN_ETAG_BLK_MAX_COUNT) wkr_cnt = QN_ETAG_BLK_MAX_COUNT;
+
+    // ---- Fill up the current block first, to keep workers processing whole blocks.
+    if (ctx->blk) {
+        if (! (rem_buf = malloc(ctx->blk_cap))) {
+            qn_err_set_out_of_memory();
+            return qn_false;
+        } // if
+        buf_size = qn_etag_read_block(rdr, rem_buf, ctx->blk_cap);
+        ret = (buf_size >= 0 && qn_etag_ctx_update(ctx, rem_buf, buf_size));
+        free(rem_buf);
+        if (! ret) return qn_false;
+        if (ctx->blk) return qn_true; // -- Reach EOF before filling up the current block.
+        ret = qn_false;
+    } // if
+
+    memset(&pool, 0, sizeof(pool));
+    pool.ctx = ctx;
+    buf_cnt = wkr_cnt + 1;
+
+    pool.jobs = calloc(QN_ETAG_BLK_MAX_COUNT, sizeof(qn_etag_job));
+    pool.free_bufs = calloc(buf_cnt, sizeof(char *));
+    tids = calloc(wkr_cnt, sizeof(pthread_t));
+    if (! pool.jobs || ! pool.free_bufs || ! tids) {
+        qn_err_set_out_of_memory();
+        goto QN_ETAG_CTX_UPDATE_CONCURRENTLY_CLEANUP;
+    } // if
+
+    for (i = 0; i < buf_cnt; i += 1) {
+        if (! (pool.free_bufs[i] = malloc(QN_ETAG_BLK_MAX_SIZE))) {
+            qn_err_set_out_of_memory();
+            goto QN_ETAG_CTX_UPDATE_CONCURRENTLY_CLEANUP;
+        } // if
+        pool.free_cnt += 1;
+    } // for
+
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.cond, NULL);
+
+    for (started = 0; started < wkr_cnt; started += 1) {
+        if (pthread_create(&tids[started], NULL, &qn_etag_wkr_routine, &pool) != 0) break;
+    } // for
+    if (started == 0) {
+        qn_err_set_try_again();
+        goto QN_ETAG_CTX_UPDATE_CONCURRENTLY_ERROR_HANDLING;
+    } // if
+
+    while (1) {
+        pthread_mutex_lock(&pool.lock);
+        while (pool.free_cnt == 0 && ! pool.failed) pthread_cond_wait(&pool.cond, &pool.lock);
+        buf = (pool.failed) ? NULL : pool.free_bufs[--pool.free_cnt];
+        pthread_mutex_unlock(&pool.lock);
+        if (! buf) break;
+
+        buf_size = qn_etag_read_block(rdr, buf, QN_ETAG_BLK_MAX_SIZE);
+        if (buf_size < QN_ETAG_BLK_MAX_SIZE) break;
+
+        pthread_mutex_lock(&pool.lock);
+        // -- Wait for workers to merge committed blocks and release slots in the context.
+        while (ctx->unused == 0 && ! pool.failed) pthread_cond_wait(&pool.cond, &pool.lock);
+        if (pool.failed || ! qn_etag_ctx_allocate_block(ctx, &blk, &blk_cap)) {
+            pool.failed = 1;
+            pool.free_bufs[pool.free_cnt++] = buf;
+            buf = NULL;
+            pthread_mutex_unlock(&pool.lock);
+            break;
+        } // if
+
+        pool.jobs[(pool.job_head + pool.job_cnt) % QN_ETAG_BLK_MAX_COUNT].blk = blk;
+        pool.jobs[(pool.job_head + pool.job_cnt) % QN_ETAG_BLK_MAX_COUNT].buf = buf;
+        pool.jobs[(pool.job_head + pool.job_cnt) % QN_ETAG_BLK_MAX_COUNT].buf_size = buf_size;
+        pool.job_cnt += 1;
+        buf = NULL;
+        pthread_cond_broadcast(&pool.cond);
+        pthread_mutex_unlock(&pool.lock);
+    } // while
+
+QN_ETAG_CTX_UPDATE_CONCURRENTLY_ERROR_HANDLING:
+    pthread_mutex_lock(&pool.lock);
+    pool.stopped = 1;
+    pthread_cond_broadcast(&pool.cond);
+    pthread_mutex_unlock(&pool.lock);
+    for (i = 0; i < started; i += 1) pthread_join(tids[i], NULL);
+
+    if (pool.failed && pool.err_code != QN_ERR_SUCCEED) qn_err_set_code(pool.err_code, 0, __FILE__, __LINE__);
+    if (started > 0 && ! pool.failed && buf) {
+        // ---- Process the last block, which is not full, in the calling thread.
+        ret = (buf_size >= 0 && qn_etag_ctx_update(ctx, buf, buf_size));
+    } // if
+    if (buf) pool.free_bufs[pool.free_cnt++] = buf;
+
+    pthread_cond_destroy(&pool.cond);
+    pthread_mutex_destroy(&pool.lock);
+
+QN_ETAG_CTX_UPDATE_CONCURRENTLY_CLEANUP:
+    if (pool.free_bufs) {
+        for (i = 0; i < pool.free_cnt; i += 1) free(pool.free_bufs[i]);
+        free(pool.free_bufs);
+    } // if
+    free(pool.jobs);
+    free(tids);
+    return ret;
+}
+
 // ----
 
-QN_SDK extern qn_string qn_etag_digest_file(const char * restrict fname);
+static qn_bool qn_etag_ctx_update_by_reading(qn_etag_context_ptr restrict ctx, qn_file_ptr restrict fl)
+{
+    ssize_t buf_size;
+    char * buf = malloc(QN_ETAG_BLK_MAX_SIZE);
+    if (! buf) {
+        qn_err_set_out_of_memory();
+        return qn_false;
+    } // if
+
+    while ((buf_size = qn_fl_read(fl, buf, QN_ETAG_BLK_MAX_SIZE)) > 0) {
+        if (! qn_etag_ctx_update(ctx, buf, buf_size)) {
+            free(buf);
+            return qn_false;
+        } // if
+    } // while
+    free(buf);
+    return (buf_size == 0);
+}
+
+QN_SDK qn_string qn_etag_digest_file(const char * restrict fname)
+{
+    qn_fl_open_extra ext;
+    qn_etag_context_ptr ctx;
+    qn_file_ptr fl;
+    qn_string digest = NULL;
+    qn_fsize fsize;
+    qn_fsize offset = 0;
+    size_t map_size;
+    char * addr;
+    qn_bool ret;
+
+    memset(&ext, 0, sizeof(ext));
+    ext.flags = QN_FL_OPEN_SEQUENTIAL;
+    if (! (fl = qn_fl_open(fname, &ext))) return NULL;
+    if (! (ctx = qn_etag_ctx_create())) {
+        qn_fl_close(fl);
+        return NULL;
+    } // if
+
+    // ---- Hash data in the page cache directly through a sliding window of mapping.
+    fsize = qn_fl_fsize(fl);
+    while (offset < fsize) {
+        map_size = (fsize - offset < QN_ETAG_MAP_MAX_SIZE) ? (fsize - offset) : QN_ETAG_MAP_MAX_SIZE;
+        if (! (addr = qn_fl_map(fl, offset, map_size))) break;
+
+        ret = qn_etag_ctx_update(ctx, addr, map_size);
+        qn_fl_unmap(addr, map_size);
+        if (! ret) goto QN_ETAG_DIGEST_FILE_CLEANUP;
+
+        offset += map_size;
+    } // while
+
+    // ---- Read the rest, which cannot be mapped, like data of pipes or files growing.
+    if (offset > 0 && ! qn_fl_seek(fl, offset)) goto QN_ETAG_DIGEST_FILE_CLEANUP;
+    if (! qn_etag_ctx_update_by_reading(ctx, fl)) goto QN_ETAG_DIGEST_FILE_CLEANUP;
+
+    digest = qn_etag_ctx_final(ctx);
+
+QN_ETAG_DIGEST_FILE_CLEANUP:
+    qn_etag_ctx_destroy(ctx);
+    qn_fl_close(fl);
+    return digest;
+}
 
 QN_SDK qn_string qn_etag_digest_buffer(char * restrict buf, int buf_size)
 {
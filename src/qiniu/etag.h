@@ -2,6 +2,7 @@
 #define __QN_ETAG_H__ 1
 
 #include "qiniu/base/string.h"
+#include "qiniu/base/io.h"
 #include "qiniu/os/types.h"
 
 #include "qiniu/macros.h"
@@ -20,12 +21,21 @@ QN_SDK extern qn_bool qn_etag_blk_update(qn_etag_block_ptr restrict blk, char *
 
 // ----
 
+typedef enum _QN_ETAG_BACKEND
+{
+    QN_ETAG_BACKEND_AUTO = 0,
+    QN_ETAG_BACKEND_OPENSSL = 1,
+    QN_ETAG_BACKEND_MULTI_BUFFER = 2
+} qn_etag_backend_em;
+
 struct _QN_ETAG_CONTEXT;
 typedef struct _QN_ETAG_CONTEXT * qn_etag_context_ptr;
 
 QN_SDK extern qn_etag_context_ptr qn_etag_ctx_create(void);
 QN_SDK extern void qn_etag_ctx_destroy(qn_etag_context_ptr restrict ctx);
 
+QN_SDK extern qn_bool qn_etag_ctx_set_backend(qn_etag_context_ptr restrict ctx, qn_etag_backend_em backend);
+
 QN_SDK extern qn_bool qn_etag_ctx_init(qn_etag_context_ptr restrict ctx);
 QN_SDK extern qn_bool qn_etag_ctx_update(qn_etag_context_ptr restrict ctx, char * restrict buf, int buf_size);
 QN_SDK extern qn_string qn_etag_ctx_final(qn_etag_context_ptr restrict ctx);
@@ -33,6 +43,8 @@ QN_SDK extern qn_string qn_etag_ctx_final(qn_etag_context_ptr restrict ctx);
 QN_SDK extern qn_bool qn_etag_ctx_allocate_block(qn_etag_context_ptr restrict ctx, qn_etag_block_ptr * restrict blk, int * restrict buf_cap);
 QN_SDK extern qn_bool qn_etag_ctx_commit_block(qn_etag_context_ptr restrict ctx, qn_etag_block_ptr blk);
 
+QN_SDK extern qn_bool qn_etag_ctx_update_concurrently(qn_etag_context_ptr restrict ctx, qn_io_reader_itf restrict rdr, int wkr_cnt);
+
 // ----
 
 QN_SDK extern qn_string qn_etag_digest_file(const char * restrict fname);
@@ -1,6 +1,8 @@
+#include <assert.h>
 #include <stdarg.h>
 #include <strings.h>
 #include <ctype.h>
+#include <pthread.h>
 #include <curl/curl.h>
 
 #include "qiniu/base/string.h"
@@ -24,17 +26,50 @@ typedef enum _QN_HTTP_JSON_WRT_STATUS
     QN_HTTP_JSON_WRT_PARSING_OBJECT = 1,
     QN_HTTP_JSON_WRT_PARSING_ARRAY = 2,
     QN_HTTP_JSON_WRT_PARSING_DONE = 3,
-    QN_HTTP_JSON_WRT_PARSING_ERROR = 4
+    QN_HTTP_JSON_WRT_PARSING_ERROR = 4,
+    QN_HTTP_JSON_WRT_PARSING_ITEMS = 5
 } qn_http_json_wrt_status;
 
+#define QN_HTTP_JSON_WRT_MAX_LEVELS 64
+
+typedef struct _QN_HTTP_JSON_WRT_LEVEL
+{
+    qn_json_class cls;
+    qn_json_variant elem; // -- NULL if the element is skipped.
+} qn_http_json_wrt_level, *qn_http_json_wrt_level_ptr;
+
 typedef struct _QN_HTTP_JSON_WRITER
 {
     qn_http_json_wrt_status sts;
     qn_json_object_ptr * obj;
     qn_json_array_ptr * arr;
     qn_json_parser_ptr prs;
+
+    // ---- Fields used in item streaming mode.
+    const char * itm_key;
+    void * itm_data;
+    qn_http_json_item_callback_fn itm_cb;
+    qn_json_object_ptr itm;
+    qn_bool own_root;
+    qn_bool skipping;
+    int itm_arr_lvl;
+    int cnt;
+    qn_http_json_wrt_level lvl[QN_HTTP_JSON_WRT_MAX_LEVELS];
 } qn_http_json_writer;
 
+static void qn_http_json_wrt_drop_levels(qn_http_json_writer_ptr restrict writer)
+{
+    if (writer->itm) {
+        qn_json_destroy_object(writer->itm);
+        writer->itm = NULL;
+    } // if
+    if (writer->cnt > 0 && writer->own_root) qn_json_destroy_object(writer->lvl[0].elem.object);
+    writer->own_root = qn_false;
+    writer->skipping = qn_false;
+    writer->itm_arr_lvl = -1;
+    writer->cnt = 0;
+}
+
 QN_SDK qn_http_json_writer_ptr qn_http_json_wrt_create(void)
 {
     qn_http_json_writer_ptr new_body = malloc(sizeof(qn_http_json_writer));
@@ -48,22 +83,47 @@ QN_SDK qn_http_json_writer_ptr qn_http_json_wrt_create(void)
         free(new_body);
         return NULL;
     } // if
+
+    new_body->itm_cb = NULL;
+    new_body->itm = NULL;
+    new_body->cnt = 0;
+    qn_http_json_wrt_drop_levels(new_body);
     return new_body;
 }
 
 QN_SDK void qn_http_json_wrt_destroy(qn_http_json_writer_ptr restrict writer)
 {
+    qn_http_json_wrt_drop_levels(writer);
     qn_json_prs_destroy(writer->prs);
     free(writer);
 }
 
 QN_SDK void qn_http_json_wrt_prepare(qn_http_json_writer_ptr restrict writer, qn_json_object_ptr * restrict obj, qn_json_array_ptr * restrict arr)
 {
+    qn_http_json_wrt_drop_levels(writer);
+    writer->itm_cb = NULL;
     writer->obj = obj;
     writer->arr = arr;
     writer->sts = QN_HTTP_JSON_WRT_PARSING_READY;
 }
 
+// -- Parse a JSON object and hand out objects of the array under `itm_key` one by one, as soon as each of them is
+//    parsed. Each item is destroyed right after the callback returns, so the array stays empty in the result
+//    object. If the callback returns qn_false, the rest of items are skipped.
+QN_SDK void qn_http_json_wrt_prepare_for_items(qn_http_json_writer_ptr restrict writer, qn_json_object_ptr * restrict obj, const char * restrict itm_key, void * restrict itm_data, qn_http_json_item_callback_fn itm_cb)
+{
+    assert(itm_key);
+    assert(itm_cb);
+
+    qn_http_json_wrt_drop_levels(writer);
+    writer->itm_key = itm_key;
+    writer->itm_data = itm_data;
+    writer->itm_cb = itm_cb;
+    writer->obj = obj;
+    writer->arr = NULL;
+    writer->sts = QN_HTTP_JSON_WRT_PARSING_ITEMS;
+}
+
 static size_t qn_http_json_wrt_parse_object(qn_http_json_writer_ptr w, char * restrict buf, size_t buf_size)
 {
     size_t size = buf_size;
@@ -106,6 +166,116 @@ static size_t qn_http_json_wrt_parse_array(qn_http_json_writer_ptr w, char * res
     return 0;
 }
 
+static qn_bool qn_http_json_wrt_open(qn_http_json_writer_ptr w, const char * restrict key, qn_json_class cls)
+{
+    qn_http_json_wrt_level_ptr parent = &w->lvl[w->cnt - 1];
+    qn_json_variant elem;
+
+    elem.object = NULL;
+    if (! parent->elem.object) {
+        // ---- Inside a skipped element.
+    } else if (w->cnt - 1 == w->itm_arr_lvl) {
+        // ---- Build an item standalone, or skip it.
+        if (cls == QN_JSON_OBJECT && ! w->skipping) {
+            if (! (w->itm = qn_json_create_object_in_arena())) return qn_false;
+            elem.object = w->itm;
+        } // if
+    } else if (cls == QN_JSON_OBJECT) {
+        elem.object = (parent->cls == QN_JSON_OBJECT) ? qn_json_create_and_set_object(parent->elem.object, key) : qn_json_create_and_push_object(parent->elem.array);
+        if (! elem.object) return qn_false;
+    } else {
+        elem.array = (parent->cls == QN_JSON_OBJECT) ? qn_json_create_and_set_array(parent->elem.object, key) : qn_json_create_and_push_array(parent->elem.array);
+        if (! elem.array) return qn_false;
+        if (w->cnt == 1 && strcmp(key, w->itm_key) == 0) w->itm_arr_lvl = w->cnt;
+    } // if
+
+    w->lvl[w->cnt].cls = cls;
+    w->lvl[w->cnt].elem = elem;
+    w->cnt += 1;
+    return qn_true;
+}
+
+static qn_bool qn_http_json_wrt_handle_event(void * restrict evt_data, qn_json_prs_event evt, const char * restrict key, qn_json_class cls, qn_json_variant_ptr restrict val)
+{
+    qn_http_json_writer_ptr w = (qn_http_json_writer_ptr) evt_data;
+    qn_http_json_wrt_level_ptr parent;
+    qn_bool ret;
+
+    if (w->cnt == 0 && evt != QN_JSON_PRS_OPEN_OBJECT && evt != QN_JSON_PRS_OPEN_ARRAY) {
+        // ---- The parser is left in a state that does not match the writer.
+        qn_err_json_set_bad_text_input();
+        return qn_false;
+    } // if
+
+    switch (evt) {
+        case QN_JSON_PRS_OPEN_OBJECT:
+        case QN_JSON_PRS_OPEN_ARRAY:
+            if (w->cnt == QN_HTTP_JSON_WRT_MAX_LEVELS) {
+                qn_err_json_set_too_many_parsing_levels();
+                return qn_false;
+            } // if
+            if (w->cnt > 0) return qn_http_json_wrt_open(w, key, cls);
+
+            // ---- The root must be an object.
+            if (cls != QN_JSON_OBJECT) {
+                qn_err_json_set_bad_text_input();
+                return qn_false;
+            } // if
+            w->own_root = (*w->obj == NULL);
+            if (w->own_root && ! (*w->obj = qn_json_create_object())) return qn_false;
+            w->lvl[0].cls = QN_JSON_OBJECT;
+            w->lvl[0].elem.object = *w->obj;
+            w->cnt = 1;
+            return qn_true;
+
+        case QN_JSON_PRS_CLOSE_OBJECT:
+        case QN_JSON_PRS_CLOSE_ARRAY:
+            w->cnt -= 1;
+            if (w->cnt == w->itm_arr_lvl) {
+                w->itm_arr_lvl = -1;
+            } else if (w->cnt - 1 == w->itm_arr_lvl && w->itm) {
+                // ---- An item is done, hand it out.
+                ret = w->itm_cb(w->itm_data, w->itm);
+                qn_json_destroy_object(w->itm);
+                w->itm = NULL;
+                if (! ret) w->skipping = qn_true;
+            } // if
+            if (w->cnt == 0) w->own_root = qn_false;
+            return qn_true;
+
+        default:
+            break;
+    } // switch
+
+    parent = &w->lvl[w->cnt - 1];
+    if (! parent->elem.object || w->cnt - 1 == w->itm_arr_lvl) return qn_true;
+
+    if (parent->cls == QN_JSON_OBJECT) {
+        if (cls == QN_JSON_STRING) return qn_json_set_text(parent->elem.object, key, val->string, posix_strlen(val->string));
+        return qn_json_set_variant(parent->elem.object, key, cls, *val);
+    } // if
+    if (cls == QN_JSON_STRING) return qn_json_push_text(parent->elem.array, val->string, posix_strlen(val->string));
+    return qn_json_push_variant(parent->elem.array, cls, *val);
+}
+
+static size_t qn_http_json_wrt_parse_items(qn_http_json_writer_ptr w, char * restrict buf, size_t buf_size)
+{
+    size_t size = buf_size;
+    if (qn_json_prs_parse_events(w->prs, buf, &size, w, &qn_http_json_wrt_handle_event)) {
+        // ---- Parsing object is done.
+        w->sts = QN_HTTP_JSON_WRT_PARSING_DONE;
+        qn_err_set_succeed();
+        return buf_size;
+    } // if
+
+    // ---- Handle errors.
+    if (qn_err_json_is_need_more_text_input()) return buf_size;
+
+    qn_http_json_wrt_drop_levels(w);
+    w->sts = QN_HTTP_JSON_WRT_PARSING_ERROR;
+    return 0;
+}
+
 QN_SDK size_t qn_http_json_wrt_write_cfn(void * user_data, char * restrict buf, size_t buf_size)
 {
     size_t ret;
@@ -130,6 +300,7 @@ QN_SDK size_t qn_http_json_wrt_write_cfn(void * user_data, char * restrict buf,
 
         case QN_HTTP_JSON_WRT_PARSING_OBJECT: return qn_http_json_wrt_parse_object(w, buf, buf_size);
         case QN_HTTP_JSON_WRT_PARSING_ARRAY: return qn_http_json_wrt_parse_array(w, buf, buf_size);
+        case QN_HTTP_JSON_WRT_PARSING_ITEMS: return qn_http_json_wrt_parse_items(w, buf, buf_size);
         case QN_HTTP_JSON_WRT_PARSING_DONE: ret = buf_size; break;
         case QN_HTTP_JSON_WRT_PARSING_ERROR: ret = 0; break;
     } // switch
@@ -271,6 +442,7 @@ typedef struct _QN_HTTP_REQUEST
 
     void * body_rdr;
     qn_http_body_reader_callback_fn body_rdr_cb;
+    qn_http_body_seeker_callback_fn body_skr_cb;
 } qn_http_request;
 
 QN_SDK qn_http_request_ptr qn_http_req_create(void)
@@ -313,6 +485,7 @@ QN_SDK void qn_http_req_reset(qn_http_request_ptr restrict req)
     req->body_size = 0;
     req->body_rdr = NULL;
     req->body_rdr_cb = NULL;
+    req->body_skr_cb = NULL;
     req->form = NULL;
 }
 
@@ -381,9 +554,15 @@ QN_SDK void qn_http_req_set_body_reader(qn_http_request_ptr restrict req, void *
 {
     req->body_rdr = body_rdr;
     req->body_rdr_cb = body_rdr_cb;
+    req->body_skr_cb = NULL;
     req->body_size = body_size;
 }
 
+QN_SDK void qn_http_req_set_body_seeker(qn_http_request_ptr restrict req, qn_http_body_seeker_callback_fn body_skr_cb)
+{
+    req->body_skr_cb = body_skr_cb;
+}
+
 QN_SDK const char * qn_http_req_body_data(qn_http_request_ptr restrict req)
 {
     return req->body_data;
@@ -400,7 +579,8 @@ enum
 {
     QN_HTTP_RESP_WRT_PARSING_BODY = 0,
     QN_HTTP_RESP_WRT_PARSING_DONE,
-    QN_HTTP_RESP_WRT_PARSING_ERROR
+    QN_HTTP_RESP_WRT_PARSING_ERROR,
+    QN_HTTP_RESP_WRT_STREAMING_BODY
 };
 
 typedef struct _QN_HTTP_RESPONSE
@@ -415,6 +595,7 @@ typedef struct _QN_HTTP_RESPONSE
     qn_string http_msg;
 
     qn_http_header_ptr hdr;
+    qn_http_timing timing;
 } qn_http_response;
 
 QN_SDK qn_http_response_ptr qn_http_resp_create(void)
@@ -457,6 +638,7 @@ QN_SDK void qn_http_resp_reset(qn_http_response_ptr restrict resp)
     resp->http_code = 0;
     resp->body_wrt = NULL;
     resp->body_wrt_cb = NULL;
+    memset(&resp->timing, 0, sizeof(resp->timing));
 
     qn_http_hdr_reset(resp->hdr);
 }
@@ -471,6 +653,11 @@ QN_SDK int qn_http_resp_get_writer_retcode(qn_http_response_ptr restrict resp)
     return resp->body_wrt_code;
 }
 
+QN_SDK const qn_http_timing * qn_http_resp_get_timing(qn_http_response_ptr restrict resp)
+{
+    return &resp->timing;
+}
+
 QN_SDK qn_http_hdr_iterator_ptr qn_http_resp_get_header_iterator(qn_http_response_ptr restrict resp)
 {
     return qn_http_hdr_itr_create(resp->hdr);
@@ -497,6 +684,16 @@ QN_SDK void qn_http_resp_set_data_writer(qn_http_response_ptr restrict resp, voi
     resp->body_wrt_cb = body_wrt_cb;
 }
 
+// -- Unlike the data writer which parses the body, the stream writer MUST consume each piece of the body and return
+//    its size. Returning any other value aborts the transfer, and the request fails with the error set by the writer.
+//    The response code and headers are ready before the first piece arrives, so the writer may check them first.
+QN_SDK void qn_http_resp_set_stream_writer(qn_http_response_ptr restrict resp, void * restrict body_wrt, qn_http_data_writer_callback_fn body_wrt_cb)
+{
+    resp->body_wrt_sts = QN_HTTP_RESP_WRT_STREAMING_BODY;
+    resp->body_wrt = body_wrt;
+    resp->body_wrt_cb = body_wrt_cb;
+}
+
 static size_t qn_http_resp_hdr_wrt_write_cfn(char * buf, size_t size, size_t nitems, void * user_data)
 {
     qn_http_response_ptr resp = (qn_http_response_ptr) user_data;
@@ -578,6 +775,10 @@ static size_t qn_http_resp_body_wrt_write_cfn(char * buf, size_t size, size_t ni
                 resp->body_wrt_sts = QN_HTTP_RESP_WRT_PARSING_DONE;
             } // if
             return buf_size;
+
+        case QN_HTTP_RESP_WRT_STREAMING_BODY:
+            resp->body_wrt_code = resp->body_wrt_cb(resp->body_wrt, buf, buf_size);
+            return resp->body_wrt_code;
         
         case QN_HTTP_RESP_WRT_PARSING_DONE:
         case QN_HTTP_RESP_WRT_PARSING_ERROR:
@@ -586,6 +787,99 @@ static size_t qn_http_resp_body_wrt_write_cfn(char * buf, size_t size, size_t ni
     return 0;
 }
 
+// ---- Definition of HTTP connection pool ----
+
+typedef struct _QN_HTTP_CONNECTION_POOL
+{
+    CURLSH * share;
+    pthread_mutex_t locks[CURL_LOCK_DATA_LAST];
+    unsigned int conn_shared:1;
+} qn_http_connection_pool;
+
+static void qn_http_pool_lock_cfn(CURL * curl, curl_lock_data data, curl_lock_access access, void * user_data)
+{
+    qn_http_connection_pool_ptr pool = (qn_http_connection_pool_ptr) user_data;
+    pthread_mutex_lock(&pool->locks[data]);
+}
+
+static void qn_http_pool_unlock_cfn(CURL * curl, curl_lock_data data, void * user_data)
+{
+    qn_http_connection_pool_ptr pool = (qn_http_connection_pool_ptr) user_data;
+    pthread_mutex_unlock(&pool->locks[data]);
+}
+
+static qn_http_connection_pool_ptr qn_http_pool_create_for(qn_bool conn_shared)
+{
+    int i;
+    qn_http_connection_pool_ptr new_pool = NULL;
+
+    new_pool = calloc(1, sizeof(qn_http_connection_pool));
+    if (!new_pool) {
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+
+    new_pool->share = curl_share_init();
+    if (!new_pool->share) {
+        free(new_pool);
+        qn_err_3rdp_set_curl_easy_error_occurred(CURLE_FAILED_INIT);
+        return NULL;
+    } // if
+
+    for (i = 0; i < CURL_LOCK_DATA_LAST; i += 1) {
+        if (pthread_mutex_init(&new_pool->locks[i], NULL) != 0) {
+            while (--i >= 0) pthread_mutex_destroy(&new_pool->locks[i]);
+            curl_share_cleanup(new_pool->share);
+            free(new_pool);
+            qn_err_set_out_of_memory();
+            return NULL;
+        } // if
+    } // for
+
+    curl_share_setopt(new_pool->share, CURLSHOPT_LOCKFUNC, qn_http_pool_lock_cfn);
+    curl_share_setopt(new_pool->share, CURLSHOPT_UNLOCKFUNC, qn_http_pool_unlock_cfn);
+    curl_share_setopt(new_pool->share, CURLSHOPT_USERDATA, new_pool);
+
+    // ---- Share resolved addresses and TLS sessions among all attached connections.
+    curl_share_setopt(new_pool->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(new_pool->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    // ---- libcurl does not support using shared live connections from different threads at the same time.
+    if (conn_shared) curl_share_setopt(new_pool->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    new_pool->conn_shared = (conn_shared) ? 1 : 0;
+    return new_pool;
+}
+
+// -- Create a pool which may be used by different threads at the same time.
+QN_SDK qn_http_connection_pool_ptr qn_http_pool_create(void)
+{
+    return qn_http_pool_create_for(qn_false);
+}
+
+// -- Create a pool which shares live connections as well, for connections used by one thread only.
+QN_SDK qn_http_connection_pool_ptr qn_http_pool_create_for_one_thread(void)
+{
+    return qn_http_pool_create_for(qn_true);
+}
+
+QN_SDK void qn_http_pool_destroy(qn_http_connection_pool_ptr restrict pool)
+{
+    int i;
+
+    if (pool) {
+        // **NOTE** : All connections attached to the pool MUST be destroyed or detached before destroying the pool.
+        curl_share_cleanup(pool->share);
+        for (i = 0; i < CURL_LOCK_DATA_LAST; i += 1) pthread_mutex_destroy(&pool->locks[i]);
+        free(pool);
+    } // if
+}
+
+QN_SDK qn_bool qn_http_pool_is_thread_safe(qn_http_connection_pool_ptr restrict pool)
+{
+    assert(pool);
+    return ! pool->conn_shared;
+}
+
 // ---- Definition of HTTP connection ----
 
 typedef struct _QN_HTTP_CONNECTION
@@ -596,6 +890,14 @@ typedef struct _QN_HTTP_CONNECTION
     qn_string url_prefix;
 
     CURL * curl;
+    struct curl_slist * headers;
+    qn_http_connection_pool_ptr pool;
+
+    // ---- Fields used by the HTTP engine.
+    qn_http_engine_ptr eng;
+    qn_http_eng_done_callback_fn done_cb;
+    void * done_data;
+    qn_http_response_ptr done_resp;
 } qn_http_connection;
 
 QN_SDK qn_http_connection_ptr qn_http_conn_create(void)
@@ -620,18 +922,160 @@ QN_SDK qn_http_connection_ptr qn_http_conn_create(void)
 QN_SDK void qn_http_conn_destroy(qn_http_connection_ptr restrict conn)
 {
     if (conn) {
+        if (conn->eng) qn_http_eng_cancel(conn->eng, conn);
         curl_easy_cleanup(conn->curl);
+        curl_slist_free_all(conn->headers);
         free(conn);
     } // if
 }
 
+QN_SDK void qn_http_conn_set_pool(qn_http_connection_ptr restrict conn, qn_http_connection_pool_ptr restrict pool)
+{
+    assert(conn);
+    assert(! conn->eng);
+
+    // ---- The pool takes effect from the next request, since every request resets the cURL handle.
+    conn->pool = pool;
+}
+
+QN_SDK qn_http_connection_pool_ptr qn_http_conn_get_pool(qn_http_connection_ptr restrict conn)
+{
+    return conn->pool;
+}
+
+static qn_bool qn_http_conn_reset(qn_http_connection_ptr restrict conn)
+{
+    CURLcode curl_code;
+
+    curl_easy_reset(conn->curl);
+
+    // ---- Options set on creation are cleared by resetting, so set them again.
+    if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_NOSIGNAL, 1L)) != CURLE_OK) {
+        qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+        return qn_false;
+    } // if
+    if (conn->pool && (curl_code = curl_easy_setopt(conn->curl, CURLOPT_SHARE, conn->pool->share)) != CURLE_OK) {
+        qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+        return qn_false;
+    } // if
+    return qn_true;
+}
+
 static size_t qn_http_conn_body_reader(char * ptr, size_t size, size_t nmemb, void * user_data)
 {
     qn_http_request_ptr req = (qn_http_request_ptr) user_data;
     return req->body_rdr_cb(req->body_rdr, ptr, size * nmemb);
 }
 
-static qn_bool qn_http_conn_do_request(qn_http_connection_ptr restrict conn, qn_http_request_ptr restrict req, qn_http_response_ptr restrict resp)
+static int qn_http_conn_body_seeker(void * user_data, curl_off_t offset, int origin)
+{
+    qn_http_request_ptr req = (qn_http_request_ptr) user_data;
+    if (origin != SEEK_SET || offset < 0) return CURL_SEEKFUNC_CANTSEEK;
+    return (req->body_skr_cb(req->body_rdr, offset)) ? CURL_SEEKFUNC_OK : CURL_SEEKFUNC_FAIL;
+}
+
+static int qn_http_conn_body_rewinder(void * user_data, char * primary_ip, char * local_ip, int primary_port, int local_port)
+{
+    qn_http_request_ptr req = (qn_http_request_ptr) user_data;
+    return (req->body_skr_cb(req->body_rdr, 0)) ? CURL_PREREQFUNC_OK : CURL_PREREQFUNC_ABORT;
+}
+
+static qn_bool qn_http_conn_set_body_seeker(qn_http_connection_ptr restrict conn, qn_http_request_ptr restrict req)
+{
+    CURLcode curl_code;
+
+    if (! req->body_skr_cb) return qn_true;
+    if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_SEEKFUNCTION, qn_http_conn_body_seeker)) != CURLE_OK) {
+        qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+        return qn_false;
+    } // if
+    if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_SEEKDATA, req)) != CURLE_OK) {
+        qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+        return qn_false;
+    } // if
+    return qn_true;
+}
+
+static qn_bool qn_http_conn_prepare_get(qn_http_connection_ptr restrict conn, const char * restrict url, qn_http_request_ptr restrict req)
+{
+    CURLcode curl_code;
+
+    if (! qn_http_conn_reset(conn)) return qn_false;
+    if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_POST, 0)) != CURLE_OK) {
+        qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+        return qn_false;
+    } // if
+    if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_URL, url)) != CURLE_OK) {
+        qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+        return qn_false;
+    } // if
+    return qn_true;
+}
+
+static qn_bool qn_http_conn_prepare_post(qn_http_connection_ptr restrict conn, const char * restrict url, qn_http_request_ptr restrict req, qn_bool copy_body)
+{
+    CURLcode curl_code;
+
+    if (! qn_http_conn_reset(conn)) return qn_false;
+
+    if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_POST, 1)) != CURLE_OK) {
+        qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+        return qn_false;
+    } // if
+    if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_URL, url)) != CURLE_OK) {
+        qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+        return qn_false;
+    } // if
+
+    if (req->form) {
+        if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_HTTPPOST, req->form->first)) != CURLE_OK) {
+            qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+            return qn_false;
+        } // if
+        
+        if (req->body_rdr && req->body_rdr_cb) {
+            if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_READFUNCTION, qn_http_conn_body_reader)) != CURLE_OK) {
+                qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+                return qn_false;
+            } // if
+        } // if
+        if (req->body_rdr && req->body_skr_cb) {
+            // -- cURL reads a streamed part over from its start on every attempt, e.g. on a fresh connection after the
+            //    reused one died, without seeking it, so move the reader back right before each attempt.
+            if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_PREREQFUNCTION, qn_http_conn_body_rewinder)) != CURLE_OK) {
+                qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+                return qn_false;
+            } // if
+            if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_PREREQDATA, req)) != CURLE_OK) {
+                qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+                return qn_false;
+            } // if
+        } // if
+    } else if (req->body_data) {
+        if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_POSTFIELDSIZE, req->body_size)) != CURLE_OK) {
+            qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+            return qn_false;
+        } // if
+        // -- The body data may be released before the transfer is done in asynchronous requests, so let cURL keep a copy.
+        if ((curl_code = curl_easy_setopt(conn->curl, (copy_body) ? CURLOPT_COPYPOSTFIELDS : CURLOPT_POSTFIELDS, req->body_data)) != CURLE_OK) {
+            qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+            return qn_false;
+        } // if
+    } else {
+        if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_READFUNCTION, qn_http_conn_body_reader)) != CURLE_OK) {
+            qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+            return qn_false;
+        } // if
+        if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_READDATA, req)) != CURLE_OK) {
+            qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+            return qn_false;
+        } // if
+        if (! qn_http_conn_set_body_seeker(conn, req)) return qn_false;
+    } // form
+    return qn_true;
+}
+
+static qn_bool qn_http_conn_prepare_request(qn_http_connection_ptr restrict conn, qn_http_request_ptr restrict req, qn_http_response_ptr restrict resp)
 {
     CURLcode curl_code;
     struct curl_slist * headers = NULL;
@@ -679,12 +1123,22 @@ static qn_bool qn_http_conn_do_request(qn_http_connection_ptr restrict conn, qn_
     } // if
 
     if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_HTTPHEADER, headers)) != CURLE_OK) {
+        curl_slist_free_all(headers);
         qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
         return qn_false;
     } // if
 
-    curl_code = curl_easy_perform(conn->curl);
-    curl_slist_free_all(headers);
+    // -- The header list MUST live until the request is done.
+    curl_slist_free_all(conn->headers);
+    conn->headers = headers;
+    return qn_true;
+}
+
+static qn_bool qn_http_conn_check_result(qn_http_connection_ptr restrict conn, CURLcode curl_code)
+{
+    curl_slist_free_all(conn->headers);
+    conn->headers = NULL;
+
     if (curl_code != CURLE_OK) {
         switch (curl_code) {
             case CURLE_COULDNT_CONNECT:
@@ -709,6 +1163,10 @@ static qn_bool qn_http_conn_do_request(qn_http_connection_ptr restrict conn, qn_
                 qn_err_http_set_mismatching_file_size();
                 return qn_false;
 
+            case CURLE_WRITE_ERROR:
+                // -- A stream writer aborted the transfer and has set the error.
+                return qn_false;
+
             default:
                 break;
         } // switch
@@ -716,70 +1174,219 @@ static qn_bool qn_http_conn_do_request(qn_http_connection_ptr restrict conn, qn_
     return qn_true;
 }
 
-QN_SDK qn_bool qn_http_conn_get(qn_http_connection_ptr restrict conn, const char * restrict url, qn_http_request_ptr restrict req, qn_http_response_ptr restrict resp)
+static inline qn_uint64 qn_http_conn_get_time_info(CURL * curl, CURLINFO info)
+{
+    curl_off_t us = 0;
+    return (curl_easy_getinfo(curl, info, &us) == CURLE_OK && us > 0) ? (qn_uint64) us : 0;
+}
+
+static inline qn_uint64 qn_http_conn_get_size_info(CURL * curl, CURLINFO info)
+{
+    curl_off_t size = 0;
+    return (curl_easy_getinfo(curl, info, &size) == CURLE_OK && size > 0) ? (qn_uint64) size : 0;
+}
+
+static inline qn_uint64 qn_http_conn_get_long_info(CURL * curl, CURLINFO info)
+{
+    long size = 0;
+    return (curl_easy_getinfo(curl, info, &size) == CURLE_OK && size > 0) ? (qn_uint64) size : 0;
+}
+
+static void qn_http_conn_capture_timing(qn_http_connection_ptr restrict conn, qn_http_response_ptr restrict resp)
+{
+    // -- cURL reports all times from the start of the request, so turn them into durations of each phase.
+    qn_uint64 dns = qn_http_conn_get_time_info(conn->curl, CURLINFO_NAMELOOKUP_TIME_T);
+    qn_uint64 connect = qn_http_conn_get_time_info(conn->curl, CURLINFO_CONNECT_TIME_T);
+    qn_uint64 app_connect = qn_http_conn_get_time_info(conn->curl, CURLINFO_APPCONNECT_TIME_T);
+
+    resp->timing.dns_us = dns;
+    resp->timing.connect_us = (connect > dns) ? connect - dns : 0;
+    resp->timing.tls_us = (app_connect > connect) ? app_connect - connect : 0;
+    resp->timing.ttfb_us = qn_http_conn_get_time_info(conn->curl, CURLINFO_STARTTRANSFER_TIME_T);
+    resp->timing.total_us = qn_http_conn_get_time_info(conn->curl, CURLINFO_TOTAL_TIME_T);
+    resp->timing.bytes_sent = qn_http_conn_get_long_info(conn->curl, CURLINFO_REQUEST_SIZE) + qn_http_conn_get_size_info(conn->curl, CURLINFO_SIZE_UPLOAD_T);
+    resp->timing.bytes_received = qn_http_conn_get_long_info(conn->curl, CURLINFO_HEADER_SIZE) + qn_http_conn_get_size_info(conn->curl, CURLINFO_SIZE_DOWNLOAD_T);
+}
+
+static qn_bool qn_http_conn_do_request(qn_http_connection_ptr restrict conn, qn_http_request_ptr restrict req, qn_http_response_ptr restrict resp)
 {
     CURLcode curl_code;
 
-    curl_easy_reset(conn->curl);
-    if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_POST, 0)) != CURLE_OK) {
-        qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
-        return qn_false;
-    } // if
-    if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_URL, url)) != CURLE_OK) {
-        qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
-        return qn_false;
-    } // if
+    if (! qn_http_conn_prepare_request(conn, req, resp)) return qn_false;
+    curl_code = curl_easy_perform(conn->curl);
+    qn_http_conn_capture_timing(conn, resp);
+    return qn_http_conn_check_result(conn, curl_code);
+}
+
+QN_SDK qn_bool qn_http_conn_get(qn_http_connection_ptr restrict conn, const char * restrict url, qn_http_request_ptr restrict req, qn_http_response_ptr restrict resp)
+{
+    assert(! conn->eng);
+
+    if (! qn_http_conn_prepare_get(conn, url, req)) return qn_false;
     return qn_http_conn_do_request(conn, req, resp);
 }
 
 QN_SDK qn_bool qn_http_conn_post(qn_http_connection_ptr restrict conn, const char * restrict url, qn_http_request_ptr restrict req, qn_http_response_ptr restrict resp)
+{
+    assert(! conn->eng);
+
+    if (! qn_http_conn_prepare_post(conn, url, req, qn_false)) return qn_false;
+    return qn_http_conn_do_request(conn, req, resp);
+}
+
+// ---- Definition of HTTP engine ----
+
+typedef struct _QN_HTTP_ENGINE
+{
+    CURLM * multi;
+    int running;
+} qn_http_engine;
+
+QN_SDK qn_http_engine_ptr qn_http_eng_create(void)
+{
+    qn_http_engine_ptr new_eng = NULL;
+
+    new_eng = calloc(1, sizeof(qn_http_engine));
+    if (!new_eng) {
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+
+    new_eng->multi = curl_multi_init();
+    if (!new_eng->multi) {
+        free(new_eng);
+        qn_err_3rdp_set_curl_multi_error_occurred(CURLM_OUT_OF_MEMORY);
+        return NULL;
+    } // if
+    return new_eng;
+}
+
+QN_SDK void qn_http_eng_destroy(qn_http_engine_ptr restrict eng)
+{
+    if (eng) {
+        // **NOTE** : All connections submitted and not done yet MUST be canceled or destroyed before destroying the engine.
+        assert(eng->running == 0);
+        curl_multi_cleanup(eng->multi);
+        free(eng);
+    } // if
+}
+
+static qn_bool qn_http_eng_submit(qn_http_engine_ptr restrict eng, qn_http_connection_ptr restrict conn, qn_http_request_ptr restrict req, qn_http_response_ptr restrict resp, qn_http_eng_done_callback_fn done_cb, void * restrict user_data)
 {
     CURLcode curl_code;
+    CURLMcode multi_code;
 
-    curl_easy_reset(conn->curl);
+    if (! qn_http_conn_prepare_request(conn, req, resp)) return qn_false;
 
-    if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_POST, 1)) != CURLE_OK) {
+    if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_PRIVATE, conn)) != CURLE_OK) {
         qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
         return qn_false;
     } // if
-    if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_URL, url)) != CURLE_OK) {
-        qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
+
+    if ((multi_code = curl_multi_add_handle(eng->multi, conn->curl)) != CURLM_OK) {
+        qn_err_3rdp_set_curl_multi_error_occurred(multi_code);
         return qn_false;
     } // if
 
-    if (req->form) {
-        if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_HTTPPOST, req->form->first)) != CURLE_OK) {
-            qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
-            return qn_false;
-        } // if
-        
-        if (req->body_rdr && req->body_rdr_cb) {
-            if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_READFUNCTION, qn_http_conn_body_reader)) != CURLE_OK) {
-                qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
-                return qn_false;
-            } // if
-        } // if
-    } else if (req->body_data) {
-        if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_POSTFIELDS, req->body_data)) != CURLE_OK) {
-            qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
-            return qn_false;
-        } // if
-        if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_POSTFIELDSIZE, req->body_size)) != CURLE_OK) {
-            qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
-            return qn_false;
-        } // if
-    } else {
-        if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_READFUNCTION, qn_http_conn_body_reader)) != CURLE_OK) {
-            qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
-            return qn_false;
+    conn->eng = eng;
+    conn->done_cb = done_cb;
+    conn->done_data = user_data;
+    conn->done_resp = resp;
+    eng->running += 1;
+    return qn_true;
+}
+
+QN_SDK qn_bool qn_http_eng_submit_get(qn_http_engine_ptr restrict eng, qn_http_connection_ptr restrict conn, const char * restrict url, qn_http_request_ptr restrict req, qn_http_response_ptr restrict resp, qn_http_eng_done_callback_fn done_cb, void * restrict user_data)
+{
+    assert(eng);
+    assert(! conn->eng);
+    assert(done_cb);
+
+    if (! qn_http_conn_prepare_get(conn, url, req)) return qn_false;
+    return qn_http_eng_submit(eng, conn, req, resp, done_cb, user_data);
+}
+
+QN_SDK qn_bool qn_http_eng_submit_post(qn_http_engine_ptr restrict eng, qn_http_connection_ptr restrict conn, const char * restrict url, qn_http_request_ptr restrict req, qn_http_response_ptr restrict resp, qn_http_eng_done_callback_fn done_cb, void * restrict user_data)
+{
+    assert(eng);
+    assert(! conn->eng);
+    assert(done_cb);
+
+    if (! qn_http_conn_prepare_post(conn, url, req, qn_true)) return qn_false;
+    return qn_http_eng_submit(eng, conn, req, resp, done_cb, user_data);
+}
+
+QN_SDK void qn_http_eng_cancel(qn_http_engine_ptr restrict eng, qn_http_connection_ptr restrict conn)
+{
+    if (conn->eng != eng) return;
+
+    curl_multi_remove_handle(eng->multi, conn->curl);
+    curl_slist_free_all(conn->headers);
+    conn->headers = NULL;
+    conn->eng = NULL;
+    eng->running -= 1;
+}
+
+QN_SDK int qn_http_eng_perform(qn_http_engine_ptr restrict eng, int timeout_ms)
+{
+    int still_running;
+    int msg_cnt;
+    qn_bool ok;
+    CURLMcode multi_code;
+    CURLMsg * msg;
+    qn_http_connection_ptr conn;
+    qn_http_eng_done_callback_fn done_cb;
+
+    if (eng->running == 0) return 0;
+
+    if ((multi_code = curl_multi_perform(eng->multi, &still_running)) != CURLM_OK) {
+        qn_err_3rdp_set_curl_multi_error_occurred(multi_code);
+        return -1;
+    } // if
+
+    if (still_running == eng->running) {
+        // ---- Nothing is done, wait for activities on any socket.
+        if ((multi_code = curl_multi_wait(eng->multi, NULL, 0, timeout_ms, NULL)) != CURLM_OK) {
+            qn_err_3rdp_set_curl_multi_error_occurred(multi_code);
+            return -1;
         } // if
-        if ((curl_code = curl_easy_setopt(conn->curl, CURLOPT_READDATA, req)) != CURLE_OK) {
-            qn_err_3rdp_set_curl_easy_error_occurred(curl_code);
-            return qn_false;
+        if ((multi_code = curl_multi_perform(eng->multi, &still_running)) != CURLM_OK) {
+            qn_err_3rdp_set_curl_multi_error_occurred(multi_code);
+            return -1;
         } // if
-    } // form
+    } // if
 
-    return qn_http_conn_do_request(conn, req, resp);
+    while ((msg = curl_multi_info_read(eng->multi, &msg_cnt))) {
+        if (msg->msg != CURLMSG_DONE) continue;
+
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&conn);
+        curl_multi_remove_handle(eng->multi, conn->curl);
+        conn->eng = NULL;
+        eng->running -= 1;
+
+        // ---- Report the result in the same way as the synchronous requests do.
+        qn_http_conn_capture_timing(conn, conn->done_resp);
+        ok = qn_http_conn_check_result(conn, msg->data.result);
+
+        // -- The callback may submit the connection again, so clear the fields first.
+        done_cb = conn->done_cb;
+        conn->done_cb = NULL;
+        done_cb(conn->done_data, conn, ok);
+    } // while
+    return eng->running;
+}
+
+QN_SDK qn_bool qn_http_eng_run(qn_http_engine_ptr restrict eng)
+{
+    while (eng->running > 0) {
+        if (qn_http_eng_perform(eng, QN_HTTP_ENG_DEFAULT_WAIT_TIMEOUT) < 0) return qn_false;
+    } // while
+    return qn_true;
+}
+
+QN_SDK int qn_http_eng_running_count(qn_http_engine_ptr restrict eng)
+{
+    return eng->running;
 }
 
 #ifdef __cplusplus
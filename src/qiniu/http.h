@@ -16,6 +16,7 @@ extern "C"
 // ---- Declaration of body reader and writer
 
 typedef size_t (*qn_http_body_reader_callback_fn)(void * restrict reader, char * restrict buf, size_t size);
+typedef qn_bool (*qn_http_body_seeker_callback_fn)(void * restrict reader, qn_fsize offset);
 typedef size_t (*qn_http_data_writer_callback_fn)(void * restrict writer, char * restrict buf, size_t size);
 
 // ----
@@ -27,6 +28,9 @@ QN_SDK extern qn_http_json_writer_ptr qn_http_json_wrt_create(void);
 QN_SDK extern void qn_http_json_wrt_destroy(qn_http_json_writer_ptr restrict writer);
 
 QN_SDK extern void qn_http_json_wrt_prepare(qn_http_json_writer_ptr restrict writer, qn_json_object_ptr * restrict obj, qn_json_array_ptr * restrict arr);
+typedef qn_bool (*qn_http_json_item_callback_fn)(void * restrict itm_data, qn_json_object_ptr restrict item);
+
+QN_SDK extern void qn_http_json_wrt_prepare_for_items(qn_http_json_writer_ptr restrict writer, qn_json_object_ptr * restrict obj, const char * restrict itm_key, void * restrict itm_data, qn_http_json_item_callback_fn itm_cb);
 QN_SDK extern size_t qn_http_json_wrt_write_cfn(void * restrict writer, char * restrict buf, size_t buf_size);
 
 // ---- Declaration of HTTP form
@@ -81,9 +85,26 @@ QN_SDK extern void qn_http_req_set_form(qn_http_request_ptr restrict req, qn_htt
 
 QN_SDK extern void qn_http_req_set_body_data(qn_http_request_ptr restrict req, const char * restrict body_data, qn_size body_size);
 QN_SDK extern void qn_http_req_set_body_reader(qn_http_request_ptr restrict req, void * restrict body_reader, qn_http_body_reader_callback_fn body_reader_cb, qn_fsize body_size);
+
+// -- Let cURL move the body reader back, e.g. to send the body again on a fresh connection after the reused one died.
+QN_SDK extern void qn_http_req_set_body_seeker(qn_http_request_ptr restrict req, qn_http_body_seeker_callback_fn body_seeker_cb);
 QN_SDK extern const char * qn_http_req_body_data(qn_http_request_ptr restrict req);
 QN_SDK extern qn_fsize qn_http_req_body_size(qn_http_request_ptr restrict req);
 
+// ---- Declaration of HTTP timing ----
+
+// -- Phase durations of one request in microseconds, and bytes transferred including headers.
+typedef struct _QN_HTTP_TIMING
+{
+    qn_uint64 dns_us;           // Resolving the host name.
+    qn_uint64 connect_us;       // Establishing the TCP connection after resolving.
+    qn_uint64 tls_us;           // Doing the TLS handshake after connecting, 0 for plain HTTP.
+    qn_uint64 ttfb_us;          // From the start to receiving the first byte of the response.
+    qn_uint64 total_us;         // From the start to the end of the request.
+    qn_uint64 bytes_sent;
+    qn_uint64 bytes_received;
+} qn_http_timing;
+
 // ---- Declaration of HTTP response ----
 
 struct _QN_HTTP_RESPONSE;
@@ -97,6 +118,7 @@ QN_SDK extern void qn_http_resp_reset(qn_http_response_ptr restrict resp);
 
 QN_SDK extern int qn_http_resp_get_code(qn_http_response_ptr restrict resp);
 QN_SDK extern int qn_http_resp_get_writer_retcode(qn_http_response_ptr restrict resp);
+QN_SDK extern const qn_http_timing * qn_http_resp_get_timing(qn_http_response_ptr restrict resp);
 
 // ----
 
@@ -109,18 +131,56 @@ QN_SDK extern void qn_http_resp_unset_header(qn_http_response_ptr restrict resp,
 // ----
 
 QN_SDK extern void qn_http_resp_set_data_writer(qn_http_response_ptr restrict resp, void * restrict body_writer, qn_http_data_writer_callback_fn body_writer_cb);
+QN_SDK extern void qn_http_resp_set_stream_writer(qn_http_response_ptr restrict resp, void * restrict body_writer, qn_http_data_writer_callback_fn body_writer_cb);
 
 // ---- Declaration of HTTP connection ----
 
+struct _QN_HTTP_CONNECTION_POOL;
+typedef struct _QN_HTTP_CONNECTION_POOL * qn_http_connection_pool_ptr;
+
+QN_SDK extern qn_http_connection_pool_ptr qn_http_pool_create(void);
+QN_SDK extern qn_http_connection_pool_ptr qn_http_pool_create_for_one_thread(void);
+QN_SDK extern void qn_http_pool_destroy(qn_http_connection_pool_ptr restrict pool);
+
+QN_SDK extern qn_bool qn_http_pool_is_thread_safe(qn_http_connection_pool_ptr restrict pool);
+
+// ----
+
 struct _QN_HTTP_CONNECTION;
 typedef struct _QN_HTTP_CONNECTION * qn_http_connection_ptr;
 
 QN_SDK extern qn_http_connection_ptr qn_http_conn_create(void);
 QN_SDK extern void qn_http_conn_destroy(qn_http_connection_ptr restrict conn);
 
+QN_SDK extern void qn_http_conn_set_pool(qn_http_connection_ptr restrict conn, qn_http_connection_pool_ptr restrict pool);
+QN_SDK extern qn_http_connection_pool_ptr qn_http_conn_get_pool(qn_http_connection_ptr restrict conn);
+
 QN_SDK extern qn_bool qn_http_conn_get(qn_http_connection_ptr restrict conn, const char * restrict url, qn_http_request_ptr restrict req, qn_http_response_ptr restrict resp);
 QN_SDK extern qn_bool qn_http_conn_post(qn_http_connection_ptr restrict conn, const char * restrict url, qn_http_request_ptr restrict req, qn_http_response_ptr restrict resp);
 
+// ---- Declaration of HTTP engine ----
+
+enum
+{
+    QN_HTTP_ENG_DEFAULT_WAIT_TIMEOUT = 1000 // milliseconds
+};
+
+struct _QN_HTTP_ENGINE;
+typedef struct _QN_HTTP_ENGINE * qn_http_engine_ptr;
+
+typedef void (*qn_http_eng_done_callback_fn)(void * restrict user_data, qn_http_connection_ptr restrict conn, qn_bool ok);
+
+QN_SDK extern qn_http_engine_ptr qn_http_eng_create(void);
+QN_SDK extern void qn_http_eng_destroy(qn_http_engine_ptr restrict eng);
+
+QN_SDK extern qn_bool qn_http_eng_submit_get(qn_http_engine_ptr restrict eng, qn_http_connection_ptr restrict conn, const char * restrict url, qn_http_request_ptr restrict req, qn_http_response_ptr restrict resp, qn_http_eng_done_callback_fn done_cb, void * restrict user_data);
+QN_SDK extern qn_bool qn_http_eng_submit_post(qn_http_engine_ptr restrict eng, qn_http_connection_ptr restrict conn, const char * restrict url, qn_http_request_ptr restrict req, qn_http_response_ptr restrict resp, qn_http_eng_done_callback_fn done_cb, void * restrict user_data);
+QN_SDK extern void qn_http_eng_cancel(qn_http_engine_ptr restrict eng, qn_http_connection_ptr restrict conn);
+
+QN_SDK extern int qn_http_eng_perform(qn_http_engine_ptr restrict eng, int timeout_ms);
+QN_SDK extern qn_bool qn_http_eng_run(qn_http_engine_ptr restrict eng);
+QN_SDK extern int qn_http_eng_running_count(qn_http_engine_ptr restrict eng);
+
 #ifdef __cplusplus
 }
 #endif
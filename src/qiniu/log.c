@@ -1,4 +1,8 @@
 #include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "qiniu/base/errors.h"
 #include "qiniu/os/time.h"
@@ -9,8 +13,12 @@ extern "C"
 {
 #endif
 
+#define QN_LOG_BUF_SIZE (1024 * 8)
+#define QN_LOG_BATCH_SIZE (1024 * 64)
+#define QN_LOG_IDLE_NSEC (10 * 1000 * 1000)
+
 static qn_log_level qn_log_threshold = QN_LOG_INFO;
-static char qn_log_buf[1024 * 8];
+static QN_THREAD_LOCAL char qn_log_buf[QN_LOG_BUF_SIZE];
 static qn_io_writer_itf qn_log_writer = NULL;
 static const char * qn_log_level_tags[] = {
     "[TRACE]",
@@ -36,11 +44,195 @@ QN_SDK void qn_log_set_writer(qn_io_writer_itf restrict wrt)
     qn_log_writer = wrt;
 }
 
+// ---- Asynchronous Logging ----
+
+// -- A bounded MPSC ring of fixed-size records. Producers claim a slot by CAS on the tail position, and
+//    the sequence number of each slot tells whether it is free for the round of a producer or filled for
+//    the consumer, so no lock is taken on the logging path.
+typedef struct _QN_LOG_RECORD
+{
+    qn_size seq;
+    qn_size size;
+    char data[QN_LOG_RECORD_MAX_SIZE];
+} qn_log_record;
+
+typedef struct _QN_LOG_RING
+{
+    qn_log_record * recs;
+    qn_size mask;
+    qn_size head;
+    qn_size tail;
+    qn_uint64 dropped;
+    int running;
+    pthread_t flusher;
+    char batch[QN_LOG_BATCH_SIZE];
+} qn_log_ring;
+
+static qn_log_ring * qn_log_async = NULL;
+static qn_uint64 qn_log_dropped_before = 0;
+
+static void qn_log_ring_push(qn_log_ring * restrict ring, const char * restrict data, qn_size size)
+{
+    qn_log_record * rec = NULL;
+    qn_size pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    qn_size seq;
+
+    while (1) {
+        rec = &ring->recs[pos & ring->mask];
+        seq = __atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE);
+        if (seq == pos) {
+            if (__atomic_compare_exchange_n(&ring->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+        } else if ((qn_ssize)(seq - pos) < 0) {
+            // -- The ring is full, drop the record rather than blocking the caller.
+            __atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+            return;
+        } else {
+            pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+        } // if
+    } // while
+
+    if (size > QN_LOG_RECORD_MAX_SIZE) {
+        // -- Truncate long records but keep the line break.
+        size = QN_LOG_RECORD_MAX_SIZE;
+        memcpy(rec->data, data, size - 1);
+        rec->data[size - 1] = '\n';
+    } else {
+        memcpy(rec->data, data, size);
+    } // if
+    rec->size = size;
+    __atomic_store_n(&rec->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+static qn_size qn_log_ring_drain(qn_log_ring * restrict ring)
+{
+    qn_log_record * rec = NULL;
+    qn_size batch_size = 0;
+    qn_size cnt = 0;
+
+    while (1) {
+        rec = &ring->recs[ring->head & ring->mask];
+        if (__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != ring->head + 1) break;
+
+        if (QN_LOG_BATCH_SIZE - batch_size < rec->size) {
+            qn_io_wrt_write(qn_log_writer, ring->batch, batch_size);
+            batch_size = 0;
+        } // if
+        memcpy(ring->batch + batch_size, rec->data, rec->size);
+        batch_size += rec->size;
+
+        // -- Hand the slot over to producers of the next round.
+        __atomic_store_n(&rec->seq, ring->head + ring->mask + 1, __ATOMIC_RELEASE);
+        ring->head += 1;
+        cnt += 1;
+    } // while
+
+    if (batch_size > 0) qn_io_wrt_write(qn_log_writer, ring->batch, batch_size);
+    return cnt;
+}
+
+static void * qn_log_flusher_routine(void * arg)
+{
+    qn_log_ring * ring = (qn_log_ring *) arg;
+    struct timespec idle = {0, QN_LOG_IDLE_NSEC};
+
+    while (__atomic_load_n(&ring->running, __ATOMIC_ACQUIRE)) {
+        if (qn_log_ring_drain(ring) == 0) nanosleep(&idle, NULL);
+    } // while
+
+    // -- Flush records pushed before stopping.
+    qn_log_ring_drain(ring);
+    return NULL;
+}
+
+/***************************************************************************//**
+* @ingroup Log
+*
+* Start logging asynchronously.
+*
+* @param [in] rec_cnt The number of records in the ring buffer, rounded up to a
+*                     power of 2. Pass 0 to use the default count.
+*
+* @retval qn_true The background flusher thread is running.
+* @retval qn_false An application error occurs in starting the thread.
+*
+* @remark After this call, logging functions only format records in per-thread
+*         buffers and push them into a lock-free ring buffer. A background
+*         thread drains the ring and writes records to the writer in batches.
+*         If the ring is full, records are dropped and counted, see
+*         qn_log_get_dropped_count().
+*
+*         The writer MUST be set before this call, and MUST NOT be changed
+*         until qn_log_stop_async() returns. Call qn_log_stop_async() only
+*         after other threads stop logging, it flushes all pushed records.
+*
+*         If fails, the function returns qn_false and the caller can call
+*         qn_err_get_message() to check out what happened.
+*******************************************************************************/
+QN_SDK qn_bool qn_log_start_async(qn_uint32 rec_cnt)
+{
+    qn_log_ring * ring = NULL;
+    qn_size cap = 16;
+    qn_size i;
+
+    if (qn_log_async) return qn_true;
+    if (! qn_log_writer) {
+        qn_err_set_invalid_argument();
+        return qn_false;
+    } // if
+
+    if (rec_cnt == 0) rec_cnt = QN_LOG_DEFAULT_RECORD_COUNT;
+    while (cap < rec_cnt) cap <<= 1;
+
+    if (! (ring = calloc(1, sizeof(qn_log_ring)))) {
+        qn_err_set_out_of_memory();
+        return qn_false;
+    } // if
+    if (! (ring->recs = malloc(sizeof(qn_log_record) * cap))) {
+        free(ring);
+        qn_err_set_out_of_memory();
+        return qn_false;
+    } // if
+    for (i = 0; i < cap; i += 1) ring->recs[i].seq = i;
+    ring->mask = cap - 1;
+    ring->running = 1;
+
+    if (pthread_create(&ring->flusher, NULL, &qn_log_flusher_routine, ring) != 0) {
+        free(ring->recs);
+        free(ring);
+        qn_err_set_try_again();
+        return qn_false;
+    } // if
+
+    __atomic_store_n(&qn_log_async, ring, __ATOMIC_RELEASE);
+    return qn_true;
+}
+
+QN_SDK void qn_log_stop_async(void)
+{
+    qn_log_ring * ring = __atomic_exchange_n(&qn_log_async, NULL, __ATOMIC_ACQ_REL);
+
+    if (! ring) return;
+
+    __atomic_store_n(&ring->running, 0, __ATOMIC_RELEASE);
+    pthread_join(ring->flusher, NULL);
+
+    qn_log_dropped_before += ring->dropped;
+    free(ring->recs);
+    free(ring);
+}
+
+QN_SDK qn_uint64 qn_log_get_dropped_count(void)
+{
+    qn_log_ring * ring = __atomic_load_n(&qn_log_async, __ATOMIC_ACQUIRE);
+    return qn_log_dropped_before + ((ring) ? __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED) : 0);
+}
+
 QN_SDK void qn_log_output_va(qn_log_level lvl, const char * restrict file, int line, const char * restrict fmt, va_list ap)
 {
     qn_ssize ret = 0;
     qn_size size = 0;
     const char * fname = NULL;
+    qn_log_ring * ring = NULL;
 
     if (lvl < qn_log_threshold) return;
     if (! qn_log_writer) return;
@@ -75,6 +267,11 @@ QN_SDK void qn_log_output_va(qn_log_level lvl, const char * restrict file, int l
     } // if
     qn_log_buf[size++] = '\n'; // TODO: Be compatible to Windows line break.
 
+    ring = __atomic_load_n(&qn_log_async, __ATOMIC_ACQUIRE);
+    if (ring) {
+        qn_log_ring_push(ring, qn_log_buf, size);
+        return;
+    } // if
     qn_io_wrt_write(qn_log_writer, qn_log_buf, size);
 }
 
@@ -28,6 +28,16 @@ QN_SDK extern void qn_log_set_level(qn_log_level lvl);
 
 QN_SDK extern void qn_log_set_writer(qn_io_writer_itf restrict wrt);
 
+// ---- Asynchronous Logging ----
+
+// -- Records longer than this size are truncated in asynchronous mode.
+#define QN_LOG_RECORD_MAX_SIZE 1024
+#define QN_LOG_DEFAULT_RECORD_COUNT 4096
+
+QN_SDK extern qn_bool qn_log_start_async(qn_uint32 rec_cnt);
+QN_SDK extern void qn_log_stop_async(void);
+QN_SDK extern qn_uint64 qn_log_get_dropped_count(void);
+
 QN_SDK extern void qn_log_output_va(qn_log_level lvl, const char * restrict file, int line, const char * restrict fmt, va_list ap);
 
 static inline void qn_log_output(qn_log_level lvl, const char * restrict file, int line, const char * restrict fmt, ...)
@@ -15,10 +15,14 @@
 
     #define restrict __restrict
 
+    #define QN_THREAD_LOCAL __declspec(thread)
+
 #else
 
     #define QN_SDK
 
+    #define QN_THREAD_LOCAL __thread
+
 #endif
 
 #endif // __QN_MACROS_H__
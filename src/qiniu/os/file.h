@@ -19,8 +19,25 @@ typedef struct _QN_FILE * qn_file_ptr;
 struct _QN_FL_SECTION;
 typedef struct _QN_FL_SECTION * qn_fl_section_ptr;
 
+enum
+{
+    QN_FL_OPEN_SEQUENTIAL = 0x1,
+    QN_FL_OPEN_WRITE = 0x2,      // Open for reading and writing, and create the file if it does not exist.
+    QN_FL_OPEN_READ_AHEAD = 0x4  // Queue reads of the following buffers by io_uring where available, for reading only.
+};
+
+#define QN_FL_READ_AHEAD_DEFAULT_BUF_SIZE (512 * 1024)
+#define QN_FL_READ_AHEAD_DEFAULT_DEPTH 2
+#define QN_FL_READ_AHEAD_MAX_DEPTH 16
+
 typedef struct _QN_FL_OPEN_EXTRA
 {
+    int flags;
+
+    // -- Used only with QN_FL_OPEN_READ_AHEAD, 0 means the default. Each reader of the file, including each section,
+    //    keeps up to `ra_depth` buffers of `ra_buf_size` bytes in flight.
+    size_t ra_buf_size;
+    int ra_depth;
 } qn_fl_open_extra, *qn_fl_open_extra_ptr;
 
 QN_SDK extern qn_file_ptr qn_fl_open(const char * restrict fname, qn_fl_open_extra_ptr restrict extra);
@@ -40,8 +57,14 @@ QN_SDK extern qn_bool qn_fl_seek(qn_file_ptr restrict fl, qn_foffset offset);
 QN_SDK extern qn_bool qn_fl_advance(qn_file_ptr restrict fl, qn_foffset delta);
 QN_SDK extern ssize_t qn_fl_write(qn_file_ptr restrict fl, char * restrict buf, size_t buf_size);
 
+QN_SDK extern qn_bool qn_fl_allocate(qn_file_ptr restrict fl, qn_fsize fsize);
+QN_SDK extern qn_bool qn_fl_pwrite(qn_file_ptr restrict fl, const char * restrict buf, size_t buf_size, qn_foffset offset);
+
 QN_SDK extern size_t qn_fl_reader_read_cfn(void * restrict user_data, char * restrict buf, size_t buf_size);
 
+QN_SDK extern char * qn_fl_map(qn_file_ptr restrict fl, qn_foffset offset, size_t size);
+QN_SDK extern void qn_fl_unmap(char * restrict addr, size_t size);
+
 // ---- Declaration of file info ----
 
 struct _QN_FL_INFO;
@@ -1,6 +1,7 @@
 #include "qiniu/os/file.h"
 
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
@@ -9,6 +10,15 @@
 #include <dlfcn.h>
 #endif
 
+#if defined(QN_CFG_IO_URING)
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
+
 #include "qiniu/base/errors.h"
 
 #ifdef __cplusplus
@@ -75,7 +85,8 @@ static qn_foffset qn_fl_lseek(int fd, qn_foffset offset, int whence)
         errno = EINVAL;
         return -1;
     } // if
-    return lseek(fd, (off_t)(offset & 0xFFFFFFFFL), whence);
+    // -- Keep the sign of relative offsets, which are negative when moving backwards.
+    return lseek(fd, (offset < 0) ? (off_t) offset : (off_t)(offset & 0xFFFFFFFFL), whence);
 }
 
 static qn_foffset qn_fl_lseek_loader(int fd, qn_foffset offset, int whence)
@@ -109,8 +120,452 @@ static inline qn_foffset qn_fl_lseek_wrapper(int fd, qn_foffset offset, int when
         errno = EINVAL;
         return -1;
     } // if
-    return lseek(fd, (off_t)(offset & 0xFFFFFFFFL), whence);
+    // -- Keep the sign of relative offsets, which are negative when moving backwards.
+    return lseek(fd, (offset < 0) ? (off_t) offset : (off_t)(offset & 0xFFFFFFFFL), whence);
+#endif
+}
+
+#endif
+
+#if defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
+
+// ---- Positional reads do not touch the file offset, so threads may read different parts of the same descriptor
+//      without duplicating it or taking any lock.
+static ssize_t qn_fl_pread_wrapper(int fd, char * restrict buf, size_t buf_size, qn_foffset offset)
+{
+    ssize_t ret;
+
+    do {
+#if defined(QN_CFG_LARGE_FILE_SUPPORT) && ! defined(QN_CFG_LARGE_FILE_SUPPORT_AWARE)
+        ret = pread64(fd, buf, buf_size, offset);
+#else
+        if (sizeof(offset) == 8 && 0xFFFFFFFFL < offset + buf_size) {
+            errno = EINVAL;
+            return -1;
+        } // if
+        ret = pread(fd, buf, buf_size, (off_t)(offset & 0xFFFFFFFFL));
+#endif
+    } while (ret < 0 && errno == EINTR);
+    return ret;
+}
+
+// ---- Read-ahead by io_uring (abbreviation: ra) ----
+
+// -- A reader queues reads of the following buffers of its range into its own ring, so the disk works while the
+//    consumer is busy with something else, e.g. sending the previous buffer over the network. Each file object and
+//    each section is used by one thread at a time, so the ring needs no lock. The ring is taken on the first read,
+//    and reads fall back to pread() if io_uring is not available, e.g. disabled by a seccomp policy.
+//
+//    Setting up a ring and registering its buffers costs several system calls and pins memory, so a reader gives
+//    its ring back to the pool of the file when it is destroyed, and the next section of the file, e.g. the next
+//    block read by the same upload worker, takes it over. A file ends up with one ring for each section in use at
+//    the same time.
+
+typedef struct _QN_FL_READ_AHEAD * qn_fl_read_ahead_ptr;
+typedef struct _QN_FL_RA_POOL * qn_fl_ra_pool_ptr;
+
+typedef struct _QN_FL_RA_HANDLE
+{
+    qn_fl_read_ahead_ptr ring;
+    qn_fl_ra_pool_ptr pool;     // Idle rings of the file, shared by the file and its sections. NULL means no reuse.
+    size_t buf_size;
+    int depth;                  // 0 means reading without read-ahead.
+} qn_fl_ra_handle_st, *qn_fl_ra_handle_ptr;
+
+#if defined(QN_CFG_IO_URING)
+
+enum
+{
+    QN_FL_RA_BUF_IDLE = 0,
+    QN_FL_RA_BUF_PENDING,
+    QN_FL_RA_BUF_READY
+};
+
+typedef struct _QN_FL_RA_BUFFER
+{
+    char * data;
+    qn_foffset offset;
+    size_t size;
+    int ret;                    // The number of bytes read, or the negative error number.
+    int state;
+    struct iovec iov;           // Used by vectored reads when buffers cannot be registered.
+} qn_fl_ra_buffer_st, *qn_fl_ra_buffer_ptr;
+
+typedef struct _QN_FL_READ_AHEAD
+{
+    int fd;
+    int ring_fd;
+    qn_fl_read_ahead_ptr next_idle;
+    unsigned int fixed:1;       // Buffers are registered to the ring, so the kernel need not map them for each read.
+    unsigned int broken:1;      // The ring failed while reads were in flight, so the buffers must not be freed.
+
+    unsigned int * sq_tail;
+    unsigned int * sq_mask;
+    unsigned int * sq_array;
+    struct io_uring_sqe * sqes;
+    unsigned int * cq_head;
+    unsigned int * cq_tail;
+    unsigned int * cq_mask;
+    struct io_uring_cqe * cqes;
+
+    void * sq_ring;
+    void * cq_ring;
+    size_t sq_ring_size;
+    size_t cq_ring_size;
+    size_t sqes_size;
+
+    qn_foffset next;            // The offset of the next read to queue.
+    qn_foffset end;             // The end of the range of the reader.
+    size_t buf_size;
+    unsigned int unsubmitted;
+    int head;                   // The first queued buffer, which holds the data at the current position.
+    int cnt;                    // The number of queued buffers.
+    int depth;
+    char * mem;
+    qn_fl_ra_buffer_st bufs[];
+} qn_fl_read_ahead_st;
+
+static int qn_fl_ra_enter(qn_fl_read_ahead_ptr restrict ra, unsigned int min_complete)
+{
+    int ret;
+
+    do {
+        ret = (int) syscall(__NR_io_uring_enter, ra->ring_fd, ra->unsubmitted, min_complete, (min_complete > 0) ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0) return ret;
+
+    ra->unsubmitted -= ret;
+    return 0;
+}
+
+static void qn_fl_ra_reap(qn_fl_read_ahead_ptr restrict ra)
+{
+    struct io_uring_cqe * cqe;
+    unsigned int head = *ra->cq_head;
+    unsigned int tail = __atomic_load_n(ra->cq_tail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head += 1) {
+        cqe = &ra->cqes[head & *ra->cq_mask];
+        ra->bufs[cqe->user_data].ret = cqe->res;
+        ra->bufs[cqe->user_data].state = QN_FL_RA_BUF_READY;
+    } // for
+    __atomic_store_n(ra->cq_head, head, __ATOMIC_RELEASE);
+}
+
+static qn_bool qn_fl_ra_wait(qn_fl_read_ahead_ptr restrict ra, qn_fl_ra_buffer_ptr restrict buf)
+{
+    while (buf->state == QN_FL_RA_BUF_PENDING) {
+        qn_fl_ra_reap(ra);
+        if (buf->state != QN_FL_RA_BUF_PENDING) break;
+        if (qn_fl_ra_enter(ra, 1) < 0) {
+            ra->broken = 1;
+            return qn_false;
+        } // if
+    } // while
+    return qn_true;
+}
+
+static qn_bool qn_fl_ra_drain(qn_fl_read_ahead_ptr restrict ra)
+{
+    for (; ra->cnt > 0; ra->cnt -= 1, ra->head = (ra->head + 1) % ra->depth) {
+        if (! qn_fl_ra_wait(ra, &ra->bufs[ra->head])) return qn_false;
+        ra->bufs[ra->head].state = QN_FL_RA_BUF_IDLE;
+    } // for
+    ra->head = 0;
+    return qn_true;
+}
+
+static void qn_fl_ra_queue(qn_fl_read_ahead_ptr restrict ra)
+{
+    struct io_uring_sqe * sqe;
+    qn_fl_ra_buffer_ptr buf;
+    unsigned int tail = *ra->sq_tail;
+    int idx;
+
+    for (; ra->cnt < ra->depth && ra->next < ra->end; ra->cnt += 1, tail += 1) {
+        idx = (ra->head + ra->cnt) % ra->depth;
+        buf = &ra->bufs[idx];
+        buf->offset = ra->next;
+        buf->size = (ra->end - ra->next < ra->buf_size) ? (size_t)(ra->end - ra->next) : ra->buf_size;
+        buf->state = QN_FL_RA_BUF_PENDING;
+
+        sqe = &ra->sqes[tail & *ra->sq_mask];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->fd = ra->fd;
+        sqe->off = buf->offset;
+        sqe->user_data = idx;
+        if (ra->fixed) {
+            sqe->opcode = IORING_OP_READ_FIXED;
+            sqe->addr = (qn_uint64)(uintptr_t) buf->data;
+            sqe->len = buf->size;
+            sqe->buf_index = 0;
+        } else {
+            sqe->opcode = IORING_OP_READV;
+            buf->iov.iov_base = buf->data;
+            buf->iov.iov_len = buf->size;
+            sqe->addr = (qn_uint64)(uintptr_t) &buf->iov;
+            sqe->len = 1;
+        } // if
+        ra->sq_array[tail & *ra->sq_mask] = tail & *ra->sq_mask;
+
+        ra->next += buf->size;
+        ra->unsubmitted += 1;
+    } // for
+    __atomic_store_n(ra->sq_tail, tail, __ATOMIC_RELEASE);
+
+    // -- Entries left unsubmitted because of a transient failure are submitted by the next call.
+    if (ra->unsubmitted > 0) qn_fl_ra_enter(ra, 0);
+}
+
+static void qn_fl_ra_destroy(qn_fl_read_ahead_ptr restrict ra)
+{
+    if (ra) {
+        // -- Wait for reads in flight, since the kernel writes into the buffers until they complete.
+        if (! ra->broken && qn_fl_ra_drain(ra)) free(ra->mem);
+        if (ra->sqes) munmap(ra->sqes, ra->sqes_size);
+        if (ra->cq_ring && ra->cq_ring != ra->sq_ring) munmap(ra->cq_ring, ra->cq_ring_size);
+        if (ra->sq_ring) munmap(ra->sq_ring, ra->sq_ring_size);
+        if (ra->ring_fd >= 0) close(ra->ring_fd);
+        free(ra);
+    } // if
+}
+
+static qn_fl_read_ahead_ptr qn_fl_ra_create(int fd, qn_foffset offset, qn_foffset end, size_t buf_size, int depth)
+{
+    struct io_uring_params params;
+    struct iovec iov;
+    qn_fl_read_ahead_ptr new_ra;
+    void * addr;
+    int i;
+
+    new_ra = calloc(1, sizeof(qn_fl_read_ahead_st) + sizeof(qn_fl_ra_buffer_st) * depth);
+    if (! new_ra) return NULL;
+
+    new_ra->fd = fd;
+    new_ra->ring_fd = -1;
+    new_ra->next = offset;
+    new_ra->end = end;
+    new_ra->depth = depth;
+    new_ra->buf_size = buf_size;
+
+    if (posix_memalign(&addr, 4096, buf_size * depth) != 0) goto QN_FL_RA_CREATE_ERROR;
+    new_ra->mem = (char *) addr;
+
+    memset(&params, 0, sizeof(params));
+    new_ra->ring_fd = (int) syscall(__NR_io_uring_setup, depth, &params);
+    if (new_ra->ring_fd < 0) goto QN_FL_RA_CREATE_ERROR;
+
+    new_ra->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    new_ra->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (new_ra->sq_ring_size < new_ra->cq_ring_size) new_ra->sq_ring_size = new_ra->cq_ring_size;
+    } // if
+
+    addr = mmap(NULL, new_ra->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, new_ra->ring_fd, IORING_OFF_SQ_RING);
+    if (addr == MAP_FAILED) goto QN_FL_RA_CREATE_ERROR;
+    new_ra->sq_ring = addr;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        new_ra->cq_ring = new_ra->sq_ring;
+    } else {
+        addr = mmap(NULL, new_ra->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, new_ra->ring_fd, IORING_OFF_CQ_RING);
+        if (addr == MAP_FAILED) goto QN_FL_RA_CREATE_ERROR;
+        new_ra->cq_ring = addr;
+    } // if
+
+    new_ra->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    addr = mmap(NULL, new_ra->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, new_ra->ring_fd, IORING_OFF_SQES);
+    if (addr == MAP_FAILED) goto QN_FL_RA_CREATE_ERROR;
+    new_ra->sqes = (struct io_uring_sqe *) addr;
+
+    new_ra->sq_tail = (unsigned int *)((char *) new_ra->sq_ring + params.sq_off.tail);
+    new_ra->sq_mask = (unsigned int *)((char *) new_ra->sq_ring + params.sq_off.ring_mask);
+    new_ra->sq_array = (unsigned int *)((char *) new_ra->sq_ring + params.sq_off.array);
+    new_ra->cq_head = (unsigned int *)((char *) new_ra->cq_ring + params.cq_off.head);
+    new_ra->cq_tail = (unsigned int *)((char *) new_ra->cq_ring + params.cq_off.tail);
+    new_ra->cq_mask = (unsigned int *)((char *) new_ra->cq_ring + params.cq_off.ring_mask);
+    new_ra->cqes = (struct io_uring_cqe *)((char *) new_ra->cq_ring + params.cq_off.cqes);
+
+    for (i = 0; i < depth; i += 1) new_ra->bufs[i].data = new_ra->mem + buf_size * i;
+
+    // -- Registered buffers are pinned and count against RLIMIT_MEMLOCK, so fall back to vectored reads if the
+    //    limit is too low.
+    iov.iov_base = new_ra->mem;
+    iov.iov_len = buf_size * depth;
+    new_ra->fixed = (syscall(__NR_io_uring_register, new_ra->ring_fd, IORING_REGISTER_BUFFERS, &iov, 1) == 0) ? 1 : 0;
+    return new_ra;
+
+QN_FL_RA_CREATE_ERROR:
+    qn_fl_ra_destroy(new_ra);
+    return NULL;
+}
+
+typedef struct _QN_FL_RA_POOL
+{
+    pthread_mutex_t lock;
+    qn_fl_read_ahead_ptr idle;
+} qn_fl_ra_pool_st;
+
+static qn_fl_ra_pool_ptr qn_fl_ra_pool_create(void)
+{
+    qn_fl_ra_pool_ptr new_pool = calloc(1, sizeof(qn_fl_ra_pool_st));
+    if (! new_pool) return NULL;
+
+    if (pthread_mutex_init(&new_pool->lock, NULL) != 0) {
+        free(new_pool);
+        return NULL;
+    } // if
+    return new_pool;
+}
+
+static void qn_fl_ra_pool_destroy(qn_fl_ra_pool_ptr restrict pool)
+{
+    qn_fl_read_ahead_ptr ra;
+
+    if (pool) {
+        while ((ra = pool->idle)) {
+            pool->idle = ra->next_idle;
+            qn_fl_ra_destroy(ra);
+        } // while
+        pthread_mutex_destroy(&pool->lock);
+        free(pool);
+    } // if
+}
+
+static qn_fl_read_ahead_ptr qn_fl_ra_acquire(qn_fl_ra_handle_ptr restrict rah, int fd, qn_foffset offset, qn_foffset end)
+{
+    qn_fl_read_ahead_ptr * prev;
+    qn_fl_read_ahead_ptr ra = NULL;
+    size_t buf_size = rah->buf_size;
+
+    // -- Do not allocate more than the range needs, e.g. for the last block of a file.
+    if (end - offset < buf_size) buf_size = ((size_t)(end - offset) + 4095) & ~((size_t) 4095);
+
+    if (rah->pool) {
+        pthread_mutex_lock(&rah->pool->lock);
+        for (prev = &rah->pool->idle; *prev; prev = &(*prev)->next_idle) {
+            if ((*prev)->buf_size >= buf_size) {
+                ra = *prev;
+                *prev = ra->next_idle;
+                break;
+            } // if
+        } // for
+        pthread_mutex_unlock(&rah->pool->lock);
+    } // if
+    if (! ra) return qn_fl_ra_create(fd, offset, end, buf_size, rah->depth);
+
+    // -- Idle rings have no reads in flight, so only the range needs to be set.
+    ra->fd = fd;
+    ra->next = offset;
+    ra->end = end;
+    return ra;
+}
+
+static void qn_fl_ra_release(qn_fl_ra_handle_ptr restrict rah)
+{
+    qn_fl_read_ahead_ptr ra = rah->ring;
+
+    rah->ring = NULL;
+    if (! ra) return;
+
+    if (! rah->pool || ra->broken || ! qn_fl_ra_drain(ra)) {
+        qn_fl_ra_destroy(ra);
+        return;
+    } // if
+
+    pthread_mutex_lock(&rah->pool->lock);
+    ra->next_idle = rah->pool->idle;
+    rah->pool->idle = ra;
+    pthread_mutex_unlock(&rah->pool->lock);
+}
+
+// -- Return the number of bytes copied from the buffer holding the given offset, or -1 to make the caller read
+//    synchronously.
+static ssize_t qn_fl_ra_read(qn_fl_read_ahead_ptr restrict ra, qn_foffset offset, char * restrict buf, size_t buf_size, qn_bool consume)
+{
+    qn_fl_ra_buffer_ptr head;
+    size_t copy_size;
+
+    if (ra->broken) return -1;
+
+    // ---- Drop buffers before the offset, or start over if the reader has been seeked backwards.
+    while (ra->cnt > 0) {
+        head = &ra->bufs[ra->head];
+        if (offset < head->offset) {
+            if (! qn_fl_ra_drain(ra)) return -1;
+            break;
+        } // if
+        if (offset < head->offset + head->size) break;
+
+        if (! qn_fl_ra_wait(ra, head)) return -1;
+        head->state = QN_FL_RA_BUF_IDLE;
+        ra->head = (ra->head + 1) % ra->depth;
+        ra->cnt -= 1;
+    } // while
+
+    if (ra->cnt == 0) ra->next = offset;
+    qn_fl_ra_queue(ra);
+    if (ra->cnt == 0) return 0;
+
+    head = &ra->bufs[ra->head];
+    if (! qn_fl_ra_wait(ra, head)) return -1;
+
+    // ---- Let the caller deal with errors and short reads.
+    if (head->ret < 0 || offset >= head->offset + head->ret) return -1;
+
+    copy_size = head->offset + head->ret - offset;
+    if (buf_size < copy_size) copy_size = buf_size;
+    memcpy(buf, head->data + (offset - head->offset), copy_size);
+
+    if (consume && offset + copy_size == head->offset + head->size) {
+        // -- Reuse the buffer for the next read as soon as it is consumed.
+        head->state = QN_FL_RA_BUF_IDLE;
+        ra->head = (ra->head + 1) % ra->depth;
+        ra->cnt -= 1;
+        qn_fl_ra_queue(ra);
+    } // if
+    return copy_size;
+}
+
+#else
+
+static inline qn_fl_ra_pool_ptr qn_fl_ra_pool_create(void)
+{
+    return NULL;
+}
+
+static inline void qn_fl_ra_pool_destroy(qn_fl_ra_pool_ptr restrict pool)
+{
+}
+
+static inline void qn_fl_ra_release(qn_fl_ra_handle_ptr restrict rah)
+{
+}
+
+#endif
+
+static inline void qn_fl_ra_init(qn_fl_ra_handle_ptr restrict rah, qn_fl_ra_pool_ptr restrict pool, size_t buf_size, int depth)
+{
+    rah->ring = NULL;
+    rah->pool = pool;
+    rah->buf_size = (buf_size + 4095) & ~((size_t) 4095);
+    rah->depth = depth;
+}
+
+static ssize_t qn_fl_ra_pread(qn_fl_ra_handle_ptr restrict rah, int fd, char * restrict buf, size_t buf_size, qn_foffset offset, qn_foffset end, qn_bool consume)
+{
+#if defined(QN_CFG_IO_URING)
+    ssize_t ret;
+
+    if (rah->depth > 0 && offset < end) {
+        if (! rah->ring) {
+            rah->ring = qn_fl_ra_acquire(rah, fd, offset, end);
+            if (! rah->ring) rah->depth = 0;
+        } // if
+        if (rah->ring && (ret = qn_fl_ra_read(rah->ring, offset, buf, buf_size, consume)) >= 0) return ret;
+    } // if
 #endif
+    return qn_fl_pread_wrapper(fd, buf, buf_size, offset);
 }
 
 #endif
@@ -120,6 +575,10 @@ struct _QN_FILE
     qn_io_reader_ptr rdr_vtbl;
     qn_fl_info_ptr fi;
     int fd;
+#if defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
+    qn_foffset pos;
+    qn_fl_ra_handle_st ra;
+#endif
 } qn_file_st;
 
 static inline qn_file_ptr qn_fl_from_io_reader(qn_io_reader_itf restrict itf)
@@ -196,7 +655,11 @@ QN_SDK qn_file_ptr qn_fl_open(const char * restrict fname, qn_fl_open_extra_ptr
         return NULL;
     } // if
 
-    new_file->fd = open(fname, 0);
+    if (extra && (extra->flags & QN_FL_OPEN_WRITE)) {
+        new_file->fd = open(fname, O_RDWR | O_CREAT, 0644);
+    } else {
+        new_file->fd = open(fname, 0);
+    } // if
     if (new_file->fd < 0) {
         free(new_file);
         qn_err_fl_set_opening_file_failed();
@@ -205,10 +668,23 @@ QN_SDK qn_file_ptr qn_fl_open(const char * restrict fname, qn_fl_open_extra_ptr
 
     new_file->fi = qn_fl_info_stat(fname);
     if (! new_file->fi) {
+        close(new_file->fd);
         free(new_file);
         return NULL;
     } // if
 
+    if (extra && (extra->flags & QN_FL_OPEN_SEQUENTIAL)) {
+        // ---- Just a hint to let the kernel read ahead aggressively, so ignore failures.
+        posix_fadvise(new_file->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    } // if
+
+#if defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
+    if (extra && (extra->flags & QN_FL_OPEN_READ_AHEAD)) {
+        // -- Rings are not reused if the pool cannot be created.
+        qn_fl_ra_init(&new_file->ra, qn_fl_ra_pool_create(), (extra->ra_buf_size > 0) ? extra->ra_buf_size : QN_FL_READ_AHEAD_DEFAULT_BUF_SIZE, (extra->ra_depth <= 0) ? QN_FL_READ_AHEAD_DEFAULT_DEPTH : (extra->ra_depth < QN_FL_READ_AHEAD_MAX_DEPTH) ? extra->ra_depth : QN_FL_READ_AHEAD_MAX_DEPTH);
+    } // if
+#endif
+
     new_file->rdr_vtbl = &qn_fl_rdr_vtable;
     return new_file;
 }
@@ -230,10 +706,17 @@ QN_SDK qn_file_ptr qn_fl_duplicate(qn_file_ptr restrict fl)
 
     new_file->fi = qn_fl_info_duplicate(fl->fi);
     if (! new_file->fi) {
+        close(new_file->fd);
         free(new_file);
         return NULL;
     } // if
 
+#if defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
+    // -- Start from the same position, as a duplicated descriptor shares the offset of the original one.
+    new_file->pos = fl->pos;
+    qn_fl_ra_init(&new_file->ra, (fl->ra.depth > 0) ? qn_fl_ra_pool_create() : NULL, fl->ra.buf_size, fl->ra.depth);
+#endif
+
     new_file->rdr_vtbl = &qn_fl_rdr_vtable;
     return new_file;
 }
@@ -242,6 +725,10 @@ QN_SDK void qn_fl_close(qn_file_ptr restrict fl)
 {
     if (fl) {
         qn_fl_info_destroy(fl->fi);
+#if defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
+        qn_fl_ra_release(&fl->ra);
+        qn_fl_ra_pool_destroy(fl->ra.pool);
+#endif
         close(fl->fd);
         free(fl);
     } // if
@@ -264,47 +751,137 @@ QN_SDK qn_fsize qn_fl_fsize(qn_file_ptr restrict fl)
 
 QN_SDK ssize_t qn_fl_peek(qn_file_ptr restrict fl, char * restrict buf, size_t buf_size)
 {
+#if defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
+    ssize_t ret = qn_fl_ra_pread(&fl->ra, fl->fd, buf, buf_size, fl->pos, fl->fi->fsize, qn_false);
+    if (ret < 0) {
+        qn_err_fl_set_reading_file_failed();
+        return QN_IO_RDR_READING_FAILED;
+    } // if
+#else
     ssize_t ret = qn_fl_read(fl, buf, buf_size);
     if (ret >= 0 && !qn_fl_advance(fl, -ret)) return QN_IO_RDR_READING_FAILED;
+#endif
     return ret;
 }
 
 QN_SDK ssize_t qn_fl_read(qn_file_ptr restrict fl, char * restrict buf, size_t buf_size)
 {
+#if defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
+    ssize_t ret = qn_fl_ra_pread(&fl->ra, fl->fd, buf, buf_size, fl->pos, fl->fi->fsize, qn_true);
+#else
     ssize_t ret = read(fl->fd, buf, buf_size);
+#endif
     if (ret < 0) {
         qn_err_fl_set_reading_file_failed();
         return QN_IO_RDR_READING_FAILED;
     } // if
+#if defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
+    fl->pos += ret;
+#endif
     return ret;
 }
 
 QN_SDK qn_bool qn_fl_seek(qn_file_ptr restrict fl, qn_foffset offset)
 {
+#if defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
+    // -- The position is kept in the object and passed to each positional read, so no system call is needed.
+    if (offset < 0) {
+#else
     if (qn_fl_lseek_wrapper(fl->fd, offset, SEEK_SET) < 0) {
+#endif
         qn_err_fl_set_seeking_file_failed();
         return qn_false;
     } // if
+#if defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
+    fl->pos = offset;
+#endif
     return qn_true;
 }
 
 QN_SDK qn_bool qn_fl_advance(qn_file_ptr restrict fl, qn_foffset delta)
 {
+#if defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
+    return qn_fl_seek(fl, fl->pos + delta);
+#else
     if (qn_fl_lseek_wrapper(fl->fd, delta, SEEK_CUR) < 0) {
         qn_err_fl_set_seeking_file_failed();
         return qn_false;
     } // if
     return qn_true;
+#endif
 }
 
 QN_SDK ssize_t qn_fl_write(qn_file_ptr restrict fl, char * restrict buf, size_t buf_size)
 {
+#if defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
+    if (! qn_fl_pwrite(fl, buf, buf_size, fl->pos)) return QN_IO_RDR_READING_FAILED;
+    fl->pos += buf_size;
+    return buf_size;
+#else
     ssize_t ret = write(fl->fd, buf, buf_size);
     if (ret < 0) {
-        qn_err_fl_set_reading_file_failed();
+        qn_err_fl_set_writing_file_failed();
         return QN_IO_RDR_READING_FAILED;
     } // if
     return ret;
+#endif
+}
+
+QN_SDK qn_bool qn_fl_allocate(qn_file_ptr restrict fl, qn_fsize fsize)
+{
+    int ret;
+
+#if defined(QN_CFG_LARGE_FILE_SUPPORT) && ! defined(QN_CFG_LARGE_FILE_SUPPORT_AWARE)
+    ret = ftruncate64(fl->fd, fsize);
+#else
+    if (sizeof(fsize) == 8 && 0xFFFFFFFFL < fsize) {
+        qn_err_fl_set_writing_file_failed();
+        return qn_false;
+    } // if
+    ret = ftruncate(fl->fd, (off_t)(fsize & 0xFFFFFFFFL));
+#endif
+    if (ret < 0) {
+        qn_err_fl_set_writing_file_failed();
+        return qn_false;
+    } // if
+
+    // ---- Reserve blocks in advance to avoid fragments and running out of space halfway, just a hint since not
+    //      all file systems support it.
+#if defined(QN_CFG_LARGE_FILE_SUPPORT) && ! defined(QN_CFG_LARGE_FILE_SUPPORT_AWARE)
+    if (fsize > 0) posix_fallocate64(fl->fd, 0, fsize);
+#else
+    if (fsize > 0) posix_fallocate(fl->fd, 0, (off_t)(fsize & 0xFFFFFFFFL));
+#endif
+
+    fl->fi->fsize = fsize;
+    return qn_true;
+}
+
+QN_SDK qn_bool qn_fl_pwrite(qn_file_ptr restrict fl, const char * restrict buf, size_t buf_size, qn_foffset offset)
+{
+    ssize_t ret;
+
+    // ---- Positional writes do not touch the file offset, so threads may write different parts of the same file.
+    while (buf_size > 0) {
+#if defined(QN_CFG_LARGE_FILE_SUPPORT) && ! defined(QN_CFG_LARGE_FILE_SUPPORT_AWARE)
+        ret = pwrite64(fl->fd, buf, buf_size, offset);
+#else
+        if (sizeof(offset) == 8 && 0xFFFFFFFFL < offset + buf_size) {
+            qn_err_fl_set_writing_file_failed();
+            return qn_false;
+        } // if
+        ret = pwrite(fl->fd, buf, buf_size, (off_t)(offset & 0xFFFFFFFFL));
+#endif
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            qn_err_fl_set_writing_file_failed();
+            return qn_false;
+        } // if
+        buf += ret;
+        buf_size -= ret;
+        offset += ret;
+    } // while
+    return qn_true;
 }
 
 QN_SDK qn_fl_section_ptr qn_fl_section(qn_file_ptr restrict fl, qn_foffset offset, size_t sec_size)
@@ -320,6 +897,36 @@ QN_SDK size_t qn_fl_reader_read_cfn(void * restrict user_data, char * restrict b
     return qn_fl_read(fl, buf, buf_size);
 }
 
+QN_SDK char * qn_fl_map(qn_file_ptr restrict fl, qn_foffset offset, size_t size)
+{
+    void * addr;
+
+#if defined(QN_CFG_LARGE_FILE_SUPPORT) && ! defined(QN_CFG_LARGE_FILE_SUPPORT_AWARE)
+    addr = mmap64(NULL, size, PROT_READ, MAP_PRIVATE, fl->fd, offset);
+#else
+    if (sizeof(offset) == 8 && 0xFFFFFFFFL < offset + size) {
+        qn_err_fl_set_mapping_file_failed();
+        return NULL;
+    } // if
+    addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fl->fd, (off_t)(offset & 0xFFFFFFFFL));
+#endif
+    if (addr == MAP_FAILED) {
+        qn_err_fl_set_mapping_file_failed();
+        return NULL;
+    } // if
+
+    // ---- Pages are touched once from the beginning to the end in most cases.
+    // -- Advice values are not flags, so give each one by a separate call. Both are only hints.
+    madvise(addr, size, MADV_SEQUENTIAL);
+    madvise(addr, size, MADV_WILLNEED);
+    return (char *) addr;
+}
+
+QN_SDK void qn_fl_unmap(char * restrict addr, size_t size)
+{
+    if (addr) munmap(addr, size);
+}
+
 // ---- Definition of file info depends on operating system ----
 
 QN_SDK qn_fl_info_ptr qn_fl_info_stat(const char * restrict fname)
@@ -357,6 +964,9 @@ typedef struct _QN_FL_SECTION
     qn_foffset offset;
     size_t sec_size;
     size_t rem_size;
+#if defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
+    qn_fl_ra_handle_st ra;
+#endif
 } qn_fl_section_st;
 
 static inline qn_fl_section_ptr qn_fl_sec_from_io_reader(qn_io_reader_itf restrict itf)
@@ -415,7 +1025,14 @@ static qn_io_reader_st qn_fl_sec_rdr_vtable = {
 
 QN_SDK qn_fl_section_ptr qn_fl_sec_create(qn_file_ptr restrict fl, qn_foffset offset, size_t sec_size)
 {
-    qn_fl_section_ptr new_section = calloc(1, sizeof(qn_fl_section_st));
+    qn_fl_section_ptr new_section;
+
+    if (qn_fl_fsize(fl) <= offset) {
+        qn_err_set_out_of_range();
+        return NULL;
+    } // if
+
+    new_section = calloc(1, sizeof(qn_fl_section_st));
     if (!new_section) {
         qn_err_set_out_of_memory();
         return NULL;
@@ -423,19 +1040,20 @@ QN_SDK qn_fl_section_ptr qn_fl_sec_create(qn_file_ptr restrict fl, qn_foffset of
 
 #if ! defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
     new_section->file = qn_fl_duplicate(fl);
+    if (! new_section->file) {
+        free(new_section);
+        return NULL;
+    } // if
 #else
+    // -- All sections read the shared descriptor by positional reads, so they can be used by different threads.
     new_section->file = fl;
+    qn_fl_ra_init(&new_section->ra, fl->ra.pool, fl->ra.buf_size, fl->ra.depth);
 #endif
 
     new_section->offset = offset;
     new_section->sec_size = sec_size;
     new_section->rem_size = sec_size;
 
-    if (qn_fl_fsize(fl) <= offset) {
-        qn_err_set_out_of_range();
-        return NULL;
-    } // if
-
     if (! qn_fl_sec_seek(new_section, offset)) {
         qn_fl_sec_destroy(new_section);
         return NULL;
@@ -463,6 +1081,8 @@ QN_SDK void qn_fl_sec_destroy(qn_fl_section_ptr restrict fs)
     if (fs) {
 #if ! defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
         qn_fl_close(fs->file);
+#else
+        qn_fl_ra_release(&fs->ra);
 #endif
         free(fs);
     } // if
@@ -493,18 +1113,16 @@ QN_SDK ssize_t qn_fl_sec_peek(qn_fl_section_ptr restrict fs, char * restrict buf
     read_size = (buf_size < fs->rem_size) ? buf_size : fs->rem_size;
 
 #if ! defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
-    ret = read(fs->file->fd, buf, read_size); 
-    if (ret > 0 && !qn_fl_sec_advance(fs, -read_size)) return QN_IO_RDR_READING_FAILED;
+    ret = qn_fl_peek(fs->file, buf, read_size);
 #else
-    ret = pread(fs->file->fd, buf, read_size, fs->offset + (fs->sec_size - fs->rem_size));
+    // -- Peeking does not consume data, so the remaining size is left as it is.
+    ret = qn_fl_ra_pread(&fs->ra, fs->file->fd, buf, read_size, fs->offset + (fs->sec_size - fs->rem_size), fs->offset + fs->sec_size, qn_false);
 #endif
 
     if (ret < 0) {
         qn_err_fl_set_reading_file_failed();
         return QN_IO_RDR_READING_FAILED;
     } // if
-
-    fs->rem_size -= ret;
     return ret;
 }
 
@@ -520,7 +1138,7 @@ QN_SDK ssize_t qn_fl_sec_read(qn_fl_section_ptr restrict fs, char * restrict buf
 #if ! defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
     ret = read(fs->file->fd, buf, read_size); 
 #else
-    ret = pread(fs->file->fd, buf, read_size, fs->offset + (fs->sec_size - fs->rem_size));
+    ret = qn_fl_ra_pread(&fs->ra, fs->file->fd, buf, read_size, fs->offset + (fs->sec_size - fs->rem_size), fs->offset + fs->sec_size, qn_true);
 #endif
 
     if (ret < 0) {
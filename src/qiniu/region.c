@@ -620,6 +620,11 @@ static qn_bool qn_rgn_svc_extract_and_add_entries(qn_json_object_ptr root, qn_re
     return qn_true;
 }
 
+QN_SDK void qn_rgn_svc_set_pool(qn_rgn_service_ptr restrict svc, qn_http_connection_pool_ptr restrict pool)
+{
+    qn_http_conn_set_pool(svc->conn, pool);
+}
+
 QN_SDK qn_bool qn_rgn_svc_grab_bucket_region(qn_rgn_service_ptr restrict svc, qn_rgn_auth_ptr restrict auth, const char * restrict bucket, qn_rgn_table_ptr restrict rtbl)
 {
     qn_bool ret;
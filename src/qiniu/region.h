@@ -3,6 +3,7 @@
 
 #include "qiniu/os/types.h"
 #include "qiniu/base/string.h"
+#include "qiniu/http.h"
 
 #include "qiniu/macros.h"
 
@@ -102,6 +103,8 @@ typedef struct _QN_RGN_SERVICE * qn_rgn_service_ptr;
 QN_SDK extern qn_rgn_service_ptr qn_rgn_svc_create(void);
 QN_SDK extern void qn_rgn_svc_destroy(qn_rgn_service_ptr restrict svc);
 
+QN_SDK extern void qn_rgn_svc_set_pool(qn_rgn_service_ptr restrict svc, qn_http_connection_pool_ptr restrict pool);
+
 QN_SDK extern qn_bool qn_rgn_svc_grab_bucket_region(qn_rgn_service_ptr restrict svc, qn_rgn_auth_ptr restrict auth, const char * restrict bucket, qn_rgn_table_ptr restrict rtbl);
 
 #ifdef __cplusplus
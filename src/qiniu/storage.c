@@ -1,11 +1,15 @@
 #include <assert.h>
+#include <pthread.h>
 #include <curl/curl.h>
 
+#include "qiniu/base/crc32.h"
 #include "qiniu/base/errors.h"
 #include "qiniu/base/json_parser.h"
 #include "qiniu/base/json_formatter.h"
+#include "qiniu/base/metrics.h"
 #include "qiniu/os/types_conv.h"
 #include "qiniu/version.h"
+#include "qiniu/etag.h"
 #include "qiniu/http.h"
 #include "qiniu/http_query.h"
 #include "qiniu/storage.h"
@@ -18,6 +22,17 @@ extern "C"
 
 // -------- Storage Object (abbreviation: stor) --------
 
+typedef qn_json_object_ptr (*qn_stor_finish_fn)(qn_storage_ptr restrict stor);
+
+// -- A file mapped into memory and handed out to curl slice by slice, instead of being read into a buffer first.
+typedef struct _QN_STOR_MAPPED_BODY
+{
+    char * addr;
+    size_t size;
+    size_t pos;
+    qn_etag_context_ptr qetag;
+} qn_stor_mapped_body_st, *qn_stor_mapped_body_ptr;
+
 typedef struct _QN_STORAGE
 {
     qn_http_request_ptr req;
@@ -26,6 +41,30 @@ typedef struct _QN_STORAGE
     qn_http_json_writer_ptr resp_json_wrt;
     qn_json_object_ptr obj_body;
     qn_json_array_ptr arr_body;
+    qn_json_object_ptr fake_obj_body;
+
+    // ---- Builders reused by all requests to save allocations of temporary strings.
+    qn_str_builder_ptr url_bld;
+    qn_str_builder_ptr tmp_bld;
+
+    qn_mtr_api_em mtr_api;
+
+    // ---- The mapped file being uploaded, kept until the next request since it may be in flight asynchronously.
+    qn_stor_mapped_body_st mapped_body;
+
+    // ---- Reads the body of uploads from readers ahead, detached from the source in the same way.
+    qn_io_read_ahead_reader_ptr ra_rdr;
+    size_t ra_buf_size;
+    int ra_depth;
+
+    // ---- Estimates of the connection, used to size chunks of resumable uploads.
+    qn_stor_chunk_sizing_st csz;
+
+    // ---- Fields used in asynchronous mode.
+    qn_http_engine_ptr eng;
+    qn_stor_done_callback_fn done_cb;
+    void * done_data;
+    qn_stor_finish_fn finish;
 } qn_storage;
 
 QN_SDK qn_storage_ptr qn_stor_create(void)
@@ -68,14 +107,44 @@ QN_SDK qn_storage_ptr qn_stor_create(void)
         return NULL;
     } // if
 
+    new_stor->url_bld = qn_str_bld_create(0);
+    if (!new_stor->url_bld) {
+        qn_http_json_wrt_destroy(new_stor->resp_json_wrt);
+        qn_http_conn_destroy(new_stor->conn);
+        qn_http_resp_destroy(new_stor->resp);
+        qn_http_req_destroy(new_stor->req);
+        free(new_stor);
+        return NULL;
+    } // if
+
+    new_stor->tmp_bld = qn_str_bld_create(0);
+    if (!new_stor->tmp_bld) {
+        qn_str_bld_destroy(new_stor->url_bld);
+        qn_http_json_wrt_destroy(new_stor->resp_json_wrt);
+        qn_http_conn_destroy(new_stor->conn);
+        qn_http_resp_destroy(new_stor->resp);
+        qn_http_req_destroy(new_stor->req);
+        free(new_stor);
+        return NULL;
+    } // if
+
     return new_stor;
 }
 
 QN_SDK void qn_stor_destroy(qn_storage_ptr restrict stor)
 {
     if (stor) {
+        if (stor->eng) qn_http_eng_cancel(stor->eng, stor->conn);
+        if (stor->fake_obj_body) {
+            qn_json_destroy_object(stor->fake_obj_body);
+            stor->arr_body = NULL; // The array is held by the fake object.
+        } // if
         if (stor->obj_body) qn_json_destroy_object(stor->obj_body);
         if (stor->arr_body) qn_json_destroy_array(stor->arr_body);
+        qn_fl_unmap(stor->mapped_body.addr, stor->mapped_body.size);
+        qn_io_rardr_destroy(stor->ra_rdr);
+        qn_str_bld_destroy(stor->tmp_bld);
+        qn_str_bld_destroy(stor->url_bld);
         qn_http_json_wrt_destroy(stor->resp_json_wrt);
         qn_http_conn_destroy(stor->conn);
         qn_http_resp_destroy(stor->resp);
@@ -99,6 +168,77 @@ QN_SDK qn_http_hdr_iterator_ptr qn_stor_resp_get_header_iterator(const qn_storag
     return qn_http_resp_get_header_iterator(stor->resp);
 }
 
+/***************************************************************************//**
+* @ingroup Storage-Object
+*
+* Attach a storage object to an HTTP engine for submitting requests
+* asynchronously.
+*
+* @param [in] stor The pointer to the storage object.
+* @param [in] eng The pointer to the HTTP engine, or NULL to go back to the
+*                 synchronous mode.
+* @param [in] done_cb The callback function to be called when a request is done.
+* @param [in] user_data The pointer passed to the callback function as is.
+*
+* @remark In asynchronous mode, the storage core functions submit requests to
+*         the engine and return NULL immediately, with the error code set to
+*         QN_ERR_IN_PROGRESS (check it by calling qn_err_is_in_progress()).
+*         Any other error means that the request is not submitted.
+*
+*         Once the caller drives the engine by calling qn_http_eng_perform()
+*         or qn_http_eng_run(), the done callback receives the same result
+*         object as the synchronous call returns, or NULL if an application
+*         error occurs.
+*
+*         Each storage object can carry only one request at a time, so use
+*         as many storage objects as concurrent requests. All of them may
+*         share one engine driven by one thread.
+*
+*         **NOTE**: Functions which issue more than one request, like
+*                   qn_stor_ru_upload_huge(), MUST NOT be called in
+*                   asynchronous mode. Data readers and buffers passed to
+*                   upload functions MUST be valid until the request is done.
+*******************************************************************************/
+QN_SDK void qn_stor_set_engine(qn_storage_ptr restrict stor, qn_http_engine_ptr restrict eng, qn_stor_done_callback_fn done_cb, void * restrict user_data)
+{
+    assert(stor);
+    assert(! eng || done_cb);
+
+    stor->eng = eng;
+    stor->done_cb = done_cb;
+    stor->done_data = user_data;
+}
+
+/***************************************************************************//**
+* @ingroup Storage-Management
+*
+* Attach a storage object to a connection pool for reusing connections.
+*
+* @param [in] stor The pointer to the storage object.
+* @param [in] pool The pointer to the connection pool, or NULL to use private
+*                  connections again.
+*
+* @remark Storage objects attached to the same pool share DNS cache entries
+*         and TLS sessions, so requests to the same host resume the TLS
+*         session instead of a full handshake. A pool made by
+*         qn_http_pool_create() is thread-safe and the storage objects may be
+*         used by different threads.
+*
+*         A pool made by qn_http_pool_create_for_one_thread() shares live
+*         connections as well, so requests skip the TCP handshake too. Its
+*         storage objects MUST be used by one thread only, since libcurl does
+*         not support sharing connections among threads. Worker threads of
+*         concurrent uploads keep their own connections instead of attaching
+*         to such a pool.
+*
+*         **NOTE**: The pool MUST outlive all storage objects attached to it.
+*******************************************************************************/
+QN_SDK void qn_stor_set_pool(qn_storage_ptr restrict stor, qn_http_connection_pool_ptr restrict pool)
+{
+    assert(stor);
+    qn_http_conn_set_pool(stor->conn, pool);
+}
+
 static qn_bool qn_stor_prepare_common_request_headers(qn_storage_ptr restrict stor)
 {
     if (!qn_http_req_set_header(stor->req, "Expect", "")) return qn_false;
@@ -112,6 +252,11 @@ static inline void qn_stor_reset(qn_storage_ptr restrict stor)
     qn_http_req_reset(stor->req);
     qn_http_resp_reset(stor->resp);
 
+    if (stor->fake_obj_body) {
+        qn_json_destroy_object(stor->fake_obj_body);
+        stor->fake_obj_body = NULL;
+        stor->arr_body = NULL; // The array is held by the fake object.
+    } // if
     if (stor->obj_body) {
         qn_json_destroy_object(stor->obj_body);
         stor->obj_body = NULL;
@@ -120,6 +265,100 @@ static inline void qn_stor_reset(qn_storage_ptr restrict stor)
         qn_json_destroy_array(stor->arr_body);
         stor->arr_body = NULL;
     } // if
+
+    qn_fl_unmap(stor->mapped_body.addr, stor->mapped_body.size);
+    memset(&stor->mapped_body, 0, sizeof(stor->mapped_body));
+    if (stor->ra_rdr) qn_io_rardr_reset(stor->ra_rdr, NULL);
+}
+
+// -- Append the encoded form of `<bucket>:<key>`, or `<bucket>` if the key is NULL, staging the plain form in `tmp`.
+static qn_bool qn_stor_append_encoded_uri(qn_str_builder_ptr restrict bld, qn_str_builder_ptr restrict tmp, const char * restrict bucket, const char * restrict key)
+{
+    qn_str_bld_reset(tmp);
+    if (! qn_str_bld_append_cstr(tmp, bucket)) return qn_false;
+    if (key && (! qn_str_bld_append_raw(tmp, ":", 1) || ! qn_str_bld_append_cstr(tmp, key))) return qn_false;
+    return qn_str_bld_append_base64_urlsafe(bld, qn_str_bld_cstr(tmp), qn_str_bld_size(tmp));
+}
+
+static inline qn_bool qn_stor_start_url(qn_storage_ptr restrict stor, const char * restrict base_url, const char * restrict api)
+{
+    qn_str_bld_reset(stor->url_bld);
+    if (! qn_str_bld_append_cstr(stor->url_bld, base_url)) return qn_false;
+    return qn_str_bld_append_cstr(stor->url_bld, api);
+}
+
+static inline qn_bool qn_stor_prepare_error_info(qn_storage_ptr restrict stor)
+{
+    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) return qn_false;
+    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) return qn_false;
+    return qn_true;
+}
+
+static qn_bool qn_stor_set_timing_info(qn_storage_ptr restrict stor)
+{
+    const qn_http_timing * tm = qn_http_resp_get_timing(stor->resp);
+    qn_json_object_ptr tm_obj = qn_json_create_and_set_object(stor->obj_body, "fn-timing");
+
+    if (! tm_obj) return qn_false;
+    if (! qn_json_set_integer(tm_obj, "dns-us", tm->dns_us)) return qn_false;
+    if (! qn_json_set_integer(tm_obj, "connect-us", tm->connect_us)) return qn_false;
+    if (! qn_json_set_integer(tm_obj, "tls-us", tm->tls_us)) return qn_false;
+    if (! qn_json_set_integer(tm_obj, "ttfb-us", tm->ttfb_us)) return qn_false;
+    if (! qn_json_set_integer(tm_obj, "total-us", tm->total_us)) return qn_false;
+    if (! qn_json_set_integer(tm_obj, "bytes-sent", tm->bytes_sent)) return qn_false;
+    return qn_json_set_integer(tm_obj, "bytes-received", tm->bytes_received);
+}
+
+static qn_json_object_ptr qn_stor_rename_error_info(qn_storage_ptr restrict stor)
+{
+    qn_json_set_integer(stor->obj_body, "fn-code", qn_http_resp_get_code(stor->resp));
+    if (! qn_stor_set_timing_info(stor)) return NULL;
+    if (! qn_json_rename(stor->obj_body, "error", "fn-error")) return (qn_err_is_no_such_entry()) ? stor->obj_body : NULL;
+    return stor->obj_body;
+}
+
+static qn_json_object_ptr qn_stor_record_metrics(qn_storage_ptr restrict stor, qn_json_object_ptr restrict ret)
+{
+    const qn_http_timing * tm;
+
+    if (! qn_mtr_is_enabled()) return ret;
+
+    tm = qn_http_resp_get_timing(stor->resp);
+    qn_mtr_record_request(stor->mtr_api, (ret && qn_http_resp_get_code(stor->resp) / 100 == 2), tm->total_us, tm->bytes_sent, tm->bytes_received);
+    if (! ret) qn_mtr_record_error(qn_err_get_code());
+    return ret;
+}
+
+static void qn_stor_done_cfn(void * restrict user_data, qn_http_connection_ptr restrict conn, qn_bool ok)
+{
+    qn_storage_ptr stor = (qn_storage_ptr) user_data;
+    qn_json_object_ptr ret = (ok) ? stor->finish(stor) : NULL;
+    stor->done_cb(stor->done_data, stor, qn_stor_record_metrics(stor, ret));
+}
+
+static qn_json_object_ptr qn_stor_do_request(qn_storage_ptr restrict stor, qn_mtr_api_em api, const char * restrict url, qn_bool post, qn_stor_finish_fn finish)
+{
+    qn_bool ret;
+
+    stor->mtr_api = api;
+    if (stor->eng) {
+        // ---- Submit the request to the engine, and finish it in the done callback.
+        stor->finish = finish;
+        if (post) {
+            ret = qn_http_eng_submit_post(stor->eng, stor->conn, url, stor->req, stor->resp, &qn_stor_done_cfn, stor);
+        } else {
+            ret = qn_http_eng_submit_get(stor->eng, stor->conn, url, stor->req, stor->resp, &qn_stor_done_cfn, stor);
+        } // if
+        if (ret) qn_err_set_in_progress();
+        return NULL;
+    } // if
+
+    if (post) {
+        ret = qn_http_conn_post(stor->conn, url, stor->req, stor->resp);
+    } else {
+        ret = qn_http_conn_get(stor->conn, url, stor->req, stor->resp);
+    } // if
+    return qn_stor_record_metrics(stor, (ret) ? finish(stor) : NULL);
 }
 
 // -------- Management Extra (abbreviation: mne) --------
@@ -164,10 +403,9 @@ QN_SDK void qn_stor_mne_set_region_entry(qn_stor_management_extra_ptr restrict m
 
 // -------- Management Functions (abbreviation: mn) --------
 
-static qn_bool qn_stor_mn_prepare(qn_storage_ptr restrict stor, const qn_string restrict url, const qn_string restrict hostname, const qn_mac_ptr restrict mac)
+static qn_bool qn_stor_mn_prepare(qn_storage_ptr restrict stor, const char * restrict url, const qn_string restrict hostname, const qn_mac_ptr restrict mac)
 {
     qn_bool ret;
-    qn_string auth_header;
     qn_string new_acctoken;
 
     if (!qn_stor_prepare_common_request_headers(stor)) return qn_false;
@@ -176,26 +414,18 @@ static qn_bool qn_stor_mn_prepare(qn_storage_ptr restrict stor, const qn_string
     new_acctoken = qn_mac_make_acctoken(mac, url, qn_http_req_body_data(stor->req), qn_http_req_body_size(stor->req));
     if (!new_acctoken) return qn_false;
 
-    auth_header = qn_cs_sprintf("QBox %s", new_acctoken);
+    qn_str_bld_reset(stor->tmp_bld);
+    ret = qn_str_bld_append_raw(stor->tmp_bld, "QBox ", 5) && qn_str_bld_append_cstr(stor->tmp_bld, new_acctoken);
     qn_str_destroy(new_acctoken);
-    if (!auth_header) return qn_false;
+    if (!ret) return qn_false;
 
-    ret = qn_http_req_set_header(stor->req, "Authorization", auth_header);
-    qn_str_destroy(auth_header);
-    return ret;
+    return qn_http_req_set_header(stor->req, "Authorization", qn_str_bld_cstr(stor->tmp_bld));
 }
 
-static const qn_string qn_stor_mn_make_stat_op(const char * restrict bucket, const char * restrict key)
+static qn_bool qn_stor_mn_append_stat_op(qn_str_builder_ptr restrict bld, qn_str_builder_ptr restrict tmp, const char * restrict bucket, const char * restrict key)
 {
-    qn_string op;
-    qn_string encoded_uri;
-
-    encoded_uri = qn_misc_encode_uri(bucket, key);
-    if (!encoded_uri) return NULL;
-
-    op = qn_cs_sprintf("stat/%s", qn_str_cstr(encoded_uri));
-    qn_str_destroy(encoded_uri);
-    return op;
+    if (! qn_str_bld_append_raw(bld, "stat/", 5)) return qn_false;
+    return qn_stor_append_encoded_uri(bld, tmp, bucket, key);
 }
 
 /***************************************************************************//**
@@ -227,6 +457,7 @@ static const qn_string qn_stor_mn_make_stat_op(const char * restrict bucket, con
 *             {
 *                 "fn-code": <The HTTP code of the response>,
 *                 "fn-error": "<The HTTP message of the response>",
+*                 "fn-timing": {<Phase durations and transferred bytes of the request>},
 *                 "fsize": <File's size in bytes>,
 *                 "hash": "<File's hash digest generated by Qiniu-ETAG algorithm>",
 *                 "mimeType": "<File's MIME type>",
@@ -239,6 +470,11 @@ static const qn_string qn_stor_mn_make_stat_op(const char * restrict bucket, con
 *         if the HTTP response returns successfully, no matter the API's operation
 *         succeeds or not.
 *
+*         The `fn-timing` field holds an object with `dns-us`, `connect-us`,
+*         `tls-us`, `ttfb-us` and `total-us` fields in microseconds, and
+*         `bytes-sent` and `bytes-received` fields including headers, which
+*         are taken from the `qn_http_timing` structure of the response.
+*
 *         Other fields are returned only in the case that the API's operation
 *         succeeds.
 *
@@ -269,9 +505,8 @@ static const qn_string qn_stor_mn_make_stat_op(const char * restrict bucket, con
 *******************************************************************************/
 QN_SDK qn_json_object_ptr qn_stor_mn_api_stat(qn_storage_ptr restrict stor, const qn_mac_ptr restrict mac, const char * restrict bucket, const char * restrict key, qn_stor_management_extra_ptr restrict mne)
 {
-    qn_bool ret;
-    qn_string op;
-    qn_string url;
+    qn_json_object_ptr up_ret;
+    const char * url;
     qn_rgn_entry_ptr rgn_entry;
 
     assert(stor);
@@ -288,68 +523,35 @@ QN_SDK qn_json_object_ptr qn_stor_mn_api_stat(qn_storage_ptr restrict stor, cons
     } // if
 
     // ---- Prepare the stat URL.
-    op = qn_stor_mn_make_stat_op(bucket, key);
-    if (!op) return NULL;
-
-    url = qn_cs_sprintf("%s/%s", qn_str_cstr(rgn_entry->base_url), qn_str_cstr(op));
-    qn_str_destroy(op);
-    if (!url) return NULL;
+    if (! qn_stor_start_url(stor, qn_str_cstr(rgn_entry->base_url), "/")) return NULL;
+    if (! qn_stor_mn_append_stat_op(stor->url_bld, stor->tmp_bld, bucket, key)) return NULL;
+    url = qn_str_bld_cstr(stor->url_bld);
 
     // ---- Prepare the request and response.
     qn_stor_reset(stor);
 
-    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) return NULL;
 
-    if (! (stor->obj_body = qn_json_create_object())) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (stor->obj_body = qn_json_create_object())) return NULL;
 
-    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) return NULL;
 
-    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) return NULL;
 
     qn_http_json_wrt_prepare(stor->resp_json_wrt, &stor->obj_body, NULL);
     qn_http_resp_set_data_writer(stor->resp, stor->resp_json_wrt, &qn_http_json_wrt_write_cfn);
 
     // ---- Do the stat action.
-    ret = qn_http_conn_get(stor->conn, url, stor->req, stor->resp);
-    qn_str_destroy(url);
-
-    if (!ret) return NULL;
-    qn_json_set_integer(stor->obj_body, "fn-code", qn_http_resp_get_code(stor->resp));
-    if (!qn_json_rename(stor->obj_body, "error", "fn-error")) return (qn_err_is_no_such_entry()) ? stor->obj_body : NULL;
-    return stor->obj_body;
+    up_ret = qn_stor_do_request(stor, QN_MTR_API_STAT, url, qn_false, &qn_stor_rename_error_info);
+    return up_ret;
 }
 
-static const qn_string qn_stor_mn_make_copy_op(const char * restrict src_bucket, const char * restrict src_key, const char * restrict dest_bucket, const char * restrict dest_key)
+static qn_bool qn_stor_mn_append_copy_op(qn_str_builder_ptr restrict bld, qn_str_builder_ptr restrict tmp, const char * restrict src_bucket, const char * restrict src_key, const char * restrict dest_bucket, const char * restrict dest_key)
 {
-    qn_string op;
-    qn_string encoded_src_uri;
-    qn_string encoded_dest_uri;
-
-    encoded_src_uri = qn_misc_encode_uri(src_bucket, src_key);
-    if (!encoded_src_uri) return NULL;
-
-    encoded_dest_uri = qn_misc_encode_uri(dest_bucket, dest_key);
-    if (!encoded_dest_uri) {
-        qn_str_destroy(encoded_src_uri);
-        return NULL;
-    } // if
-
-    op = qn_cs_sprintf("copy/%s/%s", qn_str_cstr(encoded_src_uri), qn_str_cstr(encoded_dest_uri));
-    qn_str_destroy(encoded_dest_uri);
-    qn_str_destroy(encoded_src_uri);
-    return op;
+    if (! qn_str_bld_append_raw(bld, "copy/", 5)) return qn_false;
+    if (! qn_stor_append_encoded_uri(bld, tmp, src_bucket, src_key)) return qn_false;
+    if (! qn_str_bld_append_raw(bld, "/", 1)) return qn_false;
+    return qn_stor_append_encoded_uri(bld, tmp, dest_bucket, dest_key);
 }
 
 /***************************************************************************//**
@@ -387,6 +589,7 @@ static const qn_string qn_stor_mn_make_copy_op(const char * restrict src_bucket,
 *             {
 *                 "fn-code": <The HTTP code of the response>,
 *                 "fn-error": "<The HTTP message of the response>",
+*                 "fn-timing": {<Phase durations and transferred bytes of the request>},
 *             }
 *         ```
 *
@@ -419,10 +622,8 @@ static const qn_string qn_stor_mn_make_copy_op(const char * restrict src_bucket,
 *******************************************************************************/
 QN_SDK qn_json_object_ptr qn_stor_mn_api_copy(qn_storage_ptr restrict stor, const qn_mac_ptr restrict mac, const char * restrict src_bucket, const char * restrict src_key, const char * restrict dest_bucket, const char * restrict dest_key, qn_stor_management_extra_ptr restrict mne)
 {
-    qn_bool ret;
-    qn_string op;
-    qn_string url;
-    qn_string url_tmp;
+    qn_json_object_ptr up_ret;
+    const char * url;
     qn_rgn_entry_ptr rgn_entry;
 
     assert(stor);
@@ -441,22 +642,12 @@ QN_SDK qn_json_object_ptr qn_stor_mn_api_copy(qn_storage_ptr restrict stor, cons
     } // if
 
     // ---- Prepare the copy URL.
-    op = qn_stor_mn_make_copy_op(src_bucket, src_key, dest_bucket, dest_key);
-    if (!op) return NULL;
-
-    url = qn_cs_sprintf("%s/%s", qn_str_cstr(rgn_entry->base_url), qn_str_cstr(op));
-    qn_str_destroy(op);
-    if (!url) return NULL;
+    if (! qn_stor_start_url(stor, qn_str_cstr(rgn_entry->base_url), "/")) return NULL;
+    if (! qn_stor_mn_append_copy_op(stor->url_bld, stor->tmp_bld, src_bucket, src_key, dest_bucket, dest_key)) return NULL;
 
     // -- Handle the request to overwrite an existing file.
-    if (mne) {
-        if (mne->force) {
-            url_tmp = qn_cs_sprintf("%s/force/true", url);
-            qn_str_destroy(url);
-            if (!url_tmp) return NULL;
-            url = url_tmp;
-        } // if
-    } // if
+    if (mne && mne->force && ! qn_str_bld_append_cstr(stor->url_bld, "/force/true")) return NULL;
+    url = qn_str_bld_cstr(stor->url_bld);
 
     // ---- Prepare the request and response.
     qn_stor_reset(stor);
@@ -464,58 +655,28 @@ QN_SDK qn_json_object_ptr qn_stor_mn_api_copy(qn_storage_ptr restrict stor, cons
     // -- Nothing to post.
     qn_http_req_set_body_data(stor->req, "", 0);
 
-    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) return NULL;
 
-    if (! (stor->obj_body = qn_json_create_object())) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (stor->obj_body = qn_json_create_object())) return NULL;
 
-    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) return NULL;
 
-    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) return NULL;
 
     qn_http_json_wrt_prepare(stor->resp_json_wrt, &stor->obj_body, NULL);
     qn_http_resp_set_data_writer(stor->resp, stor->resp_json_wrt, &qn_http_json_wrt_write_cfn);
 
     // ---- Do the copy action.
-    ret = qn_http_conn_post(stor->conn, url, stor->req, stor->resp);
-    qn_str_destroy(url);
-
-    if (!ret) return NULL;
-    qn_json_set_integer(stor->obj_body, "fn-code", qn_http_resp_get_code(stor->resp));
-    if (!qn_json_rename(stor->obj_body, "error", "fn-error")) return (qn_err_is_no_such_entry()) ? stor->obj_body : NULL;
-    return stor->obj_body;
+    up_ret = qn_stor_do_request(stor, QN_MTR_API_COPY, url, qn_true, &qn_stor_rename_error_info);
+    return up_ret;
 }
 
-static const qn_string qn_stor_mn_make_move_op(const char * restrict src_bucket, const char * restrict src_key, const char * restrict dest_bucket, const char * restrict dest_key)
+static qn_bool qn_stor_mn_append_move_op(qn_str_builder_ptr restrict bld, qn_str_builder_ptr restrict tmp, const char * restrict src_bucket, const char * restrict src_key, const char * restrict dest_bucket, const char * restrict dest_key)
 {
-    qn_string op;
-    qn_string encoded_src_uri;
-    qn_string encoded_dest_uri;
-
-    encoded_src_uri = qn_misc_encode_uri(src_bucket, src_key);
-    if (!encoded_src_uri) return NULL;
-
-    encoded_dest_uri = qn_misc_encode_uri(dest_bucket, dest_key);
-    if (!encoded_dest_uri) {
-        qn_str_destroy(encoded_src_uri);
-        return NULL;
-    } // if
-
-    op = qn_cs_sprintf("move/%s/%s", qn_str_cstr(encoded_src_uri), qn_str_cstr(encoded_dest_uri));
-    qn_str_destroy(encoded_dest_uri);
-    qn_str_destroy(encoded_src_uri);
-    return op;
+    if (! qn_str_bld_append_raw(bld, "move/", 5)) return qn_false;
+    if (! qn_stor_append_encoded_uri(bld, tmp, src_bucket, src_key)) return qn_false;
+    if (! qn_str_bld_append_raw(bld, "/", 1)) return qn_false;
+    return qn_stor_append_encoded_uri(bld, tmp, dest_bucket, dest_key);
 }
 
 /***************************************************************************//**
@@ -555,6 +716,7 @@ static const qn_string qn_stor_mn_make_move_op(const char * restrict src_bucket,
 *             {
 *                 "fn-code": <The HTTP code of the response>,
 *                 "fn-error": "<The HTTP message of the response>",
+*                 "fn-timing": {<Phase durations and transferred bytes of the request>},
 *             }
 *         ```
 *
@@ -585,9 +747,8 @@ static const qn_string qn_stor_mn_make_move_op(const char * restrict src_bucket,
 *******************************************************************************/
 QN_SDK qn_json_object_ptr qn_stor_mn_api_move(qn_storage_ptr restrict stor, const qn_mac_ptr restrict mac, const char * restrict src_bucket, const char * restrict src_key, const char * restrict dest_bucket, const char * restrict dest_key, qn_stor_management_extra_ptr restrict mne)
 {
-    qn_bool ret;
-    qn_string op;
-    qn_string url;
+    qn_json_object_ptr up_ret;
+    const char * url;
     qn_rgn_entry_ptr rgn_entry;
 
     assert(stor);
@@ -606,12 +767,9 @@ QN_SDK qn_json_object_ptr qn_stor_mn_api_move(qn_storage_ptr restrict stor, cons
     } // if
 
     // ---- Prepare the move URL.
-    op = qn_stor_mn_make_move_op(src_bucket, src_key, dest_bucket, dest_key);
-    if (!op) return NULL;
-
-    url = qn_cs_sprintf("%s/%s", qn_str_cstr(rgn_entry->base_url), qn_str_cstr(op));
-    qn_str_destroy(op);
-    if (!url) return NULL;
+    if (! qn_stor_start_url(stor, qn_str_cstr(rgn_entry->base_url), "/")) return NULL;
+    if (! qn_stor_mn_append_move_op(stor->url_bld, stor->tmp_bld, src_bucket, src_key, dest_bucket, dest_key)) return NULL;
+    url = qn_str_bld_cstr(stor->url_bld);
 
     // ---- Prepare the request and response.
     qn_stor_reset(stor);
@@ -619,50 +777,26 @@ QN_SDK qn_json_object_ptr qn_stor_mn_api_move(qn_storage_ptr restrict stor, cons
     // -- Nothing to post.
     qn_http_req_set_body_data(stor->req, "", 0);
 
-    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) return NULL;
 
-    if (! (stor->obj_body = qn_json_create_object())) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (stor->obj_body = qn_json_create_object())) return NULL;
 
-    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) return NULL;
 
-    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) return NULL;
 
     qn_http_json_wrt_prepare(stor->resp_json_wrt, &stor->obj_body, NULL);
     qn_http_resp_set_data_writer(stor->resp, stor->resp_json_wrt, &qn_http_json_wrt_write_cfn);
 
     // ---- Do the move action.
-    ret = qn_http_conn_post(stor->conn, url, stor->req, stor->resp);
-    qn_str_destroy(url);
-
-    if (!ret) return NULL;
-    qn_json_set_integer(stor->obj_body, "fn-code", qn_http_resp_get_code(stor->resp));
-    if (!qn_json_rename(stor->obj_body, "error", "fn-error")) return (qn_err_is_no_such_entry()) ? stor->obj_body : NULL;
-    return stor->obj_body;
+    up_ret = qn_stor_do_request(stor, QN_MTR_API_MOVE, url, qn_true, &qn_stor_rename_error_info);
+    return up_ret;
 }
 
-static qn_string qn_stor_mn_make_delete_op(const char * restrict bucket, const char * restrict key)
+static qn_bool qn_stor_mn_append_delete_op(qn_str_builder_ptr restrict bld, qn_str_builder_ptr restrict tmp, const char * restrict bucket, const char * restrict key)
 {
-    qn_string op;
-    qn_string encoded_uri;
-
-    encoded_uri = qn_misc_encode_uri(bucket, key);
-    if (!encoded_uri) return NULL;
-
-    op = qn_cs_sprintf("delete/%s", qn_str_cstr(encoded_uri));
-    qn_str_destroy(encoded_uri);
-    return op;
+    if (! qn_str_bld_append_raw(bld, "delete/", 7)) return qn_false;
+    return qn_stor_append_encoded_uri(bld, tmp, bucket, key);
 }
 
 /***************************************************************************//**
@@ -696,6 +830,7 @@ static qn_string qn_stor_mn_make_delete_op(const char * restrict bucket, const c
 *             {
 *                 "fn-code": <The HTTP code of the response>,
 *                 "fn-error": "<The HTTP message of the response>",
+*                 "fn-timing": {<Phase durations and transferred bytes of the request>},
 *             }
 *         ```
 *
@@ -726,9 +861,8 @@ static qn_string qn_stor_mn_make_delete_op(const char * restrict bucket, const c
 *******************************************************************************/
 QN_SDK qn_json_object_ptr qn_stor_mn_api_delete(qn_storage_ptr restrict stor, const qn_mac_ptr restrict mac, const char * restrict bucket, const char * restrict key, qn_stor_management_extra_ptr restrict mne)
 {
-    qn_bool ret;
-    qn_string op;
-    qn_string url;
+    qn_json_object_ptr up_ret;
+    const char * url;
     qn_rgn_entry_ptr rgn_entry;
 
     assert(stor);
@@ -745,12 +879,9 @@ QN_SDK qn_json_object_ptr qn_stor_mn_api_delete(qn_storage_ptr restrict stor, co
     } // if
 
     // ---- Prepare the delete URL.
-    op = qn_stor_mn_make_delete_op(bucket, key);
-    if (!op) return NULL;
-
-    url = qn_cs_sprintf("%s/%s", qn_str_cstr(rgn_entry->base_url), qn_str_cstr(op));
-    qn_str_destroy(op);
-    if (!url) return NULL;
+    if (! qn_stor_start_url(stor, qn_str_cstr(rgn_entry->base_url), "/")) return NULL;
+    if (! qn_stor_mn_append_delete_op(stor->url_bld, stor->tmp_bld, bucket, key)) return NULL;
+    url = qn_str_bld_cstr(stor->url_bld);
 
     // ---- Prepare the request and response.
     qn_stor_reset(stor);
@@ -758,37 +889,20 @@ QN_SDK qn_json_object_ptr qn_stor_mn_api_delete(qn_storage_ptr restrict stor, co
     // -- Nothing to post.
     qn_http_req_set_body_data(stor->req, "", 0);
 
-    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) return NULL;
 
-    if (! (stor->obj_body = qn_json_create_object())) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (stor->obj_body = qn_json_create_object())) return NULL;
 
-    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) return NULL;
 
-    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) return NULL;
 
     qn_http_json_wrt_prepare(stor->resp_json_wrt, &stor->obj_body, NULL);
     qn_http_resp_set_data_writer(stor->resp, stor->resp_json_wrt, &qn_http_json_wrt_write_cfn);
 
     // ---- Do the delete action.
-    ret = qn_http_conn_post(stor->conn, url, stor->req, stor->resp);
-    qn_str_destroy(url);
-
-    if (!ret) return NULL;
-    qn_json_set_integer(stor->obj_body, "fn-code", qn_http_resp_get_code(stor->resp));
-    if (!qn_json_rename(stor->obj_body, "error", "fn-error")) return (qn_err_is_no_such_entry()) ? stor->obj_body : NULL;
-    return stor->obj_body;
+    up_ret = qn_stor_do_request(stor, QN_MTR_API_DELETE, url, qn_true, &qn_stor_rename_error_info);
+    return up_ret;
 }
 
 /***************************************************************************//**
@@ -823,6 +937,7 @@ QN_SDK qn_json_object_ptr qn_stor_mn_api_delete(qn_storage_ptr restrict stor, co
 *             {
 *                 "fn-code": <The HTTP code of the response>,
 *                 "fn-error": "<The HTTP message of the response>",
+*                 "fn-timing": {<Phase durations and transferred bytes of the request>},
 *             }
 *         ```
 *
@@ -853,10 +968,8 @@ QN_SDK qn_json_object_ptr qn_stor_mn_api_delete(qn_storage_ptr restrict stor, co
 *******************************************************************************/
 QN_SDK qn_json_object_ptr qn_stor_mn_api_chgm(qn_storage_ptr restrict stor, const qn_mac_ptr restrict mac, const char * restrict bucket, const char * restrict key, const char * restrict mime, qn_stor_management_extra_ptr restrict mne)
 {
-    qn_bool ret;
-    qn_string encoded_uri;
-    qn_string encoded_mime;
-    qn_string url;
+    qn_json_object_ptr up_ret;
+    const char * url;
     qn_rgn_entry_ptr rgn_entry;
 
     assert(stor);
@@ -874,65 +987,40 @@ QN_SDK qn_json_object_ptr qn_stor_mn_api_chgm(qn_storage_ptr restrict stor, cons
     } // if
 
     // ---- Prepare the change mime URL.
-    encoded_uri = qn_misc_encode_uri(bucket, key);
-    if (!encoded_uri) return NULL;
-
-    encoded_mime = qn_cs_encode_base64_urlsafe(mime, strlen(mime));
-    if (!encoded_mime) {
-        qn_str_destroy(encoded_uri);
-        return NULL;
-    } // if
-
-    url = qn_cs_sprintf("%s/chgm/%s/mime/%s", qn_str_cstr(rgn_entry->base_url), qn_str_cstr(encoded_uri), qn_str_cstr(encoded_mime));
-    qn_str_destroy(encoded_uri);
-    qn_str_destroy(encoded_mime);
-    if (!url) return NULL;
+    if (! qn_stor_start_url(stor, qn_str_cstr(rgn_entry->base_url), "/chgm/")) return NULL;
+    if (! qn_stor_append_encoded_uri(stor->url_bld, stor->tmp_bld, bucket, key)) return NULL;
+    if (! qn_str_bld_append_cstr(stor->url_bld, "/mime/")) return NULL;
+    if (! qn_str_bld_append_base64_urlsafe(stor->url_bld, mime, strlen(mime))) return NULL;
+    url = qn_str_bld_cstr(stor->url_bld);
 
     // ---- Prepare the request and response
     qn_stor_reset(stor);
 
     qn_http_req_set_body_data(stor->req, "", 0);
 
-    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) return NULL;
 
-    if (! (stor->obj_body = qn_json_create_object())) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (stor->obj_body = qn_json_create_object())) return NULL;
 
-    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) return NULL;
 
-    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) return NULL;
 
     qn_http_json_wrt_prepare(stor->resp_json_wrt, &stor->obj_body, NULL);
     qn_http_resp_set_data_writer(stor->resp, stor->resp_json_wrt, &qn_http_json_wrt_write_cfn);
 
     // ---- Do the change mime action.
-    ret = qn_http_conn_post(stor->conn, url, stor->req, stor->resp);
-    qn_str_destroy(url);
-
-    if (!ret) return NULL;
-    qn_json_set_integer(stor->obj_body, "fn-code", qn_http_resp_get_code(stor->resp));
-    if (!qn_json_rename(stor->obj_body, "error", "fn-error")) return (qn_err_is_no_such_entry()) ? stor->obj_body : NULL;
-    return stor->obj_body;
+    up_ret = qn_stor_do_request(stor, QN_MTR_API_CHGM, url, qn_true, &qn_stor_rename_error_info);
+    return up_ret;
 }
 
 // -------- Batch Operations (abbreviation: bt) --------
 
 typedef struct _QN_STOR_BATCH
 {
-    qn_string * ops;
-    int cnt;
-    int cap;
+    qn_str_builder_ptr body;
+    qn_str_builder_ptr op;
+    qn_str_builder_ptr tmp;
 } qn_stor_batch;
 
 QN_SDK qn_stor_batch_ptr qn_stor_bt_create(void)
@@ -943,11 +1031,11 @@ QN_SDK qn_stor_batch_ptr qn_stor_bt_create(void)
         return NULL;
     } // if
 
-    new_bt->cap = 4;
-    new_bt->ops = calloc(new_bt->cap, sizeof(qn_string));
-    if (!new_bt->ops) {
-        free(new_bt);
-        qn_err_set_out_of_memory();
+    new_bt->body = qn_str_bld_create(0);
+    new_bt->op = qn_str_bld_create(0);
+    new_bt->tmp = qn_str_bld_create(0);
+    if (!new_bt->body || !new_bt->op || !new_bt->tmp) {
+        qn_stor_bt_destroy(new_bt);
         return NULL;
     } // if
     return new_bt;
@@ -956,192 +1044,118 @@ QN_SDK qn_stor_batch_ptr qn_stor_bt_create(void)
 QN_SDK void qn_stor_bt_destroy(qn_stor_batch_ptr restrict bt)
 {
     if (bt) {
-        qn_stor_bt_reset(bt);
-        free(bt->ops);
+        qn_str_bld_destroy(bt->tmp);
+        qn_str_bld_destroy(bt->op);
+        qn_str_bld_destroy(bt->body);
         free(bt);
     } // if
 }
 
 QN_SDK void qn_stor_bt_reset(qn_stor_batch_ptr restrict bt)
 {
-    while (bt->cnt > 0) qn_str_destroy(bt->ops[--bt->cnt]);
-}
-
-static qn_bool qn_stor_bt_augment(qn_stor_batch_ptr restrict bt)
-{
-    int new_cap = bt->cnt + (bt->cnt >> 1); // 1.5 times
-    qn_string * new_ops = calloc(new_cap, sizeof(qn_string));
-    if (!new_ops) {
-        qn_err_set_out_of_memory();
-        return NULL;
-    } // if
-
-    memcpy(new_ops, bt->ops, bt->cnt * sizeof(qn_string));
-    free(bt->ops);
-    bt->ops = new_ops;
-    bt->cap = new_cap;
-    return qn_true;
+    qn_str_bld_reset(bt->body);
 }
 
-static qn_bool qn_stor_bt_add_op(qn_stor_batch_ptr restrict bt, const qn_string restrict op)
+// -- Append the operation built in `bt->op` to the body as an `op=<encoded op>` pair.
+static qn_bool qn_stor_bt_add_op(qn_stor_batch_ptr restrict bt)
 {
-    qn_string encoded_op;
-    qn_string entry;
-
-    if (bt->cnt == bt->cap && !qn_stor_bt_augment(bt)) return qn_false;
-
-    encoded_op = qn_cs_percent_encode(qn_str_cstr(op), qn_str_size(op));
-    if (!encoded_op) return qn_false;
-
-    entry = qn_cs_sprintf("op=%s", qn_str_cstr(encoded_op));
-    qn_str_destroy(encoded_op);
-    if (!entry) return qn_false;
-
-    bt->ops[bt->cnt++] = entry;
-    return qn_true;
+    if (qn_str_bld_size(bt->body) > 0 && ! qn_str_bld_append_raw(bt->body, "&", 1)) return qn_false;
+    if (! qn_str_bld_append_raw(bt->body, "op=", 3)) return qn_false;
+    return qn_str_bld_append_percent_encoded(bt->body, qn_str_bld_cstr(bt->op), qn_str_bld_size(bt->op), NULL);
 }
 
 QN_SDK qn_bool qn_stor_bt_add_stat_op(qn_stor_batch_ptr restrict bt, const char * restrict bucket, const char * restrict key)
 {
-    qn_bool ret;
-    qn_string op;
-
-    op = qn_stor_mn_make_stat_op(bucket, key);
-    if (!op) return qn_false;
-
-    ret = qn_stor_bt_add_op(bt, op);
-    qn_str_destroy(op);
-    return ret;
+    qn_str_bld_reset(bt->op);
+    if (! qn_stor_mn_append_stat_op(bt->op, bt->tmp, bucket, key)) return qn_false;
+    return qn_stor_bt_add_op(bt);
 }
 
 QN_SDK qn_bool qn_stor_bt_add_copy_op(qn_stor_batch_ptr restrict bt, const char * restrict src_bucket, const char * restrict src_key, const char * restrict dest_bucket, const char * restrict dest_key)
 {
-    qn_bool ret;
-    qn_string op;
-
-    op = qn_stor_mn_make_copy_op(src_bucket, src_key, dest_bucket, dest_key);
-    if (!op) return qn_false;
-
-    ret = qn_stor_bt_add_op(bt, op);
-    qn_str_destroy(op);
-    return ret;
+    qn_str_bld_reset(bt->op);
+    if (! qn_stor_mn_append_copy_op(bt->op, bt->tmp, src_bucket, src_key, dest_bucket, dest_key)) return qn_false;
+    return qn_stor_bt_add_op(bt);
 }
 
 QN_SDK qn_bool qn_stor_bt_add_move_op(qn_stor_batch_ptr restrict bt, const char * restrict src_bucket, const char * restrict src_key, const char * restrict dest_bucket, const char * restrict dest_key)
 {
-    qn_bool ret;
-    qn_string op;
-
-    op = qn_stor_mn_make_move_op(src_bucket, src_key, dest_bucket, dest_key);
-    if (!op) return qn_false;
-
-    ret = qn_stor_bt_add_op(bt, op);
-    qn_str_destroy(op);
-    return ret;
+    qn_str_bld_reset(bt->op);
+    if (! qn_stor_mn_append_move_op(bt->op, bt->tmp, src_bucket, src_key, dest_bucket, dest_key)) return qn_false;
+    return qn_stor_bt_add_op(bt);
 }
 
 QN_SDK qn_bool qn_stor_bt_add_delete_op(qn_stor_batch_ptr restrict bt, const char * restrict bucket, const char * restrict key)
 {
-    qn_bool ret;
-    qn_string op;
-
-    op = qn_stor_mn_make_delete_op(bucket, key);
-    if (!op) return qn_false;
-
-    ret = qn_stor_bt_add_op(bt, op);
-    qn_str_destroy(op);
-    return ret;
+    qn_str_bld_reset(bt->op);
+    if (! qn_stor_mn_append_delete_op(bt->op, bt->tmp, bucket, key)) return qn_false;
+    return qn_stor_bt_add_op(bt);
 }
 
 // -------- Batch Functions (abbreviation: bt) --------
 
-QN_SDK qn_json_object_ptr qn_stor_bt_api_batch(qn_storage_ptr restrict stor, const qn_mac_ptr restrict mac, const qn_stor_batch_ptr restrict bt, qn_stor_management_extra_ptr restrict mne)
+static qn_json_object_ptr qn_stor_bt_finish(qn_storage_ptr restrict stor)
 {
-    qn_bool ret;
-    qn_string body;
-    qn_string url;
-    qn_json_object_ptr fake_obj_body;
-    qn_rgn_entry_ptr rgn_entry;
-
-    assert(stor);
-    assert(mac);
-    assert(bt);
+    stor->arr_body = NULL; // Keep from destroying the array twice.
 
-    // ---- Process all extra options.
-    if (mne) {
-        if (! (rgn_entry = mne->rgn_entry)) qn_rgn_tbl_choose_first_entry(NULL, QN_RGN_SVC_RS, NULL, &rgn_entry);
+    if (stor->obj_body) {
+        // Get an object rather than an array.
+        // TODO: Trace the change of return value to this API and make the corresponding fix.
+        qn_json_destroy_object(stor->fake_obj_body);
+    } else {
+        stor->obj_body = stor->fake_obj_body;
+    } // if
+    stor->fake_obj_body = NULL;
+    return qn_stor_rename_error_info(stor);
+}
+
+QN_SDK qn_json_object_ptr qn_stor_bt_api_batch(qn_storage_ptr restrict stor, const qn_mac_ptr restrict mac, const qn_stor_batch_ptr restrict bt, qn_stor_management_extra_ptr restrict mne)
+{
+    qn_json_object_ptr up_ret;
+    const char * url;
+    qn_json_object_ptr fake_obj_body;
+    qn_rgn_entry_ptr rgn_entry;
+
+    assert(stor);
+    assert(mac);
+    assert(bt);
+
+    // ---- Process all extra options.
+    if (mne) {
+        if (! (rgn_entry = mne->rgn_entry)) qn_rgn_tbl_choose_first_entry(NULL, QN_RGN_SVC_RS, NULL, &rgn_entry);
     } else {
         rgn_entry = NULL;
         qn_rgn_tbl_choose_first_entry(NULL, QN_RGN_SVC_RS, NULL, &rgn_entry);
     } // if
 
     // ---- Prepare the batch URL.
-    body = qn_str_join_list("&", bt->ops, bt->cnt);
-    if (!body) return NULL;
-
-    url = qn_cs_sprintf("%s/batch", qn_str_cstr(rgn_entry->base_url));
-    if (!url) {
-        qn_str_destroy(body);
-        return NULL;
-    } // if
+    if (! qn_stor_start_url(stor, qn_str_cstr(rgn_entry->base_url), "/batch")) return NULL;
+    url = qn_str_bld_cstr(stor->url_bld);
 
     // ---- Prepare the request and response.
     qn_stor_reset(stor);
 
-    qn_http_req_set_body_data(stor->req, qn_str_cstr(body), qn_str_size(body));
+    // -- The body is held by the batch object, which MUST be valid until the request is done.
+    qn_http_req_set_body_data(stor->req, qn_str_bld_cstr(bt->body), qn_str_bld_size(bt->body));
 
-    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) {
-        qn_str_destroy(url);
-        qn_str_destroy(body);
-        return NULL;
-    } // if
+    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) return NULL;
 
     // Use a fake object to match the return type of all storage main functions.
-    if (! (fake_obj_body = qn_json_create_object())) {
-        qn_str_destroy(url);
-        qn_str_destroy(body);
-        return NULL;
-    } // if
+    if (! (fake_obj_body = qn_json_create_object())) return NULL;
 
-    if (! (qn_json_set_integer(fake_obj_body, "fn-code", 0))) {
-        qn_str_destroy(url);
-        qn_str_destroy(body);
-        return NULL;
-    } // if
+    if (! (qn_json_set_integer(fake_obj_body, "fn-code", 0))) return NULL;
 
-    if (! (qn_json_set_cstr(fake_obj_body, "fn-error", "OK"))) {
-        qn_str_destroy(url);
-        qn_str_destroy(body);
-        return NULL;
-    } // if
+    if (! (qn_json_set_cstr(fake_obj_body, "fn-error", "OK"))) return NULL;
 
-    if (! (stor->arr_body = qn_json_create_and_set_array(fake_obj_body, "items"))) {
-        qn_str_destroy(url);
-        qn_str_destroy(body);
-        return NULL;
-    } // if
+    if (! (stor->arr_body = qn_json_create_and_set_array(fake_obj_body, "items"))) return NULL;
 
     qn_http_json_wrt_prepare(stor->resp_json_wrt, &stor->obj_body, &stor->arr_body);
     qn_http_resp_set_data_writer(stor->resp, stor->resp_json_wrt, &qn_http_json_wrt_write_cfn);
 
     // ---- Do the batch action.
-    ret = qn_http_conn_post(stor->conn, url, stor->req, stor->resp);
-    qn_str_destroy(url);
-    qn_str_destroy(body);
-    stor->arr_body = NULL; // Keep from destroying the array twice.
-
-    if (!ret) return NULL;
-    if (stor->obj_body) {
-        // Get an object rather than an array.
-        // TODO: Trace the change of return value to this API and make the corresponding fix.
-        qn_json_destroy_object(fake_obj_body);
-    } else {
-        stor->obj_body = fake_obj_body;
-    } // if
-
-    qn_json_set_integer(stor->obj_body, "fn-code", qn_http_resp_get_code(stor->resp));
-    if (!qn_json_rename(stor->obj_body, "error", "fn-error")) return (qn_err_is_no_such_entry()) ? stor->obj_body : NULL;
-    return stor->obj_body;
+    stor->fake_obj_body = fake_obj_body;
+    up_ret = qn_stor_do_request(stor, QN_MTR_API_BATCH, url, qn_true, &qn_stor_bt_finish);
+    return up_ret;
 }
 
 // -------- List Extra (abbreviation: lse) --------
@@ -1153,6 +1167,9 @@ typedef struct _QN_STOR_LIST_EXTRA
     const char * marker;
     qn_uint32 limit;
 
+    void * itm_data;
+    qn_stor_lse_item_callback_fn itm_cb;
+
     qn_http_query_ptr qry;
     qn_rgn_entry_ptr rgn_entry;
 } qn_stor_list_extra_st;
@@ -1189,6 +1206,8 @@ QN_SDK void qn_stor_lse_reset(qn_stor_list_extra_ptr restrict lse)
     lse->delimiter = NULL;
     lse->marker = NULL;
     lse->limit = 1000;
+    lse->itm_data = NULL;
+    lse->itm_cb = NULL;
     lse->rgn_entry = NULL;
 }
 
@@ -1208,6 +1227,12 @@ QN_SDK void qn_stor_lse_set_limit(qn_stor_list_extra_ptr restrict lse, qn_uint32
     lse->limit = limit;
 }
 
+QN_SDK void qn_stor_lse_set_item_callback(qn_stor_list_extra_ptr restrict lse, void * restrict itm_data, qn_stor_lse_item_callback_fn itm_cb)
+{
+    lse->itm_data = itm_data;
+    lse->itm_cb = itm_cb;
+}
+
 // -------- List Functions (abbreviation: ls) --------
 
 /***************************************************************************//**
@@ -1238,6 +1263,7 @@ QN_SDK void qn_stor_lse_set_limit(qn_stor_list_extra_ptr restrict lse, qn_uint32
 *             {
 *                 "fn-code": <The HTTP code of the response>,
 *                 "fn-error": "<The HTTP message of the response>",
+*                 "fn-timing": {<Phase durations and transferred bytes of the request>},
 *
 *                 "marker": "<Marker used internally to sustain a query session>",
 *
@@ -1279,6 +1305,11 @@ QN_SDK void qn_stor_lse_set_limit(qn_stor_list_extra_ptr restrict lse, qn_uint32
 *         returned always, even though there are no files at all (and it is an
 *         empty array in this case).
 *
+*         If an item callback is set by qn_stor_lse_set_item_callback(), each
+*         record is passed to it as soon as it is parsed out of the response,
+*         and destroyed right after the callback returns. The `items` field is
+*         an empty array in this case.
+*
 *         All HTTP codes and corresponding messages list as follow.
 *
 *         +-------+-------------------------------------------------------+
@@ -1305,7 +1336,8 @@ QN_SDK void qn_stor_lse_set_limit(qn_stor_list_extra_ptr restrict lse, qn_uint32
 QN_SDK qn_json_object_ptr qn_stor_ls_api_list(qn_storage_ptr restrict stor, const qn_mac_ptr restrict mac, const char * restrict bucket, qn_stor_list_extra_ptr restrict lse)
 {
     qn_bool ret;
-    qn_string url;
+    qn_json_object_ptr up_ret;
+    const char * url;
     qn_string qry_str;
     qn_http_query_ptr qry;
     qn_rgn_entry_ptr rgn_entry;
@@ -1348,47 +1380,36 @@ QN_SDK qn_json_object_ptr qn_stor_ls_api_list(qn_storage_ptr restrict stor, cons
     if (! lse) qn_http_qry_destroy(qry);
     if (! qry_str) return NULL;
 
-    // ---- Prepare the copy URL.
-    url = qn_cs_sprintf("%s/list?%s", qn_str_cstr(rgn_entry->base_url), qn_str_cstr(qry_str));
+    // ---- Prepare the list URL.
+    ret = qn_stor_start_url(stor, qn_str_cstr(rgn_entry->base_url), "/list?") && qn_str_bld_append_raw(stor->url_bld, qn_str_cstr(qry_str), qn_str_size(qry_str));
     qn_str_destroy(qry_str);
-    if (! url) return NULL;
+    if (! ret) return NULL;
+    url = qn_str_bld_cstr(stor->url_bld);
 
     // ---- Prepare the request and response.
     qn_stor_reset(stor);
 
     qn_http_req_set_body_data(stor->req, "", 0);
 
-    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) return NULL;
 
-    if (! (stor->obj_body = qn_json_create_object())) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    // -- A list may hold thousands of items, so build the tree in an arena to save lots of allocations.
+    if (! (stor->obj_body = qn_json_create_object_in_arena())) return NULL;
 
-    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) return NULL;
 
-    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) return NULL;
 
-    qn_http_json_wrt_prepare(stor->resp_json_wrt, &stor->obj_body, NULL);
+    if (lse && lse->itm_cb) {
+        qn_http_json_wrt_prepare_for_items(stor->resp_json_wrt, &stor->obj_body, "items", lse->itm_data, lse->itm_cb);
+    } else {
+        qn_http_json_wrt_prepare(stor->resp_json_wrt, &stor->obj_body, NULL);
+    } // if
     qn_http_resp_set_data_writer(stor->resp, stor->resp_json_wrt, &qn_http_json_wrt_write_cfn);
 
     // ---- Do the list action.
-    ret = qn_http_conn_post(stor->conn, url, stor->req, stor->resp);
-    qn_str_destroy(url);
-    if (! ret) return NULL;
-
-    qn_json_set_integer(stor->obj_body, "fn-code", qn_http_resp_get_code(stor->resp));
-    if (! qn_json_rename(stor->obj_body, "error", "fn-error") && ! qn_err_is_no_such_entry()) return NULL;
-    return stor->obj_body;
+    up_ret = qn_stor_do_request(stor, QN_MTR_API_LIST, url, qn_true, &qn_stor_rename_error_info);
+    return up_ret;
 }
 
 // -------- Fetch Extra (abbreviation: fte) --------
@@ -1462,6 +1483,7 @@ QN_SDK void qn_stor_fte_set_region_entry(qn_stor_fetch_extra_ptr restrict fte, q
 *             {
 *                 "fn-code": <The HTTP code of the response>,
 *                 "fn-error": "<The HTTP message of the response>",
+*                 "fn-timing": {<Phase durations and transferred bytes of the request>},
 *                 "fsize": <File's size in bytes>,
 *                 "hash": "<File's hash digest generated by Qiniu-ETAG algorithm>",
 *                 "mimeType": "<File's MIME type>",
@@ -1508,10 +1530,8 @@ QN_SDK void qn_stor_fte_set_region_entry(qn_stor_fetch_extra_ptr restrict fte, q
 *******************************************************************************/
 QN_SDK qn_json_object_ptr qn_stor_ft_api_fetch(qn_storage_ptr restrict stor, const qn_mac_ptr restrict mac, const char * restrict src_url, const char * restrict dest_bucket, const char * restrict dest_key, qn_stor_fetch_extra_ptr restrict fte)
 {
-    qn_bool ret;
-    qn_string encoded_src_url;
-    qn_string encoded_dest_uri;
-    qn_string url;
+    qn_json_object_ptr up_ret;
+    const char * url;
     qn_rgn_entry_ptr rgn_entry;
 
     assert(stor);
@@ -1529,19 +1549,11 @@ QN_SDK qn_json_object_ptr qn_stor_ft_api_fetch(qn_storage_ptr restrict stor, con
     } // if
 
     // ---- Prepare the fetch URL.
-    encoded_src_url = qn_cs_encode_base64_urlsafe(src_url, strlen(src_url));
-    if (!encoded_src_url) return NULL;
-
-    encoded_dest_uri = qn_misc_encode_uri(dest_bucket, dest_key);
-    if (!encoded_dest_uri) {
-        qn_str_destroy(encoded_src_url);
-        return NULL;
-    } // if
-
-    url = qn_cs_sprintf("%s/fetch/%s/to/%s", qn_str_cstr(rgn_entry->base_url), qn_str_cstr(encoded_src_url), qn_str_cstr(encoded_dest_uri));
-    qn_str_destroy(encoded_src_url);
-    qn_str_destroy(encoded_dest_uri);
-    if (!url) return NULL;
+    if (! qn_stor_start_url(stor, qn_str_cstr(rgn_entry->base_url), "/fetch/")) return NULL;
+    if (! qn_str_bld_append_base64_urlsafe(stor->url_bld, src_url, strlen(src_url))) return NULL;
+    if (! qn_str_bld_append_cstr(stor->url_bld, "/to/")) return NULL;
+    if (! qn_stor_append_encoded_uri(stor->url_bld, stor->tmp_bld, dest_bucket, dest_key)) return NULL;
+    url = qn_str_bld_cstr(stor->url_bld);
 
     // ---- Prepare the request and response.
     qn_stor_reset(stor);
@@ -1549,37 +1561,20 @@ QN_SDK qn_json_object_ptr qn_stor_ft_api_fetch(qn_storage_ptr restrict stor, con
     // -- Nothing to post.
     qn_http_req_set_body_data(stor->req, "", 0);
 
-    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) return NULL;
 
-    if (! (stor->obj_body = qn_json_create_object())) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (stor->obj_body = qn_json_create_object())) return NULL;
 
-    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) return NULL;
 
-    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) return NULL;
 
     qn_http_json_wrt_prepare(stor->resp_json_wrt, &stor->obj_body, NULL);
     qn_http_resp_set_data_writer(stor->resp, stor->resp_json_wrt, &qn_http_json_wrt_write_cfn);
 
     // ---- Do the fetch action.
-    ret = qn_http_conn_post(stor->conn, url, stor->req, stor->resp);
-    qn_str_destroy(url);
-
-    if (!ret) return NULL;
-    qn_json_set_integer(stor->obj_body, "fn-code", qn_http_resp_get_code(stor->resp));
-    if (!qn_json_rename(stor->obj_body, "error", "fn-error")) return (qn_err_is_no_such_entry()) ? stor->obj_body : NULL;
-    return stor->obj_body;
+    up_ret = qn_stor_do_request(stor, QN_MTR_API_FETCH, url, qn_true, &qn_stor_rename_error_info);
+    return up_ret;
 }
 
 /***************************************************************************//**
@@ -1623,6 +1618,7 @@ QN_SDK qn_json_object_ptr qn_stor_ft_api_fetch(qn_storage_ptr restrict stor, con
 *             {
 *                 "fn-code": <The HTTP code of the response>,
 *                 "fn-error": "<The HTTP message of the response>",
+*                 "fn-timing": {<Phase durations and transferred bytes of the request>},
 *             }
 *         ```
 *
@@ -1657,9 +1653,8 @@ QN_SDK qn_json_object_ptr qn_stor_ft_api_fetch(qn_storage_ptr restrict stor, con
 *******************************************************************************/
 QN_SDK qn_json_object_ptr qn_stor_ft_api_prefetch(qn_storage_ptr restrict stor, const qn_mac_ptr restrict mac, const char * restrict dest_bucket, const char * restrict dest_key, qn_stor_fetch_extra_ptr restrict fte)
 {
-    qn_bool ret;
-    qn_string encoded_dest_uri;
-    qn_string url;
+    qn_json_object_ptr up_ret;
+    const char * url;
     qn_rgn_entry_ptr rgn_entry;
 
     assert(stor);
@@ -1676,12 +1671,9 @@ QN_SDK qn_json_object_ptr qn_stor_ft_api_prefetch(qn_storage_ptr restrict stor,
     } // if
 
     // ---- Prepare the prefetch URL.
-    encoded_dest_uri = qn_misc_encode_uri(dest_bucket, dest_key);
-    if (!encoded_dest_uri) return NULL;
-
-    url = qn_cs_sprintf("%.s/prefetch/%.s", qn_str_size(rgn_entry->base_url), qn_str_cstr(rgn_entry->base_url), qn_str_size(encoded_dest_uri), qn_str_cstr(encoded_dest_uri));
-    qn_str_destroy(encoded_dest_uri);
-    if (!url) return NULL;
+    if (! qn_stor_start_url(stor, qn_str_cstr(rgn_entry->base_url), "/prefetch/")) return NULL;
+    if (! qn_stor_append_encoded_uri(stor->url_bld, stor->tmp_bld, dest_bucket, dest_key)) return NULL;
+    url = qn_str_bld_cstr(stor->url_bld);
 
     // ---- Prepare the request and response.
     qn_stor_reset(stor);
@@ -1689,37 +1681,20 @@ QN_SDK qn_json_object_ptr qn_stor_ft_api_prefetch(qn_storage_ptr restrict stor,
     // -- Nothing to post.
     qn_http_req_set_body_data(stor->req, "", 0);
 
-    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! qn_stor_mn_prepare(stor, url, rgn_entry->hostname, mac)) return NULL;
 
-    if (! (stor->obj_body = qn_json_create_object())) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (stor->obj_body = qn_json_create_object())) return NULL;
 
-    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) return NULL;
 
-    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) {
-        qn_str_destroy(url);
-        return NULL;
-    } // if
+    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) return NULL;
 
     qn_http_json_wrt_prepare(stor->resp_json_wrt, &stor->obj_body, NULL);
     qn_http_resp_set_data_writer(stor->resp, stor->resp_json_wrt, &qn_http_json_wrt_write_cfn);
 
     // ---- Do the prefetch action.
-    ret = qn_http_conn_post(stor->conn, url, stor->req, stor->resp);
-    qn_str_destroy(url);
-
-    if (!ret) return NULL;
-    qn_json_set_integer(stor->obj_body, "fn-code", qn_http_resp_get_code(stor->resp));
-    if (!qn_json_rename(stor->obj_body, "error", "fn-error")) return (qn_err_is_no_such_entry()) ? stor->obj_body : NULL;
-    return stor->obj_body;
+    up_ret = qn_stor_do_request(stor, QN_MTR_API_PREFETCH, url, qn_true, &qn_stor_rename_error_info);
+    return up_ret;
 }
 
 // ----
@@ -1983,6 +1958,14 @@ typedef struct _QN_STOR_UPLOAD_EXTRA
     qn_io_reader_itf rdr;
 
     qn_ud_variable_ptr ud_vars;
+
+    qn_uint32 ru_opts;
+
+    unsigned int check_crc32:1;
+    qn_etag_context_ptr qetag;
+
+    size_t ra_buf_size;
+    int ra_depth;
 } qn_stor_upload_extra_st;
 
 QN_SDK qn_stor_upload_extra_ptr qn_stor_upe_create(void)
@@ -2037,6 +2020,27 @@ QN_SDK void qn_stor_upe_set_region_entry(qn_stor_upload_extra_ptr restrict upe,
     upe->rgn_entry = entry;
 }
 
+QN_SDK void qn_stor_upe_set_crc32_checking(qn_stor_upload_extra_ptr restrict upe, qn_bool check)
+{
+    upe->check_crc32 = (check) ? 1 : 0;
+}
+
+QN_SDK void qn_stor_upe_set_qetag_context(qn_stor_upload_extra_ptr restrict upe, qn_etag_context_ptr restrict ctx)
+{
+    upe->qetag = ctx;
+}
+
+QN_SDK void qn_stor_upe_set_resumable_options(qn_stor_upload_extra_ptr restrict upe, qn_uint32 opts)
+{
+    upe->ru_opts = opts;
+}
+
+QN_SDK void qn_stor_upe_set_read_ahead(qn_stor_upload_extra_ptr restrict upe, qn_size buf_size, int depth)
+{
+    upe->ra_buf_size = buf_size;
+    upe->ra_depth = depth;
+}
+
 // -------- Ordinary Upload (abbreviation: up) --------
 
 static qn_bool qn_stor_up_prepare_for_upload(qn_storage_ptr restrict stor, const char * restrict uptoken, qn_stor_upload_extra_ptr restrict upe)
@@ -2084,6 +2088,38 @@ static qn_bool qn_stor_up_prepare_for_upload(qn_storage_ptr restrict stor, const
     return qn_true;
 }
 
+static size_t qn_stor_mapped_body_cfn(void * user_data, char * buf, size_t size)
+{
+    qn_stor_mapped_body_ptr body = (qn_stor_mapped_body_ptr) user_data;
+
+    if (size > body->size - body->pos) size = body->size - body->pos;
+    if (size == 0) return 0;
+
+    // -- Hash the mapped pages rather than the copy in curl's buffer.
+    if (body->qetag && ! qn_etag_ctx_update(body->qetag, body->addr + body->pos, size)) return CURL_READFUNC_ABORT;
+
+    memcpy(buf, body->addr + body->pos, size);
+    body->pos += size;
+    return size;
+}
+
+static qn_bool qn_stor_mapped_body_seek_cfn(void * user_data, qn_fsize offset)
+{
+    qn_stor_mapped_body_ptr body = (qn_stor_mapped_body_ptr) user_data;
+
+    if ((qn_fsize) body->size < offset) return qn_false;
+
+    // -- Start hashing over, and hash the bytes before the new position from the mapped pages since they are not read
+    //    again.
+    if (body->qetag) {
+        if (! qn_etag_ctx_init(body->qetag)) return qn_false;
+        if (offset > 0 && ! qn_etag_ctx_update(body->qetag, body->addr, offset)) return qn_false;
+    } // if
+
+    body->pos = offset;
+    return qn_true;
+}
+
 /***************************************************************************//**
 * @ingroup Storage-Management
 *
@@ -2106,6 +2142,14 @@ static qn_bool qn_stor_up_prepare_for_upload(qn_storage_ptr restrict stor, const
 *         to put it into the destination bucket. It's the simplest way to
 *         upload a file.
 *
+*         The file is mapped into memory and handed out to the HTTP layer
+*         slice by slice, without reading it into intermediate buffers. If
+*         CRC-32 checking is enabled by qn_stor_upe_set_crc32_checking(), the
+*         checksum is computed on the mapped pages and sent for the server to
+*         verify. If a QETAG context is set by qn_stor_upe_set_qetag_context(),
+*         it is initialized and updated with the mapped pages as they are sent,
+*         so the caller can compare its digest with the returned hash.
+*
 *         If succeeds, the function returns a result information object
 *         contains a few of fields describing the meta data about the file,
 *         accompanied by some option ones describing other information like
@@ -2116,6 +2160,7 @@ static qn_bool qn_stor_up_prepare_for_upload(qn_storage_ptr restrict stor, const
 *             {
 *                 "fn-code": <The HTTP code of the response>,
 *                 "fn-error": "<The HTTP message of the response>",
+*                 "fn-timing": {<Phase durations and transferred bytes of the request>},
 *
 *                 "fsize": <File's size in bytes>,
 *                 "hash": "<File's hash digest generated by Qiniu-ETAG algorithm>",
@@ -2162,8 +2207,10 @@ static qn_bool qn_stor_up_prepare_for_upload(qn_storage_ptr restrict stor, const
 QN_SDK qn_json_object_ptr qn_stor_up_api_upload_file(qn_storage_ptr restrict stor, const char * restrict uptoken, const char * restrict fname, qn_stor_upload_extra_ptr restrict upe)
 {
     const char * mime_type = NULL;
-    qn_bool ret;
-    qn_fl_info_ptr fi;
+    char crc32_str[16];
+    qn_json_object_ptr up_ret;
+    qn_file_ptr fl;
+    qn_fsize fsize;
     qn_http_form_ptr form;
     qn_rgn_entry_ptr rgn_entry;
 
@@ -2180,32 +2227,56 @@ QN_SDK qn_json_object_ptr qn_stor_up_api_upload_file(qn_storage_ptr restrict sto
 
     if (! qn_stor_up_prepare_for_upload(stor, uptoken, upe)) return NULL;
 
+    // ---- Map the file, the mapping stays valid after closing it.
+    if (! (fl = qn_fl_open(fname, NULL))) return NULL;
+    fsize = qn_fl_fsize(fl);
+    if (sizeof(size_t) < sizeof(qn_fsize) && SIZE_MAX < fsize) {
+        qn_fl_close(fl);
+        qn_err_set_overflow_upper_bound();
+        return NULL;
+    } // if
+    if (fsize > 0 && ! (stor->mapped_body.addr = qn_fl_map(fl, 0, fsize))) {
+        qn_fl_close(fl);
+        return NULL;
+    } // if
+    stor->mapped_body.size = fsize;
+    qn_fl_close(fl);
+
     // ----
     form = qn_http_req_get_form(stor->req);
 
-    fi = qn_fl_info_stat(fname);
-    if (!fi) return NULL;
+    if (upe && upe->check_crc32 && ! upe->crc32) {
+        // -- Checksum the mapped pages in place, which also brings them into the page cache for sending.
+        snprintf(crc32_str, sizeof(crc32_str), "%u", qn_crc32_update(0, stor->mapped_body.addr, stor->mapped_body.size));
+        if (! qn_http_form_add_text(form, "crc32", crc32_str, strlen(crc32_str))) return NULL;
+    } // if
+
+    if (upe && upe->qetag) {
+        if (! qn_etag_ctx_init(upe->qetag)) return NULL;
+        stor->mapped_body.qetag = upe->qetag;
+    } // if
 
-    ret = qn_http_form_add_file(form, "file", qn_str_cstr(qn_fl_info_fname(fi)), NULL, qn_fl_info_fsize(fi), mime_type);
-    qn_fl_info_destroy(fi);
-    if (!ret) return NULL;
+    if (fsize == 0) {
+        // -- Curl takes a zero length of a streamed part as unknown, so let it send the empty file by itself.
+        if (! qn_http_form_add_file(form, "file", fname, NULL, 0, mime_type)) return NULL;
+    } else {
+        if (! qn_http_form_add_file_reader(form, "file", fname, NULL, fsize, mime_type, stor->req)) return NULL;
+        qn_http_req_set_body_reader(stor->req, &stor->mapped_body, &qn_stor_mapped_body_cfn, fsize);
+        qn_http_req_set_body_seeker(stor->req, &qn_stor_mapped_body_seek_cfn);
+    } // if
 
     // ----
     if (rgn_entry->hostname && !qn_http_req_set_header(stor->req, "Host", qn_str_cstr(rgn_entry->hostname))) return NULL;
 
     // ----
-    ret = qn_http_conn_post(stor->conn, qn_str_cstr(rgn_entry->base_url), stor->req, stor->resp);
-    if (!ret) return NULL;
-
-    qn_json_set_integer(stor->obj_body, "fn-code", qn_http_resp_get_code(stor->resp));
-    if (!qn_json_rename(stor->obj_body, "error", "fn-error")) return (qn_err_is_no_such_entry()) ? stor->obj_body : NULL;
-    return stor->obj_body;
+    up_ret = qn_stor_do_request(stor, QN_MTR_API_UPLOAD, qn_str_cstr(rgn_entry->base_url), qn_true, &qn_stor_rename_error_info);
+    return up_ret;
 }
 
 QN_SDK qn_json_object_ptr qn_stor_up_api_upload_buffer(qn_storage_ptr restrict stor, const char * restrict uptoken, const char * restrict buf, qn_size buf_size, qn_stor_upload_extra_ptr restrict upe)
 {
     const char * mime_type = NULL;
-    qn_bool ret;
+    qn_json_object_ptr up_ret;
     qn_http_form_ptr form;
     qn_rgn_entry_ptr rgn_entry;
 
@@ -2231,12 +2302,8 @@ QN_SDK qn_json_object_ptr qn_stor_up_api_upload_buffer(qn_storage_ptr restrict s
 
     // ----
     if (rgn_entry->hostname && !qn_http_req_set_header(stor->req, "Host", qn_str_cstr(rgn_entry->hostname))) return NULL;
-    ret = qn_http_conn_post(stor->conn, qn_str_cstr(rgn_entry->base_url), stor->req, stor->resp);
-    if (!ret) return NULL;
-
-    qn_json_set_integer(stor->obj_body, "fn-code", qn_http_resp_get_code(stor->resp));
-    if (!qn_json_rename(stor->obj_body, "error", "fn-error")) return (qn_err_is_no_such_entry()) ? stor->obj_body : NULL;
-    return stor->obj_body;
+    up_ret = qn_stor_do_request(stor, QN_MTR_API_UPLOAD, qn_str_cstr(rgn_entry->base_url), qn_true, &qn_stor_rename_error_info);
+    return up_ret;
 }
 
 static size_t qn_stor_upload_cfn(void * user_data, char * buf, size_t size)
@@ -2253,7 +2320,9 @@ QN_SDK qn_json_object_ptr qn_stor_up_api_upload(qn_storage_ptr restrict stor, co
 {
     const char * mime_type = NULL;
     qn_bool ret;
+    qn_json_object_ptr up_ret;
     qn_rgn_entry_ptr rgn_entry;
+    qn_io_reader_itf body_rdr;
 
     assert(stor);
     assert(uptoken);
@@ -2272,16 +2341,30 @@ QN_SDK qn_json_object_ptr qn_stor_up_api_upload(qn_storage_ptr restrict stor, co
     ret = qn_http_form_add_file_reader(qn_http_req_get_form(stor->req), "file", qn_str_cstr(qn_io_rdr_name(data_rdr)), NULL, qn_io_rdr_size(data_rdr), mime_type, stor->req);
     if (! ret) return NULL;
 
-    qn_http_req_set_body_reader(stor->req, data_rdr, qn_stor_upload_cfn, qn_io_rdr_size(data_rdr));
+    body_rdr = data_rdr;
+    if (upe && upe->ra_depth > 0) {
+        if (stor->ra_rdr && (stor->ra_buf_size != upe->ra_buf_size || stor->ra_depth != upe->ra_depth)) {
+            qn_io_rardr_destroy(stor->ra_rdr);
+            stor->ra_rdr = NULL;
+        } // if
+        if (! stor->ra_rdr) {
+            if (! (stor->ra_rdr = qn_io_rardr_create(NULL, upe->ra_buf_size, upe->ra_depth))) return NULL;
+            stor->ra_buf_size = upe->ra_buf_size;
+            stor->ra_depth = upe->ra_depth;
+        } // if
+        qn_io_rardr_reset(stor->ra_rdr, data_rdr);
+        body_rdr = qn_io_rardr_to_io_reader(stor->ra_rdr);
+    } // if
+
+    qn_http_req_set_body_reader(stor->req, body_rdr, qn_stor_upload_cfn, qn_io_rdr_size(data_rdr));
 
     // ----
     if (rgn_entry->hostname && !qn_http_req_set_header(stor->req, "Host", qn_str_cstr(rgn_entry->hostname))) return NULL;
-    ret = qn_http_conn_post(stor->conn, qn_str_cstr(rgn_entry->base_url), stor->req, stor->resp);
-    if (! ret) return NULL;
+    up_ret = qn_stor_do_request(stor, QN_MTR_API_UPLOAD, qn_str_cstr(rgn_entry->base_url), qn_true, &qn_stor_rename_error_info);
 
-    qn_json_set_integer(stor->obj_body, "fn-code", qn_http_resp_get_code(stor->resp));
-    if (! qn_json_rename(stor->obj_body, "error", "fn-error")) return (qn_err_is_no_such_entry()) ? stor->obj_body : NULL;
-    return stor->obj_body;
+    // ---- The caller may close the data reader once a synchronous request returns, so stop reading it ahead.
+    if (stor->ra_rdr && ! stor->eng) qn_io_rardr_reset(stor->ra_rdr, NULL);
+    return up_ret;
 }
 
 // -------- Resumable Upload Object (abbreviation: ru) --------
@@ -2293,8 +2376,10 @@ typedef struct _QN_STOR_RESUMABLE_UPLOAD
     qn_io_reader_itf src_rdr;
     int blk_cnt;
     int ctx_idx;
-    int ctx_pos:16;
-    int need_comma:1;
+    int ctx_pos;
+    int ctx_size;
+    const char * ctx;
+    unsigned int need_comma:1;
     qn_fsize fsize;
     qn_fsize uploaded_fsize;
 } qn_stor_resumable_upload_st;
@@ -2308,41 +2393,47 @@ static ssize_t qn_stor_ru_ctx_rdr_read_vfn(qn_io_reader_itf restrict itf, char *
 {
     qn_json_array_ptr blk_arr;
     qn_json_object_ptr blk_info;
-    qn_string ctx;
     qn_stor_resumable_upload_ptr ru = qn_stor_ru_ctx_from_io_reader(itf);
     char * pos = buf;
     size_t rem_size = buf_size;
+    int blk_cnt;
     int copy_bytes;
 
     blk_arr = qn_json_get_array(ru->progress, "blocks", NULL);
+    blk_cnt = qn_json_size_array(blk_arr);
 
-    while (rem_size > 0 && ru->ctx_idx < qn_json_size_array(blk_arr)) {
+    while (rem_size > 0 && ru->ctx_idx < blk_cnt) {
         if (ru->need_comma) {
             *pos++ = ',';
             rem_size -= 1;
+            ru->need_comma = 0;
+            continue;
         } // if
 
-        blk_info = qn_json_pick_object(blk_arr, ru->ctx_idx, NULL);
-        ctx = qn_json_get_string(blk_info, "ctx", NULL);
-        if (! ctx) {
-            qn_err_stor_set_lack_of_block_context();
-            return -1;
+        if (! ru->ctx) {
+            // ---- Look up the context and its size only once, not in each step of copying.
+            blk_info = qn_json_pick_object(blk_arr, ru->ctx_idx, NULL);
+            ru->ctx = qn_json_get_string(blk_info, "ctx", NULL);
+            if (! ru->ctx) {
+                qn_err_stor_set_lack_of_block_context();
+                return -1;
+            } // if
+            ru->ctx_size = posix_strlen(ru->ctx);
         } // if
 
-        copy_bytes = qn_str_size(ctx) - ru->ctx_pos;
+        copy_bytes = ru->ctx_size - ru->ctx_pos;
         if (rem_size < copy_bytes) copy_bytes = rem_size;
 
-        if (copy_bytes > 0) {
-            memcpy(pos, qn_str_cstr(ctx) + ru->ctx_pos, copy_bytes);
-            pos += copy_bytes;
-            rem_size -= copy_bytes;
-            ru->ctx_pos += copy_bytes;
+        memcpy(pos, ru->ctx + ru->ctx_pos, copy_bytes);
+        pos += copy_bytes;
+        rem_size -= copy_bytes;
+        ru->ctx_pos += copy_bytes;
 
-            if (ru->ctx_pos == qn_str_size(ctx)) {
-                ru->need_comma = 1;
-                ru->ctx_pos = 0;
-                ru->ctx_idx += 1;
-            } // if
+        if (ru->ctx_pos == ru->ctx_size) {
+            ru->need_comma = (ru->ctx_idx + 1 < blk_cnt) ? 1 : 0;
+            ru->ctx = NULL;
+            ru->ctx_pos = 0;
+            ru->ctx_idx += 1;
         } // if
     } // while
     return buf_size - rem_size;
@@ -2645,6 +2736,10 @@ QN_SDK qn_io_reader_itf qn_stor_ru_create_block_reader(qn_stor_resumable_upload_
         } // if
         if (! (new_blk_info = qn_json_create_and_push_object(blk_arr))) return NULL;
         if (! qn_json_set_integer(new_blk_info, "bsize", blk_size)) return NULL;
+    } else {
+        // -- Resume an interrupted block, its information has been recorded already.
+        if (! (new_blk_info = qn_json_pick_object(blk_arr, blk_idx, NULL))) return NULL;
+        blk_size = qn_json_get_integer(new_blk_info, "bsize", blk_size);
     } // if
 
     // -- The source reader is a file.
@@ -2656,6 +2751,7 @@ QN_SDK qn_io_reader_itf qn_stor_ru_to_context_reader(qn_stor_resumable_upload_pt
 {
     ru->ctx_idx = 0;
     ru->ctx_pos = 0;
+    ru->ctx = NULL;
     ru->need_comma = 0;
     return &ru->rdr_vtbl;
 }
@@ -2683,36 +2779,16 @@ QN_SDK qn_bool qn_stor_ru_is_file_uploaded(qn_stor_resumable_upload_ptr restrict
     return ru->uploaded_fsize == ru->fsize;
 }
 
-static inline qn_bool qn_stor_prepare_error_info(qn_storage_ptr restrict stor)
-{
-    if (! (qn_json_set_integer(stor->obj_body, "fn-code", 0))) return qn_false;
-    if (! (qn_json_set_cstr(stor->obj_body, "fn-error", "OK"))) return qn_false;
-    return qn_true;
-}
-
-static inline qn_json_object_ptr qn_stor_rename_error_info(qn_storage_ptr restrict stor)
-{
-    qn_json_set_integer(stor->obj_body, "fn-code", qn_http_resp_get_code(stor->resp));
-    if (! qn_json_rename(stor->obj_body, "error", "fn-error")) return (qn_err_is_no_such_entry()) ? stor->obj_body : NULL;
-    return stor->obj_body;
-}
-
 static qn_bool qn_stor_ru_prepare_for_resumable_upload(qn_storage_ptr restrict stor, const char * restrict uptoken, const char * restrict mime, qn_io_reader_itf restrict rdr, qn_uint size, qn_rgn_entry_ptr rgn_entry)
 {
-    qn_bool ret;
-    qn_string tmp_hdr;
-
     // ---- Reset the stor object.
     qn_stor_reset(stor);
 
     // ---- Set all the HTTP request headers.
     // -- Set the `Authorization` header.
-    tmp_hdr = qn_cs_sprintf("UpToken %s", uptoken);
-    if (! tmp_hdr) return qn_false;
-
-    ret = qn_http_req_set_header(stor->req, "Authorization", tmp_hdr);
-    qn_str_destroy(tmp_hdr);
-    if (! ret) return qn_false;
+    qn_str_bld_reset(stor->tmp_bld);
+    if (! qn_str_bld_append_raw(stor->tmp_bld, "UpToken ", 8) || ! qn_str_bld_append_cstr(stor->tmp_bld, uptoken)) return qn_false;
+    if (! qn_http_req_set_header(stor->req, "Authorization", qn_str_bld_cstr(stor->tmp_bld))) return qn_false;
 
     // -- Set the common headers.
     if (! qn_stor_prepare_common_request_headers(stor)) return qn_false;
@@ -2721,12 +2797,9 @@ static qn_bool qn_stor_ru_prepare_for_resumable_upload(qn_storage_ptr restrict s
     if (! mime) mime = "application/octet-stream";
     if (! qn_http_req_set_header(stor->req, "Content-Type", mime)) return qn_false;
 
-    tmp_hdr = qn_cs_sprintf("%u", size);
-    if (! tmp_hdr) return qn_false;
-
-    ret = qn_http_req_set_header(stor->req, "Content-Length", tmp_hdr);
-    qn_str_destroy(tmp_hdr);
-    if (! ret) return qn_false;
+    qn_str_bld_reset(stor->tmp_bld);
+    if (! qn_str_bld_append_integer(stor->tmp_bld, size)) return qn_false;
+    if (! qn_http_req_set_header(stor->req, "Content-Length", qn_str_bld_cstr(stor->tmp_bld))) return qn_false;
 
     // ---- Prepare the request body reader.
     qn_http_req_set_body_reader(stor->req, rdr, qn_stor_upload_cfn, size);
@@ -2744,9 +2817,9 @@ static qn_bool qn_stor_ru_prepare_for_resumable_upload(qn_storage_ptr restrict s
 
 QN_SDK qn_json_object_ptr qn_stor_ru_api_mkblk(qn_storage_ptr restrict stor, const char * restrict uptoken, qn_io_reader_itf restrict data_rdr, qn_json_object_ptr restrict blk_info, qn_uint chk_size, qn_stor_upload_extra_ptr restrict upe)
 {
-    qn_bool ret;
+    qn_json_object_ptr up_ret;
     int blk_size;
-    qn_string url;
+    const char * url;
     qn_rgn_entry_ptr rgn_entry;
 
     // ---- Check preconditions.
@@ -2775,19 +2848,19 @@ QN_SDK qn_json_object_ptr qn_stor_ru_api_mkblk(qn_storage_ptr restrict stor, con
     if (! qn_stor_ru_prepare_for_resumable_upload(stor, uptoken, "application/octet-stream", data_rdr, chk_size, rgn_entry)) return NULL;
 
     // ---- Prepare upload URL.
-    url = qn_cs_sprintf("%s/mkblk/%d", qn_str_cstr(rgn_entry->base_url), blk_size);
+    if (! qn_stor_start_url(stor, qn_str_cstr(rgn_entry->base_url), "/mkblk/")) return NULL;
+    if (! qn_str_bld_append_integer(stor->url_bld, blk_size)) return NULL;
+    url = qn_str_bld_cstr(stor->url_bld);
 
     // ---- Do the mkblk action.
-    ret = qn_http_conn_post(stor->conn, url, stor->req, stor->resp);
-    qn_str_destroy(url);
-    if (! ret) return NULL;
-    return qn_stor_rename_error_info(stor);
+    up_ret = qn_stor_do_request(stor, QN_MTR_API_MKBLK, url, qn_true, &qn_stor_rename_error_info);
+    return up_ret;
 }
 
 QN_SDK qn_json_object_ptr qn_stor_ru_api_bput(qn_storage_ptr restrict stor, const char * restrict uptoken, qn_io_reader_itf restrict data_rdr, qn_json_object_ptr restrict blk_info, qn_uint chk_size, qn_stor_upload_extra_ptr restrict upe)
 {
-    qn_bool ret;
-    qn_string url;
+    qn_json_object_ptr up_ret;
+    const char * url;
     qn_string host;
     qn_string ctx;
     qn_integer offset;
@@ -2838,22 +2911,22 @@ QN_SDK qn_json_object_ptr qn_stor_ru_api_bput(qn_storage_ptr restrict stor, cons
     if (! qn_stor_ru_prepare_for_resumable_upload(stor, uptoken, "application/octet-stream", data_rdr, chk_size, rgn_entry)) return NULL;
 
     // ---- Prepare upload URL.
-    url = qn_cs_sprintf("%s/bput/%s/%d", qn_str_cstr(host), qn_str_cstr(ctx), offset);
+    if (! qn_stor_start_url(stor, qn_str_cstr(host), "/bput/")) return NULL;
+    if (! qn_str_bld_append_cstr(stor->url_bld, qn_str_cstr(ctx))) return NULL;
+    if (! qn_str_bld_append_raw(stor->url_bld, "/", 1)) return NULL;
+    if (! qn_str_bld_append_integer(stor->url_bld, offset)) return NULL;
+    url = qn_str_bld_cstr(stor->url_bld);
 
     // ---- Do the bput action.
-    ret = qn_http_conn_post(stor->conn, url, stor->req, stor->resp);
-    qn_str_destroy(url);
-    if (! ret) return NULL;
-    return qn_stor_rename_error_info(stor);
+    up_ret = qn_stor_do_request(stor, QN_MTR_API_BPUT, url, qn_true, &qn_stor_rename_error_info);
+    return up_ret;
 }
 
 QN_SDK qn_json_object_ptr qn_stor_ru_api_mkfile(qn_storage_ptr restrict stor, const char * restrict uptoken, qn_io_reader_itf restrict ctx_rdr, qn_json_object_ptr restrict last_blk_info, qn_fsize fsize, qn_stor_upload_extra_ptr restrict upe)
 {
-    qn_bool ret;
-    qn_string url;
-    qn_string url_tmp;
+    qn_json_object_ptr up_ret;
+    const char * url;
     qn_string host;
-    qn_string tmp_str;
     int ctx_size;
     qn_rgn_entry_ptr rgn_entry;
     const qn_string * entries = NULL;
@@ -2888,40 +2961,18 @@ QN_SDK qn_json_object_ptr qn_stor_ru_api_mkfile(qn_storage_ptr restrict stor, co
     if (! qn_stor_ru_prepare_for_resumable_upload(stor, uptoken, "text/plain", ctx_rdr, ctx_size, rgn_entry)) return NULL;
 
     // ---- Prepare upload URL.
-    tmp_str = qn_type_fsize_to_string(fsize);
-    if (! tmp_str) return NULL;
-    url = qn_cs_sprintf("%s/mkfile/%s", qn_str_cstr(host), qn_str_cstr(tmp_str));
-    qn_str_destroy(tmp_str);
+    if (! qn_stor_start_url(stor, qn_str_cstr(host), "/mkfile/")) return NULL;
+    if (! qn_str_bld_append_integer(stor->url_bld, fsize)) return NULL;
 
     if (upe) {
         if (upe->final_key) {
-            tmp_str = qn_cs_encode_base64_urlsafe(upe->final_key, strlen(upe->final_key));
-            if (! tmp_str) {
-                qn_str_destroy(url);
-                return NULL;
-            } // if
-
-            url_tmp = qn_cs_sprintf("%s/key/%s", qn_str_cstr(url), qn_str_cstr(tmp_str));
-            qn_str_destroy(tmp_str);
-            qn_str_destroy(url);
-            if (! url_tmp) return NULL;
-
-            url = url_tmp;
+            if (! qn_str_bld_append_cstr(stor->url_bld, "/key/")) return NULL;
+            if (! qn_str_bld_append_base64_urlsafe(stor->url_bld, upe->final_key, strlen(upe->final_key))) return NULL;
         } // if
 
         if (upe->mime_type) {
-            tmp_str = qn_cs_encode_base64_urlsafe(upe->mime_type, posix_strlen(upe->mime_type));
-            if (! tmp_str) {
-                qn_str_destroy(url);
-                return NULL;
-            } // if
-
-            url_tmp = qn_cs_sprintf("%s/mimeType/%s", qn_str_cstr(url), qn_str_cstr(tmp_str));
-            qn_str_destroy(tmp_str);
-            qn_str_destroy(url);
-            if (! url_tmp) return NULL;
-
-            url = url_tmp;
+            if (! qn_str_bld_append_cstr(stor->url_bld, "/mimeType/")) return NULL;
+            if (! qn_str_bld_append_base64_urlsafe(stor->url_bld, upe->mime_type, posix_strlen(upe->mime_type))) return NULL;
         } // if
 
         if (upe->ud_vars && qn_ud_var_count(upe->ud_vars) > 0) {
@@ -2930,94 +2981,1321 @@ QN_SDK qn_json_object_ptr qn_stor_ru_api_mkfile(qn_storage_ptr restrict stor, co
             for (i = 0; i < qn_ud_var_count(upe->ud_vars); i += 1) {
                 qn_ud_var_get_pair_raw(upe->ud_vars, entries[i], &key, &key_size, &val, &val_size);
 
-                tmp_str = qn_cs_encode_base64_urlsafe(val, val_size);
-                if (! tmp_str) {
-                    qn_str_destroy(tmp_str);
-                    return NULL;
-                } // if
-
-                url_tmp = qn_cs_join_raw("/", qn_str_cstr(url), qn_str_size(url), key, key_size, qn_str_cstr(tmp_str), qn_str_size(tmp_str), NULL);
-                qn_str_destroy(tmp_str);
-                qn_str_destroy(url);
-                if (! url_tmp) return NULL;
-
-                url = url_tmp;
-            } // if
+                if (! qn_str_bld_append_raw(stor->url_bld, "/", 1)) return NULL;
+                if (! qn_str_bld_append_raw(stor->url_bld, key, key_size)) return NULL;
+                if (! qn_str_bld_append_raw(stor->url_bld, "/", 1)) return NULL;
+                if (! qn_str_bld_append_base64_urlsafe(stor->url_bld, val, val_size)) return NULL;
+            } // for
         } // if
     } // if
+    url = qn_str_bld_cstr(stor->url_bld);
 
     // ---- Do the mkfile action.
-    ret = qn_http_conn_post(stor->conn, url, stor->req, stor->resp);
-    qn_str_destroy(url);
-    if (! ret) return NULL;
-    return qn_stor_rename_error_info(stor);
+    up_ret = qn_stor_do_request(stor, QN_MTR_API_MKFILE, url, qn_true, &qn_stor_rename_error_info);
+    return up_ret;
 }
 
-QN_SDK qn_json_object_ptr qn_stor_ru_upload_huge(qn_storage_ptr restrict stor, const char * restrict uptoken, qn_stor_resumable_upload_ptr ru, int * start_idx, qn_uint chk_size, qn_stor_upload_extra_ptr restrict upe)
+static inline void qn_stor_ru_lock(pthread_mutex_t * lock)
 {
-    int i;
-    qn_integer offset;
-    qn_json_object_ptr up_ret;
-    qn_json_object_ptr blk_info;
-    qn_io_reader_itf sec_rdr;
-    qn_io_section_reader_ptr chk_rdr;
-
-    // ---- Check preconditions.
-    assert(stor);
-    assert(uptoken);
-    assert(ru);
-    assert(0 <= *start_idx);
+    if (lock) pthread_mutex_lock(lock);
+}
 
-    // ---- Prepare internal objects.
-    
-    chk_rdr = qn_io_srdr_create(NULL, 0);
-    if (! chk_rdr) return NULL;
+static inline void qn_stor_ru_unlock(pthread_mutex_t * lock)
+{
+    if (lock) pthread_mutex_unlock(lock);
+}
 
-    // ---- Start from the given index.
-    for (i = *start_idx; i < qn_stor_ru_get_block_count(ru); i += 1) {
-        blk_info = qn_stor_ru_get_block_info(ru, i);
-        if (blk_info && qn_stor_ru_is_block_uploaded(blk_info)) continue;
+// ---- Chunk preparation (abbreviation: cp) ----
 
-        if (! (sec_rdr = qn_stor_ru_create_block_reader(ru, i, &blk_info))) {
-            qn_io_srdr_destroy(chk_rdr);
-            *start_idx = i;
-            return NULL;
-        } // if
+// -- Chunks are read into memory and checksummed before being sent, so the checksums returned by the
+//    upload APIs can be verified. With a threaded prefetcher, the next chunk is prepared while the current one
+//    is in flight. Requests of the same block cannot overlap since each one needs the context returned by the
+//    previous one, but the disk reading and checksumming are taken off the round trips.
 
-        if ((offset = qn_json_get_integer(blk_info, "offset", 0)) == 0) {
-            qn_io_srdr_reset(chk_rdr, sec_rdr, chk_size);
-            up_ret = qn_stor_ru_api_mkblk(stor, uptoken, qn_io_srdr_to_io_reader(chk_rdr), blk_info, chk_size, upe);
-            if (! up_ret || qn_json_get_integer(up_ret, "fn-code", -1) != 200) goto QN_STOR_UPLOAD_HUGE_ERROR_HANDLING;
-            if (! (blk_info = qn_stor_ru_update_block_info(ru, i, up_ret))) {
-                up_ret = NULL;
-                goto QN_STOR_UPLOAD_HUGE_ERROR_HANDLING;
-            } // if
-        } else if (! qn_io_rdr_advance(sec_rdr, offset)) {
-            goto QN_STOR_UPLOAD_HUGE_ERROR_HANDLING;
+typedef struct _QN_STOR_RU_CHUNK
+{
+    qn_io_reader_ptr rdr_vtbl;
+    char * buf;
+    qn_uint cap;
+    qn_uint size;
+    qn_uint pos;
+    qn_uint32 crc32;
+} qn_stor_ru_chunk_st, *qn_stor_ru_chunk_ptr;
+
+static inline qn_stor_ru_chunk_ptr qn_stor_ru_chk_from_io_reader(qn_io_reader_itf restrict itf)
+{
+    return (qn_stor_ru_chunk_ptr)( ( (char *)itf ) - (char *)( &((qn_stor_ru_chunk_ptr)0)->rdr_vtbl ) );
+}
+
+static ssize_t qn_stor_ru_chk_read_vfn(qn_io_reader_itf restrict itf, char * restrict buf, size_t buf_size)
+{
+    qn_stor_ru_chunk_ptr chk = qn_stor_ru_chk_from_io_reader(itf);
+
+    if (chk->size - chk->pos < buf_size) buf_size = chk->size - chk->pos;
+    memcpy(buf, chk->buf + chk->pos, buf_size);
+    chk->pos += buf_size;
+    return buf_size;
+}
+
+static qn_fsize qn_stor_ru_chk_size_vfn(qn_io_reader_itf restrict itf)
+{
+    return qn_stor_ru_chk_from_io_reader(itf)->size;
+}
+
+static qn_io_reader_st qn_stor_ru_chk_rdr_vtable = {
+    NULL, // CLOSE
+    NULL, // PEEK
+    &qn_stor_ru_chk_read_vfn, // READ
+    NULL, // SEEK
+    NULL, // ADVANCE
+    NULL, // DUPLICATE
+    NULL, // SECTION
+    NULL, // NAME
+    &qn_stor_ru_chk_size_vfn  // SIZE
+};
+
+static qn_bool qn_stor_ru_chk_fill(qn_stor_ru_chunk_ptr restrict chk, qn_io_reader_itf restrict src_rdr, qn_uint size)
+{
+    char * new_buf;
+    ssize_t ret;
+
+    if (chk->cap < size) {
+        if (! (new_buf = realloc(chk->buf, size))) {
+            qn_err_set_out_of_memory();
+            return qn_false;
         } // if
+        chk->buf = new_buf;
+        chk->cap = size;
+    } // if
 
-        // ---- If the whole block is uploaded through the /mkblk API, skip all subsequent calls to the /bput API.
-        while (! qn_stor_ru_is_block_uploaded(blk_info)) {
-            qn_io_srdr_reset(chk_rdr, sec_rdr, chk_size);
-            up_ret = qn_stor_ru_api_bput(stor, uptoken, qn_io_srdr_to_io_reader(chk_rdr), blk_info, chk_size, upe);
-            if (! up_ret || qn_json_get_integer(up_ret, "fn-code", -1) != 200) goto QN_STOR_UPLOAD_HUGE_ERROR_HANDLING;
-            if (! (blk_info = qn_stor_ru_update_block_info(ru, i, up_ret))) {
-                up_ret = NULL;
-                goto QN_STOR_UPLOAD_HUGE_ERROR_HANDLING;
-            } // if
+    chk->size = 0;
+    chk->pos = 0;
+    while (chk->size < size) {
+        ret = qn_io_rdr_read(src_rdr, chk->buf + chk->size, size - chk->size);
+        if (ret < 0) return qn_false;
+        if (ret == 0) break;
+        chk->size += ret;
+    } // while
+    if (chk->size == 0) {
+        // -- The source ends before the block does.
+        qn_err_stor_set_lack_of_block_info();
+        return qn_false;
+    } // if
+
+    chk->crc32 = qn_crc32_update(0, chk->buf, chk->size);
+    return qn_true;
+}
+
+enum
+{
+    QN_STOR_RU_CP_IDLE = 0,
+    QN_STOR_RU_CP_REQUESTED = 1,
+    QN_STOR_RU_CP_READY = 2
+};
+
+typedef struct _QN_STOR_RU_CHUNK_PREPARER
+{
+    qn_stor_ru_chunk_st chks[2];
+    int fill_idx;
+
+    qn_io_reader_itf src_rdr;
+    qn_uint req_size;
+    int state;
+    qn_bool ok;
+    qn_err_code_em err_code;
+
+    qn_io_prefetcher_ptr pf;
+} qn_stor_ru_chunk_preparer_st, *qn_stor_ru_chunk_preparer_ptr;
+
+static qn_bool qn_stor_ru_cp_next_cfn(void * restrict data)
+{
+    return ((qn_stor_ru_chunk_preparer_ptr) data)->state == QN_STOR_RU_CP_REQUESTED;
+}
+
+static void qn_stor_ru_cp_fill_cfn(void * restrict data)
+{
+    qn_stor_ru_chunk_preparer_ptr cp = (qn_stor_ru_chunk_preparer_ptr) data;
+
+    cp->ok = qn_stor_ru_chk_fill(&cp->chks[cp->fill_idx], cp->src_rdr, cp->req_size);
+    cp->err_code = (cp->ok) ? QN_ERR_SUCCEED : qn_err_get_code();
+}
+
+static void qn_stor_ru_cp_commit_cfn(void * restrict data)
+{
+    ((qn_stor_ru_chunk_preparer_ptr) data)->state = QN_STOR_RU_CP_READY;
+}
+
+static qn_stor_ru_chunk_preparer_ptr qn_stor_ru_cp_create(qn_bool threaded)
+{
+    qn_stor_ru_chunk_preparer_ptr new_cp;
+
+    new_cp = calloc(1, sizeof(qn_stor_ru_chunk_preparer_st));
+    if (! new_cp) {
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+
+    new_cp->chks[0].rdr_vtbl = &qn_stor_ru_chk_rdr_vtable;
+    new_cp->chks[1].rdr_vtbl = &qn_stor_ru_chk_rdr_vtable;
+
+    new_cp->pf = qn_io_pf_create(new_cp, &qn_stor_ru_cp_next_cfn, &qn_stor_ru_cp_fill_cfn, &qn_stor_ru_cp_commit_cfn, threaded);
+    if (! new_cp->pf) {
+        free(new_cp);
+        return NULL;
+    } // if
+    return new_cp;
+}
+
+static void qn_stor_ru_cp_request(qn_stor_ru_chunk_preparer_ptr restrict cp, qn_io_reader_itf restrict src_rdr, qn_uint size)
+{
+    qn_io_pf_lock(cp->pf);
+    cp->src_rdr = src_rdr;
+    cp->req_size = size;
+    cp->state = QN_STOR_RU_CP_REQUESTED;
+    qn_io_pf_notify(cp->pf);
+    qn_io_pf_unlock(cp->pf);
+}
+
+static void qn_stor_ru_cp_drain(qn_stor_ru_chunk_preparer_ptr restrict cp)
+{
+    qn_io_pf_lock(cp->pf);
+    qn_io_pf_settle(cp->pf);
+    cp->state = QN_STOR_RU_CP_IDLE;
+    qn_io_pf_unlock(cp->pf);
+}
+
+static qn_stor_ru_chunk_ptr qn_stor_ru_cp_wait(qn_stor_ru_chunk_preparer_ptr restrict cp)
+{
+    qn_stor_ru_chunk_ptr chk;
+
+    qn_io_pf_lock(cp->pf);
+    while (cp->state == QN_STOR_RU_CP_REQUESTED) qn_io_pf_wait(cp->pf);
+    cp->state = QN_STOR_RU_CP_IDLE;
+    qn_io_pf_unlock(cp->pf);
+
+    if (! cp->ok) {
+        qn_err_set_code(cp->err_code, 0, __FILE__, __LINE__);
+        return NULL;
+    } // if
+
+    chk = &cp->chks[cp->fill_idx];
+    cp->fill_idx ^= 1;
+    return chk;
+}
+
+static void qn_stor_ru_cp_destroy(qn_stor_ru_chunk_preparer_ptr restrict cp)
+{
+    if (cp) {
+        qn_io_pf_destroy(cp->pf);
+        free(cp->chks[0].buf);
+        free(cp->chks[1].buf);
+        free(cp);
+    } // if
+}
+
+static inline qn_stor_ru_chunk_preparer_ptr qn_stor_ru_cp_create_for(qn_stor_upload_extra_ptr restrict upe, qn_bool * restrict ok)
+{
+    qn_uint32 opts = (upe) ? upe->ru_opts : 0;
+    qn_stor_ru_chunk_preparer_ptr cp;
+
+    *ok = qn_true;
+    if ((opts & (QN_STOR_RU_PIPELINE_CHUNKS | QN_STOR_RU_SIZE_CHUNKS_BY_BDP | QN_STOR_RU_ADAPT_CHUNK_SIZE)) == 0) return NULL;
+    if (! (cp = qn_stor_ru_cp_create(opts & QN_STOR_RU_PIPELINE_CHUNKS))) *ok = qn_false;
+    return cp;
+}
+
+static inline qn_io_read_ahead_reader_ptr qn_stor_ru_rardr_create_for(qn_stor_upload_extra_ptr restrict upe, qn_stor_ru_chunk_preparer_ptr restrict cp, qn_bool * restrict ok)
+{
+    qn_io_read_ahead_reader_ptr ra_rdr;
+
+    // ---- The chunk preparer reads chunks ahead by itself.
+    *ok = qn_true;
+    if (! upe || upe->ra_depth <= 0 || cp) return NULL;
+    if (! (ra_rdr = qn_io_rardr_create(NULL, upe->ra_buf_size, upe->ra_depth))) *ok = qn_false;
+    return ra_rdr;
+}
+
+// -------- Chunk Sizing (abbreviation: csz) --------
+
+// -- Each chunk costs a whole request, so the delay to cover is the minimum of request times, an upper
+//    bound of the RTT plus the turnaround of the server. The bandwidth is a moving average of the rest of
+//    request times. A chunk of several BDPs keeps the link busy for most of the delay it costs, and the
+//    chunk size grows from the first measurement by the same factor until the bandwidth is saturated.
+#define QN_STOR_CSZ_BDP_FACTOR 4
+
+// -- A chunk taking this many times longer than expected is handled like a timeout.
+#define QN_STOR_CSZ_LATE_FACTOR 4
+
+static inline qn_uint qn_stor_csz_round_chunk_size(qn_uint64 size)
+{
+    if (size < QN_STOR_RU_CHUNK_MIN_SIZE) size = QN_STOR_RU_CHUNK_MIN_SIZE;
+    if (size > QN_STOR_RU_BLOCK_MAX_SIZE) size = QN_STOR_RU_BLOCK_MAX_SIZE;
+    return (qn_uint)(size & ~((qn_uint64) QN_STOR_RU_CHUNK_MIN_SIZE - 1));
+}
+
+static inline qn_uint qn_stor_csz_bdp_chunk_size(qn_stor_chunk_sizing_ptr restrict csz)
+{
+    return qn_stor_csz_round_chunk_size(csz->bandwidth * csz->min_delay_us / 1000000 * QN_STOR_CSZ_BDP_FACTOR);
+}
+
+QN_SDK void qn_stor_csz_back_off(qn_stor_chunk_sizing_ptr restrict csz, qn_uint chk_size)
+{
+    assert(csz);
+
+    // -- Retry less data on a flaky link, and distrust the bandwidth measured before.
+    csz->chk_size = qn_stor_csz_round_chunk_size(chk_size / 2);
+    csz->bandwidth /= 2;
+}
+
+QN_SDK void qn_stor_csz_measure_chunk(qn_stor_chunk_sizing_ptr restrict csz, qn_uint32 opts, qn_uint chk_size, qn_uint64 total_us)
+{
+    qn_uint64 bw;
+    qn_uint target;
+    qn_bool late;
+
+    assert(csz);
+
+    if (total_us == 0) return;
+
+    late = (csz->bandwidth > 0 && total_us > (csz->min_delay_us + (qn_uint64) chk_size * 1000000 / csz->bandwidth) * QN_STOR_CSZ_LATE_FACTOR);
+
+    if (csz->min_delay_us == 0 || total_us < csz->min_delay_us) csz->min_delay_us = total_us;
+
+    if (total_us > csz->min_delay_us) {
+        bw = (qn_uint64) chk_size * 1000000 / (total_us - csz->min_delay_us);
+        csz->bandwidth = (csz->bandwidth == 0) ? bw : (csz->bandwidth * 7 + bw) / 8;
+    } else if (csz->bandwidth == 0) {
+        csz->bandwidth = (qn_uint64) chk_size * 1000000 / total_us;
+    } // if
+
+    if (! (opts & QN_STOR_RU_ADAPT_CHUNK_SIZE)) return;
+
+    if (late) {
+        qn_stor_csz_back_off(csz, chk_size);
+        return;
+    } // if
+
+    // -- Move towards the BDP target by at most a factor of 2 per chunk, so one odd measurement does not
+    //    swing the size from one end to the other.
+    if (csz->chk_size == 0) csz->chk_size = chk_size;
+    target = qn_stor_csz_bdp_chunk_size(csz);
+    if (target > csz->chk_size) {
+        csz->chk_size = (target < (qn_uint64) csz->chk_size * 2) ? target : qn_stor_csz_round_chunk_size((qn_uint64) csz->chk_size * 2);
+    } else if (target < csz->chk_size) {
+        csz->chk_size = (target > csz->chk_size / 2) ? target : qn_stor_csz_round_chunk_size(csz->chk_size / 2);
+    } // if
+}
+
+QN_SDK qn_uint qn_stor_csz_choose_chunk_size(qn_stor_chunk_sizing_ptr restrict csz, qn_uint32 opts, qn_uint chk_size, qn_uint rem_size)
+{
+    assert(csz);
+
+    if (chk_size == 0) chk_size = QN_STOR_RU_CHUNK_DEFAULT_SIZE;
+    if (opts & QN_STOR_RU_ADAPT_CHUNK_SIZE) {
+        if (csz->chk_size > 0) chk_size = csz->chk_size;
+    } else if ((opts & QN_STOR_RU_SIZE_CHUNKS_BY_BDP) && csz->bandwidth > 0) {
+        chk_size = qn_stor_csz_bdp_chunk_size(csz);
+    } // if
+    return (rem_size < chk_size) ? rem_size : chk_size;
+}
+
+static qn_bool qn_stor_ru_upload_prepared_chunks(qn_storage_ptr restrict stor, const char * restrict uptoken, qn_stor_resumable_upload_ptr ru, int blk_idx, qn_json_object_ptr blk_info, qn_io_reader_itf restrict sec_rdr, qn_stor_ru_chunk_preparer_ptr restrict cp, qn_uint chk_size, qn_stor_upload_extra_ptr restrict upe, pthread_mutex_t * lock, qn_json_object_ptr * up_ret)
+{
+    qn_integer offset;
+    qn_integer blk_size;
+    qn_json_object_ptr new_blk_info;
+    qn_stor_ru_chunk_ptr chk;
+    qn_uint32 opts = upe->ru_opts;
+
+    offset = qn_json_get_integer(blk_info, "offset", 0);
+    blk_size = qn_json_get_integer(blk_info, "bsize", 0);
+    if (offset < blk_size) qn_stor_ru_cp_request(cp, sec_rdr, qn_stor_csz_choose_chunk_size(&stor->csz, opts, chk_size, blk_size - offset));
+
+    while (offset < blk_size) {
+        if (! (chk = qn_stor_ru_cp_wait(cp))) return qn_false;
+
+        // ---- Prepare the next chunk while this one is being sent.
+        if (offset + chk->size < blk_size) qn_stor_ru_cp_request(cp, sec_rdr, qn_stor_csz_choose_chunk_size(&stor->csz, opts, chk_size, blk_size - offset - chk->size));
+
+        if (offset == 0) {
+            *up_ret = qn_stor_ru_api_mkblk(stor, uptoken, (qn_io_reader_itf) &chk->rdr_vtbl, blk_info, chk->size, upe);
+        } else {
+            *up_ret = qn_stor_ru_api_bput(stor, uptoken, (qn_io_reader_itf) &chk->rdr_vtbl, blk_info, chk->size, upe);
+        } // if
+        if (! *up_ret || qn_json_get_integer(*up_ret, "fn-code", -1) != 200) {
+            // -- Back off on failures of the connection or the server, but not on rejected requests.
+            if ((opts & QN_STOR_RU_ADAPT_CHUNK_SIZE) && (! *up_ret || qn_json_get_integer(*up_ret, "fn-code", -1) >= 500)) qn_stor_csz_back_off(&stor->csz, chk->size);
+            goto QN_STOR_RU_UPLOAD_PREPARED_CHUNKS_ERROR_HANDLING;
+        } // if
+
+        if (qn_json_get_integer(*up_ret, "crc32", -1) != chk->crc32) {
+            qn_err_stor_set_mismatching_crc32();
+            *up_ret = NULL;
+            goto QN_STOR_RU_UPLOAD_PREPARED_CHUNKS_ERROR_HANDLING;
+        } // if
+        qn_stor_csz_measure_chunk(&stor->csz, opts, chk->size, qn_http_resp_get_timing(stor->resp)->total_us);
+
+        qn_stor_ru_lock(lock);
+        new_blk_info = qn_stor_ru_update_block_info(ru, blk_idx, *up_ret);
+        qn_stor_ru_unlock(lock);
+        if (! (blk_info = new_blk_info)) {
+            *up_ret = NULL;
+            goto QN_STOR_RU_UPLOAD_PREPARED_CHUNKS_ERROR_HANDLING;
         } // if
+        offset = qn_json_get_integer(blk_info, "offset", 0);
+    } // while
+    return qn_true;
+
+QN_STOR_RU_UPLOAD_PREPARED_CHUNKS_ERROR_HANDLING:
+    // -- Wait for the next chunk, so the block reader is not used after being closed.
+    qn_stor_ru_cp_drain(cp);
+    return qn_false;
+}
+
+static qn_bool qn_stor_ru_upload_block(qn_storage_ptr restrict stor, const char * restrict uptoken, qn_stor_resumable_upload_ptr ru, int blk_idx, qn_io_section_reader_ptr restrict chk_rdr, qn_stor_ru_chunk_preparer_ptr restrict cp, qn_io_read_ahead_reader_ptr restrict ra_rdr, qn_uint chk_size, qn_stor_upload_extra_ptr restrict upe, pthread_mutex_t * lock, qn_json_object_ptr * up_ret)
+{
+    qn_integer offset;
+    qn_json_object_ptr blk_info;
+    qn_json_object_ptr new_blk_info;
+    qn_io_reader_itf sec_rdr;
+    qn_io_reader_itf blk_rdr;
+
+    *up_ret = NULL;
+    if (chk_size == 0) chk_size = QN_STOR_RU_CHUNK_DEFAULT_SIZE;
+
+    // ---- The progress object is shared by all workers, so touch it only with the lock held.
+    qn_stor_ru_lock(lock);
+    blk_info = qn_stor_ru_get_block_info(ru, blk_idx);
+    if (blk_info && qn_stor_ru_is_block_uploaded(blk_info)) {
+        qn_stor_ru_unlock(lock);
+        return qn_true;
+    } // if
+    sec_rdr = qn_stor_ru_create_block_reader(ru, blk_idx, &blk_info);
+    qn_stor_ru_unlock(lock);
+    if (! sec_rdr) return qn_false;
+
+    if (cp) {
+        if ((offset = qn_json_get_integer(blk_info, "offset", 0)) > 0 && ! qn_io_rdr_advance(sec_rdr, offset)) goto QN_STOR_RU_UPLOAD_BLOCK_ERROR_HANDLING;
+        if (! qn_stor_ru_upload_prepared_chunks(stor, uptoken, ru, blk_idx, blk_info, sec_rdr, cp, chk_size, upe, lock, up_ret)) goto QN_STOR_RU_UPLOAD_BLOCK_ERROR_HANDLING;
+
         qn_io_rdr_close(sec_rdr);
-    } // for
+        return qn_true;
+    } // if
 
-    qn_io_srdr_destroy(chk_rdr);
-    *start_idx = i;
-    return qn_stor_ru_api_mkfile(stor, uptoken, qn_stor_ru_to_context_reader(ru), blk_info, qn_stor_ru_uploaded_fsize(ru), upe);
+    if (ra_rdr) {
+        // -- Read the following chunks of the block while the current one is being sent.
+        qn_io_rardr_reset(ra_rdr, sec_rdr);
+        blk_rdr = qn_io_rardr_to_io_reader(ra_rdr);
+    } else {
+        blk_rdr = sec_rdr;
+    } // if
 
-QN_STOR_UPLOAD_HUGE_ERROR_HANDLING:
+    if ((offset = qn_json_get_integer(blk_info, "offset", 0)) == 0) {
+        qn_io_srdr_reset(chk_rdr, blk_rdr, chk_size);
+        *up_ret = qn_stor_ru_api_mkblk(stor, uptoken, qn_io_srdr_to_io_reader(chk_rdr), blk_info, chk_size, upe);
+        if (! *up_ret || qn_json_get_integer(*up_ret, "fn-code", -1) != 200) goto QN_STOR_RU_UPLOAD_BLOCK_ERROR_HANDLING;
+
+        qn_stor_ru_lock(lock);
+        new_blk_info = qn_stor_ru_update_block_info(ru, blk_idx, *up_ret);
+        qn_stor_ru_unlock(lock);
+        if (! (blk_info = new_blk_info)) {
+            *up_ret = NULL;
+            goto QN_STOR_RU_UPLOAD_BLOCK_ERROR_HANDLING;
+        } // if
+    } else if (! qn_io_rdr_advance(blk_rdr, offset)) {
+        goto QN_STOR_RU_UPLOAD_BLOCK_ERROR_HANDLING;
+    } // if
+
+    // ---- If the whole block is uploaded through the /mkblk API, skip all subsequent calls to the /bput API.
+    while (! qn_stor_ru_is_block_uploaded(blk_info)) {
+        qn_io_srdr_reset(chk_rdr, blk_rdr, chk_size);
+        *up_ret = qn_stor_ru_api_bput(stor, uptoken, qn_io_srdr_to_io_reader(chk_rdr), blk_info, chk_size, upe);
+        if (! *up_ret || qn_json_get_integer(*up_ret, "fn-code", -1) != 200) goto QN_STOR_RU_UPLOAD_BLOCK_ERROR_HANDLING;
+
+        qn_stor_ru_lock(lock);
+        new_blk_info = qn_stor_ru_update_block_info(ru, blk_idx, *up_ret);
+        qn_stor_ru_unlock(lock);
+        if (! (blk_info = new_blk_info)) {
+            *up_ret = NULL;
+            goto QN_STOR_RU_UPLOAD_BLOCK_ERROR_HANDLING;
+        } // if
+    } // while
+
+    if (ra_rdr) qn_io_rardr_reset(ra_rdr, NULL);
     qn_io_rdr_close(sec_rdr);
+    return qn_true;
+
+QN_STOR_RU_UPLOAD_BLOCK_ERROR_HANDLING:
+    if (ra_rdr) qn_io_rardr_reset(ra_rdr, NULL);
+    qn_io_rdr_close(sec_rdr);
+    return qn_false;
+}
+
+static qn_json_object_ptr qn_stor_ru_make_file(qn_storage_ptr restrict stor, const char * restrict uptoken, qn_stor_resumable_upload_ptr ru, qn_stor_upload_extra_ptr restrict upe)
+{
+    qn_json_object_ptr last_blk_info;
+
+    if (qn_stor_ru_get_block_count(ru) == 0 || ! (last_blk_info = qn_stor_ru_get_block_info(ru, qn_stor_ru_get_block_count(ru) - 1))) {
+        qn_err_stor_set_lack_of_block_info();
+        return NULL;
+    } // if
+    return qn_stor_ru_api_mkfile(stor, uptoken, qn_stor_ru_to_context_reader(ru), last_blk_info, qn_stor_ru_uploaded_fsize(ru), upe);
+}
+
+QN_SDK qn_json_object_ptr qn_stor_ru_upload_huge(qn_storage_ptr restrict stor, const char * restrict uptoken, qn_stor_resumable_upload_ptr ru, int * start_idx, qn_uint chk_size, qn_stor_upload_extra_ptr restrict upe)
+{
+    int i;
+    qn_bool ok;
+    qn_json_object_ptr up_ret;
+    qn_io_section_reader_ptr chk_rdr;
+    qn_stor_ru_chunk_preparer_ptr cp;
+    qn_io_read_ahead_reader_ptr ra_rdr;
+
+    // ---- Check preconditions.
+    assert(stor);
+    assert(uptoken);
+    assert(ru);
+    assert(0 <= *start_idx);
+    assert(! stor->eng);
+
+    // ---- Prepare internal objects.
+    
+    chk_rdr = qn_io_srdr_create(NULL, 0);
+    if (! chk_rdr) return NULL;
+
+    cp = qn_stor_ru_cp_create_for(upe, &ok);
+    if (! ok) {
+        qn_io_srdr_destroy(chk_rdr);
+        return NULL;
+    } // if
+
+    ra_rdr = qn_stor_ru_rardr_create_for(upe, cp, &ok);
+    if (! ok) {
+        qn_stor_ru_cp_destroy(cp);
+        qn_io_srdr_destroy(chk_rdr);
+        return NULL;
+    } // if
+
+    // ---- Start from the given index.
+    for (i = *start_idx; i < qn_stor_ru_get_block_count(ru); i += 1) {
+        if (! qn_stor_ru_upload_block(stor, uptoken, ru, i, chk_rdr, cp, ra_rdr, chk_size, upe, NULL, &up_ret)) {
+            qn_io_rardr_destroy(ra_rdr);
+            qn_stor_ru_cp_destroy(cp);
+            qn_io_srdr_destroy(chk_rdr);
+            *start_idx = i;
+            return up_ret;
+        } // if
+    } // for
+
+    qn_io_rardr_destroy(ra_rdr);
+    qn_stor_ru_cp_destroy(cp);
     qn_io_srdr_destroy(chk_rdr);
     *start_idx = i;
-    return up_ret;
+    return qn_stor_ru_make_file(stor, uptoken, ru, upe);
+}
+
+// ---- Concurrent upload of blocks (abbreviation: cu) ----
+
+typedef struct _QN_STOR_RU_CONCURRENT_UPLOAD
+{
+    pthread_mutex_t lock;
+    qn_stor_resumable_upload_ptr ru;
+    const char * uptoken;
+    qn_stor_upload_extra_ptr upe;
+    qn_uint chk_size;
+    int next_idx;
+    int fail_idx;
+    qn_err_code_em fail_code;
+    qn_storage_ptr fail_stor;
+    qn_json_object_ptr fail_ret;
+} qn_stor_ru_concurrent_upload_st, *qn_stor_ru_concurrent_upload_ptr;
+
+typedef struct _QN_STOR_RU_WORKER
+{
+    pthread_t tid;
+    qn_storage_ptr stor;
+    qn_io_section_reader_ptr chk_rdr;
+    qn_stor_ru_chunk_preparer_ptr cp;
+    qn_io_read_ahead_reader_ptr ra_rdr;
+    qn_stor_ru_concurrent_upload_ptr cu;
+    qn_bool running;
+} qn_stor_ru_worker_st, *qn_stor_ru_worker_ptr;
+
+static void * qn_stor_ru_worker_routine(void * arg)
+{
+    int blk_idx;
+    qn_json_object_ptr up_ret;
+    qn_stor_ru_worker_ptr wkr = (qn_stor_ru_worker_ptr) arg;
+    qn_stor_ru_concurrent_upload_ptr cu = wkr->cu;
+
+    while (1) {
+        // ---- Claim blocks in order, so that all blocks before the first failed one are uploaded when workers stop.
+        pthread_mutex_lock(&cu->lock);
+        blk_idx = cu->next_idx;
+        if (blk_idx < qn_stor_ru_get_block_count(cu->ru)) cu->next_idx += 1;
+        pthread_mutex_unlock(&cu->lock);
+
+        if (blk_idx >= qn_stor_ru_get_block_count(cu->ru)) break;
+
+        if (! qn_stor_ru_upload_block(wkr->stor, cu->uptoken, cu->ru, blk_idx, wkr->chk_rdr, wkr->cp, wkr->ra_rdr, cu->chk_size, cu->upe, &cu->lock, &up_ret)) {
+            pthread_mutex_lock(&cu->lock);
+            if (blk_idx < cu->fail_idx) {
+                cu->fail_idx = blk_idx;
+                cu->fail_code = qn_err_get_code();
+                cu->fail_stor = wkr->stor;
+                cu->fail_ret = up_ret;
+            } // if
+            // -- Stop other workers from claiming more blocks.
+            cu->next_idx = qn_stor_ru_get_block_count(cu->ru);
+            pthread_mutex_unlock(&cu->lock);
+            break;
+        } // if
+    } // while
+    return NULL;
+}
+
+QN_SDK qn_json_object_ptr qn_stor_ru_upload_huge_concurrently(qn_storage_ptr restrict stor, const char * restrict uptoken, qn_stor_resumable_upload_ptr ru, int * start_idx, qn_uint chk_size, int wkr_cnt, qn_stor_upload_extra_ptr restrict upe)
+{
+    int i;
+    qn_bool ok;
+    qn_stor_ru_concurrent_upload_st cu;
+    qn_stor_ru_worker_ptr wkrs;
+    qn_http_connection_pool_ptr pool;
+
+    // ---- Check preconditions.
+    assert(stor);
+    assert(uptoken);
+    assert(ru);
+    assert(0 <= *start_idx);
+    assert(! stor->eng);
+
+#if ! defined(QN_CFG_SHARED_FD_FOR_SECTIONS)
+    // -- Sections of one file share the same offset, so blocks cannot be read concurrently.
+    wkr_cnt = 1;
+#endif
+
+    if (wkr_cnt > qn_stor_ru_get_block_count(ru) - *start_idx) wkr_cnt = qn_stor_ru_get_block_count(ru) - *start_idx;
+    if (wkr_cnt <= 1) return qn_stor_ru_upload_huge(stor, uptoken, ru, start_idx, chk_size, upe);
+
+    // ---- Prepare internal objects.
+    memset(&cu, 0, sizeof(cu));
+    cu.ru = ru;
+    cu.uptoken = uptoken;
+    cu.upe = upe;
+    cu.chk_size = chk_size;
+    cu.next_idx = *start_idx;
+    cu.fail_idx = qn_stor_ru_get_block_count(ru);
+
+    wkrs = calloc(wkr_cnt, sizeof(qn_stor_ru_worker_st));
+    if (! wkrs) {
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+
+    if (pthread_mutex_init(&cu.lock, NULL) != 0) {
+        free(wkrs);
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+
+    // -- The calling thread works as the first worker on the given storage object.
+    wkrs[0].stor = stor;
+    for (i = 0; i < wkr_cnt; i += 1) {
+        wkrs[i].cu = &cu;
+        if (i > 0) {
+            if (! (wkrs[i].stor = qn_stor_create())) goto QN_STOR_RU_UPLOAD_HUGE_CONCURRENTLY_ERROR_HANDLING;
+            // -- Reuse DNS cache entries and TLS sessions of the caller if possible, but not its connections.
+            pool = qn_http_conn_get_pool(stor->conn);
+            if (pool && qn_http_pool_is_thread_safe(pool)) qn_stor_set_pool(wkrs[i].stor, pool);
+            // -- Start from the estimates of the caller's connection.
+            wkrs[i].stor->csz = stor->csz;
+        } // if
+        if (! (wkrs[i].chk_rdr = qn_io_srdr_create(NULL, 0))) goto QN_STOR_RU_UPLOAD_HUGE_CONCURRENTLY_ERROR_HANDLING;
+        wkrs[i].cp = qn_stor_ru_cp_create_for(upe, &ok);
+        if (! ok) goto QN_STOR_RU_UPLOAD_HUGE_CONCURRENTLY_ERROR_HANDLING;
+        wkrs[i].ra_rdr = qn_stor_ru_rardr_create_for(upe, wkrs[i].cp, &ok);
+        if (! ok) goto QN_STOR_RU_UPLOAD_HUGE_CONCURRENTLY_ERROR_HANDLING;
+    } // for
+
+    // ---- Upload blocks on independent connections.
+    for (i = 1; i < wkr_cnt; i += 1) {
+        // -- Go on with fewer workers if any thread cannot be created.
+        wkrs[i].running = (pthread_create(&wkrs[i].tid, NULL, &qn_stor_ru_worker_routine, &wkrs[i]) == 0);
+    } // for
+    qn_stor_ru_worker_routine(&wkrs[0]);
+    for (i = 1; i < wkr_cnt; i += 1) {
+        if (wkrs[i].running) pthread_join(wkrs[i].tid, NULL);
+    } // for
+
+    *start_idx = cu.fail_idx;
+    if (cu.fail_idx < qn_stor_ru_get_block_count(ru)) {
+        // -- Hand over the failed result to the given storage object, so the caller owns it as usual.
+        if (cu.fail_ret && cu.fail_stor != stor) {
+            if (stor->obj_body) qn_json_destroy_object(stor->obj_body);
+            stor->obj_body = cu.fail_stor->obj_body;
+            cu.fail_stor->obj_body = NULL;
+        } // if
+        if (! cu.fail_ret) qn_err_set_code(cu.fail_code, 0, __FILE__, __LINE__);
+        goto QN_STOR_RU_UPLOAD_HUGE_CONCURRENTLY_ERROR_HANDLING;
+    } // if
+
+    for (i = 0; i < wkr_cnt; i += 1) {
+        qn_io_rardr_destroy(wkrs[i].ra_rdr);
+        qn_stor_ru_cp_destroy(wkrs[i].cp);
+        qn_io_srdr_destroy(wkrs[i].chk_rdr);
+        if (i > 0) qn_stor_destroy(wkrs[i].stor);
+    } // for
+    free(wkrs);
+    pthread_mutex_destroy(&cu.lock);
+
+    // ---- Make the file with block contexts in order.
+    return qn_stor_ru_make_file(stor, uptoken, ru, upe);
+
+QN_STOR_RU_UPLOAD_HUGE_CONCURRENTLY_ERROR_HANDLING:
+    for (i = 0; i < wkr_cnt; i += 1) {
+        qn_io_rardr_destroy(wkrs[i].ra_rdr);
+        qn_stor_ru_cp_destroy(wkrs[i].cp);
+        if (wkrs[i].chk_rdr) qn_io_srdr_destroy(wkrs[i].chk_rdr);
+        if (i > 0 && wkrs[i].stor) qn_stor_destroy(wkrs[i].stor);
+    } // for
+    free(wkrs);
+    pthread_mutex_destroy(&cu.lock);
+    return cu.fail_ret;
+}
+
+// -------- Download Extra (abbreviation: dne) --------
+
+typedef struct _QN_STOR_DOWNLOAD_EXTRA
+{
+    unsigned int check_qetag:1;
+    const char * qetag;
+    qn_rgn_entry_ptr rgn_entry;
+} qn_stor_download_extra_st;
+
+QN_SDK qn_stor_download_extra_ptr qn_stor_dne_create(void)
+{
+    qn_stor_download_extra_ptr new_dne = calloc(1, sizeof(qn_stor_download_extra_st));
+    if (! new_dne) {
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+    return new_dne;
+}
+
+QN_SDK void qn_stor_dne_destroy(qn_stor_download_extra_ptr restrict dne)
+{
+    if (dne) {
+        free(dne);
+    } // if
+}
+
+QN_SDK void qn_stor_dne_reset(qn_stor_download_extra_ptr restrict dne)
+{
+    memset(dne, 0, sizeof(qn_stor_download_extra_st));
+}
+
+QN_SDK void qn_stor_dne_set_region_entry(qn_stor_download_extra_ptr restrict dne, qn_rgn_entry_ptr restrict entry)
+{
+    dne->rgn_entry = entry;
+}
+
+QN_SDK void qn_stor_dne_set_qetag_checking(qn_stor_download_extra_ptr restrict dne, qn_bool check)
+{
+    dne->check_qetag = (check) ? 1 : 0;
+}
+
+QN_SDK void qn_stor_dne_set_expected_qetag(qn_stor_download_extra_ptr restrict dne, const char * restrict qetag)
+{
+    dne->qetag = qetag;
+}
+
+// -------- Ranged Download Object (abbreviation: dn) --------
+
+typedef struct _QN_STOR_DOWNLOAD
+{
+    qn_string url;
+    qn_string etag;   // The ETag seen first, to find out whether the file changes between sessions.
+    char * rng_sts;   // One '0' or '1' for each range, saved as is in the progress record.
+    int rng_cnt;
+    qn_uint rng_size;
+    qn_fsize fsize;
+    qn_fsize downloaded_fsize;
+} qn_stor_download_st;
+
+static inline qn_uint qn_stor_dn_range_size(qn_stor_download_ptr restrict dn, int rng_idx)
+{
+    qn_fsize offset = (qn_fsize) rng_idx * dn->rng_size;
+    return (dn->fsize - offset < dn->rng_size) ? (qn_uint)(dn->fsize - offset) : dn->rng_size;
+}
+
+static qn_stor_download_ptr qn_stor_dn_allocate(qn_fsize fsize, qn_uint rng_size)
+{
+    qn_stor_download_ptr new_dn = calloc(1, sizeof(qn_stor_download_st));
+    if (! new_dn) {
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+
+    new_dn->fsize = fsize;
+    new_dn->rng_size = rng_size;
+    new_dn->rng_cnt = (fsize + rng_size - 1) / rng_size;
+
+    new_dn->rng_sts = malloc(new_dn->rng_cnt + 1);
+    if (! new_dn->rng_sts) {
+        free(new_dn);
+        qn_err_set_out_of_memory();
+        return NULL;
+    } // if
+    memset(new_dn->rng_sts, '0', new_dn->rng_cnt);
+    new_dn->rng_sts[new_dn->rng_cnt] = '\0';
+    return new_dn;
+}
+
+/***************************************************************************//**
+* @ingroup Storage-Download
+*
+* Create a ranged download object which holds the progress of downloading a
+* file.
+*
+* @param [in] url The URL of the file, made by qn_mac_make_dnurl() for files
+*                 in private buckets.
+* @param [in] fsize The size of the file, usually taken from the result of
+*                   qn_stor_mn_api_stat().
+* @param [in] rng_size The size of each range, or 0 to use the default size.
+*
+* @retval non-NULL The pointer to the new download object.
+* @retval NULL Failed in creating the object.
+*
+* @remark The file is split into ranges of the same size except the last one.
+*         Call qn_stor_dn_to_string() to save the progress after a failed
+*         download, and qn_stor_dn_from_string() to resume it later.
+*******************************************************************************/
+QN_SDK qn_stor_download_ptr qn_stor_dn_create(const char * restrict url, qn_fsize fsize, qn_uint rng_size)
+{
+    qn_stor_download_ptr new_dn;
+
+    assert(url);
+
+    if (rng_size == 0) rng_size = QN_STOR_DN_RANGE_DEFAULT_SIZE;
+    if (rng_size < QN_STOR_DN_RANGE_MIN_SIZE) rng_size = QN_STOR_DN_RANGE_MIN_SIZE;
+
+    if (! (new_dn = qn_stor_dn_allocate(fsize, rng_size))) return NULL;
+    if (! (new_dn->url = qn_cs_duplicate(url))) {
+        qn_stor_dn_destroy(new_dn);
+        return NULL;
+    } // if
+    return new_dn;
+}
+
+QN_SDK void qn_stor_dn_destroy(qn_stor_download_ptr restrict dn)
+{
+    if (dn) {
+        if (dn->url) qn_str_destroy(dn->url);
+        if (dn->etag) qn_str_destroy(dn->etag);
+        free(dn->rng_sts);
+        free(dn);
+    } // if
+}
+
+QN_SDK qn_string qn_stor_dn_to_string(qn_stor_download_ptr restrict dn)
+{
+    qn_json_object_ptr progress;
+    qn_string fsize_str;
+    qn_string ret = NULL;
+
+    assert(dn);
+
+    if (! (progress = qn_json_create_object())) return NULL;
+
+    if (! qn_json_set_cstr(progress, "url", qn_str_cstr(dn->url))) goto QN_STOR_DN_TO_STRING_CLEANUP;
+
+    if (! (fsize_str = qn_type_fsize_to_string(dn->fsize))) goto QN_STOR_DN_TO_STRING_CLEANUP;
+    if (! qn_json_set_text(progress, "fsize", qn_str_cstr(fsize_str), qn_str_size(fsize_str))) {
+        qn_str_destroy(fsize_str);
+        goto QN_STOR_DN_TO_STRING_CLEANUP;
+    } // if
+    qn_str_destroy(fsize_str);
+
+    if (! qn_json_set_integer(progress, "rsize", dn->rng_size)) goto QN_STOR_DN_TO_STRING_CLEANUP;
+    if (! qn_json_set_text(progress, "ranges", dn->rng_sts, dn->rng_cnt)) goto QN_STOR_DN_TO_STRING_CLEANUP;
+    if (dn->etag && ! qn_json_set_cstr(progress, "etag", qn_str_cstr(dn->etag))) goto QN_STOR_DN_TO_STRING_CLEANUP;
+
+    ret = qn_json_object_to_string(progress);
+
+QN_STOR_DN_TO_STRING_CLEANUP:
+    qn_json_destroy_object(progress);
+    return ret;
+}
+
+QN_SDK qn_stor_download_ptr qn_stor_dn_from_string(const char * restrict str, qn_size str_len)
+{
+    qn_json_object_ptr progress;
+    qn_string url;
+    qn_string fsize_str;
+    qn_string rng_sts;
+    qn_string etag;
+    qn_json_integer rng_size;
+    qn_fsize fsize;
+    qn_stor_download_ptr dn = NULL;
+    int i;
+
+    assert(str && str_len > 0);
+
+    if (! (progress = qn_json_object_from_string(str, str_len))) return NULL;
+
+    url = qn_json_get_string(progress, "url", NULL);
+    fsize_str = qn_json_get_string(progress, "fsize", NULL);
+    rng_size = qn_json_get_integer(progress, "rsize", 0);
+    rng_sts = qn_json_get_string(progress, "ranges", NULL);
+    etag = qn_json_get_string(progress, "etag", NULL);
+    if (! url || ! fsize_str || ! rng_sts || rng_size < QN_STOR_DN_RANGE_MIN_SIZE || (fsize = atoll(qn_str_cstr(fsize_str))) < 0) {
+        qn_err_stor_set_invalid_resumable_session_information();
+        goto QN_STOR_DN_FROM_STRING_ERROR_HANDLING;
+    } // if
+
+    if (! (dn = qn_stor_dn_allocate(fsize, rng_size))) goto QN_STOR_DN_FROM_STRING_ERROR_HANDLING;
+    if (qn_str_size(rng_sts) != dn->rng_cnt) {
+        qn_err_stor_set_invalid_resumable_session_information();
+        goto QN_STOR_DN_FROM_STRING_ERROR_HANDLING;
+    } // if
+
+    for (i = 0; i < dn->rng_cnt; i += 1) {
+        if (qn_str_cstr(rng_sts)[i] == '1') {
+            dn->rng_sts[i] = '1';
+            dn->downloaded_fsize += qn_stor_dn_range_size(dn, i);
+        } else if (qn_str_cstr(rng_sts)[i] != '0') {
+            qn_err_stor_set_invalid_resumable_session_information();
+            goto QN_STOR_DN_FROM_STRING_ERROR_HANDLING;
+        } // if
+    } // for
+
+    if (! (dn->url = qn_str_duplicate(url))) goto QN_STOR_DN_FROM_STRING_ERROR_HANDLING;
+    if (etag && ! (dn->etag = qn_str_duplicate(etag))) goto QN_STOR_DN_FROM_STRING_ERROR_HANDLING;
+
+    qn_json_destroy_object(progress);
+    return dn;
+
+QN_STOR_DN_FROM_STRING_ERROR_HANDLING:
+    qn_stor_dn_destroy(dn);
+    qn_json_destroy_object(progress);
+    return NULL;
+}
+
+// -- Download URLs of private files expire, so a resumed session may go on with a new one.
+QN_SDK qn_bool qn_stor_dn_set_url(qn_stor_download_ptr restrict dn, const char * restrict url)
+{
+    qn_string new_url;
+
+    assert(dn);
+    assert(url);
+
+    if (! (new_url = qn_cs_duplicate(url))) return qn_false;
+    qn_str_destroy(dn->url);
+    dn->url = new_url;
+    return qn_true;
+}
+
+QN_SDK int qn_stor_dn_get_range_count(qn_stor_download_ptr restrict dn)
+{
+    assert(dn);
+    return dn->rng_cnt;
+}
+
+QN_SDK qn_bool qn_stor_dn_is_range_downloaded(qn_stor_download_ptr restrict dn, int rng_idx)
+{
+    assert(dn);
+    assert(0 <= rng_idx && rng_idx < dn->rng_cnt);
+    return dn->rng_sts[rng_idx] == '1';
+}
+
+QN_SDK qn_fsize qn_stor_dn_total_fsize(qn_stor_download_ptr restrict dn)
+{
+    assert(dn);
+    return dn->fsize;
+}
+
+QN_SDK qn_fsize qn_stor_dn_downloaded_fsize(qn_stor_download_ptr restrict dn)
+{
+    assert(dn);
+    return dn->downloaded_fsize;
+}
+
+QN_SDK qn_bool qn_stor_dn_is_file_downloaded(qn_stor_download_ptr restrict dn)
+{
+    assert(dn);
+    return dn->downloaded_fsize == dn->fsize;
+}
+
+// -------- Ranged Download Functions (abbreviation: dn) --------
+
+typedef struct _QN_STOR_DN_CONCURRENT_DOWNLOAD
+{
+    pthread_mutex_t lock;
+    qn_stor_download_ptr dn;
+    qn_file_ptr fl;
+    qn_string url;
+    qn_string host;
+    int next_idx;
+    qn_bool failed;
+    qn_err_code_em fail_code;
+    qn_storage_ptr fail_stor;
+    qn_json_object_ptr fail_ret;
+} qn_stor_dn_concurrent_download_st, *qn_stor_dn_concurrent_download_ptr;
+
+typedef struct _QN_STOR_DN_WORKER
+{
+    pthread_t tid;
+    qn_storage_ptr stor;
+    qn_stor_dn_concurrent_download_ptr cd;
+    qn_bool running;
+} qn_stor_dn_worker_st, *qn_stor_dn_worker_ptr;
+
+typedef struct _QN_STOR_DN_RANGE_WRITER
+{
+    qn_storage_ptr stor;
+    qn_file_ptr fl;
+    qn_foffset offset;
+    qn_uint size;
+    qn_uint written;
+    unsigned int whole:1; // The range covers the whole file, so a 200 response carries the same data.
+} qn_stor_dn_range_writer_st, *qn_stor_dn_range_writer_ptr;
+
+static size_t qn_stor_dn_range_write_cfn(void * user_data, char * buf, size_t buf_size)
+{
+    qn_stor_dn_range_writer_ptr rw = (qn_stor_dn_range_writer_ptr) user_data;
+    int code = qn_http_resp_get_code(rw->stor->resp);
+
+    if (code != 206 && code != 200) {
+        // -- Parse the error message if any, the response code tells what happens even if the body is not JSON.
+        qn_http_json_wrt_write_cfn(rw->stor->resp_json_wrt, buf, buf_size);
+        return buf_size;
+    } // if
+
+    if ((code == 200 && ! rw->whole) || buf_size > rw->size - rw->written) {
+        qn_err_stor_set_unexpected_download_range();
+        return 0;
+    } // if
+
+    // ---- Write data in place, so ranges can arrive in any order.
+    if (! qn_fl_pwrite(rw->fl, buf, buf_size, rw->offset + rw->written)) return 0;
+    rw->written += buf_size;
+    return buf_size;
+}
+
+static qn_bool qn_stor_dn_check_etag(qn_stor_download_ptr restrict dn, const char * restrict etag)
+{
+    qn_size etag_size;
+
+    // -- Nothing to check if the server does not return it.
+    if (! etag) return qn_true;
+
+    etag_size = posix_strlen(etag);
+    if (etag_size >= 2 && etag[0] == '"' && etag[etag_size - 1] == '"') {
+        etag += 1;
+        etag_size -= 2;
+    } // if
+
+    if (! dn->etag) return (dn->etag = qn_cs_clone(etag, etag_size)) != NULL;
+    if (qn_str_size(dn->etag) == etag_size && memcmp(qn_str_cstr(dn->etag), etag, etag_size) == 0) return qn_true;
+
+    // -- The file has changed since the first range was downloaded.
+    qn_err_stor_set_mismatching_qetag();
+    return qn_false;
+}
+
+static qn_bool qn_stor_dn_download_range(qn_storage_ptr restrict stor, qn_stor_dn_concurrent_download_ptr restrict cd, int rng_idx, qn_json_object_ptr * dn_ret)
+{
+    qn_stor_dn_range_writer_st rw;
+    qn_stor_download_ptr dn = cd->dn;
+    qn_bool ok;
+    int code;
+
+    *dn_ret = NULL;
+
+    rw.stor = stor;
+    rw.fl = cd->fl;
+    rw.offset = (qn_foffset) rng_idx * dn->rng_size;
+    rw.size = qn_stor_dn_range_size(dn, rng_idx);
+    rw.written = 0;
+    rw.whole = (rw.size == dn->fsize) ? 1 : 0;
+
+    // ---- Prepare the request and response.
+    qn_stor_reset(stor);
+
+    if (! qn_stor_prepare_common_request_headers(stor)) return qn_false;
+    if (cd->host && ! qn_http_req_set_header(stor->req, "Host", qn_str_cstr(cd->host))) return qn_false;
+
+    qn_str_bld_reset(stor->tmp_bld);
+    if (! qn_str_bld_append_raw(stor->tmp_bld, "bytes=", 6)) return qn_false;
+    if (! qn_str_bld_append_integer(stor->tmp_bld, rw.offset)) return qn_false;
+    if (! qn_str_bld_append_raw(stor->tmp_bld, "-", 1)) return qn_false;
+    if (! qn_str_bld_append_integer(stor->tmp_bld, rw.offset + rw.size - 1)) return qn_false;
+    if (! qn_http_req_set_header(stor->req, "Range", qn_str_bld_cstr(stor->tmp_bld))) return qn_false;
+
+    if (! (stor->obj_body = qn_json_create_object())) return qn_false;
+    if (! qn_stor_prepare_error_info(stor)) return qn_false;
+
+    qn_http_json_wrt_prepare(stor->resp_json_wrt, &stor->obj_body, NULL);
+    qn_http_resp_set_stream_writer(stor->resp, &rw, &qn_stor_dn_range_write_cfn);
+
+    // ---- Do the download action.
+    if (! (*dn_ret = qn_stor_do_request(stor, QN_MTR_API_DOWNLOAD, qn_str_cstr(cd->url), qn_false, &qn_stor_rename_error_info))) return qn_false;
+
+    code = qn_http_resp_get_code(stor->resp);
+    if (code != 206 && code != 200) return qn_false;
+
+    if (rw.written != rw.size) {
+        *dn_ret = NULL;
+        qn_err_stor_set_unexpected_download_range();
+        return qn_false;
+    } // if
+
+    pthread_mutex_lock(&cd->lock);
+    ok = qn_stor_dn_check_etag(dn, qn_http_resp_get_header(stor->resp, "ETag"));
+    if (ok) {
+        dn->rng_sts[rng_idx] = '1';
+        dn->downloaded_fsize += rw.size;
+    } // if
+    pthread_mutex_unlock(&cd->lock);
+
+    if (! ok) *dn_ret = NULL;
+    return ok;
+}
+
+static void * qn_stor_dn_worker_routine(void * arg)
+{
+    int rng_idx;
+    qn_json_object_ptr dn_ret;
+    qn_stor_dn_worker_ptr wkr = (qn_stor_dn_worker_ptr) arg;
+    qn_stor_dn_concurrent_download_ptr cd = wkr->cd;
+
+    while (1) {
+        pthread_mutex_lock(&cd->lock);
+        // -- Skip ranges downloaded in previous sessions.
+        while (cd->next_idx < cd->dn->rng_cnt && cd->dn->rng_sts[cd->next_idx] == '1') cd->next_idx += 1;
+        rng_idx = cd->next_idx;
+        if (rng_idx < cd->dn->rng_cnt) cd->next_idx += 1;
+        pthread_mutex_unlock(&cd->lock);
+
+        if (rng_idx >= cd->dn->rng_cnt) break;
+
+        if (! qn_stor_dn_download_range(wkr->stor, cd, rng_idx, &dn_ret)) {
+            pthread_mutex_lock(&cd->lock);
+            if (! cd->failed) {
+                cd->failed = qn_true;
+                cd->fail_code = qn_err_get_code();
+                cd->fail_stor = wkr->stor;
+                cd->fail_ret = dn_ret;
+            } // if
+            // -- Stop other workers from claiming more ranges.
+            cd->next_idx = cd->dn->rng_cnt;
+            pthread_mutex_unlock(&cd->lock);
+            break;
+        } // if
+    } // while
+    return NULL;
+}
+
+static qn_bool qn_stor_dn_prepare_url(qn_stor_dn_concurrent_download_ptr restrict cd, qn_stor_download_extra_ptr restrict dne)
+{
+    const char * url = qn_str_cstr(cd->dn->url);
+    const char * host;
+    const char * path;
+
+    if (! dne || ! dne->rgn_entry) return (cd->url = qn_str_duplicate(cd->dn->url)) != NULL;
+
+    // ---- Send requests to the given entry, with the host of the URL unless the entry has its own one.
+    host = strstr(url, "://");
+    host = (host) ? host + 3 : url;
+    path = strchr(host, '/');
+    if (! path) path = host + posix_strlen(host);
+
+    if (! (cd->url = qn_cs_sprintf("%s%s", qn_str_cstr(dne->rgn_entry->base_url), path))) return qn_false;
+    cd->host = (dne->rgn_entry->hostname) ? qn_str_duplicate(dne->rgn_entry->hostname) : qn_cs_clone(host, path - host);
+    return cd->host != NULL;
+}
+
+static qn_json_object_ptr qn_stor_dn_make_result(qn_storage_ptr restrict stor, qn_stor_download_ptr restrict dn, const char * restrict fname, qn_stor_download_extra_ptr restrict dne)
+{
+    qn_string qetag = NULL;
+    const char * expected_qetag;
+
+    if (dne && (dne->check_qetag || dne->qetag)) {
+        if (! (qetag = qn_etag_digest_file(fname))) return NULL;
+
+        expected_qetag = (dne->qetag) ? dne->qetag : ((dn->etag) ? qn_str_cstr(dn->etag) : NULL);
+        if (expected_qetag && strcmp(qn_str_cstr(qetag), expected_qetag) != 0) {
+            // -- Unknown which ranges are broken, so download all of them again in the next session.
+            memset(dn->rng_sts, '0', dn->rng_cnt);
+            dn->downloaded_fsize = 0;
+
+            qn_str_destroy(qetag);
+            qn_err_stor_set_mismatching_qetag();
+            return NULL;
+        } // if
+    } // if
+
+    qn_stor_reset(stor);
+
+    if (! (stor->obj_body = qn_json_create_object())) goto QN_STOR_DN_MAKE_RESULT_ERROR_HANDLING;
+    if (! qn_json_set_integer(stor->obj_body, "fn-code", 200)) goto QN_STOR_DN_MAKE_RESULT_ERROR_HANDLING;
+    if (! qn_json_set_cstr(stor->obj_body, "fn-error", "OK")) goto QN_STOR_DN_MAKE_RESULT_ERROR_HANDLING;
+    if (! qn_json_set_integer(stor->obj_body, "fsize", dn->fsize)) goto QN_STOR_DN_MAKE_RESULT_ERROR_HANDLING;
+    if (qetag && ! qn_json_set_cstr(stor->obj_body, "hash", qn_str_cstr(qetag))) goto QN_STOR_DN_MAKE_RESULT_ERROR_HANDLING;
+
+    if (qetag) qn_str_destroy(qetag);
+    return stor->obj_body;
+
+QN_STOR_DN_MAKE_RESULT_ERROR_HANDLING:
+    if (qetag) qn_str_destroy(qetag);
+    return NULL;
+}
+
+/***************************************************************************//**
+* @ingroup Storage-Download
+*
+* Download a file by ranges concurrently, and assemble them into a local file.
+*
+* @param [in] stor The pointer to the storage object.
+* @param [in] dn The pointer to the ranged download object which holds the
+*                URL and the progress of the file.
+* @param [in] fname The path of the local file, which will be created if it
+*                   does not exist.
+* @param [in] wkr_cnt The number of ranges to download at the same time.
+* @param [in] dne The pointer to an extra option structure, or NULL.
+*
+* @retval non-NULL The pointer to a result object, or the error message object
+*                  of the first failed range (see the REMARK section).
+* @retval NULL An application error occurs in downloading the file.
+*
+* @remark The local file is extended to the full size first, then each worker
+*         fetches a range on its own connection with a `Range` header and
+*         writes the data in place by qn_fl_pwrite(). Workers other than the
+*         calling thread share DNS cache entries and TLS sessions of the given
+*         storage object's pool if it is attached to a thread-safe one.
+*
+*         Ranges downloaded in previous sessions are skipped, so save the
+*         progress by qn_stor_dn_to_string() after a failure and call this
+*         function again with the same local file to resume.
+*
+*         If QETAG checking is enabled, the function computes the QETAG of
+*         the local file and compares it with the expected one, or with the
+*         ETag returned by the server if none is set. A mismatch resets the
+*         progress and fails with QN_ERR_STOR_MISMATCHING_QETAG.
+*
+*         If succeeds, the function returns a result object as follows:
+*
+*         ```
+*             {
+*                 "fn-code": 200,
+*                 "fn-error": "OK",
+*                 "fsize": <File's size in bytes>,
+*                 "hash": "<File's QETAG, only if QETAG checking is enabled>"
+*             }
+*         ```
+*
+*         **NOTE**: The function MUST NOT be called in asynchronous mode.
+*******************************************************************************/
+QN_SDK qn_json_object_ptr qn_stor_dn_download_file(qn_storage_ptr restrict stor, qn_stor_download_ptr restrict dn, const char * restrict fname, int wkr_cnt, qn_stor_download_extra_ptr restrict dne)
+{
+    int i;
+    int rem_cnt;
+    qn_fl_open_extra ext;
+    qn_json_object_ptr ret = NULL;
+    qn_stor_dn_concurrent_download_st cd;
+    qn_stor_dn_worker_ptr wkrs = NULL;
+    qn_http_connection_pool_ptr pool;
+
+    // ---- Check preconditions.
+    assert(stor);
+    assert(dn);
+    assert(fname);
+    assert(! stor->eng);
+
+    // ---- Prepare internal objects.
+    memset(&cd, 0, sizeof(cd));
+    cd.dn = dn;
+
+    if (! qn_stor_dn_prepare_url(&cd, dne)) goto QN_STOR_DN_DOWNLOAD_FILE_CLEANUP;
+
+    memset(&ext, 0, sizeof(ext));
+    ext.flags = QN_FL_OPEN_WRITE;
+    if (! (cd.fl = qn_fl_open(fname, &ext))) goto QN_STOR_DN_DOWNLOAD_FILE_CLEANUP;
+
+    // -- Extend the file to the full size first, it keeps data of downloaded ranges in a resumed session.
+    if (! qn_fl_allocate(cd.fl, dn->fsize)) goto QN_STOR_DN_DOWNLOAD_FILE_CLEANUP;
+
+    for (rem_cnt = 0, i = 0; i < dn->rng_cnt; i += 1) {
+        if (dn->rng_sts[i] == '0') rem_cnt += 1;
+    } // for
+    if (wkr_cnt > rem_cnt) wkr_cnt = rem_cnt;
+    if (wkr_cnt < 1) wkr_cnt = 1;
+
+    wkrs = calloc(wkr_cnt, sizeof(qn_stor_dn_worker_st));
+    if (! wkrs) {
+        qn_err_set_out_of_memory();
+        goto QN_STOR_DN_DOWNLOAD_FILE_CLEANUP;
+    } // if
+
+    if (pthread_mutex_init(&cd.lock, NULL) != 0) {
+        free(wkrs);
+        wkrs = NULL;
+        qn_err_set_out_of_memory();
+        goto QN_STOR_DN_DOWNLOAD_FILE_CLEANUP;
+    } // if
+
+    // -- The calling thread works as the first worker on the given storage object.
+    wkrs[0].stor = stor;
+    for (i = 0; i < wkr_cnt; i += 1) {
+        wkrs[i].cd = &cd;
+        if (i > 0) {
+            if (! (wkrs[i].stor = qn_stor_create())) goto QN_STOR_DN_DOWNLOAD_FILE_CLEANUP;
+            // -- Reuse DNS cache entries and TLS sessions of the caller if possible, but not its connections.
+            pool = qn_http_conn_get_pool(stor->conn);
+            if (pool && qn_http_pool_is_thread_safe(pool)) qn_stor_set_pool(wkrs[i].stor, pool);
+        } // if
+    } // for
+
+    // ---- Download ranges on independent connections.
+    for (i = 1; i < wkr_cnt; i += 1) {
+        // -- Go on with fewer workers if any thread cannot be created.
+        wkrs[i].running = (pthread_create(&wkrs[i].tid, NULL, &qn_stor_dn_worker_routine, &wkrs[i]) == 0);
+    } // for
+    qn_stor_dn_worker_routine(&wkrs[0]);
+    for (i = 1; i < wkr_cnt; i += 1) {
+        if (wkrs[i].running) pthread_join(wkrs[i].tid, NULL);
+    } // for
+
+    if (cd.failed) {
+        // -- Hand over the failed result to the given storage object, so the caller owns it as usual.
+        if (cd.fail_ret && cd.fail_stor != stor) {
+            if (stor->obj_body) qn_json_destroy_object(stor->obj_body);
+            stor->obj_body = cd.fail_stor->obj_body;
+            cd.fail_stor->obj_body = NULL;
+        } // if
+        ret = cd.fail_ret;
+        if (! ret) qn_err_set_code(cd.fail_code, 0, __FILE__, __LINE__);
+        goto QN_STOR_DN_DOWNLOAD_FILE_CLEANUP;
+    } // if
+
+    qn_fl_close(cd.fl);
+    cd.fl = NULL;
+
+    // ---- Verify the file and make the result.
+    ret = qn_stor_dn_make_result(stor, dn, fname, dne);
+
+QN_STOR_DN_DOWNLOAD_FILE_CLEANUP:
+    if (wkrs) {
+        for (i = 1; i < wkr_cnt; i += 1) {
+            if (wkrs[i].stor) qn_stor_destroy(wkrs[i].stor);
+        } // for
+        free(wkrs);
+        pthread_mutex_destroy(&cd.lock);
+    } // if
+    if (cd.fl) qn_fl_close(cd.fl);
+    if (cd.host) qn_str_destroy(cd.host);
+    if (cd.url) qn_str_destroy(cd.url);
+    return ret;
 }
 
 #ifdef __cplusplus
@@ -16,6 +16,7 @@
 #include "qiniu/base/io.h"
 #include "qiniu/base/json.h"
 #include "qiniu/auth.h"
+#include "qiniu/etag.h"
 #include "qiniu/http.h"
 #include "qiniu/region.h"
 #include "qiniu/reader.h"
@@ -41,6 +42,11 @@ QN_SDK extern qn_json_object_ptr qn_stor_get_object_body(const qn_storage_ptr re
 QN_SDK extern qn_json_array_ptr qn_stor_get_array_body(const qn_storage_ptr restrict stor);
 QN_SDK extern qn_http_hdr_iterator_ptr qn_stor_resp_get_header_iterator(const qn_storage_ptr restrict stor);
 
+typedef void (*qn_stor_done_callback_fn)(void * restrict user_data, qn_storage_ptr restrict stor, qn_json_object_ptr restrict ret);
+
+QN_SDK extern void qn_stor_set_pool(qn_storage_ptr restrict stor, qn_http_connection_pool_ptr restrict pool);
+QN_SDK extern void qn_stor_set_engine(qn_storage_ptr restrict stor, qn_http_engine_ptr restrict eng, qn_stor_done_callback_fn done_cb, void * restrict user_data);
+
 // -------- Management Extra (abbreviation: mne) --------
 
 struct _QN_STOR_MANAGEMENT_EXTRA;
@@ -92,6 +98,10 @@ QN_SDK extern void qn_stor_lse_set_prefix(qn_stor_list_extra_ptr restrict lse, c
 QN_SDK extern void qn_stor_lse_set_marker(qn_stor_list_extra_ptr restrict lse, const char * restrict marker);
 QN_SDK extern void qn_stor_lse_set_limit(qn_stor_list_extra_ptr restrict lse, qn_uint32 limit);
 
+typedef qn_bool (*qn_stor_lse_item_callback_fn)(void * restrict itm_data, qn_json_object_ptr restrict item);
+
+QN_SDK extern void qn_stor_lse_set_item_callback(qn_stor_list_extra_ptr restrict lse, void * restrict itm_data, qn_stor_lse_item_callback_fn itm_cb);
+
 // -------- List Functions (abbreviation: ls) --------
 
 QN_SDK extern qn_json_object_ptr qn_stor_ls_api_list(qn_storage_ptr restrict stor, const qn_mac_ptr restrict mac, const char * restrict bucket, qn_stor_list_extra_ptr restrict lse);
@@ -165,6 +175,13 @@ QN_SDK extern void qn_stor_upe_set_local_crc32(qn_stor_upload_extra_ptr restrict
 QN_SDK extern void qn_stor_upe_set_accept_type(qn_stor_upload_extra_ptr restrict upe, const char * restrict accept_type);
 QN_SDK extern void qn_stor_upe_set_user_defined_variables(qn_stor_upload_extra_ptr restrict upe, qn_ud_variable_ptr ud_vars);
 QN_SDK extern void qn_stor_upe_set_region_entry(qn_stor_upload_extra_ptr restrict upe, qn_rgn_entry_ptr restrict entry);
+QN_SDK extern void qn_stor_upe_set_crc32_checking(qn_stor_upload_extra_ptr restrict upe, qn_bool check);
+QN_SDK extern void qn_stor_upe_set_qetag_context(qn_stor_upload_extra_ptr restrict upe, qn_etag_context_ptr restrict ctx);
+QN_SDK extern void qn_stor_upe_set_resumable_options(qn_stor_upload_extra_ptr restrict upe, qn_uint32 opts);
+
+// -- Read the body ahead on a helper thread with `depth` buffers of `buf_size` bytes, for uploads from readers
+//    and chunks of resumable uploads not pipelined. A depth of 0 disables it, which is the default.
+QN_SDK extern void qn_stor_upe_set_read_ahead(qn_stor_upload_extra_ptr restrict upe, qn_size buf_size, int depth);
 
 // -------- Ordinary Upload (abbreviation: up) --------
 
@@ -177,11 +194,20 @@ QN_SDK extern qn_json_object_ptr qn_stor_up_api_upload(qn_storage_ptr restrict s
 
 enum
 {
+    QN_STOR_RU_CHUNK_MIN_SIZE = (1024 * 64),
     QN_STOR_RU_CHUNK_DEFAULT_SIZE = (1024 * 256),
     QN_STOR_RU_BLOCK_MAX_SIZE = (1024 * 1024 * 4),
     QN_STOR_RU_BLOCK_LAST_INDEX = (-1)
 };
 
+// -- Options of resumable uploads, set by qn_stor_upe_set_resumable_options().
+enum
+{
+    QN_STOR_RU_PIPELINE_CHUNKS = 0x1,    // Read and checksum the next chunk while the current one is in flight.
+    QN_STOR_RU_SIZE_CHUNKS_BY_BDP = 0x2, // Size chunks by the bandwidth-delay product measured on the connection.
+    QN_STOR_RU_ADAPT_CHUNK_SIZE = 0x4    // Grow or shrink chunks gradually towards the BDP, and back off on failures.
+};
+
 struct _QN_STOR_RESUMABLE_UPLOAD;
 typedef struct _QN_STOR_RESUMABLE_UPLOAD * qn_stor_resumable_upload_ptr;
 
@@ -214,6 +240,65 @@ QN_SDK extern qn_json_object_ptr qn_stor_ru_api_bput(qn_storage_ptr restrict sto
 QN_SDK extern qn_json_object_ptr qn_stor_ru_api_mkfile(qn_storage_ptr restrict stor, const char * restrict uptoken, qn_io_reader_itf restrict ctx_rdr, qn_json_object_ptr restrict last_blk_info, qn_fsize fsize, qn_stor_upload_extra_ptr restrict upe);
 
 QN_SDK extern qn_json_object_ptr qn_stor_ru_upload_huge(qn_storage_ptr restrict stor, const char * restrict uptoken, qn_stor_resumable_upload_ptr ru, int * start_idx, qn_uint chk_size, qn_stor_upload_extra_ptr restrict upe);
+QN_SDK extern qn_json_object_ptr qn_stor_ru_upload_huge_concurrently(qn_storage_ptr restrict stor, const char * restrict uptoken, qn_stor_resumable_upload_ptr ru, int * start_idx, qn_uint chk_size, int wkr_cnt, qn_stor_upload_extra_ptr restrict upe);
+
+// -------- Chunk Sizing (abbreviation: csz) --------
+
+// -- Estimates of a connection, used to size chunks of resumable uploads. Each storage object keeps its own.
+typedef struct _QN_STOR_CHUNK_SIZING
+{
+    qn_uint64 min_delay_us;
+    qn_uint64 bandwidth; // In bytes per second.
+    qn_uint chk_size;    // The adapted chunk size, or 0 before any chunk is measured.
+} qn_stor_chunk_sizing_st, *qn_stor_chunk_sizing_ptr;
+
+// -- Update the estimates by the total time of a chunk request, and adapt the chunk size if asked by the options.
+QN_SDK extern void qn_stor_csz_measure_chunk(qn_stor_chunk_sizing_ptr restrict csz, qn_uint32 opts, qn_uint chk_size, qn_uint64 total_us);
+QN_SDK extern void qn_stor_csz_back_off(qn_stor_chunk_sizing_ptr restrict csz, qn_uint chk_size);
+QN_SDK extern qn_uint qn_stor_csz_choose_chunk_size(qn_stor_chunk_sizing_ptr restrict csz, qn_uint32 opts, qn_uint chk_size, qn_uint rem_size);
+
+// -------- Download Extra (abbreviation: dne) --------
+
+struct _QN_STOR_DOWNLOAD_EXTRA;
+typedef struct _QN_STOR_DOWNLOAD_EXTRA * qn_stor_download_extra_ptr;
+
+QN_SDK extern qn_stor_download_extra_ptr qn_stor_dne_create(void);
+QN_SDK extern void qn_stor_dne_destroy(qn_stor_download_extra_ptr restrict dne);
+QN_SDK extern void qn_stor_dne_reset(qn_stor_download_extra_ptr restrict dne);
+
+QN_SDK extern void qn_stor_dne_set_region_entry(qn_stor_download_extra_ptr restrict dne, qn_rgn_entry_ptr restrict entry);
+QN_SDK extern void qn_stor_dne_set_qetag_checking(qn_stor_download_extra_ptr restrict dne, qn_bool check);
+QN_SDK extern void qn_stor_dne_set_expected_qetag(qn_stor_download_extra_ptr restrict dne, const char * restrict qetag);
+
+// -------- Ranged Download Object (abbreviation: dn) --------
+
+enum
+{
+    QN_STOR_DN_RANGE_MIN_SIZE = (1024 * 64),
+    QN_STOR_DN_RANGE_DEFAULT_SIZE = (1024 * 1024 * 4)
+};
+
+struct _QN_STOR_DOWNLOAD;
+typedef struct _QN_STOR_DOWNLOAD * qn_stor_download_ptr;
+
+QN_SDK extern qn_stor_download_ptr qn_stor_dn_create(const char * restrict url, qn_fsize fsize, qn_uint rng_size);
+QN_SDK extern void qn_stor_dn_destroy(qn_stor_download_ptr restrict dn);
+
+QN_SDK extern qn_string qn_stor_dn_to_string(qn_stor_download_ptr restrict dn);
+QN_SDK extern qn_stor_download_ptr qn_stor_dn_from_string(const char * restrict str, qn_size str_len);
+
+QN_SDK extern qn_bool qn_stor_dn_set_url(qn_stor_download_ptr restrict dn, const char * restrict url);
+
+QN_SDK extern int qn_stor_dn_get_range_count(qn_stor_download_ptr restrict dn);
+QN_SDK extern qn_bool qn_stor_dn_is_range_downloaded(qn_stor_download_ptr restrict dn, int rng_idx);
+
+QN_SDK extern qn_fsize qn_stor_dn_total_fsize(qn_stor_download_ptr restrict dn);
+QN_SDK extern qn_fsize qn_stor_dn_downloaded_fsize(qn_stor_download_ptr restrict dn);
+QN_SDK extern qn_bool qn_stor_dn_is_file_downloaded(qn_stor_download_ptr restrict dn);
+
+// -------- Ranged Download Functions (abbreviation: dn) --------
+
+QN_SDK extern qn_json_object_ptr qn_stor_dn_download_file(qn_storage_ptr restrict stor, qn_stor_download_ptr restrict dn, const char * restrict fname, int wkr_cnt, qn_stor_download_extra_ptr restrict dne);
 
 #ifdef __cplusplus
 }
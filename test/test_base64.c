@@ -0,0 +1,240 @@
+#include <CUnit/Basic.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qiniu/base/base64.h"
+
+static const char test_alphabet[] = {"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"};
+
+static const qn_b64_kernel test_kernels[] = {QN_B64_KERNEL_SSE41, QN_B64_KERNEL_AVX2};
+
+#define TEST_KERNEL_COUNT (sizeof(test_kernels) / sizeof(test_kernels[0]))
+
+// ---- test known values ----
+
+void test_encode_and_decode_known_values(void)
+{
+    const char * bins[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar", "\xFB\xFF"};
+    const char * padded[] = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy", "-_8="};
+    const char * unpadded[] = {"", "Zg", "Zm8", "Zm9v", "Zm9vYg", "Zm9vYmE", "Zm9vYmFy", "-_8"};
+    char buf[16];
+    qn_size size;
+    int i;
+
+    for (i = 0; i < sizeof(bins) / sizeof(bins[0]); i += 1) {
+        size = qn_b64_encode_urlsafe(buf, sizeof(buf), bins[i], strlen(bins[i]), QN_B64_APPEND_PADDING);
+        CU_ASSERT_EQUAL(size, strlen(padded[i]));
+        CU_ASSERT_NSTRING_EQUAL(buf, padded[i], size);
+
+        size = qn_b64_encode_urlsafe(buf, sizeof(buf), bins[i], strlen(bins[i]), 0);
+        CU_ASSERT_EQUAL(size, strlen(unpadded[i]));
+        CU_ASSERT_NSTRING_EQUAL(buf, unpadded[i], size);
+
+        size = qn_b64_decode_urlsafe(buf, sizeof(buf), padded[i], strlen(padded[i]), 0);
+        CU_ASSERT_EQUAL(size, strlen(bins[i]));
+        CU_ASSERT_NSTRING_EQUAL(buf, bins[i], size);
+
+        size = qn_b64_decode_urlsafe(buf, sizeof(buf), unpadded[i], strlen(unpadded[i]), 0);
+        CU_ASSERT_EQUAL(size, strlen(bins[i]));
+        CU_ASSERT_NSTRING_EQUAL(buf, bins[i], size);
+    } // for
+}
+
+CU_TestInfo test_normal_cases_of_known_values[] = {
+    {"test_encode_and_decode_known_values()", test_encode_and_decode_known_values},
+    CU_TEST_INFO_NULL
+};
+
+// ---- test kernels against the scalar code ----
+
+static qn_bool test_encode_equally(const char * restrict bin, qn_size bin_size, qn_uint32 opts, char * restrict expected, char * restrict encoded)
+{
+    qn_size cap = qn_b64_encode_urlsafe(NULL, 0, bin, bin_size, opts);
+    qn_size expected_size;
+    qn_size encoded_size;
+    int i;
+
+    qn_b64_set_kernel(QN_B64_KERNEL_SCALAR);
+    expected_size = qn_b64_encode_urlsafe(expected, cap, bin, bin_size, opts);
+
+    for (i = 0; i < TEST_KERNEL_COUNT; i += 1) {
+        qn_b64_set_kernel(test_kernels[i]);
+        encoded_size = qn_b64_encode_urlsafe(encoded, cap, bin, bin_size, opts);
+        if (encoded_size != expected_size || memcmp(encoded, expected, expected_size) != 0) return qn_false;
+    } // for
+    return qn_true;
+}
+
+static qn_bool test_decode_equally(const char * restrict str, qn_size str_size, char * restrict expected, char * restrict decoded)
+{
+    qn_size cap = qn_b64_decode_urlsafe(NULL, 0, str, str_size, 0);
+    qn_size expected_size;
+    qn_size decoded_size;
+    int i;
+
+    if (cap == 0) return qn_true;
+
+    qn_b64_set_kernel(QN_B64_KERNEL_SCALAR);
+    expected_size = qn_b64_decode_urlsafe(expected, cap, str, str_size, 0);
+
+    for (i = 0; i < TEST_KERNEL_COUNT; i += 1) {
+        qn_b64_set_kernel(test_kernels[i]);
+        decoded_size = qn_b64_decode_urlsafe(decoded, cap, str, str_size, 0);
+        if (decoded_size != expected_size || memcmp(decoded, expected, expected_size) != 0) return qn_false;
+    } // for
+    return qn_true;
+}
+
+void test_kernels_encode_all_triples(void)
+{
+    qn_size bin_size = 3 << 24;
+    char * bin = malloc(bin_size);
+    char * expected = malloc(4 << 24);
+    char * encoded = malloc(4 << 24);
+    int i;
+
+    if (!bin || !expected || !encoded) {
+        CU_FAIL("Cannot allocate buffers.");
+        free(bin);
+        free(expected);
+        free(encoded);
+        return;
+    } // if
+
+    for (i = 0; i < (1 << 24); i += 1) {
+        bin[i * 3] = (char)(i >> 16);
+        bin[i * 3 + 1] = (char)(i >> 8);
+        bin[i * 3 + 2] = (char)i;
+    } // for
+
+    CU_ASSERT_TRUE(test_encode_equally(bin, bin_size, QN_B64_APPEND_PADDING, expected, encoded));
+
+    free(bin);
+    free(expected);
+    free(encoded);
+}
+
+void test_kernels_decode_all_quartets(void)
+{
+    qn_size str_size = 4 << 18;
+    char * str = malloc(str_size);
+    char * expected = malloc(3 << 18);
+    char * decoded = malloc(3 << 18);
+    qn_bool ok = qn_true;
+    int i;
+    int j;
+
+    if (!str || !expected || !decoded) {
+        CU_FAIL("Cannot allocate buffers.");
+        free(str);
+        free(expected);
+        free(decoded);
+        return;
+    } // if
+
+    // -- All quartets which begin with the same char, one chunk after another.
+    for (i = 0; i < 64 && ok; i += 1) {
+        for (j = 0; j < (1 << 18); j += 1) {
+            str[j * 4] = test_alphabet[i];
+            str[j * 4 + 1] = test_alphabet[(j >> 12) & 0x3F];
+            str[j * 4 + 2] = test_alphabet[(j >> 6) & 0x3F];
+            str[j * 4 + 3] = test_alphabet[j & 0x3F];
+        } // for
+        ok = test_decode_equally(str, str_size, expected, decoded);
+    } // for
+    CU_ASSERT_TRUE(ok);
+
+    free(str);
+    free(expected);
+    free(decoded);
+}
+
+void test_kernels_decode_any_char_at_any_position(void)
+{
+    char str[96];
+    char expected[72];
+    char decoded[72];
+    qn_bool ok = qn_true;
+    int pos;
+    int c;
+
+    // -- Chars of the standard alphabet and invalid ones make the kernels fall back to the scalar code.
+    for (pos = 0; pos < sizeof(str) && ok; pos += 1) {
+        for (c = 0; c < 256 && ok; c += 1) {
+            memcpy(str, test_alphabet, 64);
+            memcpy(str + 64, test_alphabet, 32);
+            str[pos] = (char)c;
+            ok = test_decode_equally(str, sizeof(str), expected, decoded);
+        } // for
+    } // for
+    CU_ASSERT_TRUE(ok);
+}
+
+void test_kernels_handle_any_size(void)
+{
+    char bin[300];
+    char str[400];
+    char expected[400];
+    char decoded[400];
+    qn_size str_size;
+    qn_bool ok = qn_true;
+    int i;
+
+    srand(1);
+    for (i = 0; i < sizeof(bin); i += 1) bin[i] = (char)rand();
+
+    // -- Cover all sizes of tails left to the scalar code, with and without padding chars.
+    for (i = 0; i <= sizeof(bin) && ok; i += 1) {
+        ok = test_encode_equally(bin, i, QN_B64_APPEND_PADDING, expected, decoded) && test_encode_equally(bin, i, 0, expected, decoded);
+
+        qn_b64_set_kernel(QN_B64_KERNEL_AVX2);
+        str_size = qn_b64_encode_urlsafe(str, sizeof(str), bin, i, QN_B64_APPEND_PADDING);
+        ok = ok && test_decode_equally(str, str_size, expected, decoded);
+        ok = ok && qn_b64_decode_urlsafe(decoded, sizeof(decoded), str, str_size, 0) == i && memcmp(decoded, bin, i) == 0;
+    } // for
+    CU_ASSERT_TRUE(ok);
+}
+
+CU_TestInfo test_normal_cases_of_kernels[] = {
+    {"test_kernels_encode_all_triples()", test_kernels_encode_all_triples},
+    {"test_kernels_decode_all_quartets()", test_kernels_decode_all_quartets},
+    {"test_kernels_decode_any_char_at_any_position()", test_kernels_decode_any_char_at_any_position},
+    {"test_kernels_handle_any_size()", test_kernels_handle_any_size},
+    CU_TEST_INFO_NULL
+};
+
+// ---- test suites ----
+
+CU_SuiteInfo suites[] = {
+    {"test_normal_cases_of_known_values", NULL, NULL, test_normal_cases_of_known_values},
+    {"test_normal_cases_of_kernels", NULL, NULL, test_normal_cases_of_kernels},
+    CU_SUITE_INFO_NULL
+};
+
+int main(void)
+{
+    CU_pSuite pSuite = NULL;
+
+    if (CU_initialize_registry() != CUE_SUCCESS) {
+        return CU_get_error();
+    } // if
+
+    pSuite = CU_add_suite("Suite_Test_Base64", NULL, NULL);
+    if (pSuite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    } // if
+
+    if (CU_register_suites(suites) != CUE_SUCCESS) {
+        printf("Cannot register test suites.\n");
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+} // main
@@ -0,0 +1,267 @@
+#include <CUnit/Basic.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "qiniu/storage.h"
+
+#define TEST_KB (1024)
+#define TEST_MB (1024 * 1024)
+
+// ---- test sizing chunks by BDP ----
+
+static void test_measure_first_chunk(void)
+{
+    qn_stor_chunk_sizing_st csz;
+
+    memset(&csz, 0, sizeof(csz));
+
+    // -- A request without timing is ignored.
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_SIZE_CHUNKS_BY_BDP, 256 * TEST_KB, 0);
+    CU_ASSERT_EQUAL(csz.min_delay_us, 0);
+    CU_ASSERT_EQUAL(csz.bandwidth, 0);
+
+    // -- The first request gives both the delay and the bandwidth.
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_SIZE_CHUNKS_BY_BDP, 256 * TEST_KB, 100000);
+    CU_ASSERT_EQUAL(csz.min_delay_us, 100000);
+    CU_ASSERT_EQUAL(csz.bandwidth, 256 * TEST_KB * 10);
+    CU_ASSERT_EQUAL(csz.chk_size, 0);
+
+    // -- 4 BDPs of 2.5MB/s by 100ms.
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, QN_STOR_RU_SIZE_CHUNKS_BY_BDP, 0, 4 * TEST_MB), TEST_MB);
+}
+
+static void test_measure_more_chunks(void)
+{
+    qn_stor_chunk_sizing_st csz;
+
+    memset(&csz, 0, sizeof(csz));
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_SIZE_CHUNKS_BY_BDP, 256 * TEST_KB, 100000);
+
+    // -- Time beyond the minimum delay is spent on sending, 256KB in 50ms here, and averaged with 1/8 weight.
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_SIZE_CHUNKS_BY_BDP, 256 * TEST_KB, 150000);
+    CU_ASSERT_EQUAL(csz.min_delay_us, 100000);
+    CU_ASSERT_EQUAL(csz.bandwidth, (256 * TEST_KB * 10 * 7 + 256 * TEST_KB * 20) / 8);
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, QN_STOR_RU_SIZE_CHUNKS_BY_BDP, 0, 4 * TEST_MB), 18 * 64 * TEST_KB);
+
+    // -- A faster request lowers the minimum delay.
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_SIZE_CHUNKS_BY_BDP, 256 * TEST_KB, 80000);
+    CU_ASSERT_EQUAL(csz.min_delay_us, 80000);
+}
+
+static void test_choose_chunk_size_by_bdp(void)
+{
+    qn_stor_chunk_sizing_st csz;
+
+    memset(&csz, 0, sizeof(csz));
+
+    // -- Nothing is measured yet, so use the given size or the default one.
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, QN_STOR_RU_SIZE_CHUNKS_BY_BDP, 0, 4 * TEST_MB), QN_STOR_RU_CHUNK_DEFAULT_SIZE);
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, QN_STOR_RU_SIZE_CHUNKS_BY_BDP, 512 * TEST_KB, 4 * TEST_MB), 512 * TEST_KB);
+
+    // -- 4 BDPs of 1MB/s by 100ms, rounded down to a multiple of the minimum chunk size.
+    csz.bandwidth = 1000000;
+    csz.min_delay_us = 100000;
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, QN_STOR_RU_SIZE_CHUNKS_BY_BDP, 0, 4 * TEST_MB), 6 * 64 * TEST_KB);
+
+    // -- The rest of the block is smaller than a chunk.
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, QN_STOR_RU_SIZE_CHUNKS_BY_BDP, 0, 1000), 1000);
+
+    // -- The given size is used if sizing by BDP is not asked for.
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, 0, 512 * TEST_KB, 4 * TEST_MB), 512 * TEST_KB);
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, 0, 0, 4 * TEST_MB), QN_STOR_RU_CHUNK_DEFAULT_SIZE);
+}
+
+static void test_clamp_chunk_size_by_bdp(void)
+{
+    qn_stor_chunk_sizing_st csz;
+
+    memset(&csz, 0, sizeof(csz));
+
+    // -- A fast link with a long delay is capped by the block size.
+    csz.bandwidth = 100 * TEST_MB;
+    csz.min_delay_us = 200000;
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, QN_STOR_RU_SIZE_CHUNKS_BY_BDP, 0, 4 * TEST_MB), QN_STOR_RU_BLOCK_MAX_SIZE);
+
+    // -- A slow link with a short delay is raised to the minimum chunk size.
+    csz.bandwidth = 10 * TEST_KB;
+    csz.min_delay_us = 1000;
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, QN_STOR_RU_SIZE_CHUNKS_BY_BDP, 0, 4 * TEST_MB), QN_STOR_RU_CHUNK_MIN_SIZE);
+}
+
+CU_TestInfo test_bdp_sizing_cases[] = {
+    {"test_measure_first_chunk()", test_measure_first_chunk},
+    {"test_measure_more_chunks()", test_measure_more_chunks},
+    {"test_choose_chunk_size_by_bdp()", test_choose_chunk_size_by_bdp},
+    {"test_clamp_chunk_size_by_bdp()", test_clamp_chunk_size_by_bdp},
+    CU_TEST_INFO_NULL
+};
+
+// ---- test adapting chunk sizes ----
+
+static void test_grow_chunk_size(void)
+{
+    qn_stor_chunk_sizing_st csz;
+
+    memset(&csz, 0, sizeof(csz));
+
+    // -- Nothing is measured yet, so use the given size or the default one.
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, 0, 4 * TEST_MB), QN_STOR_RU_CHUNK_DEFAULT_SIZE);
+
+    // -- The target is 4 BDPs of 2.5MB/s by 100ms, and the size grows by at most a factor of 2 per chunk.
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, 256 * TEST_KB, 100000);
+    CU_ASSERT_EQUAL(csz.chk_size, 512 * TEST_KB);
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, 0, 4 * TEST_MB), 512 * TEST_KB);
+
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, 512 * TEST_KB, 300000);
+    CU_ASSERT_EQUAL(csz.chk_size, TEST_MB);
+
+    // -- Stay on the target.
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, TEST_MB, 500000);
+    CU_ASSERT_EQUAL(csz.chk_size, TEST_MB);
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, 0, 4 * TEST_MB), TEST_MB);
+
+    // -- The given size does not override the adapted one, but the rest of the block does.
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, 256 * TEST_KB, 4 * TEST_MB), TEST_MB);
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, 0, 1000), 1000);
+}
+
+static void test_grow_chunk_size_to_block_size(void)
+{
+    qn_stor_chunk_sizing_st csz;
+
+    memset(&csz, 0, sizeof(csz));
+    csz.min_delay_us = 200000;
+    csz.bandwidth = 100 * TEST_MB;
+    csz.chk_size = 2 * TEST_MB;
+
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, 2 * TEST_MB, 220000);
+    CU_ASSERT_EQUAL(csz.chk_size, QN_STOR_RU_BLOCK_MAX_SIZE);
+
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, 4 * TEST_MB, 240000);
+    CU_ASSERT_EQUAL(csz.chk_size, QN_STOR_RU_BLOCK_MAX_SIZE);
+}
+
+static void test_shrink_chunk_size(void)
+{
+    qn_stor_chunk_sizing_st csz;
+
+    // -- The target is 1MB, and the size shrinks by at most a factor of 2 per chunk.
+    memset(&csz, 0, sizeof(csz));
+    csz.min_delay_us = 100000;
+    csz.bandwidth = 256 * TEST_KB * 10;
+    csz.chk_size = 4 * TEST_MB;
+
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, 4 * TEST_MB, 1700000);
+    CU_ASSERT_EQUAL(csz.chk_size, 2 * TEST_MB);
+
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, 2 * TEST_MB, 900000);
+    CU_ASSERT_EQUAL(csz.chk_size, TEST_MB);
+
+    // -- Within a factor of 2, the size moves to the target at once.
+    csz.chk_size = 1536 * TEST_KB;
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, 1536 * TEST_KB, 700000);
+    CU_ASSERT_EQUAL(csz.chk_size, TEST_MB);
+}
+
+static void test_keep_chunk_size_without_adapting(void)
+{
+    qn_stor_chunk_sizing_st csz;
+
+    memset(&csz, 0, sizeof(csz));
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_SIZE_CHUNKS_BY_BDP, 256 * TEST_KB, 100000);
+    CU_ASSERT_EQUAL(csz.chk_size, 0);
+
+    // -- Even a late chunk does not change the size.
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_SIZE_CHUNKS_BY_BDP, 256 * TEST_KB, 10000000);
+    CU_ASSERT_EQUAL(csz.chk_size, 0);
+}
+
+static void test_back_off(void)
+{
+    qn_stor_chunk_sizing_st csz;
+
+    memset(&csz, 0, sizeof(csz));
+    csz.min_delay_us = 100000;
+    csz.bandwidth = 256 * TEST_KB * 10;
+    csz.chk_size = TEST_MB;
+
+    // -- Halve the failed chunk and the bandwidth.
+    qn_stor_csz_back_off(&csz, TEST_MB);
+    CU_ASSERT_EQUAL(csz.chk_size, 512 * TEST_KB);
+    CU_ASSERT_EQUAL(csz.bandwidth, 256 * TEST_KB * 5);
+    CU_ASSERT_EQUAL(qn_stor_csz_choose_chunk_size(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, 0, 4 * TEST_MB), 512 * TEST_KB);
+
+    // -- Half of the size is rounded down to a multiple of the minimum chunk size.
+    qn_stor_csz_back_off(&csz, 300 * TEST_KB);
+    CU_ASSERT_EQUAL(csz.chk_size, 128 * TEST_KB);
+
+    // -- The size does not go below the minimum chunk size.
+    qn_stor_csz_back_off(&csz, QN_STOR_RU_CHUNK_MIN_SIZE);
+    CU_ASSERT_EQUAL(csz.chk_size, QN_STOR_RU_CHUNK_MIN_SIZE);
+}
+
+static void test_back_off_on_late_chunk(void)
+{
+    qn_stor_chunk_sizing_st csz0;
+    qn_stor_chunk_sizing_st csz;
+
+    memset(&csz0, 0, sizeof(csz0));
+    csz0.min_delay_us = 100000;
+    csz0.bandwidth = 256 * TEST_KB * 10;
+    csz0.chk_size = TEST_MB;
+
+    // -- 1MB is expected to take 500ms, so up to 4 times of that only lowers the bandwidth and the target.
+    csz = csz0;
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, TEST_MB, 2000000);
+    CU_ASSERT_EQUAL(csz.chk_size, 14 * 64 * TEST_KB);
+
+    // -- Any longer is handled like a timeout.
+    csz = csz0;
+    qn_stor_csz_measure_chunk(&csz, QN_STOR_RU_ADAPT_CHUNK_SIZE, TEST_MB, 2000001);
+    CU_ASSERT_EQUAL(csz.chk_size, 512 * TEST_KB);
+}
+
+CU_TestInfo test_adaptive_sizing_cases[] = {
+    {"test_grow_chunk_size()", test_grow_chunk_size},
+    {"test_grow_chunk_size_to_block_size()", test_grow_chunk_size_to_block_size},
+    {"test_shrink_chunk_size()", test_shrink_chunk_size},
+    {"test_keep_chunk_size_without_adapting()", test_keep_chunk_size_without_adapting},
+    {"test_back_off()", test_back_off},
+    {"test_back_off_on_late_chunk()", test_back_off_on_late_chunk},
+    CU_TEST_INFO_NULL
+};
+
+// ---- test suites ----
+
+CU_SuiteInfo suites[] = {
+    {"test_bdp_sizing_cases", NULL, NULL, test_bdp_sizing_cases},
+    {"test_adaptive_sizing_cases", NULL, NULL, test_adaptive_sizing_cases},
+    CU_SUITE_INFO_NULL
+};
+
+int main(void)
+{
+    CU_pSuite pSuite = NULL;
+
+    if (CU_initialize_registry() != CUE_SUCCESS) {
+        return CU_get_error();
+    } // if
+
+    pSuite = CU_add_suite("Suite_Test_Chunk_Sizing", NULL, NULL);
+    if (pSuite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    } // if
+
+    if (CU_register_suites(suites) != CUE_SUCCESS) {
+        printf("Cannot register test suites.\n");
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+} // main
@@ -0,0 +1,89 @@
+#include <CUnit/Basic.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "qiniu/base/crc32.h"
+
+static qn_uint32 test_bitwise_crc32(const char * buf, qn_size buf_size)
+{
+    qn_uint32 crc = 0xFFFFFFFF;
+    qn_size i;
+    int k;
+
+    for (i = 0; i < buf_size; i += 1) {
+        crc ^= (unsigned char) buf[i];
+        for (k = 0; k < 8; k += 1) crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+    } // for
+    return ~crc;
+}
+
+void test_known_values(void)
+{
+    CU_ASSERT_EQUAL(qn_crc32_update(0, "", 0), 0);
+    CU_ASSERT_EQUAL(qn_crc32_update(0, "123456789", 9), 0xCBF43926);
+    CU_ASSERT_EQUAL(qn_crc32_update(0, "The quick brown fox jumps over the lazy dog", 43), 0x414FA339);
+}
+
+void test_any_alignment_and_split(void)
+{
+    char buf[256 + 8];
+    qn_uint32 crc;
+    int off;
+    int len;
+    int i;
+
+    for (i = 0; i < sizeof(buf); i += 1) buf[i] = (char)(i * 37 + 11);
+
+    for (off = 0; off < 8; off += 1) {
+        for (len = 0; len <= 256; len += 1) {
+            CU_ASSERT_EQUAL(qn_crc32_update(0, buf + off, len), test_bitwise_crc32(buf + off, len));
+        } // for
+    } // for
+
+    // -- Feeding data piece by piece gives the same result as feeding it at once.
+    for (i = 0; i <= 256; i += 13) {
+        crc = qn_crc32_update(0, buf, i);
+        crc = qn_crc32_update(crc, buf + i, 256 - i);
+        CU_ASSERT_EQUAL(crc, test_bitwise_crc32(buf, 256));
+    } // for
+}
+
+CU_TestInfo test_normal_cases[] = {
+    {"test_known_values()", test_known_values},
+    {"test_any_alignment_and_split()", test_any_alignment_and_split},
+    CU_TEST_INFO_NULL
+};
+
+// ---- test suites ----
+
+CU_SuiteInfo suites[] = {
+    {"test_normal_cases", NULL, NULL, test_normal_cases},
+    CU_SUITE_INFO_NULL
+};
+
+int main(void)
+{
+    CU_pSuite pSuite = NULL;
+
+    if (CU_initialize_registry() != CUE_SUCCESS) {
+        return CU_get_error();
+    } // if
+
+    pSuite = CU_add_suite("Suite_Test_CRC32", NULL, NULL);
+    if (pSuite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    } // if
+
+    if (CU_register_suites(suites) != CUE_SUCCESS) {
+        printf("Cannot register test suites.\n");
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+} // main
@@ -0,0 +1,189 @@
+#include <CUnit/Basic.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "qiniu/base/errors.h"
+#include "qiniu/storage.h"
+
+#define TEST_URL "http://test.example.com/file.bin"
+#define TEST_RANGE_SIZE (4 * 1024 * 1024)
+#define TEST_FILE_SIZE ((qn_fsize) TEST_RANGE_SIZE * 2 + 777)
+
+static qn_stor_download_ptr test_dn_from_cstr(const char * str)
+{
+    return qn_stor_dn_from_string(str, strlen(str));
+}
+
+static void test_create_download(void)
+{
+    qn_stor_download_ptr dn;
+
+    dn = qn_stor_dn_create(TEST_URL, TEST_FILE_SIZE, TEST_RANGE_SIZE);
+    CU_ASSERT_FATAL(dn != NULL);
+
+    CU_ASSERT_EQUAL(qn_stor_dn_get_range_count(dn), 3);
+    CU_ASSERT_EQUAL(qn_stor_dn_total_fsize(dn), TEST_FILE_SIZE);
+    CU_ASSERT_EQUAL(qn_stor_dn_downloaded_fsize(dn), 0);
+    CU_ASSERT_FALSE(qn_stor_dn_is_range_downloaded(dn, 0));
+    CU_ASSERT_FALSE(qn_stor_dn_is_range_downloaded(dn, 2));
+    CU_ASSERT_FALSE(qn_stor_dn_is_file_downloaded(dn));
+
+    qn_stor_dn_destroy(dn);
+
+    // The range size is rounded up to the minimum one.
+    dn = qn_stor_dn_create(TEST_URL, 1024 * 1024, 1);
+    CU_ASSERT_FATAL(dn != NULL);
+    CU_ASSERT_EQUAL(qn_stor_dn_get_range_count(dn), 1024 * 1024 / QN_STOR_DN_RANGE_MIN_SIZE);
+    qn_stor_dn_destroy(dn);
+
+    // An empty file has no range to download.
+    dn = qn_stor_dn_create(TEST_URL, 0, 0);
+    CU_ASSERT_FATAL(dn != NULL);
+    CU_ASSERT_EQUAL(qn_stor_dn_get_range_count(dn), 0);
+    CU_ASSERT_TRUE(qn_stor_dn_is_file_downloaded(dn));
+    qn_stor_dn_destroy(dn);
+}
+
+static void test_round_trip_download(void)
+{
+    qn_stor_download_ptr dn;
+    qn_stor_download_ptr dn2;
+    qn_string str;
+    qn_string str2;
+
+    dn = qn_stor_dn_create(TEST_URL, TEST_FILE_SIZE, TEST_RANGE_SIZE);
+    CU_ASSERT_FATAL(dn != NULL);
+
+    str = qn_stor_dn_to_string(dn);
+    CU_ASSERT_FATAL(str != NULL);
+
+    dn2 = qn_stor_dn_from_string(qn_str_cstr(str), qn_str_size(str));
+    CU_ASSERT_FATAL(dn2 != NULL);
+
+    CU_ASSERT_EQUAL(qn_stor_dn_get_range_count(dn2), qn_stor_dn_get_range_count(dn));
+    CU_ASSERT_EQUAL(qn_stor_dn_total_fsize(dn2), qn_stor_dn_total_fsize(dn));
+    CU_ASSERT_EQUAL(qn_stor_dn_downloaded_fsize(dn2), 0);
+
+    str2 = qn_stor_dn_to_string(dn2);
+    CU_ASSERT_FATAL(str2 != NULL);
+    CU_ASSERT_STRING_EQUAL(qn_str_cstr(str2), qn_str_cstr(str));
+
+    qn_str_destroy(str2);
+    qn_str_destroy(str);
+    qn_stor_dn_destroy(dn2);
+    qn_stor_dn_destroy(dn);
+}
+
+static void test_resume_download(void)
+{
+    qn_stor_download_ptr dn;
+    qn_string str;
+
+    dn = test_dn_from_cstr("{\"url\":\"" TEST_URL "\",\"fsize\":\"8389385\",\"rsize\":4194304,\"ranges\":\"101\",\"etag\":\"FqAbc\"}");
+    CU_ASSERT_FATAL(dn != NULL);
+
+    CU_ASSERT_EQUAL(qn_stor_dn_get_range_count(dn), 3);
+    CU_ASSERT_TRUE(qn_stor_dn_is_range_downloaded(dn, 0));
+    CU_ASSERT_FALSE(qn_stor_dn_is_range_downloaded(dn, 1));
+    CU_ASSERT_TRUE(qn_stor_dn_is_range_downloaded(dn, 2));
+
+    // The last range is shorter than the others.
+    CU_ASSERT_EQUAL(qn_stor_dn_downloaded_fsize(dn), TEST_RANGE_SIZE + 777);
+    CU_ASSERT_FALSE(qn_stor_dn_is_file_downloaded(dn));
+
+    str = qn_stor_dn_to_string(dn);
+    CU_ASSERT_FATAL(str != NULL);
+    CU_ASSERT_PTR_NOT_NULL(strstr(qn_str_cstr(str), "\"ranges\":\"101\""));
+    CU_ASSERT_PTR_NOT_NULL(strstr(qn_str_cstr(str), "\"etag\":\"FqAbc\""));
+    qn_str_destroy(str);
+    qn_stor_dn_destroy(dn);
+
+    dn = test_dn_from_cstr("{\"url\":\"" TEST_URL "\",\"fsize\":\"8389385\",\"rsize\":4194304,\"ranges\":\"111\"}");
+    CU_ASSERT_FATAL(dn != NULL);
+    CU_ASSERT_EQUAL(qn_stor_dn_downloaded_fsize(dn), TEST_FILE_SIZE);
+    CU_ASSERT_TRUE(qn_stor_dn_is_file_downloaded(dn));
+
+    CU_ASSERT_TRUE(qn_stor_dn_set_url(dn, "http://test.example.com/file.bin?e=1&token=abc"));
+    str = qn_stor_dn_to_string(dn);
+    CU_ASSERT_FATAL(str != NULL);
+    CU_ASSERT_PTR_NOT_NULL(strstr(qn_str_cstr(str), "token=abc"));
+    CU_ASSERT_PTR_NULL(strstr(qn_str_cstr(str), "\"etag\""));
+    qn_str_destroy(str);
+    qn_stor_dn_destroy(dn);
+}
+
+static void test_malformed_download(void)
+{
+    static const char * strs[] = {
+        // Not a JSON object.
+        "[\"" TEST_URL "\"]",
+        // Missing fields.
+        "{\"fsize\":\"8389385\",\"rsize\":4194304,\"ranges\":\"000\"}",
+        "{\"url\":\"" TEST_URL "\",\"rsize\":4194304,\"ranges\":\"000\"}",
+        "{\"url\":\"" TEST_URL "\",\"fsize\":\"8389385\",\"rsize\":4194304}",
+        // Ranges too small.
+        "{\"url\":\"" TEST_URL "\",\"fsize\":\"8389385\",\"rsize\":1024,\"ranges\":\"000\"}",
+        // Wrong number of ranges.
+        "{\"url\":\"" TEST_URL "\",\"fsize\":\"8389385\",\"rsize\":4194304,\"ranges\":\"00\"}",
+        "{\"url\":\"" TEST_URL "\",\"fsize\":\"8389385\",\"rsize\":4194304,\"ranges\":\"0000\"}",
+        // Unknown range states.
+        "{\"url\":\"" TEST_URL "\",\"fsize\":\"8389385\",\"rsize\":4194304,\"ranges\":\"0x0\"}",
+        // Negative file size.
+        "{\"url\":\"" TEST_URL "\",\"fsize\":\"-1\",\"rsize\":4194304,\"ranges\":\"\"}",
+        NULL
+    };
+    qn_stor_download_ptr dn;
+    int i;
+
+    for (i = 0; strs[i]; i += 1) {
+        dn = test_dn_from_cstr(strs[i]);
+        CU_ASSERT_PTR_NULL(dn);
+        if (dn) qn_stor_dn_destroy(dn);
+    } // for
+
+    // Broken JSON text.
+    dn = test_dn_from_cstr("{\"url\":\"" TEST_URL "\",\"fsize\":");
+    CU_ASSERT_PTR_NULL(dn);
+}
+
+CU_TestInfo test_download_cases[] = {
+    {"test_create_download()", test_create_download},
+    {"test_round_trip_download()", test_round_trip_download},
+    {"test_resume_download()", test_resume_download},
+    {"test_malformed_download()", test_malformed_download},
+    CU_TEST_INFO_NULL
+};
+
+// ---- test suites ----
+
+CU_SuiteInfo suites[] = {
+    {"test_download_cases", NULL, NULL, test_download_cases},
+    CU_SUITE_INFO_NULL
+};
+
+int main(void)
+{
+    CU_pSuite pSuite = NULL;
+
+    if (CU_initialize_registry() != CUE_SUCCESS) {
+        return CU_get_error();
+    } // if
+
+    pSuite = CU_add_suite("Suite_Test_Download", NULL, NULL);
+    if (pSuite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    } // if
+
+    if (CU_register_suites(suites) != CUE_SUCCESS) {
+        printf("Cannot register test suites.\n");
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+} // main
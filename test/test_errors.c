@@ -0,0 +1,121 @@
+#include <CUnit/Basic.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "qiniu/base/errors.h"
+
+#define TEST_THREAD_COUNT 8
+#define TEST_ROUNDS 100000
+
+typedef struct _TEST_ERR_WORKER
+{
+    qn_err_code_em code;
+    qn_bool ok;
+} test_err_worker;
+
+static pthread_barrier_t test_barrier;
+
+static void * test_set_and_check_code(void * arg)
+{
+    test_err_worker * wk = (test_err_worker *) arg;
+    int i;
+
+    wk->ok = qn_err_is_succeed();
+
+    pthread_barrier_wait(&test_barrier);
+    for (i = 0; i < TEST_ROUNDS && wk->ok; i += 1) {
+        qn_err_set_code(wk->code, 0, __FILE__, __LINE__);
+        wk->ok = (qn_err_get_code() == wk->code);
+        qn_err_set_succeed();
+        wk->ok = wk->ok && qn_err_is_succeed();
+    } // for
+    return NULL;
+}
+
+void test_error_state_per_thread(void)
+{
+    static const qn_err_code_em codes[] = {
+        QN_ERR_OUT_OF_MEMORY,
+        QN_ERR_TRY_AGAIN,
+        QN_ERR_OUT_OF_BUFFER,
+        QN_ERR_JSON_BAD_TEXT_INPUT,
+        QN_ERR_JSON_NEED_MORE_TEXT_INPUT,
+        QN_ERR_HTTP_INVALID_HEADER_SYNTAX,
+        QN_ERR_FL_READING_FILE_FAILED,
+        QN_ERR_STOR_INVALID_LIST_RESULT
+    };
+    test_err_worker wks[TEST_THREAD_COUNT];
+    pthread_t ths[TEST_THREAD_COUNT];
+    int i;
+
+    qn_err_json_set_bad_text_input();
+    pthread_barrier_init(&test_barrier, NULL, TEST_THREAD_COUNT);
+
+    for (i = 0; i < TEST_THREAD_COUNT; i += 1) {
+        wks[i].code = codes[i];
+        pthread_create(&ths[i], NULL, &test_set_and_check_code, &wks[i]);
+    } // for
+    for (i = 0; i < TEST_THREAD_COUNT; i += 1) {
+        pthread_join(ths[i], NULL);
+        CU_ASSERT_TRUE(wks[i].ok);
+    } // for
+
+    pthread_barrier_destroy(&test_barrier);
+
+    // -- Errors set by other threads never overwrite the one of this thread.
+    CU_ASSERT_TRUE(qn_err_json_is_bad_text_input());
+}
+
+void test_format_message(void)
+{
+    char buf[256];
+    ssize_t ret;
+
+    qn_err_3rdp_set_glibc_error_occurred(ENOENT);
+    ret = qn_err_format_message(buf, sizeof(buf));
+    CU_ASSERT_TRUE(ret > 0);
+    CU_ASSERT_PTR_NOT_NULL(strstr(buf, "glibc error occurred"));
+    CU_ASSERT_PTR_NOT_NULL(strstr(buf, strerror(ENOENT)));
+}
+
+CU_TestInfo test_normal_cases[] = {
+    {"test_error_state_per_thread()", test_error_state_per_thread},
+    {"test_format_message()", test_format_message},
+    CU_TEST_INFO_NULL
+};
+
+// ---- test suites ----
+
+CU_SuiteInfo suites[] = {
+    {"test_normal_cases", NULL, NULL, test_normal_cases},
+    CU_SUITE_INFO_NULL
+};
+
+int main(void)
+{
+    CU_pSuite pSuite = NULL;
+
+    if (CU_initialize_registry() != CUE_SUCCESS) {
+        return CU_get_error();
+    } // if
+
+    pSuite = CU_add_suite("Suite_Test_Errors", NULL, NULL);
+    if (pSuite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    } // if
+
+    if (CU_register_suites(suites) != CUE_SUCCESS) {
+        printf("Cannot register test suites.\n");
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+} // main
@@ -1,6 +1,10 @@
 #include <CUnit/Basic.h> 
 
+#include <stdio.h>
+#include <unistd.h>
+
 #include "qiniu/base/string.h"
+#include "qiniu/os/file.h"
 #include "qiniu/etag.c"
 
 // ---- test extern functions ----
@@ -164,11 +168,222 @@ CU_TestInfo test_normal_cases_of_buffer_etags[] = {
     CU_TEST_INFO_NULL
 };
 
+// ----
+
+static qn_bool test_create_file(char * restrict fname, int buf_size)
+{
+    int fd;
+    int ret;
+    char * buf = calloc(1, buf_size + 1);
+
+    fd = mkstemp(fname);
+    if (fd < 0) {
+        free(buf);
+        return qn_false;
+    } // if
+    ret = write(fd, buf, buf_size);
+    close(fd);
+    free(buf);
+    return (ret == buf_size);
+}
+
+static qn_string test_digest_file_concurrently(int buf_size, int wkr_cnt)
+{
+    char fname[] = "/tmp/test_etag_XXXXXX";
+    qn_string digest = NULL;
+    qn_etag_context_ptr ctx;
+    qn_file_ptr fl;
+
+    if (test_create_file(fname, buf_size) && (fl = qn_fl_open(fname, NULL))) {
+        if ((ctx = qn_etag_ctx_create())) {
+            if (qn_etag_ctx_update_concurrently(ctx, qn_fl_to_io_reader(fl), wkr_cnt)) digest = qn_etag_ctx_final(ctx);
+            qn_etag_ctx_destroy(ctx);
+        } // if
+        qn_fl_close(fl);
+    } // if
+    unlink(fname);
+    return digest;
+}
+
+static qn_string test_digest_file(int buf_size)
+{
+    char fname[] = "/tmp/test_etag_XXXXXX";
+    qn_string digest = NULL;
+
+    if (test_create_file(fname, buf_size)) digest = qn_etag_digest_file(fname);
+    unlink(fname);
+    return digest;
+}
+
+void test_concurrently_size_equals_zero_byte(void)
+{
+    qn_string digest = test_digest_file_concurrently(0, 4);
+
+    CU_ASSERT_PTR_NOT_NULL(digest);
+    CU_ASSERT_STRING_EQUAL(digest, "Fto5o-5ea0sNMlW_75VgGJCv2AcJ");
+}
+
+void test_concurrently_size_equals_one_block(void)
+{
+    qn_string digest = test_digest_file_concurrently((1 << 22), 4);
+
+    CU_ASSERT_PTR_NOT_NULL(digest);
+    CU_ASSERT_STRING_EQUAL(digest, "FivMvS848VwT631aif2dhfWV4jvD");
+}
+
+void test_concurrently_size_one_byte_greater_than_one_block(void)
+{
+    qn_string digest = test_digest_file_concurrently((1 << 22) + 1, 4);
+
+    CU_ASSERT_PTR_NOT_NULL(digest);
+    CU_ASSERT_STRING_EQUAL(digest, "lhCFgki5yzon0rjN9uJusf6qtsF6");
+}
+
+void test_concurrently_size_equals_two_blocks(void)
+{
+    qn_string digest = test_digest_file_concurrently((1 << 22) * 2, 4);
+
+    CU_ASSERT_PTR_NOT_NULL(digest);
+    CU_ASSERT_STRING_EQUAL(digest, "lsCVE24-Immdd6zm-ffVVhsWYcDG");
+}
+
+void test_concurrently_size_one_byte_greater_than_three_blocks(void)
+{
+    qn_string digest = test_digest_file_concurrently((1 << 22) * 3 + 1, 2);
+
+    CU_ASSERT_PTR_NOT_NULL(digest);
+    CU_ASSERT_STRING_EQUAL(digest, "lvJcAt9M54FOUTGLz0jIOR_inhfs");
+}
+
+void test_concurrently_more_blocks_than_context_slots(void)
+{
+    int buf_size = (1 << 22) * (QN_ETAG_BLK_MAX_COUNT * 2 + 1) + 1;
+    qn_string expected;
+    qn_string digest;
+    char * buf = calloc(1, buf_size);
+
+    expected = qn_etag_digest_buffer(buf, buf_size);
+    free(buf);
+
+    digest = test_digest_file_concurrently(buf_size, 8);
+
+    CU_ASSERT_PTR_NOT_NULL(digest);
+    CU_ASSERT_STRING_EQUAL(digest, expected);
+}
+
+CU_TestInfo test_normal_cases_of_concurrent_etags[] = {
+    {"test_concurrently_size_equals_zero_byte()", test_concurrently_size_equals_zero_byte},
+    {"test_concurrently_size_equals_one_block()", test_concurrently_size_equals_one_block},
+    {"test_concurrently_size_one_byte_greater_than_one_block()", test_concurrently_size_one_byte_greater_than_one_block},
+    {"test_concurrently_size_equals_two_blocks()", test_concurrently_size_equals_two_blocks},
+    {"test_concurrently_size_one_byte_greater_than_three_blocks()", test_concurrently_size_one_byte_greater_than_three_blocks},
+    {"test_concurrently_more_blocks_than_context_slots()", test_concurrently_more_blocks_than_context_slots},
+    CU_TEST_INFO_NULL
+};
+
+// ----
+
+void test_file_size_equals_zero_byte(void)
+{
+    qn_string digest = test_digest_file(0);
+
+    CU_ASSERT_PTR_NOT_NULL(digest);
+    CU_ASSERT_STRING_EQUAL(digest, "Fto5o-5ea0sNMlW_75VgGJCv2AcJ");
+}
+
+void test_file_size_equals_one_block(void)
+{
+    qn_string digest = test_digest_file((1 << 22));
+
+    CU_ASSERT_PTR_NOT_NULL(digest);
+    CU_ASSERT_STRING_EQUAL(digest, "FivMvS848VwT631aif2dhfWV4jvD");
+}
+
+void test_file_size_one_byte_greater_than_three_blocks(void)
+{
+    qn_string digest = test_digest_file((1 << 22) * 3 + 1);
+
+    CU_ASSERT_PTR_NOT_NULL(digest);
+    CU_ASSERT_STRING_EQUAL(digest, "lvJcAt9M54FOUTGLz0jIOR_inhfs");
+}
+
+void test_file_size_one_byte_greater_than_one_mapping(void)
+{
+    int buf_size = QN_ETAG_MAP_MAX_SIZE + 1;
+    qn_string expected;
+    qn_string digest;
+    char * buf = calloc(1, buf_size);
+
+    expected = qn_etag_digest_buffer(buf, buf_size);
+    free(buf);
+
+    digest = test_digest_file(buf_size);
+
+    CU_ASSERT_PTR_NOT_NULL(digest);
+    CU_ASSERT_STRING_EQUAL(digest, expected);
+}
+
+CU_TestInfo test_normal_cases_of_file_etags[] = {
+    {"test_file_size_equals_zero_byte()", test_file_size_equals_zero_byte},
+    {"test_file_size_equals_one_block()", test_file_size_equals_one_block},
+    {"test_file_size_one_byte_greater_than_three_blocks()", test_file_size_one_byte_greater_than_three_blocks},
+    {"test_file_size_one_byte_greater_than_one_mapping()", test_file_size_one_byte_greater_than_one_mapping},
+    CU_TEST_INFO_NULL
+};
+
+// ----
+
+static qn_string test_digest_buffer_by_backend(char * restrict buf, int buf_size, qn_etag_backend_em backend)
+{
+    qn_string digest = NULL;
+    qn_etag_context_ptr ctx = qn_etag_ctx_create();
+    if (! ctx) return NULL;
+
+    if (qn_etag_ctx_set_backend(ctx, backend) && qn_etag_ctx_update(ctx, buf, buf_size)) digest = qn_etag_ctx_final(ctx);
+    qn_etag_ctx_destroy(ctx);
+    return digest;
+}
+
+void test_backends_make_same_digests(void)
+{
+    int sizes[] = {(1 << 22) * 2, (1 << 22) * 9 + 3, (1 << 22) * (QN_ETAG_BLK_MAX_COUNT + 1) + 55};
+    qn_string expected;
+    qn_string digest;
+    char * buf;
+    int i;
+    int j;
+
+    if (qn_sha1_mb_lane_count() == 0) return;
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i += 1) {
+        buf = malloc(sizes[i]);
+        for (j = 0; j < sizes[i]; j += 1) buf[j] = (char)(j * 7 + (j >> 13));
+
+        expected = test_digest_buffer_by_backend(buf, sizes[i], QN_ETAG_BACKEND_OPENSSL);
+        digest = test_digest_buffer_by_backend(buf, sizes[i], QN_ETAG_BACKEND_MULTI_BUFFER);
+        free(buf);
+
+        CU_ASSERT_PTR_NOT_NULL(expected);
+        CU_ASSERT_PTR_NOT_NULL(digest);
+        CU_ASSERT_STRING_EQUAL(digest, expected);
+        qn_str_destroy(expected);
+        qn_str_destroy(digest);
+    } // for
+}
+
+CU_TestInfo test_normal_cases_of_backends[] = {
+    {"test_backends_make_same_digests()", test_backends_make_same_digests},
+    CU_TEST_INFO_NULL
+};
+
 // ---- test suites ----
 
 CU_SuiteInfo suites[] = {
     {"test_normal_cases_of_extern_functions", NULL, NULL, test_normal_cases_of_extern_functions},
     {"test_normal_cases_of_buffer_etags", NULL, NULL, test_normal_cases_of_buffer_etags},
+    {"test_normal_cases_of_concurrent_etags", NULL, NULL, test_normal_cases_of_concurrent_etags},
+    {"test_normal_cases_of_file_etags", NULL, NULL, test_normal_cases_of_file_etags},
+    {"test_normal_cases_of_backends", NULL, NULL, test_normal_cases_of_backends},
     CU_SUITE_INFO_NULL
 };
 
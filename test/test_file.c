@@ -0,0 +1,571 @@
+#include <CUnit/Basic.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "qiniu/base/errors.h"
+#include "qiniu/base/io.h"
+#include "qiniu/os/file.h"
+
+#define TEST_FILE_SIZE (1024 * 1024 * 3 + 777)
+
+static char test_fname[64];
+static char test_wr_fname[64];
+static char * test_data = NULL;
+
+static int test_create_file(char * fname, const char * data, size_t data_size)
+{
+    FILE * fp;
+    int fd;
+
+    strcpy(fname, "/tmp/qn_test_file_XXXXXX");
+    if ((fd = mkstemp(fname)) < 0) return -1;
+    if (! (fp = fdopen(fd, "wb"))) {
+        close(fd);
+        return -1;
+    } // if
+    if (fwrite(data, 1, data_size, fp) != data_size) {
+        fclose(fp);
+        return -1;
+    } // if
+    return fclose(fp);
+}
+
+static int test_init_file_suite(void)
+{
+    size_t i;
+
+    if (! (test_data = malloc(TEST_FILE_SIZE))) return -1;
+    for (i = 0; i < TEST_FILE_SIZE; i += 1) test_data[i] = (char)((i * 131) ^ (i >> 11));
+
+    if (test_create_file(test_fname, test_data, TEST_FILE_SIZE) != 0) return -1;
+    return test_create_file(test_wr_fname, "", 0);
+}
+
+static int test_clean_file_suite(void)
+{
+    unlink(test_fname);
+    unlink(test_wr_fname);
+    free(test_data);
+    test_data = NULL;
+    return 0;
+}
+
+// -- Read until EOF in pieces of the given sizes in turn, and check the data against the expected one.
+static size_t test_read_through(qn_io_reader_itf rdr, size_t offset, const size_t * sizes, int size_cnt)
+{
+    static char buf[256 * 1024];
+    ssize_t ret;
+    size_t total = 0;
+    int i = 0;
+
+    while ((ret = qn_io_rdr_read(rdr, buf, sizes[i])) > 0) {
+        CU_ASSERT_TRUE(ret <= sizes[i]);
+        if (memcmp(buf, test_data + offset + total, ret) != 0) {
+            CU_FAIL("Data read differs from the file content");
+            break;
+        } // if
+        total += ret;
+        i = (i + 1) % size_cnt;
+    } // while
+    CU_ASSERT_EQUAL(ret, QN_IO_RDR_EOF);
+    return total;
+}
+
+// ---- test functions of file ----
+
+void test_section_peek_then_read(void)
+{
+    static const size_t sizes[] = {4093};
+    char buf[512];
+    qn_file_ptr fl;
+    qn_fl_section_ptr fs;
+
+    fl = qn_fl_open(test_fname, NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fl);
+    fs = qn_fl_section(fl, 1000, 50000);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fs);
+
+    // -- Peeking does not consume the section, so it gets the same data each time.
+    CU_ASSERT_EQUAL(qn_fl_sec_peek(fs, buf, sizeof(buf)), sizeof(buf));
+    CU_ASSERT_TRUE(memcmp(buf, test_data + 1000, sizeof(buf)) == 0);
+    CU_ASSERT_EQUAL(qn_fl_sec_peek(fs, buf, sizeof(buf)), sizeof(buf));
+    CU_ASSERT_TRUE(memcmp(buf, test_data + 1000, sizeof(buf)) == 0);
+
+    // -- The whole section is still there after peeking.
+    CU_ASSERT_EQUAL(test_read_through(qn_fl_sec_to_io_reader(fs), 1000, sizes, 1), 50000);
+    CU_ASSERT_EQUAL(qn_fl_sec_peek(fs, buf, sizeof(buf)), QN_IO_RDR_EOF);
+
+    // -- Peek in the middle of the section, then read from the same position.
+    CU_ASSERT_TRUE(qn_fl_sec_seek(fs, 1000 + 49900));
+    CU_ASSERT_EQUAL(qn_fl_sec_peek(fs, buf, sizeof(buf)), 100);
+    CU_ASSERT_TRUE(memcmp(buf, test_data + 1000 + 49900, 100) == 0);
+    CU_ASSERT_EQUAL(qn_fl_sec_read(fs, buf, sizeof(buf)), 100);
+    CU_ASSERT_TRUE(memcmp(buf, test_data + 1000 + 49900, 100) == 0);
+    CU_ASSERT_EQUAL(qn_fl_sec_read(fs, buf, sizeof(buf)), QN_IO_RDR_EOF);
+
+    qn_fl_sec_destroy(fs);
+    qn_fl_close(fl);
+}
+
+void test_seek_advance_write_round_trip(void)
+{
+    qn_fl_open_extra fl_ext;
+    char buf[4096];
+    qn_file_ptr fl;
+
+    memset(&fl_ext, 0, sizeof(fl_ext));
+    fl_ext.flags = QN_FL_OPEN_WRITE;
+    fl = qn_fl_open(test_wr_fname, &fl_ext);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fl);
+
+    // -- Writing moves the position of the file, so read back from the beginning.
+    CU_ASSERT_EQUAL(qn_fl_write(fl, test_data, 10000), 10000);
+    CU_ASSERT_TRUE(qn_fl_seek(fl, 0));
+    CU_ASSERT_EQUAL(qn_fl_read(fl, buf, sizeof(buf)), sizeof(buf));
+    CU_ASSERT_TRUE(memcmp(buf, test_data, sizeof(buf)) == 0);
+
+    // -- Overwrite a range in the middle, then continue from the end of it.
+    CU_ASSERT_TRUE(qn_fl_seek(fl, 2000));
+    CU_ASSERT_EQUAL(qn_fl_write(fl, test_data + 5000, 500), 500);
+    CU_ASSERT_TRUE(qn_fl_advance(fl, 1000));
+    CU_ASSERT_EQUAL(qn_fl_read(fl, buf, 100), 100);
+    CU_ASSERT_TRUE(memcmp(buf, test_data + 3500, 100) == 0);
+
+    CU_ASSERT_TRUE(qn_fl_advance(fl, -1600));
+    CU_ASSERT_EQUAL(qn_fl_peek(fl, buf, 500), 500);
+    CU_ASSERT_TRUE(memcmp(buf, test_data + 5000, 500) == 0);
+    CU_ASSERT_EQUAL(qn_fl_read(fl, buf, 500), 500);
+    CU_ASSERT_TRUE(memcmp(buf, test_data + 5000, 500) == 0);
+    CU_ASSERT_EQUAL(qn_fl_read(fl, buf, 100), 100);
+    CU_ASSERT_TRUE(memcmp(buf, test_data + 2500, 100) == 0);
+
+    // -- Write at the end to extend the file.
+    CU_ASSERT_TRUE(qn_fl_seek(fl, 10000));
+    CU_ASSERT_EQUAL(qn_fl_write(fl, test_data + 10000, 3000), 3000);
+    CU_ASSERT_TRUE(qn_fl_seek(fl, 9000));
+    CU_ASSERT_EQUAL(qn_fl_read(fl, buf, sizeof(buf)), 4000);
+    CU_ASSERT_TRUE(memcmp(buf, test_data + 9000, 4000) == 0);
+    CU_ASSERT_EQUAL(qn_fl_read(fl, buf, sizeof(buf)), QN_IO_RDR_EOF);
+
+    CU_ASSERT_FALSE(qn_fl_seek(fl, -1));
+    qn_fl_close(fl);
+}
+
+// ---- test functions of read-ahead file ----
+
+#define TEST_RA_BUF_SIZE (64 * 1024)
+
+static qn_file_ptr test_open_read_ahead(const char * fname)
+{
+    qn_fl_open_extra fl_ext;
+
+    memset(&fl_ext, 0, sizeof(fl_ext));
+    fl_ext.flags = QN_FL_OPEN_READ_AHEAD;
+    fl_ext.ra_buf_size = TEST_RA_BUF_SIZE;
+    fl_ext.ra_depth = 3;
+    return qn_fl_open(fname, &fl_ext);
+}
+
+void test_ra_odd_read_sizes(void)
+{
+    static const size_t sizes[] = {1, 7, 4093, TEST_RA_BUF_SIZE + 1, 200001, TEST_RA_BUF_SIZE - 1};
+    qn_file_ptr fl;
+
+    fl = test_open_read_ahead(test_fname);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fl);
+    CU_ASSERT_EQUAL(test_read_through(qn_fl_to_io_reader(fl), 0, sizes, sizeof(sizes) / sizeof(sizes[0])), TEST_FILE_SIZE);
+    qn_fl_close(fl);
+}
+
+void test_ra_seek_back_and_forward(void)
+{
+    static const size_t sizes[] = {9973};
+    char buf[4096];
+    qn_file_ptr fl;
+
+    fl = test_open_read_ahead(test_fname);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fl);
+
+    // -- Start reading ahead, then go back into data already read.
+    CU_ASSERT_EQUAL(qn_fl_read(fl, buf, sizeof(buf)), sizeof(buf));
+    CU_ASSERT_EQUAL(qn_fl_read(fl, buf, sizeof(buf)), sizeof(buf));
+    CU_ASSERT_TRUE(memcmp(buf, test_data + 4096, sizeof(buf)) == 0);
+    CU_ASSERT_TRUE(qn_fl_seek(fl, 1000));
+    CU_ASSERT_EQUAL(qn_fl_read(fl, buf, sizeof(buf)), sizeof(buf));
+    CU_ASSERT_TRUE(memcmp(buf, test_data + 1000, sizeof(buf)) == 0);
+
+    // -- Jump over buffers in flight.
+    CU_ASSERT_TRUE(qn_fl_seek(fl, TEST_RA_BUF_SIZE * 10 + 3));
+    CU_ASSERT_EQUAL(qn_fl_read(fl, buf, sizeof(buf)), sizeof(buf));
+    CU_ASSERT_TRUE(memcmp(buf, test_data + TEST_RA_BUF_SIZE * 10 + 3, sizeof(buf)) == 0);
+    CU_ASSERT_TRUE(qn_fl_advance(fl, TEST_RA_BUF_SIZE / 2));
+    CU_ASSERT_EQUAL(qn_fl_read(fl, buf, sizeof(buf)), sizeof(buf));
+    CU_ASSERT_TRUE(memcmp(buf, test_data + TEST_RA_BUF_SIZE * 10 + 3 + 4096 + TEST_RA_BUF_SIZE / 2, sizeof(buf)) == 0);
+
+    // -- Back to the beginning and read through.
+    CU_ASSERT_TRUE(qn_fl_seek(fl, 0));
+    CU_ASSERT_EQUAL(test_read_through(qn_fl_to_io_reader(fl), 0, sizes, 1), TEST_FILE_SIZE);
+
+    // -- Near the end of the file.
+    CU_ASSERT_TRUE(qn_fl_seek(fl, TEST_FILE_SIZE - 10));
+    CU_ASSERT_EQUAL(qn_fl_read(fl, buf, sizeof(buf)), 10);
+    CU_ASSERT_TRUE(memcmp(buf, test_data + TEST_FILE_SIZE - 10, 10) == 0);
+    CU_ASSERT_EQUAL(qn_fl_read(fl, buf, sizeof(buf)), QN_IO_RDR_EOF);
+    qn_fl_close(fl);
+}
+
+void test_ra_peek_then_read(void)
+{
+    char peek_buf[5000];
+    char buf[5000];
+    qn_file_ptr fl;
+    ssize_t peek_ret;
+    ssize_t ret;
+    size_t pos = 0;
+
+    fl = test_open_read_ahead(test_fname);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fl);
+
+    // -- Peeks cross buffer boundaries as reads go on. Both may stop at the end of a buffer, but at the same place.
+    while (pos < TEST_RA_BUF_SIZE * 5) {
+        peek_ret = qn_fl_peek(fl, peek_buf, sizeof(peek_buf));
+        ret = qn_fl_read(fl, buf, sizeof(buf));
+        CU_ASSERT_TRUE(ret > 0);
+        CU_ASSERT_EQUAL(peek_ret, ret);
+        if (ret <= 0 || peek_ret != ret) break;
+        CU_ASSERT_TRUE(memcmp(peek_buf, test_data + pos, ret) == 0);
+        CU_ASSERT_TRUE(memcmp(buf, test_data + pos, ret) == 0);
+        pos += ret;
+    } // while
+    qn_fl_close(fl);
+}
+
+void test_ra_section_ending_mid_buffer(void)
+{
+    static const size_t sizes[] = {3001, TEST_RA_BUF_SIZE};
+    char buf[512];
+    qn_file_ptr fl;
+    qn_fl_section_ptr fs;
+    qn_fl_section_ptr fs2;
+
+    // -- Use one section at a time, since sections share the file offset in builds without positional reads.
+    fl = test_open_read_ahead(test_fname);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fl);
+    fs = qn_fl_section(fl, 100000, TEST_RA_BUF_SIZE * 2 + 12345);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fs);
+
+    // -- Neither section reads beyond its end, even if its last buffer ends in the middle.
+    CU_ASSERT_EQUAL(qn_fl_sec_peek(fs, buf, sizeof(buf)), sizeof(buf));
+    CU_ASSERT_TRUE(memcmp(buf, test_data + 100000, sizeof(buf)) == 0);
+    CU_ASSERT_EQUAL(test_read_through(qn_fl_sec_to_io_reader(fs), 100000, sizes, 2), TEST_RA_BUF_SIZE * 2 + 12345);
+
+    fs2 = qn_fl_section(fl, 100000 + TEST_RA_BUF_SIZE * 2 + 12345, TEST_RA_BUF_SIZE / 3);
+    CU_ASSERT_PTR_NOT_NULL(fs2);
+    if (fs2) {
+        CU_ASSERT_EQUAL(test_read_through(qn_fl_sec_to_io_reader(fs2), 100000 + TEST_RA_BUF_SIZE * 2 + 12345, sizes, 2), TEST_RA_BUF_SIZE / 3);
+        qn_fl_sec_destroy(fs2);
+    } // if
+
+    CU_ASSERT_TRUE(qn_fl_sec_reset(fs));
+    CU_ASSERT_EQUAL(test_read_through(qn_fl_sec_to_io_reader(fs), 100000, sizes + 1, 1), TEST_RA_BUF_SIZE * 2 + 12345);
+
+    qn_fl_sec_destroy(fs);
+    qn_fl_close(fl);
+}
+
+void test_ra_sections_one_after_another(void)
+{
+    static const size_t sizes[] = {7001};
+    static const size_t sec_sizes[] = {TEST_RA_BUF_SIZE / 3, TEST_RA_BUF_SIZE * 4, TEST_RA_BUF_SIZE + 1, TEST_RA_BUF_SIZE * 4};
+    char buf[1000];
+    qn_file_ptr fl;
+    qn_fl_section_ptr fs;
+    size_t offset = 12345;
+    int i;
+
+    fl = test_open_read_ahead(test_fname);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fl);
+
+    // -- Each section takes over the ring of the previous one, including one set up for a smaller range.
+    for (i = 0; i < sizeof(sec_sizes) / sizeof(sec_sizes[0]); i += 1) {
+        fs = qn_fl_section(fl, offset, sec_sizes[i]);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(fs);
+        CU_ASSERT_EQUAL(test_read_through(qn_fl_sec_to_io_reader(fs), offset, sizes, 1), sec_sizes[i]);
+        qn_fl_sec_destroy(fs);
+        offset += sec_sizes[i];
+    } // for
+
+    // -- A section destroyed with reads in flight leaves a ring ready for the next one.
+    fs = qn_fl_section(fl, 0, TEST_RA_BUF_SIZE * 8);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fs);
+    CU_ASSERT_EQUAL(qn_fl_sec_read(fs, buf, sizeof(buf)), sizeof(buf));
+    CU_ASSERT_TRUE(memcmp(buf, test_data, sizeof(buf)) == 0);
+    qn_fl_sec_destroy(fs);
+
+    fs = qn_fl_section(fl, TEST_RA_BUF_SIZE * 3 + 5, TEST_RA_BUF_SIZE * 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fs);
+    CU_ASSERT_EQUAL(test_read_through(qn_fl_sec_to_io_reader(fs), TEST_RA_BUF_SIZE * 3 + 5, sizes, 1), TEST_RA_BUF_SIZE * 2);
+    qn_fl_sec_destroy(fs);
+
+    // -- The file itself reads on after its sections are gone.
+    CU_ASSERT_TRUE(qn_fl_seek(fl, 0));
+    CU_ASSERT_EQUAL(test_read_through(qn_fl_to_io_reader(fl), 0, sizes, 1), TEST_FILE_SIZE);
+    qn_fl_close(fl);
+}
+
+void test_ra_file_smaller_than_buffer(void)
+{
+    static const size_t sizes[] = {TEST_RA_BUF_SIZE * 2};
+    char small_fname[64];
+    char buf[100];
+    qn_file_ptr fl;
+
+    CU_ASSERT_EQUAL_FATAL(test_create_file(small_fname, test_data, 1000), 0);
+    fl = test_open_read_ahead(small_fname);
+    CU_ASSERT_PTR_NOT_NULL(fl);
+    if (fl) {
+        CU_ASSERT_EQUAL(qn_fl_peek(fl, buf, sizeof(buf)), sizeof(buf));
+        CU_ASSERT_TRUE(memcmp(buf, test_data, sizeof(buf)) == 0);
+        CU_ASSERT_EQUAL(test_read_through(qn_fl_to_io_reader(fl), 0, sizes, 1), 1000);
+        qn_fl_close(fl);
+    } // if
+    unlink(small_fname);
+}
+
+// ---- test functions of read-ahead reader ----
+
+#define TEST_RARDR_BUF_SIZE (64 * 1024)
+#define TEST_RARDR_DEPTH 3
+
+// -- A reader giving the file content up to a given offset, and failing after that.
+typedef struct _TEST_FAILING_READER
+{
+    qn_io_reader_ptr rdr_vtbl;
+    size_t pos;
+    size_t fail_pos;
+} test_failing_reader;
+
+static ssize_t test_failing_read_vfn(qn_io_reader_itf restrict itf, char * restrict buf, size_t buf_size)
+{
+    test_failing_reader * rdr = (test_failing_reader *) itf;
+
+    if (rdr->pos == rdr->fail_pos) {
+        qn_err_fl_set_reading_file_failed();
+        return QN_IO_RDR_READING_FAILED;
+    } // if
+    if (buf_size > rdr->fail_pos - rdr->pos) buf_size = rdr->fail_pos - rdr->pos;
+    memcpy(buf, test_data + rdr->pos, buf_size);
+    rdr->pos += buf_size;
+    return buf_size;
+}
+
+static qn_io_reader_st test_failing_reader_vtable = {
+    NULL, // CLOSE
+    NULL, // PEEK
+    &test_failing_read_vfn,
+    NULL, // SEEK
+    NULL, // ADVANCE
+    NULL, // DUPLICATE
+    NULL, // SECTION
+    NULL, // NAME
+    NULL  // SIZE
+};
+
+void test_rardr_sequential_read(void)
+{
+    static const size_t sizes[] = {1, 4093, TEST_RARDR_BUF_SIZE, TEST_RARDR_BUF_SIZE + 1, 200001};
+    qn_file_ptr fl;
+    qn_io_read_ahead_reader_ptr ra;
+
+    fl = qn_fl_open(test_fname, NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fl);
+    ra = qn_io_rardr_create(qn_fl_to_io_reader(fl), TEST_RARDR_BUF_SIZE, TEST_RARDR_DEPTH);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ra);
+
+    CU_ASSERT_EQUAL(qn_io_rdr_size(qn_io_rardr_to_io_reader(ra)), TEST_FILE_SIZE);
+    CU_ASSERT_EQUAL(test_read_through(qn_io_rardr_to_io_reader(ra), 0, sizes, sizeof(sizes) / sizeof(sizes[0])), TEST_FILE_SIZE);
+
+    qn_io_rardr_destroy(ra);
+    qn_fl_close(fl);
+}
+
+void test_rardr_seek_then_read(void)
+{
+    static const size_t sizes[] = {7777};
+    char buf[4096];
+    qn_file_ptr fl;
+    qn_io_read_ahead_reader_ptr ra;
+    qn_io_reader_itf rdr;
+
+    fl = qn_fl_open(test_fname, NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fl);
+    ra = qn_io_rardr_create(qn_fl_to_io_reader(fl), TEST_RARDR_BUF_SIZE, TEST_RARDR_DEPTH);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ra);
+    rdr = qn_io_rardr_to_io_reader(ra);
+
+    // -- Buffers read ahead are dropped on seeking, both forward and backward.
+    CU_ASSERT_EQUAL(qn_io_rdr_read(rdr, buf, sizeof(buf)), sizeof(buf));
+    CU_ASSERT_TRUE(qn_io_rdr_seek(rdr, 1000000));
+    CU_ASSERT_EQUAL(qn_io_rdr_read(rdr, buf, sizeof(buf)), sizeof(buf));
+    CU_ASSERT_TRUE(memcmp(buf, test_data + 1000000, sizeof(buf)) == 0);
+    CU_ASSERT_TRUE(qn_io_rdr_seek(rdr, 12345));
+    CU_ASSERT_EQUAL(test_read_through(rdr, 12345, sizes, 1), TEST_FILE_SIZE - 12345);
+
+    qn_io_rardr_destroy(ra);
+    qn_fl_close(fl);
+}
+
+void test_rardr_advance(void)
+{
+    static const size_t sizes[] = {TEST_RARDR_BUF_SIZE / 2};
+    char buf[4096];
+    qn_file_ptr fl;
+    qn_io_read_ahead_reader_ptr ra;
+    qn_io_reader_itf rdr;
+    size_t pos;
+
+    fl = qn_fl_open(test_fname, NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fl);
+    ra = qn_io_rardr_create(qn_fl_to_io_reader(fl), TEST_RARDR_BUF_SIZE, TEST_RARDR_DEPTH);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ra);
+    rdr = qn_io_rardr_to_io_reader(ra);
+
+    // -- Within the current buffer.
+    CU_ASSERT_EQUAL(qn_io_rdr_read(rdr, buf, 100), 100);
+    CU_ASSERT_TRUE(qn_io_rdr_advance(rdr, 1000));
+    pos = 1100;
+    CU_ASSERT_EQUAL(qn_io_rdr_peek(rdr, buf, sizeof(buf)), sizeof(buf));
+    CU_ASSERT_TRUE(memcmp(buf, test_data + pos, sizeof(buf)) == 0);
+
+    // -- Across buffer boundaries, into data likely read ahead.
+    CU_ASSERT_TRUE(qn_io_rdr_advance(rdr, TEST_RARDR_BUF_SIZE + 7));
+    pos += TEST_RARDR_BUF_SIZE + 7;
+    CU_ASSERT_EQUAL(qn_io_rdr_read(rdr, buf, 100), 100);
+    CU_ASSERT_TRUE(memcmp(buf, test_data + pos, 100) == 0);
+    pos += 100;
+
+    // -- Beyond all buffers, so the source has to move for the rest.
+    CU_ASSERT_TRUE(qn_io_rdr_advance(rdr, TEST_RARDR_BUF_SIZE * TEST_RARDR_DEPTH * 2 + 3));
+    pos += TEST_RARDR_BUF_SIZE * TEST_RARDR_DEPTH * 2 + 3;
+    CU_ASSERT_EQUAL(test_read_through(rdr, pos, sizes, 1), TEST_FILE_SIZE - pos);
+
+    qn_io_rardr_destroy(ra);
+    qn_fl_close(fl);
+}
+
+void test_rardr_detach_then_eof(void)
+{
+    char buf[4096];
+    qn_file_ptr fl;
+    qn_io_read_ahead_reader_ptr ra;
+
+    fl = qn_fl_open(test_fname, NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fl);
+    ra = qn_io_rardr_create(qn_fl_to_io_reader(fl), TEST_RARDR_BUF_SIZE, TEST_RARDR_DEPTH);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ra);
+
+    CU_ASSERT_EQUAL(qn_io_rdr_read(qn_io_rardr_to_io_reader(ra), buf, sizeof(buf)), sizeof(buf));
+    CU_ASSERT_TRUE(memcmp(buf, test_data, sizeof(buf)) == 0);
+
+    // -- Nothing is left from the detached source, and the source itself may be closed.
+    qn_io_rardr_reset(ra, NULL);
+    qn_fl_close(fl);
+    CU_ASSERT_EQUAL(qn_io_rdr_peek(qn_io_rardr_to_io_reader(ra), buf, sizeof(buf)), QN_IO_RDR_EOF);
+    CU_ASSERT_EQUAL(qn_io_rdr_read(qn_io_rardr_to_io_reader(ra), buf, sizeof(buf)), QN_IO_RDR_EOF);
+
+    qn_io_rardr_destroy(ra);
+}
+
+void test_rardr_failing_source(void)
+{
+    static const size_t sizes[] = {5000};
+    test_failing_reader src;
+    qn_io_read_ahead_reader_ptr ra;
+    qn_io_reader_itf rdr;
+    char buf[5000];
+    size_t total = 0;
+    ssize_t ret;
+
+    src.rdr_vtbl = &test_failing_reader_vtable;
+    src.pos = 0;
+    src.fail_pos = TEST_RARDR_BUF_SIZE * 2 + 4321;
+
+    ra = qn_io_rardr_create((qn_io_reader_itf) &src.rdr_vtbl, TEST_RARDR_BUF_SIZE, TEST_RARDR_DEPTH);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(ra);
+    rdr = qn_io_rardr_to_io_reader(ra);
+
+    // -- All data before the failure is delivered, then the error of the helper thread shows up in this thread.
+    qn_err_set_succeed();
+    while ((ret = qn_io_rdr_read(rdr, buf, sizes[0])) > 0) {
+        CU_ASSERT_TRUE(memcmp(buf, test_data + total, ret) == 0);
+        total += ret;
+    } // while
+    CU_ASSERT_EQUAL(total, src.fail_pos);
+    CU_ASSERT_EQUAL(ret, QN_IO_RDR_READING_FAILED);
+    CU_ASSERT_TRUE(qn_err_fl_is_reading_file_failed());
+
+    qn_io_rardr_destroy(ra);
+}
+
+CU_TestInfo test_file_cases[] = {
+    {"test_section_peek_then_read()", test_section_peek_then_read},
+    {"test_seek_advance_write_round_trip()", test_seek_advance_write_round_trip},
+    CU_TEST_INFO_NULL
+};
+
+CU_TestInfo test_read_ahead_cases[] = {
+    {"test_ra_odd_read_sizes()", test_ra_odd_read_sizes},
+    {"test_ra_seek_back_and_forward()", test_ra_seek_back_and_forward},
+    {"test_ra_peek_then_read()", test_ra_peek_then_read},
+    {"test_ra_section_ending_mid_buffer()", test_ra_section_ending_mid_buffer},
+    {"test_ra_file_smaller_than_buffer()", test_ra_file_smaller_than_buffer},
+    {"test_ra_sections_one_after_another()", test_ra_sections_one_after_another},
+    CU_TEST_INFO_NULL
+};
+
+CU_TestInfo test_read_ahead_reader_cases[] = {
+    {"test_rardr_sequential_read()", test_rardr_sequential_read},
+    {"test_rardr_seek_then_read()", test_rardr_seek_then_read},
+    {"test_rardr_advance()", test_rardr_advance},
+    {"test_rardr_detach_then_eof()", test_rardr_detach_then_eof},
+    {"test_rardr_failing_source()", test_rardr_failing_source},
+    CU_TEST_INFO_NULL
+};
+
+// ---- test suites ----
+
+CU_SuiteInfo suites[] = {
+    {"test_file_cases", test_init_file_suite, test_clean_file_suite, test_file_cases},
+    {"test_read_ahead_cases", test_init_file_suite, test_clean_file_suite, test_read_ahead_cases},
+    {"test_read_ahead_reader_cases", test_init_file_suite, test_clean_file_suite, test_read_ahead_reader_cases},
+    CU_SUITE_INFO_NULL
+};
+
+int main(void)
+{
+    CU_pSuite pSuite = NULL;
+
+    if (CU_initialize_registry() != CUE_SUCCESS) {
+        return CU_get_error();
+    } // if
+
+    pSuite = CU_add_suite("Suite_Test_File", NULL, NULL);
+    if (pSuite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    } // if
+
+    if (CU_register_suites(suites) != CUE_SUCCESS) {
+        printf("Cannot register test suites.\n");
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+} // main
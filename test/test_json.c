@@ -591,6 +591,94 @@ void test_arr_replace()
     qn_json_destroy_array(arr_root);
 }
 
+void test_obj_with_many_keys(void)
+{
+    qn_bool ret = qn_false;
+    qn_json_object_ptr obj_root = NULL;
+    qn_string str = NULL;
+    const char * keys[] = {"_k", "_c", "_o", "_a", "_m", "_e", "_q", "_b", "_n", "_d", "_p", "_f"};
+    int i = 0;
+
+    obj_root = qn_json_create_object();
+    CU_ASSERT_FATAL(obj_root != NULL);
+
+    // push enough keys in unsorted order to make the object build its index
+    for (i = 0; i < sizeof(keys) / sizeof(keys[0]); i += 1) {
+        ret = qn_json_set_integer(obj_root, keys[i], i);
+        CU_ASSERT_TRUE(ret);
+    } // for
+    CU_ASSERT_EQUAL(qn_json_size_object(obj_root), sizeof(keys) / sizeof(keys[0]));
+
+    for (i = 0; i < sizeof(keys) / sizeof(keys[0]); i += 1) {
+        CU_ASSERT_EQUAL(qn_json_get_integer(obj_root, keys[i], -1), i);
+    } // for
+
+    // replace an existing key
+    ret = qn_json_set_integer(obj_root, "_m", 100);
+    CU_ASSERT_TRUE(ret);
+    CU_ASSERT_EQUAL(qn_json_size_object(obj_root), sizeof(keys) / sizeof(keys[0]));
+    CU_ASSERT_EQUAL(qn_json_get_integer(obj_root, "_m", -1), 100);
+
+    qn_json_unset(obj_root, "_a");
+    qn_json_unset(obj_root, "_q");
+    qn_json_unset(obj_root, "_x");
+    CU_ASSERT_EQUAL(qn_json_size_object(obj_root), sizeof(keys) / sizeof(keys[0]) - 2);
+    CU_ASSERT_EQUAL(qn_json_get_integer(obj_root, "_a", -1), -1);
+    CU_ASSERT_EQUAL(qn_json_get_integer(obj_root, "_q", -1), -1);
+    CU_ASSERT_EQUAL(qn_json_get_integer(obj_root, "_f", -1), 11);
+
+    ret = qn_json_rename(obj_root, "_k", "_z");
+    CU_ASSERT_TRUE(ret);
+    CU_ASSERT_EQUAL(qn_json_get_integer(obj_root, "_k", -1), -1);
+    CU_ASSERT_EQUAL(qn_json_get_integer(obj_root, "_z", -1), 0);
+
+    // the formatter must still output keys in order
+    str = qn_json_object_to_string(obj_root);
+    CU_ASSERT_FATAL(str != NULL);
+    CU_ASSERT_STRING_EQUAL(qn_str_cstr(str), "{\"_b\":7,\"_c\":1,\"_d\":9,\"_e\":5,\"_f\":11,\"_m\":100,\"_n\":8,\"_o\":2,\"_p\":10,\"_z\":0}");
+    qn_str_destroy(str);
+
+    qn_json_destroy_object(obj_root);
+}
+
+void test_containers_beyond_65535_elements(void)
+{
+    qn_bool ret = qn_false;
+    qn_json_object_ptr obj_root = NULL;
+    qn_json_array_ptr arr_root = NULL;
+    char key[16];
+    int i = 0;
+
+    obj_root = qn_json_create_object();
+    CU_ASSERT_FATAL(obj_root != NULL);
+
+    arr_root = qn_json_create_array();
+    CU_ASSERT_FATAL(arr_root != NULL);
+
+    for (i = 0; i < 70000; i += 1) {
+        sprintf(key, "_k%d", i);
+        ret = qn_json_set_integer(obj_root, key, i);
+        if (!ret) break;
+        ret = (i % 2 == 0) ? qn_json_push_integer(arr_root, i) : qn_json_unshift_integer(arr_root, i);
+        if (!ret) break;
+    } // for
+    CU_ASSERT_TRUE(ret);
+
+    CU_ASSERT_EQUAL(qn_json_size_object(obj_root), 70000);
+    CU_ASSERT_EQUAL(qn_json_get_integer(obj_root, "_k0", -1), 0);
+    CU_ASSERT_EQUAL(qn_json_get_integer(obj_root, "_k65535", -1), 65535);
+    CU_ASSERT_EQUAL(qn_json_get_integer(obj_root, "_k69999", -1), 69999);
+
+    CU_ASSERT_EQUAL(qn_json_size_array(arr_root), 70000);
+    CU_ASSERT_EQUAL(qn_json_pick_integer(arr_root, 0, -1), 69999);
+    CU_ASSERT_EQUAL(qn_json_pick_integer(arr_root, 34999, -1), 1);
+    CU_ASSERT_EQUAL(qn_json_pick_integer(arr_root, 35000, -1), 0);
+    CU_ASSERT_EQUAL(qn_json_pick_integer(arr_root, 69999, -1), 69998);
+
+    qn_json_destroy_array(arr_root);
+    qn_json_destroy_object(obj_root);
+}
+
 CU_TestInfo test_normal_cases_of_json_manipulating[] = {
     {"test_manipulate_object()", test_manipulate_object},
     {"test_obj_rename_alone_field_1_new_key_greater_than_old_key()", test_obj_rename_alone_field_1_new_key_greater_than_old_key},
@@ -605,8 +693,10 @@ CU_TestInfo test_normal_cases_of_json_manipulating[] = {
     {"test_obj_rename_accompanied_field_3_new_key_equals_to_old_key()", test_obj_rename_accompanied_field_3_new_key_equals_to_old_key},
     {"test_obj_rename_accompanied_field_4_new_key_replace_old_key_in_place()", test_obj_rename_accompanied_field_4_new_key_replace_old_key_in_place},
     {"test_obj_set()", test_obj_set},
+    {"test_obj_with_many_keys()", test_obj_with_many_keys},
     {"test_manipulate_array()", test_manipulate_array},
     {"test_arr_replace()", test_arr_replace},
+    {"test_containers_beyond_65535_elements()", test_containers_beyond_65535_elements},
     CU_TEST_INFO_NULL
 };
 
@@ -1487,6 +1577,192 @@ void test_parse_array_holding_embedded_arrays(void)
     qn_json_destroy_array(arr_root);
 }
 
+void test_parse_object_in_arena(void)
+{
+    qn_bool ret;
+    const char buf[] = {"{\"items\":[{\"key\":\"a.txt\",\"fsize\":123},{\"key\":\"b.txt\",\"fsize\":456}],\"marker\":\"xyz\"}"};
+    qn_size buf_len = 30;
+    qn_json_object_ptr obj_root = NULL;
+    qn_json_object_ptr obj_elem = NULL;
+    qn_json_array_ptr arr_elem = NULL;
+    qn_json_variant new_elem;
+    qn_string str = NULL;
+    qn_json_parser_ptr prs = NULL;
+
+    prs = qn_json_prs_create();
+    CU_ASSERT_FATAL(prs != NULL);
+
+    qn_json_prs_use_arena(prs, qn_true);
+
+    // input in two chunks
+    ret = qn_json_prs_parse_object(prs, buf, &buf_len, &obj_root);
+    CU_ASSERT_FALSE(ret);
+    CU_ASSERT_TRUE(qn_err_json_is_need_more_text_input());
+
+    buf_len = strlen(buf) - 30;
+    ret = qn_json_prs_parse_object(prs, buf + 30, &buf_len, &obj_root);
+    qn_json_prs_destroy(prs);
+    if (!ret) {
+        CU_FAIL("Cannot parse the object in an arena.");
+        return;
+    } // if
+
+    arr_elem = qn_json_get_array(obj_root, "items", NULL);
+    CU_ASSERT_FATAL(arr_elem != NULL);
+    CU_ASSERT_EQUAL(qn_json_size_array(arr_elem), 2);
+
+    obj_elem = qn_json_pick_object(arr_elem, 1, NULL);
+    CU_ASSERT_FATAL(obj_elem != NULL);
+    CU_ASSERT_STRING_EQUAL(qn_json_get_cstr(obj_elem, "key", ""), "b.txt");
+    CU_ASSERT_EQUAL(qn_json_get_integer(obj_elem, "fsize", 0), 456);
+    CU_ASSERT_STRING_EQUAL(qn_json_get_cstr(obj_root, "marker", ""), "xyz");
+
+    // the tree in an arena can be modified as usual
+    ret = qn_json_set_cstr(obj_elem, "key", "c.txt");
+    CU_ASSERT_TRUE(ret);
+    qn_json_shift(arr_elem);
+
+    obj_elem = qn_json_create_object();
+    CU_ASSERT_FATAL(obj_elem != NULL);
+    ret = qn_json_set_integer(obj_elem, "_int", 789);
+    CU_ASSERT_TRUE(ret);
+    ret = qn_json_set_object(obj_root, "_obj", obj_elem);
+    CU_ASSERT_TRUE(ret);
+
+    // the string is moved into the arena
+    new_elem.string = qn_cs_duplicate("A line for creating string element.");
+    CU_ASSERT_FATAL(new_elem.string != NULL);
+    ret = qn_json_set_variant(obj_root, "marker", QN_JSON_STRING, new_elem);
+    CU_ASSERT_TRUE(ret);
+
+    ret = qn_json_rename(obj_root, "marker", "_str");
+    CU_ASSERT_TRUE(ret);
+
+    str = qn_json_object_to_string(obj_root);
+    CU_ASSERT_FATAL(str != NULL);
+    CU_ASSERT_STRING_EQUAL(qn_str_cstr(str), "{\"_obj\":{\"_int\":789},\"_str\":\"A line for creating string element.\",\"items\":[{\"fsize\":456,\"key\":\"c.txt\"}]}");
+    qn_str_destroy(str);
+
+    qn_json_destroy_object(obj_root);
+}
+
+void test_parse_object_holding_four_levels(void)
+{
+    qn_bool ret;
+    const char buf[] = {"{\"items\":[{\"key\":\"a.txt\",\"meta\":{\"_int\":1}},{\"key\":\"b.txt\"}]}"};
+    qn_size buf_len = strlen(buf);
+    qn_json_object_ptr obj_root = NULL;
+    qn_json_parser_ptr prs = NULL;
+    qn_string str = NULL;
+
+    prs = qn_json_prs_create();
+    CU_ASSERT_FATAL(prs != NULL);
+
+    // the stack of levels grows while parsing the innermost object
+    ret = qn_json_prs_parse_object(prs, buf, &buf_len, &obj_root);
+    qn_json_prs_destroy(prs);
+    if (!ret) {
+        CU_FAIL("Cannot parse the object holding four levels.");
+        return;
+    } // if
+
+    str = qn_json_object_to_string(obj_root);
+    CU_ASSERT_FATAL(str != NULL);
+    CU_ASSERT_STRING_EQUAL(qn_str_cstr(str), buf);
+    qn_str_destroy(str);
+
+    qn_json_destroy_object(obj_root);
+}
+
+typedef struct _TEST_EVENT_LOG
+{
+    char txt[512];
+    int cnt;
+    int stop_at;
+} test_event_log;
+
+static qn_bool test_record_event(void * restrict evt_data, qn_json_prs_event evt, const char * restrict key, qn_json_class cls, qn_json_variant_ptr restrict val)
+{
+    test_event_log * log = (test_event_log *) evt_data;
+    size_t len = strlen(log->txt);
+
+    log->cnt += 1;
+    if (log->cnt == log->stop_at) {
+        qn_err_set_no_such_entry();
+        return qn_false;
+    } // if
+
+    if (key) len += snprintf(log->txt + len, sizeof(log->txt) - len, "%s=", key);
+    switch (evt) {
+        case QN_JSON_PRS_OPEN_OBJECT: snprintf(log->txt + len, sizeof(log->txt) - len, "{"); break;
+        case QN_JSON_PRS_CLOSE_OBJECT: snprintf(log->txt + len, sizeof(log->txt) - len, "}"); break;
+        case QN_JSON_PRS_OPEN_ARRAY: snprintf(log->txt + len, sizeof(log->txt) - len, "["); break;
+        case QN_JSON_PRS_CLOSE_ARRAY: snprintf(log->txt + len, sizeof(log->txt) - len, "]"); break;
+        default:
+            switch (cls) {
+                case QN_JSON_STRING: snprintf(log->txt + len, sizeof(log->txt) - len, "'%s',", val->string); break;
+                case QN_JSON_INTEGER: snprintf(log->txt + len, sizeof(log->txt) - len, "%lld,", (long long) val->integer); break;
+                case QN_JSON_BOOLEAN: snprintf(log->txt + len, sizeof(log->txt) - len, "%s,", (val->boolean) ? "T" : "F"); break;
+                case QN_JSON_NULL: snprintf(log->txt + len, sizeof(log->txt) - len, "N,"); break;
+                default: snprintf(log->txt + len, sizeof(log->txt) - len, "?,"); break;
+            } // switch
+            break;
+    } // switch
+    return qn_true;
+}
+
+void test_parse_events_in_two_chunks(void)
+{
+    qn_bool ret;
+    const char buf[] = {"{\"items\":[{\"key\":\"a.txt\",\"fsize\":123},{\"key\":\"b.txt\",\"fsize\":456}],\"marker\":\"xyz\",\"flags\":[true,null]}"};
+    qn_size buf_len = 30;
+    test_event_log log;
+    qn_json_parser_ptr prs = NULL;
+
+    memset(&log, 0, sizeof(log));
+
+    prs = qn_json_prs_create();
+    CU_ASSERT_FATAL(prs != NULL);
+
+    ret = qn_json_prs_parse_events(prs, buf, &buf_len, &log, &test_record_event);
+    CU_ASSERT_FALSE(ret);
+    CU_ASSERT_TRUE(qn_err_json_is_need_more_text_input());
+
+    // events of elements in the first chunk are reported immediately
+    CU_ASSERT_STRING_EQUAL(log.txt, "{items=[{key='a.txt',");
+
+    buf_len = strlen(buf) - 30;
+    ret = qn_json_prs_parse_events(prs, buf + 30, &buf_len, &log, &test_record_event);
+    qn_json_prs_destroy(prs);
+    CU_ASSERT_TRUE(ret);
+    CU_ASSERT_STRING_EQUAL(log.txt, "{items=[{key='a.txt',fsize=123,}{key='b.txt',fsize=456,}]marker='xyz',flags=[T,N,]}");
+}
+
+void test_parse_array_holding_null(void)
+{
+    qn_bool ret;
+    const char buf[] = {"[null,false]"};
+    qn_size buf_len = strlen(buf);
+    qn_json_array_ptr arr_root = NULL;
+    qn_json_parser_ptr prs = NULL;
+
+    prs = qn_json_prs_create();
+    CU_ASSERT_FATAL(prs != NULL);
+
+    ret = qn_json_prs_parse_array(prs, buf, &buf_len, &arr_root);
+    qn_json_prs_destroy(prs);
+    if (!ret) {
+        CU_FAIL("Cannot parse the array holding null.");
+        return;
+    } // if
+
+    CU_ASSERT_EQUAL(qn_json_size_array(arr_root), 2);
+    CU_ASSERT_PTR_NOT_NULL(qn_json_pick_variant(arr_root, 0, QN_JSON_NULL));
+    CU_ASSERT_PTR_NOT_NULL(qn_json_pick_variant(arr_root, 1, QN_JSON_BOOLEAN));
+
+    qn_json_destroy_array(arr_root);
+}
+
 CU_TestInfo test_normal_cases_of_json_parsing[] = {
     {"test_parse_empty_object()", test_parse_empty_object},
     {"test_parse_object_holding_one_element()", test_parse_object_holding_one_element},
@@ -1519,6 +1795,10 @@ CU_TestInfo test_normal_cases_of_json_parsing[] = {
     {"test_parse_array_holding_ordinary_elements()", test_parse_array_holding_ordinary_elements},
     {"test_parse_array_holding_empty_complex_elements()", test_parse_array_holding_empty_complex_elements},
     {"test_parse_array_holding_embedded_arrays()", test_parse_array_holding_embedded_arrays},
+    {"test_parse_object_in_arena()", test_parse_object_in_arena},
+    {"test_parse_object_holding_four_levels()", test_parse_object_holding_four_levels},
+    {"test_parse_events_in_two_chunks()", test_parse_events_in_two_chunks},
+    {"test_parse_array_holding_null()", test_parse_array_holding_null},
     CU_TEST_INFO_NULL
 };
 
@@ -1587,10 +1867,62 @@ void test_parse_object_without_enough_input_of_value(void)
     } // if
 }
 
+void test_parse_object_holding_bad_embedded_object(void)
+{
+    qn_bool ret;
+    const char buf[] = {"{\"_obj\":{\"_key\":bad}}"};
+    qn_size buf_len = strlen(buf);
+    qn_json_object_ptr obj_root = NULL;
+    qn_json_parser_ptr prs = NULL;
+
+    prs = qn_json_prs_create();
+    CU_ASSERT_FATAL(prs != NULL);
+
+    ret = qn_json_prs_parse_object(prs, buf, &buf_len, &obj_root);
+    qn_json_prs_destroy(prs);
+    CU_ASSERT_FALSE(ret);
+    CU_ASSERT_PTR_NULL(obj_root);
+
+    if (!qn_err_json_is_bad_text_input()) {
+        CU_FAIL("The error is not `bad text input`.");
+        return;
+    } // if
+}
+
+void test_parse_events_aborted_by_callback(void)
+{
+    qn_bool ret;
+    const char buf[] = {"{\"_arr\":[1,2,3],\"_int\":4}"};
+    qn_size buf_len = strlen(buf);
+    test_event_log log;
+    qn_json_parser_ptr prs = NULL;
+
+    memset(&log, 0, sizeof(log));
+    log.stop_at = 5;
+
+    prs = qn_json_prs_create();
+    CU_ASSERT_FATAL(prs != NULL);
+
+    ret = qn_json_prs_parse_events(prs, buf, &buf_len, &log, &test_record_event);
+    CU_ASSERT_FALSE(ret);
+    CU_ASSERT_TRUE(qn_err_is_no_such_entry());
+    CU_ASSERT_STRING_EQUAL(log.txt, "{_arr=[1,2,");
+
+    // the parser is ready for another text after aborting
+    memset(&log, 0, sizeof(log));
+    buf_len = strlen(buf);
+    ret = qn_json_prs_parse_events(prs, buf, &buf_len, &log, &test_record_event);
+    qn_json_prs_destroy(prs);
+    CU_ASSERT_TRUE(ret);
+    CU_ASSERT_STRING_EQUAL(log.txt, "{_arr=[1,2,3,]_int=4,}");
+}
+
 CU_TestInfo test_abnormal_cases_of_json_parsing[] = {
     {"test_parse_object_without_enough_input_of_key_string()", test_parse_object_without_enough_input_of_key_string},
     {"test_parse_object_without_enough_input_of_integer()", test_parse_object_without_enough_input_of_integer},
     {"test_parse_object_without_enough_input_of_value()", test_parse_object_without_enough_input_of_value},
+    {"test_parse_object_holding_bad_embedded_object()", test_parse_object_holding_bad_embedded_object},
+    {"test_parse_events_aborted_by_callback()", test_parse_events_aborted_by_callback},
     CU_TEST_INFO_NULL
 };
 
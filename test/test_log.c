@@ -0,0 +1,145 @@
+#include <CUnit/Basic.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "qiniu/log.h"
+
+#define TEST_THREAD_COUNT 8
+#define TEST_RECORDS_PER_THREAD 20000
+
+typedef struct _TEST_LOG_WRITER
+{
+    qn_io_writer_ptr vtbl;
+    qn_size lines;
+    qn_size bytes;
+    qn_size writes;
+    qn_bool broken;
+} test_log_writer;
+
+static ssize_t test_log_wrt_write(qn_io_writer_itf restrict itf, const char * restrict buf, size_t buf_size)
+{
+    test_log_writer * wrt = (test_log_writer *) itf;
+    size_t i;
+
+    // -- Each write must consist of whole records.
+    if (buf_size == 0 || buf[buf_size - 1] != '\n') wrt->broken = qn_true;
+    for (i = 0; i < buf_size; i += 1) if (buf[i] == '\n') wrt->lines += 1;
+    wrt->bytes += buf_size;
+    wrt->writes += 1;
+    return buf_size;
+}
+
+static qn_io_writer_st test_log_wrt_vtable = {
+    NULL,
+    &test_log_wrt_write,
+    NULL
+};
+
+static void * test_log_routine(void * arg)
+{
+    int i;
+
+    for (i = 0; i < TEST_RECORDS_PER_THREAD; i += 1) {
+        qn_log_info(__FILE__, __LINE__, "thread %ld record %d", (long) arg, i);
+    } // for
+    return NULL;
+}
+
+static void test_log_from_threads(qn_uint32 rec_cnt)
+{
+    test_log_writer wrt;
+    pthread_t ths[TEST_THREAD_COUNT];
+    qn_uint64 dropped = qn_log_get_dropped_count();
+    int i;
+
+    memset(&wrt, 0, sizeof(wrt));
+    wrt.vtbl = &test_log_wrt_vtable;
+    qn_log_set_writer((qn_io_writer_itf) &wrt);
+
+    CU_ASSERT_TRUE(qn_log_start_async(rec_cnt));
+    for (i = 0; i < TEST_THREAD_COUNT; i += 1) pthread_create(&ths[i], NULL, &test_log_routine, (void *)(long) i);
+    for (i = 0; i < TEST_THREAD_COUNT; i += 1) pthread_join(ths[i], NULL);
+    qn_log_stop_async();
+
+    qn_log_set_writer(NULL);
+
+    // -- Every record is either written out or counted as dropped.
+    CU_ASSERT_FALSE(wrt.broken);
+    CU_ASSERT_EQUAL(wrt.lines + (qn_log_get_dropped_count() - dropped), TEST_THREAD_COUNT * TEST_RECORDS_PER_THREAD);
+    CU_ASSERT_TRUE(wrt.lines > 0);
+}
+
+void test_log_async_from_threads(void)
+{
+    test_log_from_threads(0);
+}
+
+void test_log_async_with_small_ring(void)
+{
+    test_log_from_threads(16);
+}
+
+void test_log_async_truncating_long_records(void)
+{
+    test_log_writer wrt;
+    char msg[QN_LOG_RECORD_MAX_SIZE * 2];
+
+    memset(&wrt, 0, sizeof(wrt));
+    wrt.vtbl = &test_log_wrt_vtable;
+    qn_log_set_writer((qn_io_writer_itf) &wrt);
+
+    memset(msg, 'x', sizeof(msg) - 1);
+    msg[sizeof(msg) - 1] = '\0';
+
+    CU_ASSERT_TRUE(qn_log_start_async(0));
+    qn_log_info_cstr(__FILE__, __LINE__, msg);
+    qn_log_stop_async();
+
+    qn_log_set_writer(NULL);
+
+    CU_ASSERT_FALSE(wrt.broken);
+    CU_ASSERT_EQUAL(wrt.lines, 1);
+    CU_ASSERT_EQUAL(wrt.bytes, QN_LOG_RECORD_MAX_SIZE);
+}
+
+CU_TestInfo test_normal_cases[] = {
+    {"test_log_async_from_threads()", test_log_async_from_threads},
+    {"test_log_async_with_small_ring()", test_log_async_with_small_ring},
+    {"test_log_async_truncating_long_records()", test_log_async_truncating_long_records},
+    CU_TEST_INFO_NULL
+};
+
+// ---- test suites ----
+
+CU_SuiteInfo suites[] = {
+    {"test_normal_cases", NULL, NULL, test_normal_cases},
+    CU_SUITE_INFO_NULL
+};
+
+int main(void)
+{
+    CU_pSuite pSuite = NULL;
+
+    if (CU_initialize_registry() != CUE_SUCCESS) {
+        return CU_get_error();
+    } // if
+
+    pSuite = CU_add_suite("Suite_Test_Log", NULL, NULL);
+    if (pSuite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    } // if
+
+    if (CU_register_suites(suites) != CUE_SUCCESS) {
+        printf("Cannot register test suites.\n");
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+} // main
@@ -0,0 +1,137 @@
+#include <CUnit/Basic.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "qiniu/base/json.h"
+#include "qiniu/base/json_parser.h"
+#include "qiniu/base/metrics.h"
+
+#define TEST_THREAD_COUNT 4
+#define TEST_REQUESTS_PER_THREAD 10000
+
+static void * test_record_requests(void * arg)
+{
+    int i;
+
+    for (i = 1; i <= TEST_REQUESTS_PER_THREAD; i += 1) {
+        qn_mtr_record_request(QN_MTR_API_BPUT, (i % 100 != 0), i, 100, 10);
+    } // for
+    qn_mtr_record_retry(QN_MTR_API_BPUT);
+    qn_mtr_record_error(QN_ERR_TRY_AGAIN);
+    return NULL;
+}
+
+void test_snapshot_of_threads(void)
+{
+    pthread_t ths[TEST_THREAD_COUNT];
+    qn_json_object_ptr root;
+    qn_json_object_ptr api;
+    qn_json_object_ptr hist;
+    qn_json_integer val;
+    int i;
+
+    qn_mtr_enable();
+    for (i = 0; i < TEST_THREAD_COUNT; i += 1) pthread_create(&ths[i], NULL, &test_record_requests, NULL);
+    for (i = 0; i < TEST_THREAD_COUNT; i += 1) pthread_join(ths[i], NULL);
+    qn_mtr_disable();
+
+    // -- Nothing is recorded when disabled.
+    qn_mtr_record_request(QN_MTR_API_BPUT, qn_true, 1, 1, 1);
+
+    root = qn_mtr_snapshot();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(root);
+
+    api = qn_json_get_object(qn_json_get_object(root, "apis", NULL), "bput", NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(api);
+    CU_ASSERT_EQUAL(qn_json_get_integer(api, "requests", 0), TEST_THREAD_COUNT * TEST_REQUESTS_PER_THREAD);
+    CU_ASSERT_EQUAL(qn_json_get_integer(api, "failures", 0), TEST_THREAD_COUNT * TEST_REQUESTS_PER_THREAD / 100);
+    CU_ASSERT_EQUAL(qn_json_get_integer(api, "retries", 0), TEST_THREAD_COUNT);
+    CU_ASSERT_EQUAL(qn_json_get_integer(api, "bytes-sent", 0), TEST_THREAD_COUNT * TEST_REQUESTS_PER_THREAD * 100);
+    CU_ASSERT_EQUAL(qn_json_get_integer(api, "bytes-received", 0), TEST_THREAD_COUNT * TEST_REQUESTS_PER_THREAD * 10);
+    CU_ASSERT_PTR_NULL(qn_json_get_object(qn_json_get_object(root, "apis", NULL), "stat", NULL));
+
+    // -- Latencies are 1..10000, percentiles are accurate to 1/16.
+    hist = qn_json_get_object(api, "latency-us", NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(hist);
+    CU_ASSERT_EQUAL(qn_json_get_integer(hist, "count", 0), TEST_THREAD_COUNT * TEST_REQUESTS_PER_THREAD);
+    CU_ASSERT_EQUAL(qn_json_get_integer(hist, "max", 0), TEST_REQUESTS_PER_THREAD);
+    val = qn_json_get_integer(hist, "p50", 0);
+    CU_ASSERT_TRUE(val >= 5000 && val <= 5000 + 5000 / 16);
+    val = qn_json_get_integer(hist, "p99", 0);
+    CU_ASSERT_TRUE(val >= 9900 && val <= TEST_REQUESTS_PER_THREAD);
+
+    CU_ASSERT_EQUAL(qn_json_get_integer(qn_json_get_object(root, "errors", NULL), "1002", 0), TEST_THREAD_COUNT);
+
+    qn_json_destroy_object(root);
+}
+
+void test_snapshot_of_json_parsing(void)
+{
+    const char * txt = "{\"a\":[1,2,3],\"b\":\"text\"}";
+    qn_json_object_ptr obj;
+    qn_json_object_ptr root;
+    qn_json_object_ptr parsing;
+    qn_json_integer bytes;
+    qn_json_integer count;
+
+    root = qn_mtr_snapshot();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(root);
+    parsing = qn_json_get_object(root, "json-parsing", NULL);
+    bytes = qn_json_get_integer(parsing, "bytes", -1);
+    count = qn_json_get_integer(qn_json_get_object(parsing, "elapsed-ns", NULL), "count", -1);
+    qn_json_destroy_object(root);
+
+    qn_mtr_enable();
+    obj = qn_json_object_from_string(txt, strlen(txt));
+    qn_mtr_disable();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(obj);
+    qn_json_destroy_object(obj);
+
+    root = qn_mtr_snapshot();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(root);
+    parsing = qn_json_get_object(root, "json-parsing", NULL);
+    CU_ASSERT_EQUAL(qn_json_get_integer(parsing, "bytes", -1), bytes + strlen(txt));
+    CU_ASSERT_EQUAL(qn_json_get_integer(qn_json_get_object(parsing, "elapsed-ns", NULL), "count", -1), count + 1);
+    qn_json_destroy_object(root);
+}
+
+CU_TestInfo test_normal_cases[] = {
+    {"test_snapshot_of_threads()", test_snapshot_of_threads},
+    {"test_snapshot_of_json_parsing()", test_snapshot_of_json_parsing},
+    CU_TEST_INFO_NULL
+};
+
+// ---- test suites ----
+
+CU_SuiteInfo suites[] = {
+    {"test_normal_cases", NULL, NULL, test_normal_cases},
+    CU_SUITE_INFO_NULL
+};
+
+int main(void)
+{
+    CU_pSuite pSuite = NULL;
+
+    if (CU_initialize_registry() != CUE_SUCCESS) {
+        return CU_get_error();
+    } // if
+
+    pSuite = CU_add_suite("Suite_Test_Metrics", NULL, NULL);
+    if (pSuite == NULL) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    } // if
+
+    if (CU_register_suites(suites) != CUE_SUCCESS) {
+        printf("Cannot register test suites.\n");
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+} // main
@@ -181,12 +181,102 @@ void test_snprintf(void)
     CU_ASSERT_EQUAL(str_len, strlen(ret));
 } // test_snprintf
 
+void test_builder(void)
+{
+    int i = 0;
+    qn_str_builder_ptr bld = NULL;
+
+    bld = qn_str_bld_create(4);
+    if (!bld) {
+        CU_FAIL("Cannot create a new string builder.");
+        return;
+    } // if
+
+    CU_ASSERT_STRING_EQUAL(qn_str_bld_cstr(bld), "");
+    CU_ASSERT_EQUAL(qn_str_bld_size(bld), 0);
+
+    CU_ASSERT_TRUE(qn_str_bld_append_cstr(bld, "/mkfile/"));
+    CU_ASSERT_TRUE(qn_str_bld_append_integer(bld, 12345678901LL));
+    CU_ASSERT_TRUE(qn_str_bld_append_raw(bld, "/key/", 5));
+    CU_ASSERT_TRUE(qn_str_bld_append_base64_urlsafe(bld, "a/b?c", 5));
+    CU_ASSERT_TRUE(qn_str_bld_append_raw(bld, "&op=", 4));
+    CU_ASSERT_TRUE(qn_str_bld_append_percent_encoded(bld, "stat/a=b", 8, NULL));
+    CU_ASSERT_TRUE(qn_str_bld_append_integer(bld, -42));
+    CU_ASSERT_STRING_EQUAL(qn_str_bld_cstr(bld), "/mkfile/12345678901/key/YS9iP2M=&op=stat%2Fa%3Db-42");
+    CU_ASSERT_EQUAL(qn_str_bld_size(bld), strlen(qn_str_bld_cstr(bld)));
+
+    // -- Reuse the grown buffer.
+    qn_str_bld_reset(bld);
+    CU_ASSERT_STRING_EQUAL(qn_str_bld_cstr(bld), "");
+    CU_ASSERT_EQUAL(qn_str_bld_size(bld), 0);
+
+    for (i = 0; i < 1000; i += 1) {
+        CU_ASSERT_TRUE(qn_str_bld_append_integer(bld, 0));
+    } // for
+    CU_ASSERT_EQUAL(qn_str_bld_size(bld), 1000);
+    CU_ASSERT_EQUAL(strspn(qn_str_bld_cstr(bld), "0"), 1000);
+
+    qn_str_bld_destroy(bld);
+} // test_builder
+
+static qn_bool test_check_like_default(int c)
+{
+    return qn_cs_percent_encode_check(c);
+}
+
+static qn_bool test_check_keeping_slashes(int c)
+{
+    if (c == '/') return qn_false;
+    return qn_cs_percent_encode_check(c);
+}
+
+void test_percent_encode_with_table(void)
+{
+    char bin[80];
+    qn_string expected = NULL;
+    qn_string encoded = NULL;
+    qn_cs_percent_encode_table tbl;
+    qn_bool same = qn_true;
+    int pos = 0;
+    int c = 0;
+
+    encoded = qn_cs_percent_encode("a b/c%41%4", 10);
+    CU_ASSERT_STRING_EQUAL(encoded, "a%20b%2Fc%41%254");
+    qn_str_destroy(encoded);
+
+    qn_cs_percent_encode_compile_table(&tbl, &test_check_keeping_slashes);
+
+    // -- Put every byte value at every position, and compare with the results of checkers called for each char.
+    for (pos = 0; pos < sizeof(bin) && same; pos += 1) {
+        for (c = 0; c < 256 && same; c += 1) {
+            memset(bin, 'a', sizeof(bin));
+            memcpy(bin + 40, "%4a/b", 5);
+            bin[pos] = (char) c;
+
+            expected = qn_cs_percent_encode_with_checker(bin, sizeof(bin), &test_check_like_default);
+            encoded = qn_cs_percent_encode(bin, sizeof(bin));
+            same = (expected && encoded && strcmp(expected, encoded) == 0);
+            qn_str_destroy(expected);
+            qn_str_destroy(encoded);
+
+            expected = qn_cs_percent_encode_with_checker(bin, sizeof(bin), &test_check_keeping_slashes);
+            encoded = qn_cs_percent_encode_with_table(bin, sizeof(bin), &tbl);
+            same = same && (expected && encoded && strcmp(expected, encoded) == 0);
+            qn_str_destroy(expected);
+            qn_str_destroy(encoded);
+        } // for
+    } // for
+    CU_ASSERT_TRUE(same);
+} // test_percent_encode_with_table
+
 CU_TestInfo test_normal_cases[] = {
     {"test_duplicate", test_duplicate},
     {"test_join_list", test_join_list},
     {"test_join", test_join},
     {"test_sprintf", test_sprintf},
     {"test_snprintf", test_snprintf},
+    {"test_builder", test_builder},
+    {"test_percent_encode_with_table", test_percent_encode_with_table},
     CU_TEST_INFO_NULL
 };
 